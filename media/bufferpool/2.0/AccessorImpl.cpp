@@ -19,6 +19,7 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 #include <unistd.h>
 #include <utils/Log.h>
@@ -41,6 +42,7 @@ namespace {
     static constexpr size_t kMinBufferCountForEviction = 25;
     static constexpr size_t kMaxUnusedBufferCount = 64;
     static constexpr size_t kUnusedBufferCountTarget = kMaxUnusedBufferCount - 16;
+    static constexpr int64_t kTrimDurationUs = 5000000; // 5 secs
 
     static constexpr nsecs_t kEvictGranularityNs = 1000000000; // 1 sec
     static constexpr nsecs_t kEvictDurationNs = 5000000000; // 5 secs
@@ -306,6 +308,7 @@ Accessor::Impl::Impl::BufferPool::BufferPool()
     : mTimestampUs(getTimestampNow()),
       mLastCleanUpUs(mTimestampUs),
       mLastLogUs(mTimestampUs),
+      mLastTrimUs(mTimestampUs),
       mSeq(0),
       mStartSeq(0) {
     mValid = mInvalidationChannel.isValid();
@@ -322,15 +325,32 @@ std::atomic<std::uint32_t> Accessor::Impl::BufferPool::Invalidation::sInvSeqId(0
 
 Accessor::Impl::Impl::BufferPool::~BufferPool() {
     std::lock_guard<std::mutex> lock(mMutex);
-    ALOGV("Destruction - bufferpool2 %p "
-          "cached: %zu/%zuM, %zu/%d%% in use; "
-          "allocs: %zu, %d%% recycled; "
-          "transfers: %zu, %d%% unfetched",
-          this, mStats.mBuffersCached, mStats.mSizeCached >> 20,
-          mStats.mBuffersInUse, percentage(mStats.mBuffersInUse, mStats.mBuffersCached),
-          mStats.mTotalAllocations, percentage(mStats.mTotalRecycles, mStats.mTotalAllocations),
-          mStats.mTotalTransfers,
-          percentage(mStats.mTotalTransfers - mStats.mTotalFetches, mStats.mTotalTransfers));
+    ALOGV("Destruction - bufferpool2 %p %s", this, mStats.dump().c_str());
+}
+
+std::string Accessor::Impl::BufferPool::Stats::dump() const {
+    char line[256];
+    snprintf(line, sizeof(line),
+             "cached: %zu/%zuM, %zu/%d%% in use; "
+             "allocs: %zu, %d%% recycled (%zu hits, %zu misses), %zu evicted; "
+             "transfers: %zu, %d%% unfetched",
+             mBuffersCached, mSizeCached >> 20,
+             mBuffersInUse, percentage(mBuffersInUse, mBuffersCached),
+             mTotalAllocations, percentage(mTotalRecycles, mTotalAllocations),
+             mTotalRecycles, mTotalAllocations - mTotalRecycles, mTotalEvictions,
+             mTotalTransfers, percentage(mTotalTransfers - mTotalFetches, mTotalTransfers));
+    std::string result = line;
+    for (const auto &it : mSizeClasses) {
+        const SizeClass &sizeClass = it.second;
+        snprintf(line, sizeof(line),
+                 "\n  class %zu: %zu cached, %zu in use, high-water %zu; "
+                 "%zu hits, %zu misses, %zu evicted",
+                 it.first, sizeClass.mBuffersCached, sizeClass.mBuffersInUse,
+                 sizeClass.mHighWater, sizeClass.mHits, sizeClass.mMisses,
+                 sizeClass.mEvictions);
+        result.append(line);
+    }
+    return result;
 }
 
 void Accessor::Impl::BufferPool::Invalidation::onConnect(
@@ -679,11 +699,14 @@ bool Accessor::Impl::BufferPool::getFreeBuffer(
         const std::shared_ptr<BufferPoolAllocator> &allocator,
         const std::vector<uint8_t> &params, BufferId *pId,
         const native_handle_t** handle) {
-    auto bufferIt = mFreeBuffers.begin();
-    for (;bufferIt != mFreeBuffers.end(); ++bufferIt) {
-        BufferId bufferId = *bufferIt;
-        if (allocator->compatible(params, mBuffers[bufferId]->mConfig)) {
-            break;
+    // Best fit: allocators may accept larger buffers than requested.
+    auto bufferIt = mFreeBuffers.end();
+    for (auto it = mFreeBuffers.begin(); it != mFreeBuffers.end(); ++it) {
+        const std::unique_ptr<InternalBuffer> &buffer = mBuffers[*it];
+        if ((bufferIt == mFreeBuffers.end() ||
+                    buffer->mAllocSize < mBuffers[*bufferIt]->mAllocSize) &&
+                allocator->compatible(params, buffer->mConfig)) {
+            bufferIt = it;
         }
     }
     if (bufferIt != mFreeBuffers.end()) {
@@ -732,13 +755,7 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
         if (mTimestampUs > mLastLogUs + kLogDurationUs ||
                 mStats.buffersNotInUse() > kMaxUnusedBufferCount) {
             mLastLogUs = mTimestampUs;
-            ALOGV("bufferpool2 %p : %zu(%zu size) total buffers - "
-                  "%zu(%zu size) used buffers - %zu/%zu (recycle/alloc) - "
-                  "%zu/%zu (fetch/transfer)",
-                  this, mStats.mBuffersCached, mStats.mSizeCached,
-                  mStats.mBuffersInUse, mStats.mSizeInUse,
-                  mStats.mTotalRecycles, mStats.mTotalAllocations,
-                  mStats.mTotalFetches, mStats.mTotalTransfers);
+            ALOGV("bufferpool2 %p : %s", this, mStats.dump().c_str());
         }
         for (auto freeIt = mFreeBuffers.begin(); freeIt != mFreeBuffers.end();) {
             if (!clearCache && mStats.buffersNotInUse() <= kUnusedBufferCountTarget &&
@@ -757,6 +774,33 @@ void Accessor::Impl::BufferPool::cleanUp(bool clearCache) {
                 ALOGW("bufferpool2 inconsistent!");
             }
         }
+        if (mTimestampUs > mLastTrimUs + kTrimDurationUs) {
+            mLastTrimUs = mTimestampUs;
+            trimSizeClasses();
+        }
+    }
+}
+
+void Accessor::Impl::BufferPool::trimSizeClasses() {
+    for (auto freeIt = mFreeBuffers.begin(); freeIt != mFreeBuffers.end();) {
+        auto it = mBuffers.find(*freeIt);
+        if (it == mBuffers.end()) {
+            ++freeIt;
+            continue;
+        }
+        const Stats::SizeClass &sizeClass =
+                mStats.mSizeClasses[getSizeClass(it->second->mAllocSize)];
+        if (sizeClass.mBuffersCached > sizeClass.mHighWater &&
+                it->second->mOwnerCount == 0 && it->second->mTransactionCount == 0) {
+            mStats.onBufferEvicted(it->second->mAllocSize);
+            mBuffers.erase(it);
+            freeIt = mFreeBuffers.erase(freeIt);
+        } else {
+            ++freeIt;
+        }
+    }
+    for (auto &it : mStats.mSizeClasses) {
+        it.second.mHighWater = it.second.mBuffersInUse;
     }
 }
 
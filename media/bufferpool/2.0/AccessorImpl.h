@@ -17,8 +17,10 @@
 #ifndef ANDROID_HARDWARE_MEDIA_BUFFERPOOL_V2_0_ACCESSORIMPL_H
 #define ANDROID_HARDWARE_MEDIA_BUFFERPOOL_V2_0_ACCESSORIMPL_H
 
+#include <algorithm>
 #include <map>
 #include <set>
+#include <string>
 #include <condition_variable>
 #include <utils/Timers.h>
 #include "Accessor.h"
@@ -95,6 +97,7 @@ private:
         int64_t mTimestampUs;
         int64_t mLastCleanUpUs;
         int64_t mLastLogUs;
+        int64_t mLastTrimUs;
         BufferId mSeq;
         BufferId mStartSeq;
         bool mValid;
@@ -169,6 +172,31 @@ private:
         } mInvalidation;
         /// Buffer pool statistics which tracks allocation and transfer statistics.
         struct Stats {
+            /// Statistics of the buffers of one size class. (see getSizeClass())
+            struct SizeClass {
+                /// # of cached buffers which are used or available to use.
+                size_t mBuffersCached;
+                /// # of currently used buffers
+                size_t mBuffersInUse;
+                /// Highest # of buffers used at once since the last trim.
+                size_t mHighWater;
+                /// # of allocations that were served from the cache.
+                size_t mHits;
+                /// # of allocations that had to allocate a new buffer.
+                size_t mMisses;
+                /// # of buffers evicted.
+                size_t mEvictions;
+
+                SizeClass()
+                    : mBuffersCached(0), mBuffersInUse(0), mHighWater(0),
+                      mHits(0), mMisses(0), mEvictions(0) {}
+
+                void onBufferUsed() {
+                    mBuffersInUse++;
+                    mHighWater = std::max(mHighWater, mBuffersInUse);
+                }
+            };
+
             /// Total size of allocations which are used or available to use.
             /// (bytes or pixels)
             size_t mSizeCached;
@@ -188,10 +216,16 @@ private:
             size_t mTotalTransfers;
             /// # of transfers that had to be fetched.
             size_t mTotalFetches;
+            /// # of buffers evicted.
+            size_t mTotalEvictions;
+
+            /// Statistics per size class.
+            std::map<size_t, SizeClass> mSizeClasses;
 
             Stats()
                 : mSizeCached(0), mBuffersCached(0), mSizeInUse(0), mBuffersInUse(0),
-                  mTotalAllocations(0), mTotalRecycles(0), mTotalTransfers(0), mTotalFetches(0) {}
+                  mTotalAllocations(0), mTotalRecycles(0), mTotalTransfers(0), mTotalFetches(0),
+                  mTotalEvictions(0) {}
 
             /// # of currently unused buffers
             size_t buffersNotInUse() const {
@@ -208,12 +242,23 @@ private:
                 mBuffersInUse++;
 
                 mTotalAllocations++;
+
+                SizeClass &sizeClass = mSizeClasses[getSizeClass(allocSize)];
+                sizeClass.mBuffersCached++;
+                sizeClass.onBufferUsed();
+                sizeClass.mMisses++;
             }
 
             /// A buffer is evicted and destroyed.
             void onBufferEvicted(size_t allocSize) {
                 mSizeCached -= allocSize;
                 mBuffersCached--;
+
+                mTotalEvictions++;
+
+                SizeClass &sizeClass = mSizeClasses[getSizeClass(allocSize)];
+                sizeClass.mBuffersCached--;
+                sizeClass.mEvictions++;
             }
 
             /// A buffer is recycled on an allocation request.
@@ -223,12 +268,18 @@ private:
 
                 mTotalAllocations++;
                 mTotalRecycles++;
+
+                SizeClass &sizeClass = mSizeClasses[getSizeClass(allocSize)];
+                sizeClass.onBufferUsed();
+                sizeClass.mHits++;
             }
 
             /// A buffer is available to be recycled.
             void onBufferUnused(size_t allocSize) {
                 mSizeInUse -= allocSize;
                 mBuffersInUse--;
+
+                mSizeClasses[getSizeClass(allocSize)].mBuffersInUse--;
             }
 
             /// A buffer transfer is initiated.
@@ -240,6 +291,9 @@ private:
             void onBufferFetched() {
                 mTotalFetches++;
             }
+
+            /// Returns a summary of the statistics, one line per size class.
+            std::string dump() const;
         } mStats;
 
         bool isValid() {
@@ -249,6 +303,13 @@ private:
         void invalidate(bool needsAck, BufferId from, BufferId to,
                         const std::shared_ptr<Accessor::Impl> &impl);
 
+        /**
+         * Evicts the free buffers of the size classes which cache more
+         * buffers than they have used at once since the last trim, and starts
+         * a new high-water mark period.
+         */
+        void trimSizeClasses();
+
         static void createInvalidator();
 
     public:
@@ -329,7 +390,8 @@ private:
         bool handleClose(ConnectionId connectionId);
 
         /**
-         * Recycles a existing free buffer if it is possible.
+         * Recycles a existing free buffer if it is possible. Among the free
+         * buffers compatible with |params| the smallest one is recycled.
          *
          * @param allocator the buffer allocator
          * @param params    the allocation parameters.
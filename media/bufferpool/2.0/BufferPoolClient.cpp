@@ -17,6 +17,8 @@
 #define LOG_TAG "BufferPoolClient"
 //#define LOG_NDEBUG 0
 
+#include <condition_variable>
+#include <list>
 #include <thread>
 #include <utils/Log.h>
 #include "BufferPoolClient.h"
@@ -34,6 +36,10 @@ static constexpr int kPostMaxRetry = 3;
 static constexpr int kCacheTtlUs = 1000000; // TODO: tune
 static constexpr size_t kMaxCachedBufferCount = 64;
 static constexpr size_t kCachedBufferCountTarget = kMaxCachedBufferCount - 16;
+// Buffer releases are posted in batches of up to kReleaseBatchCount, waiting
+// at most kReleaseBatchDelayUs for more releases or another status message.
+static constexpr size_t kReleaseBatchCount = 16;
+static constexpr int64_t kReleaseBatchDelayUs = 2000; // 2ms
 
 class BufferPoolClient::Impl
         : public std::enable_shared_from_this<BufferPoolClient::Impl> {
@@ -75,6 +81,8 @@ public:
 
     void postBufferRelease(BufferId bufferId);
 
+    void flushBufferReleases();
+
     bool postSend(
             BufferId bufferId, ConnectionId receiver,
             TransactionId *transactionId, int64_t *timestampUs);
@@ -107,6 +115,9 @@ private:
 
     struct BlockPoolDataDtor;
     struct ClientBuffer;
+    struct ReleaseFlusher;
+
+    static ReleaseFlusher &getReleaseFlusher();
 
     bool mLocal;
     bool mValid;
@@ -152,9 +163,12 @@ private:
         std::list<BufferId> mReleasedIds;
         uint32_t mInvalidateId; // TODO: invalidation ACK to bufferpool
         bool mInvalidateAck;
+        bool mFlushScheduled;
+        int64_t mFirstReleasingUs;
         std::unique_ptr<BufferStatusChannel> mStatusChannel;
 
-        ReleaseCache() : mInvalidateId(0), mInvalidateAck(true) {}
+        ReleaseCache() : mInvalidateId(0), mInvalidateAck(true),
+                mFlushScheduled(false), mFirstReleasingUs(0) {}
     } mReleasing;
 
     // This lock is held during synchronization from remote side.
@@ -179,6 +193,59 @@ struct BufferPoolClient::Impl::BlockPoolDataDtor {
     const std::weak_ptr<BufferPoolClient::Impl> mImpl;
 };
 
+// Posts the buffer releases held back by clients once their batching delay
+// is over, unless they were posted with another message before.
+struct BufferPoolClient::Impl::ReleaseFlusher {
+    std::list<std::pair<std::weak_ptr<BufferPoolClient::Impl>, int64_t>> mClients;
+    std::mutex mMutex;
+    std::condition_variable mCv;
+
+    ReleaseFlusher() {
+        std::thread flusher(&ReleaseFlusher::flusherThread, this);
+        flusher.detach();
+    }
+
+    void schedule(const std::weak_ptr<BufferPoolClient::Impl> &impl, int64_t deadlineUs) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        bool notify = mClients.empty();
+        // Deadlines are in order since the delay is the same for all clients.
+        mClients.emplace_back(impl, deadlineUs);
+        if (notify) {
+            mCv.notify_one();
+        }
+    }
+
+    void flusherThread() {
+        while (true) {
+            std::shared_ptr<BufferPoolClient::Impl> impl;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                if (mClients.empty()) {
+                    mCv.wait(lock);
+                    continue;
+                }
+                int64_t now = getTimestampNow();
+                if (now < mClients.front().second) {
+                    mCv.wait_for(lock, std::chrono::microseconds(
+                            mClients.front().second - now));
+                    continue;
+                }
+                impl = mClients.front().first.lock();
+                mClients.pop_front();
+            }
+            if (impl && impl->isValid()) {
+                impl->flushBufferReleases();
+            }
+        }
+    }
+};
+
+// static
+BufferPoolClient::Impl::ReleaseFlusher &BufferPoolClient::Impl::getReleaseFlusher() {
+    static ReleaseFlusher *sFlusher = new ReleaseFlusher(); // never deleted
+    return *sFlusher;
+}
+
 struct BufferPoolClient::Impl::ClientBuffer {
 private:
     int64_t mExpireUs;
@@ -360,6 +427,14 @@ ResultStatus BufferPoolClient::Impl::allocate(
     if (!mLocal || !mLocalConnection || !mValid) {
         return ResultStatus::CRITICAL_ERROR;
     }
+    {
+        // Post the held back releases first, so that those buffers can be recycled.
+        std::lock_guard<std::mutex> lock(mReleasing.mLock);
+        if (!mReleasing.mReleasingIds.empty()) {
+            mReleasing.mStatusChannel->postBufferRelease(
+                    mConnectionId, mReleasing.mReleasingIds, mReleasing.mReleasedIds);
+        }
+    }
     BufferId bufferId;
     native_handle_t *handle = nullptr;
     buffer->reset();
@@ -478,7 +553,7 @@ ResultStatus BufferPoolClient::Impl::receive(
                                       *buffer ? true : false, &needsSync);
     ALOGV("client receive %lld - %u : %s (%d)", (long long)mConnectionId, bufferId,
           *buffer ? "ok" : "fail", posted);
-    if (mValid && mLocal && mLocalConnection) {
+    if (needsSync && mValid && mLocal && mLocalConnection) {
         mLocalConnection->cleanUp(false);
     }
     if (needsSync && mRemoteConnection) {
@@ -496,8 +571,29 @@ ResultStatus BufferPoolClient::Impl::receive(
 
 
 void BufferPoolClient::Impl::postBufferRelease(BufferId bufferId) {
+    int64_t now = getTimestampNow();
+    {
+        std::lock_guard<std::mutex> lock(mReleasing.mLock);
+        if (mReleasing.mReleasingIds.empty()) {
+            mReleasing.mFirstReleasingUs = now;
+        }
+        mReleasing.mReleasingIds.push_back(bufferId);
+        if (mReleasing.mReleasingIds.size() >= kReleaseBatchCount ||
+                now >= mReleasing.mFirstReleasingUs + kReleaseBatchDelayUs) {
+            mReleasing.mStatusChannel->postBufferRelease(
+                    mConnectionId, mReleasing.mReleasingIds, mReleasing.mReleasedIds);
+        }
+        if (mReleasing.mReleasingIds.empty() || mReleasing.mFlushScheduled) {
+            return;
+        }
+        mReleasing.mFlushScheduled = true;
+    }
+    getReleaseFlusher().schedule(shared_from_this(), now + kReleaseBatchDelayUs);
+}
+
+void BufferPoolClient::Impl::flushBufferReleases() {
     std::lock_guard<std::mutex> lock(mReleasing.mLock);
-    mReleasing.mReleasingIds.push_back(bufferId);
+    mReleasing.mFlushScheduled = false;
     mReleasing.mStatusChannel->postBufferRelease(
             mConnectionId, mReleasing.mReleasingIds, mReleasing.mReleasedIds);
 }
@@ -521,9 +617,9 @@ bool BufferPoolClient::Impl::postSend(
         ret =  mReleasing.mStatusChannel->postBufferStatusMessage(
                 *transactionId, bufferId, BufferStatus::TRANSFER_TO, mConnectionId,
                 receiver, mReleasing.mReleasingIds, mReleasing.mReleasedIds);
-        needsSync = !mLocal && mReleasing.mStatusChannel->needsSync();
+        needsSync = mReleasing.mStatusChannel->needsSync();
     }
-    if (mValid && mLocal && mLocalConnection) {
+    if (needsSync && mValid && mLocal && mLocalConnection) {
         mLocalConnection->cleanUp(false);
     }
     if (needsSync && mRemoteConnection) {
@@ -567,7 +663,7 @@ bool BufferPoolClient::Impl::postReceiveResult(
             result ? BufferStatus::TRANSFER_OK : BufferStatus::TRANSFER_ERROR,
             mConnectionId, -1, mReleasing.mReleasingIds,
             mReleasing.mReleasedIds);
-    *needsSync = !mLocal && mReleasing.mStatusChannel->needsSync();
+    *needsSync = mReleasing.mStatusChannel->needsSync();
     return ret;
 }
 
@@ -86,19 +86,23 @@ ResultStatus BufferStatusObserver::close(ConnectionId id) {
 
 void BufferStatusObserver::getBufferStatusChanges(std::vector<BufferStatusMessage> &messages) {
     for (auto it = mBufferStatusQueues.begin(); it != mBufferStatusQueues.end(); ++it) {
-        BufferStatusMessage message;
         size_t avail = it->second->availableToRead();
-        while (avail > 0) {
-            if (!it->second->read(&message, 1)) {
-                // Since avaliable # of reads are already confirmed,
-                // this should not happen.
-                // TODO: error handling (spurious client?)
-                ALOGW("FMQ message cannot be read from %lld", (long long)it->first);
-                return;
-            }
-            message.connectionId = it->first;
-            messages.push_back(message);
-            --avail;
+        if (avail == 0) {
+            continue;
+        }
+        // Drain the queue with a single read.
+        size_t start = messages.size();
+        messages.resize(start + avail);
+        if (!it->second->read(&messages[start], avail)) {
+            // Since avaliable # of reads are already confirmed,
+            // this should not happen.
+            // TODO: error handling (spurious client?)
+            ALOGW("FMQ message cannot be read from %lld", (long long)it->first);
+            messages.resize(start);
+            return;
+        }
+        for (size_t i = start; i < messages.size(); ++i) {
+            messages[i].connectionId = it->first;
         }
     }
 }
@@ -133,22 +137,24 @@ void BufferStatusChannel::postBufferRelease(
     if (mValid && pending.size() > 0) {
         size_t avail = mBufferStatusQueue->availableToWrite();
         avail = std::min(avail, pending.size());
-        BufferStatusMessage message;
-        for (size_t i = 0 ; i < avail; ++i) {
-            BufferId id = pending.front();
-            message.newStatus = BufferStatus::NOT_USED;
-            message.bufferId = id;
-            message.connectionId = connectionId;
-            if (!mBufferStatusQueue->write(&message, 1)) {
-                // Since avaliable # of writes are already confirmed,
-                // this should not happen.
-                // TODO: error handing?
-                ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
-                return;
-            }
-            pending.pop_front();
-            posted.push_back(id);
+        if (avail == 0) {
+            return;
         }
+        std::vector<BufferStatusMessage> messages(avail);
+        auto it = pending.begin();
+        for (size_t i = 0 ; i < avail; ++i, ++it) {
+            messages[i].newStatus = BufferStatus::NOT_USED;
+            messages[i].bufferId = *it;
+            messages[i].connectionId = connectionId;
+        }
+        if (!mBufferStatusQueue->write(messages.data(), avail)) {
+            // Since avaliable # of writes are already confirmed,
+            // this should not happen.
+            // TODO: error handing?
+            ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
+            return;
+        }
+        posted.splice(posted.end(), pending, pending.begin(), it);
     }
 }
 
@@ -183,22 +189,15 @@ bool BufferStatusChannel::postBufferStatusMessage(
         size_t avail = mBufferStatusQueue->availableToWrite();
         size_t numPending = pending.size();
         if (avail >= numPending + 1) {
-            BufferStatusMessage release, message;
-            for (size_t i = 0; i < numPending; ++i) {
-                BufferId id = pending.front();
-                release.newStatus = BufferStatus::NOT_USED;
-                release.bufferId = id;
-                release.connectionId = connectionId;
-                if (!mBufferStatusQueue->write(&release, 1)) {
-                    // Since avaliable # of writes are already confirmed,
-                    // this should not happen.
-                    // TODO: error handling?
-                    ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
-                    return false;
-                }
-                pending.pop_front();
-                posted.push_back(id);
+            // Pending releases are sent along with the message in one write.
+            std::vector<BufferStatusMessage> messages(numPending + 1);
+            auto it = pending.begin();
+            for (size_t i = 0; i < numPending; ++i, ++it) {
+                messages[i].newStatus = BufferStatus::NOT_USED;
+                messages[i].bufferId = *it;
+                messages[i].connectionId = connectionId;
             }
+            BufferStatusMessage &message = messages[numPending];
             message.transactionId = transactionId;
             message.bufferId = bufferId;
             message.newStatus = status;
@@ -206,12 +205,13 @@ bool BufferStatusChannel::postBufferStatusMessage(
             message.targetConnectionId = targetId;
             // TODO : timesatamp
             message.timestampUs = 0;
-            if (!mBufferStatusQueue->write(&message, 1)) {
+            if (!mBufferStatusQueue->write(messages.data(), messages.size())) {
                 // Since avaliable # of writes are already confirmed,
                 // this should not happen.
                 ALOGW("FMQ message cannot be sent from %lld", (long long)connectionId);
                 return false;
             }
+            posted.splice(posted.end(), pending);
             return true;
         }
     }
@@ -113,6 +113,26 @@ protected:
     virtual ~BufferPoolAllocator() = default;
 };
 
+/**
+ * Returns the size class of an allocation of |size|: |size| rounded up to the
+ * next of four steps per power of two, 4KB being the smallest class.
+ *
+ * Allocators which round allocations up to their size class, and accept
+ * larger buffers in compatible(), let requests of slightly different sizes
+ * recycle each other's buffers at the cost of less than 25% extra memory.
+ * Buffer pool keeps its statistics per size class as well.
+ */
+inline size_t getSizeClass(size_t size) {
+    constexpr size_t kMinSizeClass = 4096;
+    if (size <= kMinSizeClass) {
+        return kMinSizeClass;
+    }
+    // The step is a quarter of the highest power of two below |size|.
+    int msb = 63 - __builtin_clzll((unsigned long long)(size - 1));
+    size_t step = size_t(1) << (msb - 2);
+    return (size + step - 1) & ~(step - 1);
+}
+
 }  // namespace implementation
 }  // namespace V2_0
 }  // namespace bufferpool
@@ -18,6 +18,8 @@
 #include <sys/mman.h>
 #include "allocator.h"
 
+using android::hardware::media::bufferpool::V2_0::implementation::getSizeClass;
+
 union Params {
   struct {
     uint32_t capacity;
@@ -179,6 +181,31 @@ bool TestBufferPoolAllocator::compatible(const std::vector<uint8_t> &newParams,
   return false;
 }
 
+ResultStatus SizeClassBufferPoolAllocator::allocate(
+    const std::vector<uint8_t> &params,
+    std::shared_ptr<BufferPoolAllocation> *alloc,
+    size_t *allocSize) {
+  Params ashmemParams;
+  memcpy(&ashmemParams, params.data(), std::min(sizeof(Params), params.size()));
+  ashmemParams.data.capacity = getSizeClass(ashmemParams.data.capacity);
+
+  std::vector<uint8_t> classParams(
+      ashmemParams.array, ashmemParams.array + sizeof(ashmemParams));
+  return TestBufferPoolAllocator::allocate(classParams, alloc, allocSize);
+}
+
+bool SizeClassBufferPoolAllocator::compatible(const std::vector<uint8_t> &newParams,
+                                             const std::vector<uint8_t> &oldParams) {
+  Params newAlloc;
+  Params oldAlloc;
+  memcpy(&newAlloc, newParams.data(), std::min(sizeof(Params), newParams.size()));
+  memcpy(&oldAlloc, oldParams.data(), std::min(sizeof(Params), oldParams.size()));
+
+  size_t newClass = getSizeClass(newAlloc.data.capacity);
+  size_t oldClass = getSizeClass(oldAlloc.data.capacity);
+  return newClass <= oldClass && oldClass <= newClass * 2;
+}
+
 bool TestBufferPoolAllocator::Fill(const native_handle_t *handle, const unsigned char val) {
   if (!HandleAshmem::isValid(handle)) {
     return false;
@@ -244,6 +271,12 @@ void getTestAllocatorParams(std::vector<uint8_t> *params) {
   params->assign(ashmemParams.array, ashmemParams.array + sizeof(ashmemParams));
 }
 
+void getTestAllocatorParams(std::vector<uint8_t> *params, uint32_t capacity) {
+  Params ashmemParams(capacity);
+
+  params->assign(ashmemParams.array, ashmemParams.array + sizeof(ashmemParams));
+}
+
 void getIpcMutexParams(std::vector<uint8_t> *params) {
   Params ashmemParams(sizeof(IpcMutex));
 
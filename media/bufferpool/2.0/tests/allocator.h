@@ -60,9 +60,24 @@ class TestBufferPoolAllocator : public BufferPoolAllocator {
   static bool UnmapMemoryForMutex(void *mem);
 };
 
+// buffer allocator which rounds capacities up to their size class, and
+// recycles a buffer for requests of up to two times smaller size class.
+class SizeClassBufferPoolAllocator : public TestBufferPoolAllocator {
+ public:
+  ResultStatus allocate(const std::vector<uint8_t> &params,
+                        std::shared_ptr<BufferPoolAllocation> *alloc,
+                        size_t *allocSize) override;
+
+  bool compatible(const std::vector<uint8_t> &newParams,
+                  const std::vector<uint8_t> &oldParams) override;
+};
+
 // retrieve buffer allocator paramters
 void getTestAllocatorParams(std::vector<uint8_t> *params);
 
+// retrieve buffer allocator paramters for the specified capacity
+void getTestAllocatorParams(std::vector<uint8_t> *params, uint32_t capacity);
+
 void getIpcMutexParams(std::vector<uint8_t> *params);
 
 #endif  // VNDK_HIDL_BUFFERPOOL_V2_0_ALLOCATOR_H
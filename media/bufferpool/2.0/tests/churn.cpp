@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Benchmark of bufferpool recycling under variable-sized linear allocation
+ * churn, as seen with compressed input buffers of a codec.
+ *
+ * Each iteration allocates a buffer of a random size between 8KB and 256KB
+ * while a window of recently allocated buffers is kept in use. The exact
+ * allocator only recycles a buffer of the same size, the size class allocator
+ * one of the same or a slightly larger size class.
+ *
+ * How to run the benchmark:
+ *      $ mm -j72 && adb sync
+ *      $ adb shell /data/benchmarktest64/BufferpoolChurnBenchmark/BufferpoolChurnBenchmark
+ */
+
+#define LOG_TAG "BufferpoolChurnBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <bufferpool/ClientManager.h>
+#include <deque>
+#include <memory>
+#include <random>
+#include <vector>
+#include "allocator.h"
+
+using android::hardware::media::bufferpool::BufferPoolData;
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+
+namespace {
+
+constexpr uint32_t kMinCapacity = 8 * 1024;
+constexpr uint32_t kMaxCapacity = 256 * 1024;
+
+// Counts the allocations which could not be served from the pool.
+template <class Allocator>
+class CountingAllocator : public Allocator {
+ public:
+  ResultStatus allocate(const std::vector<uint8_t> &params,
+                        std::shared_ptr<BufferPoolAllocation> *alloc,
+                        size_t *allocSize) override {
+    ++mAllocations;
+    return Allocator::allocate(params, alloc, allocSize);
+  }
+
+  size_t mAllocations = 0;
+};
+
+template <class Allocator>
+void BM_Churn(benchmark::State &state) {
+  const size_t buffersInUse = state.range(0);
+  android::sp<ClientManager> manager = ClientManager::getInstance();
+  std::shared_ptr<CountingAllocator<Allocator>> allocator =
+      std::make_shared<CountingAllocator<Allocator>>();
+  ConnectionId connectionId;
+  if (manager->create(allocator, &connectionId) != ResultStatus::OK) {
+    state.SkipWithError("Unable to create the connection");
+    return;
+  }
+
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<uint32_t> capacities(kMinCapacity, kMaxCapacity);
+  std::deque<std::shared_ptr<BufferPoolData>> buffers;
+  std::vector<uint8_t> params;
+  size_t requests = 0;
+  for (auto _ : state) {
+    getTestAllocatorParams(&params, capacities(generator));
+    native_handle_t *handle = nullptr;
+    std::shared_ptr<BufferPoolData> buffer;
+    if (manager->allocate(connectionId, params, &handle, &buffer) != ResultStatus::OK) {
+      state.SkipWithError("Allocation failed");
+      break;
+    }
+    native_handle_close(handle);
+    native_handle_delete(handle);
+    ++requests;
+
+    buffers.push_back(std::move(buffer));
+    if (buffers.size() > buffersInUse) {
+      buffers.pop_front();
+    }
+  }
+  buffers.clear();
+  manager->close(connectionId);
+
+  state.counters["Allocations"] = allocator->mAllocations;
+  state.counters["RecycleRate"] =
+      requests == 0 ? 0. : 1. - (double)allocator->mAllocations / requests;
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Churn, TestBufferPoolAllocator)->Arg(4)->Arg(16);
+BENCHMARK_TEMPLATE(BM_Churn, SizeClassBufferPoolAllocator)->Arg(4)->Arg(16);
+
+BENCHMARK_MAIN();
@@ -173,6 +173,57 @@ TEST_F(BufferpoolSingleTest, TransferBuffer) {
   }
 }
 
+// Size class recycle test.
+// Check whether a free buffer is recycled for a request of a smaller but
+// close size, and the smallest of the compatible free buffers is chosen.
+TEST_F(BufferpoolSingleTest, RecycleSizeClassBuffer) {
+  ResultStatus status;
+  std::shared_ptr<BufferPoolAllocator> allocator =
+      std::make_shared<SizeClassBufferPoolAllocator>();
+  ConnectionId connectionId;
+  status = mManager->create(allocator, &connectionId);
+  ASSERT_TRUE(status == ResultStatus::OK);
+
+  auto allocate = [&](uint32_t capacity, std::shared_ptr<BufferPoolData> *buffer) {
+    std::vector<uint8_t> vecParams;
+    getTestAllocatorParams(&vecParams, capacity);
+    native_handle_t *allocHandle = nullptr;
+    ResultStatus res = mManager->allocate(connectionId, vecParams, &allocHandle, buffer);
+    if (allocHandle) {
+      native_handle_close(allocHandle);
+      native_handle_delete(allocHandle);
+    }
+    return res;
+  };
+
+  BufferId largeId, smallId;
+  {
+    std::shared_ptr<BufferPoolData> large, small;
+    ASSERT_TRUE(allocate(10000, &large) == ResultStatus::OK);
+    ASSERT_TRUE(allocate(6000, &small) == ResultStatus::OK);
+    largeId = large->mId;
+    smallId = small->mId;
+  }
+  {
+    // Both free buffers fit, the smaller one is recycled.
+    std::shared_ptr<BufferPoolData> buffer;
+    ASSERT_TRUE(allocate(5000, &buffer) == ResultStatus::OK);
+    EXPECT_TRUE(buffer->mId == smallId);
+  }
+  {
+    std::shared_ptr<BufferPoolData> buffer;
+    ASSERT_TRUE(allocate(9000, &buffer) == ResultStatus::OK);
+    EXPECT_TRUE(buffer->mId == largeId);
+  }
+  {
+    // No free buffer is large enough.
+    std::shared_ptr<BufferPoolData> buffer;
+    ASSERT_TRUE(allocate(20000, &buffer) == ResultStatus::OK);
+    EXPECT_TRUE(buffer->mId != largeId && buffer->mId != smallId);
+  }
+  mManager->close(connectionId);
+}
+
 }  // anonymous namespace
 
 int main(int argc, char** argv) {
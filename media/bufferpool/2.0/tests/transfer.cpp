@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Benchmark of bufferpool buffer transfers at simulated video frame rates.
+ *
+ * Each iteration is a frame: a buffer is allocated, sent, received and both
+ * references are released, then the loop waits for the next frame time.
+ * The argument is the frame rate, 0 running the frames back to back. Waiting
+ * is not timed, so the time of an iteration is the cost of a transferred
+ * buffer and the Transfers counter the transfers per second of busy time.
+ *
+ * How to run the benchmark:
+ *      $ mm -j72 && adb sync
+ *      $ adb shell /data/benchmarktest64/BufferpoolTransferBenchmark/BufferpoolTransferBenchmark
+ */
+
+#define LOG_TAG "BufferpoolTransferBenchmark"
+
+#include <benchmark/benchmark.h>
+
+#include <bufferpool/ClientManager.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "allocator.h"
+
+using android::hardware::media::bufferpool::BufferPoolData;
+using android::hardware::media::bufferpool::V2_0::ResultStatus;
+using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
+using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
+using android::hardware::media::bufferpool::V2_0::implementation::TransactionId;
+
+namespace {
+
+// Number of frames which are received but not released yet.
+constexpr size_t kFramesInFlight = 4;
+
+void closeHandle(native_handle_t *handle) {
+  if (handle) {
+    native_handle_close(handle);
+    native_handle_delete(handle);
+  }
+}
+
+void BM_Transfer(benchmark::State &state) {
+  const int64_t fps = state.range(0);
+  android::sp<ClientManager> manager = ClientManager::getInstance();
+  std::shared_ptr<BufferPoolAllocator> allocator =
+      std::make_shared<TestBufferPoolAllocator>();
+  ConnectionId connectionId;
+  ConnectionId receiverId;
+  if (manager->create(allocator, &connectionId) != ResultStatus::OK) {
+    state.SkipWithError("Unable to create the connection");
+    return;
+  }
+  manager->registerSender(manager, connectionId, &receiverId);
+
+  std::vector<uint8_t> params;
+  getTestAllocatorParams(&params);
+  std::vector<std::shared_ptr<BufferPoolData>> received(kFramesInFlight);
+  const std::chrono::nanoseconds frameDuration(fps > 0 ? 1000000000 / fps : 0);
+  auto nextFrame = std::chrono::steady_clock::now();
+  size_t transfers = 0;
+  for (auto _ : state) {
+    native_handle_t *handle = nullptr;
+    std::shared_ptr<BufferPoolData> buffer;
+    if (manager->allocate(connectionId, params, &handle, &buffer) != ResultStatus::OK) {
+      state.SkipWithError("Allocation failed");
+      break;
+    }
+    closeHandle(handle);
+
+    TransactionId transactionId;
+    int64_t timestampUs;
+    native_handle_t *receivedHandle = nullptr;
+    std::shared_ptr<BufferPoolData> receivedBuffer;
+    if (manager->postSend(receiverId, buffer, &transactionId, &timestampUs) !=
+            ResultStatus::OK ||
+        manager->receive(receiverId, transactionId, buffer->mId, timestampUs,
+                         &receivedHandle, &receivedBuffer) != ResultStatus::OK) {
+      state.SkipWithError("Transfer failed");
+      break;
+    }
+    closeHandle(receivedHandle);
+    buffer.reset();
+    received[transfers % kFramesInFlight] = std::move(receivedBuffer);
+    ++transfers;
+
+    if (fps > 0) {
+      state.PauseTiming();
+      nextFrame += frameDuration;
+      std::this_thread::sleep_until(nextFrame);
+      state.ResumeTiming();
+    }
+  }
+  received.clear();
+  manager->close(connectionId);
+
+  state.counters["Transfers"] = benchmark::Counter(transfers, benchmark::Counter::kIsRate);
+}
+
+}  // namespace
+
+BENCHMARK(BM_Transfer)
+    ->Arg(0) /* <-- back to back */
+    ->Arg(30)
+    ->Arg(120)
+    ->Arg(240)
+    ->MinTime(2.0);
+
+BENCHMARK_MAIN();
@@ -20,9 +20,12 @@
 
 #include <cutils/properties.h>
 #include <media/stagefright/foundation/AMessage.h>
+#include <utils/AndroidThreads.h>
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <C2Config.h>
 #include <C2Debug.h>
 #include <C2PlatformSupport.h>
@@ -101,6 +104,9 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
         }
         case kWhatInit: {
             int32_t err = thiz->onInit();
+            if (err == C2_OK) {
+                thiz->startOutputThread();
+            }
             Reply(msg, &err);
             [[fallthrough]];
         }
@@ -109,12 +115,14 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatStop: {
+            thiz->waitForOutput();
             int32_t err = thiz->onStop();
             thiz->mOutputBlockPool.reset();
             Reply(msg, &err);
             break;
         }
         case kWhatReset: {
+            thiz->waitForOutput();
             thiz->onReset();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -122,6 +130,7 @@ void SimpleC2Component::WorkHandler::onMessageReceived(const sp<AMessage> &msg)
             break;
         }
         case kWhatRelease: {
+            thiz->stopOutputThread();
             thiz->onRelease();
             thiz->mOutputBlockPool.reset();
             mRunning = false;
@@ -200,7 +209,9 @@ SimpleC2Component::SimpleC2Component(
     : mDummyReadView(DummyReadView()),
       mIntf(intf),
       mLooper(new ALooper),
-      mHandler(new WorkHandler) {
+      mHandler(new WorkHandler),
+      mRequestedPipelineDepth(1u),
+      mPipelineDepth(1u) {
     mLooper->setName(intf->getName().c_str());
     (void)mLooper->registerHandler(mHandler);
     mLooper->start(false, false, ANDROID_PRIORITY_VIDEO);
@@ -209,6 +220,7 @@ SimpleC2Component::SimpleC2Component(
 SimpleC2Component::~SimpleC2Component() {
     mLooper->unregisterHandler(mHandler->id());
     (void)mLooper->stop();
+    stopOutputThread();
 }
 
 c2_status_t SimpleC2Component::setListener_vb(
@@ -393,6 +405,10 @@ std::list<std::unique_ptr<C2Work>> vec(std::unique_ptr<C2Work> &work) {
 
 void SimpleC2Component::finish(
         uint64_t frameIndex, std::function<void(const std::unique_ptr<C2Work> &)> fillWork) {
+    if (isOutputDeferred()) {
+        queueOutput([this, frameIndex, fillWork] { finish(frameIndex, fillWork); });
+        return;
+    }
     std::unique_ptr<C2Work> work;
     {
         Mutexed<WorkQueue>::Locked queue(mWorkQueue);
@@ -429,6 +445,15 @@ void SimpleC2Component::cloneAndSend(
         work->input.ordinal = queue->pending().at(frameIndex)->input.ordinal;
     }
     work->worklets.emplace_back(new C2Worklet);
+    if (isOutputDeferred()) {
+        std::shared_ptr<std::unique_ptr<C2Work>> deferred =
+                std::make_shared<std::unique_ptr<C2Work>>(std::move(work));
+        queueOutput([this, deferred, fillWork] {
+            fillWork(*deferred);
+            returnWork(std::move(*deferred));
+        });
+        return;
+    }
     if (work) {
         fillWork(work);
         std::shared_ptr<C2Component::Listener> listener = mExecState.lock()->mListener;
@@ -437,6 +462,109 @@ void SimpleC2Component::cloneAndSend(
     }
 }
 
+void SimpleC2Component::setPipelineDepth(uint32_t depth) {
+    mRequestedPipelineDepth = std::max(depth, 1u);
+}
+
+bool SimpleC2Component::isPipelined() const {
+    return mPipelineDepth > 1u;
+}
+
+void SimpleC2Component::queueOutput(std::function<void()> job) {
+    if (isOutputDeferred()) {
+        mPendingOutput.push_back(std::move(job));
+    } else {
+        job();
+    }
+}
+
+bool SimpleC2Component::isOutputDeferred() const {
+    return isPipelined() && std::this_thread::get_id() != mOutputThread.get_id();
+}
+
+void SimpleC2Component::returnWork(std::unique_ptr<C2Work> work) {
+    if (isOutputDeferred()) {
+        std::shared_ptr<std::unique_ptr<C2Work>> deferred =
+                std::make_shared<std::unique_ptr<C2Work>>(std::move(work));
+        queueOutput([this, deferred] { returnWork(std::move(*deferred)); });
+        return;
+    }
+    Mutexed<ExecState>::Locked state(mExecState);
+    std::shared_ptr<C2Component::Listener> listener = state->mListener;
+    state.unlock();
+    listener->onWorkDone_nb(shared_from_this(), vec(work));
+}
+
+void SimpleC2Component::releaseOutput() {
+    if (mPendingOutput.empty()) {
+        return;
+    }
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    // The work under processing is the last one in flight.
+    while (queue->mBatches.size() + (queue->mRunning ? 1 : 0) >= mPipelineDepth - 1) {
+        queue.waitForCondition(queue->mCond);
+    }
+    queue->mBatches.push_back(std::move(mPendingOutput));
+    mPendingOutput.clear();
+    queue->mCond.broadcast();
+}
+
+void SimpleC2Component::waitForOutput() {
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    while (!queue->mBatches.empty() || queue->mRunning) {
+        queue.waitForCondition(queue->mCond);
+    }
+}
+
+void SimpleC2Component::startOutputThread() {
+    mPipelineDepth = std::max(property_get_int32(
+            "debug.stagefright.c2_sw_pipeline_depth", mRequestedPipelineDepth), 1);
+    if (mPipelineDepth > 1u && !mOutputThread.joinable()) {
+        mOutputQueue.lock()->mExit = false;
+        mOutputThread = std::thread(&SimpleC2Component::outputThreadLoop, this);
+    }
+    ALOGV("pipeline depth %u", mPipelineDepth);
+}
+
+void SimpleC2Component::stopOutputThread() {
+    if (!mOutputThread.joinable()) {
+        return;
+    }
+    {
+        Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+        queue->mExit = true;
+        queue->mCond.broadcast();
+    }
+    mOutputThread.join();
+    mOutputThread = std::thread();
+}
+
+void SimpleC2Component::outputThreadLoop() {
+    androidSetThreadPriority(0, ANDROID_PRIORITY_VIDEO);
+    Mutexed<OutputQueue>::Locked queue(mOutputQueue);
+    while (true) {
+        // Exit only once all output is out.
+        if (queue->mBatches.empty()) {
+            if (queue->mExit) {
+                break;
+            }
+            queue.waitForCondition(queue->mCond);
+            continue;
+        }
+        OutputBatch batch = std::move(queue->mBatches.front());
+        queue->mBatches.pop_front();
+        queue->mRunning = true;
+        queue.unlock();
+        for (const std::function<void()> &job : batch) {
+            job();
+        }
+        batch.clear();
+        queue.lock();
+        queue->mRunning = false;
+        queue->mCond.broadcast();
+    }
+}
+
 bool SimpleC2Component::processQueue() {
     std::unique_ptr<C2Work> work;
     uint64_t generation;
@@ -457,6 +585,7 @@ bool SimpleC2Component::processQueue() {
     }
     if (isFlushPending) {
         ALOGV("processing pending flush");
+        waitForOutput();
         c2_status_t err = onFlush_sm();
         if (err != C2_OK) {
             ALOGD("flush err: %d", err);
@@ -513,6 +642,7 @@ bool SimpleC2Component::processQueue() {
 
     if (!work) {
         c2_status_t err = drain(drainMode, mOutputBlockPool);
+        releaseOutput();
         if (err != C2_OK) {
             Mutexed<ExecState>::Locked state(mExecState);
             std::shared_ptr<C2Component::Listener> listener = state->mListener;
@@ -553,19 +683,14 @@ bool SimpleC2Component::processQueue() {
         work->result = C2_NOT_FOUND;
         queue.unlock();
 
-        Mutexed<ExecState>::Locked state(mExecState);
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        returnWork(std::move(work));
+        releaseOutput();
         return hasQueuedWork;
     }
     if (work->workletsProcessed != 0u) {
         queue.unlock();
-        Mutexed<ExecState>::Locked state(mExecState);
         ALOGV("returning this work");
-        std::shared_ptr<C2Component::Listener> listener = state->mListener;
-        state.unlock();
-        listener->onWorkDone_nb(shared_from_this(), vec(work));
+        returnWork(std::move(work));
     } else {
         ALOGV("queue pending work");
         work->input.buffers.clear();
@@ -588,6 +713,8 @@ bool SimpleC2Component::processQueue() {
             listener->onWorkDone_nb(shared_from_this(), vec(unexpected));
         }
     }
+    // Pending work goes in before its output jobs may finish it.
+    releaseOutput();
     return hasQueuedWork;
 }
 
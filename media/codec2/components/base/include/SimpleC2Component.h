@@ -18,7 +18,9 @@
 #define SIMPLE_C2_COMPONENT_H_
 
 #include <list>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <C2Component.h>
 
@@ -139,6 +141,41 @@ protected:
             std::function<void(const std::unique_ptr<C2Work> &)> fillWork);
 
 
+    /**
+     * Opt in to pipelined processing.
+     *
+     * The output stage of up to |depth| - 1 works then runs on a separate output
+     * thread, while the next work is processed. See queueOutput(). Call this
+     * from the constructor of the component. The
+     * debug.stagefright.c2_sw_pipeline_depth property overrides |depth|; a depth
+     * of 1 processes one work at a time.
+     *
+     * \param[in]   depth   the maximum number of works in flight.
+     */
+    void setPipelineDepth(uint32_t depth);
+
+    /**
+     * Whether the component runs pipelined, i.e. with a pipeline depth above 1
+     * once the property override is applied. Only valid once initialized.
+     */
+    bool isPipelined() const;
+
+    /**
+     * Queue the output stage of the work under processing, e.g. copying a
+     * decoded frame into an output block and finishing the corresponding work.
+     *
+     * When pipelining, |job| runs on the output thread, after the jobs queued
+     * before it, once process() or drain() has returned and the current work
+     * has been returned or made pending. finish() and cloneAndSend() called from
+     * process() or drain() are deferred the same way, so that works are
+     * returned in order. |job| must therefore not refer to the current work,
+     * nor to decoder state that the next process() call may change. Otherwise
+     * |job| runs right away.
+     *
+     * \param[in]   job     the output stage to run.
+     */
+    void queueOutput(std::function<void()> job);
+
     std::shared_ptr<C2Buffer> createLinearBuffer(
             const std::shared_ptr<C2LinearBlock> &block, size_t offset, size_t size);
 
@@ -232,6 +269,35 @@ private:
     class BlockingBlockPool;
     std::shared_ptr<BlockingBlockPool> mOutputBlockPool;
 
+    // Output jobs of a processed work or drain, in order.
+    typedef std::vector<std::function<void()>> OutputBatch;
+
+    struct OutputQueue {
+        std::list<OutputBatch> mBatches;
+        bool mRunning = false;  // a batch is running on the output thread
+        bool mExit = false;
+        Condition mCond;
+    };
+
+    // Whether output is deferred to the output thread, false on that thread.
+    bool isOutputDeferred() const;
+    // Returns a processed work to the listener, after its output jobs if deferred.
+    void returnWork(std::unique_ptr<C2Work> work);
+    // Hands the jobs queued while processing to the output thread, waiting
+    // while the pipeline is full.
+    void releaseOutput();
+    // Waits until all output jobs have run.
+    void waitForOutput();
+    void startOutputThread();
+    void stopOutputThread();
+    void outputThreadLoop();
+
+    uint32_t mRequestedPipelineDepth;
+    uint32_t mPipelineDepth;    // set on init; 1 without pipelining
+    OutputBatch mPendingOutput;  // jobs queued while processing, looper thread only
+    Mutexed<OutputQueue> mOutputQueue;
+    std::thread mOutputThread;
+
     SimpleC2Component() = delete;
 };
 
@@ -0,0 +1,259 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Benchmark of a software Codec2 decoder with and without pipelined output.
+ *
+ * How to run the benchmark:
+ *
+ * 1. Push IVF streams to /data/local/tmp/C2SoftDecoderBenchmark/, e.g. encoded with
+ *      $ ffmpeg -i input.mp4 -c:v libvpx-vp9 -an bbb_1920x1080_vp9.ivf
+ *
+ * 2. Compile the benchmark and sync to device:
+ *      $ mm -j72 && adb sync
+ *
+ * 3. Run:
+ *      $ adb shell /data/benchmarktest64/C2SoftVp9DecBenchmark/C2SoftVp9DecBenchmark
+ *
+ * The argument of each run is the pipeline depth, 1 decoding one work at a time.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "C2SoftDecoderBenchmark"
+#include <log/log.h>
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <C2AllocatorIon.h>
+#include <C2Buffer.h>
+#include <C2BufferPriv.h>
+#include <C2Component.h>
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <benchmark/benchmark.h>
+#include <cutils/properties.h>
+
+using namespace android;
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace {
+
+const std::string kAssetDirectory = "/data/local/tmp/C2SoftDecoderBenchmark/";
+constexpr size_t kMaxWorksInFlight = 8;
+constexpr std::chrono::seconds kTimeout(10);
+
+// Reads the frames of an IVF file.
+bool readIvfFrames(const std::string& path, std::vector<std::vector<uint8_t>>* frames) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  uint8_t header[32];
+  bool ok = fread(header, sizeof(header), 1, file) == 1 && memcmp(header, "DKIF", 4) == 0;
+  while (ok) {
+    uint8_t frameHeader[12];
+    if (fread(frameHeader, sizeof(frameHeader), 1, file) != 1) {
+      break;
+    }
+    const uint32_t size = frameHeader[0] | frameHeader[1] << 8 | frameHeader[2] << 16 |
+                          (uint32_t)frameHeader[3] << 24;
+    std::vector<uint8_t> frame(size);
+    ok = fread(frame.data(), size, 1, file) == 1;
+    frames->push_back(std::move(frame));
+  }
+  fclose(file);
+  return ok && !frames->empty();
+}
+
+struct CodecListener : public C2Component::Listener {
+  void onWorkDone_nb(std::weak_ptr<C2Component> comp,
+                     std::list<std::unique_ptr<C2Work>> workItems) override {
+    (void)comp;
+    std::lock_guard<std::mutex> lock(mLock);
+    for (std::unique_ptr<C2Work>& work : workItems) {
+      if (!work->worklets.empty()) {
+        const C2FrameData& output = work->worklets.front()->output;
+        mOutputFrames += output.buffers.size();
+        mEos |= (output.flags & C2FrameData::FLAG_END_OF_STREAM) != 0;
+      }
+      mError |= work->result != C2_OK;
+      work->input.buffers.clear();
+      work->worklets.clear();
+      mWorks.push_back(std::move(work));
+    }
+    mCondition.notify_all();
+  }
+
+  void onTripped_nb(std::weak_ptr<C2Component> comp,
+                    std::vector<std::shared_ptr<C2SettingResult>> settingResults) override {
+    (void)comp;
+    (void)settingResults;
+  }
+
+  void onError_nb(std::weak_ptr<C2Component> comp, uint32_t errorCode) override {
+    (void)comp;
+    ALOGE("component error %u", errorCode);
+    std::lock_guard<std::mutex> lock(mLock);
+    mError = true;
+    mCondition.notify_all();
+  }
+
+  std::mutex mLock;
+  std::condition_variable mCondition;
+  std::list<std::unique_ptr<C2Work>> mWorks;
+  size_t mOutputFrames = 0;
+  bool mEos = false;
+  bool mError = false;
+};
+
+// Decodes |frames| once, returns the number of output frames or -1 on error.
+int64_t decode(const std::shared_ptr<C2Component>& component,
+               const std::shared_ptr<C2BlockPool>& linearPool,
+               const std::vector<std::vector<uint8_t>>& frames) {
+  std::shared_ptr<CodecListener> listener = std::make_shared<CodecListener>();
+  for (size_t i = 0; i < kMaxWorksInFlight; ++i) {
+    listener->mWorks.emplace_back(new C2Work);
+  }
+  if (component->setListener_vb(listener, C2_MAY_BLOCK) != C2_OK ||
+      component->start() != C2_OK) {
+    return -1;
+  }
+
+  for (size_t i = 0; i < frames.size(); ++i) {
+    std::unique_ptr<C2Work> work;
+    {
+      std::unique_lock<std::mutex> lock(listener->mLock);
+      if (!listener->mCondition.wait_for(lock, kTimeout, [&listener] {
+            return !listener->mWorks.empty() || listener->mError;
+          }) || listener->mError) {
+        break;
+      }
+      work = std::move(listener->mWorks.front());
+      listener->mWorks.pop_front();
+    }
+
+    std::shared_ptr<C2LinearBlock> block;
+    if (linearPool->fetchLinearBlock(frames[i].size(),
+                                     {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                                     &block) != C2_OK) {
+      break;
+    }
+    C2WriteView view = block->map().get();
+    if (view.error() != C2_OK) {
+      break;
+    }
+    memcpy(view.base(), frames[i].data(), frames[i].size());
+
+    work->input.flags = i + 1 == frames.size() ? C2FrameData::FLAG_END_OF_STREAM
+                                               : (C2FrameData::flags_t)0;
+    work->input.ordinal.timestamp = i;
+    work->input.ordinal.frameIndex = i;
+    work->input.buffers.clear();
+    work->input.buffers.emplace_back(
+        C2Buffer::CreateLinearBuffer(block->share(0, frames[i].size(), C2Fence())));
+    work->worklets.clear();
+    work->worklets.emplace_back(new C2Worklet);
+    work->result = C2_OK;
+
+    std::list<std::unique_ptr<C2Work>> items;
+    items.push_back(std::move(work));
+    if (component->queue_nb(&items) != C2_OK) {
+      break;
+    }
+  }
+
+  bool eos;
+  {
+    std::unique_lock<std::mutex> lock(listener->mLock);
+    eos = listener->mCondition.wait_for(lock, kTimeout, [&listener] {
+      return listener->mEos || listener->mError;
+    }) && !listener->mError;
+  }
+  component->stop();
+  component->reset();
+  return eos ? listener->mOutputFrames : -1;
+}
+
+void BM_Decode(benchmark::State& state, const std::string& fileName) {
+  std::vector<std::vector<uint8_t>> frames;
+  if (!readIvfFrames(kAssetDirectory + fileName, &frames)) {
+    state.SkipWithError("Unable to read the IVF file");
+    return;
+  }
+
+  // Read by the component when it starts.
+  const std::string depth = std::to_string(state.range(0));
+  property_set("debug.stagefright.c2_sw_pipeline_depth", depth.c_str());
+
+  std::shared_ptr<C2Allocator> linearAllocator;
+  if (GetCodec2PlatformAllocatorStore()->fetchAllocator(C2AllocatorStore::DEFAULT_LINEAR,
+                                                        &linearAllocator) != C2_OK) {
+    state.SkipWithError("Unable to get the linear allocator");
+    return;
+  }
+  std::shared_ptr<C2BlockPool> linearPool =
+      std::make_shared<C2PooledBlockPool>(linearAllocator, 0 /* localId */);
+
+  C2ComponentFactory* factory = CreateCodec2Factory();
+  std::shared_ptr<C2Component> component;
+  if (factory->createComponent(0 /* id */, &component, std::default_delete<C2Component>()) !=
+      C2_OK) {
+    DestroyCodec2Factory(factory);
+    state.SkipWithError("Unable to create the component");
+    return;
+  }
+
+  int64_t outputFrames = 0;
+  for (auto _ : state) {
+    const int64_t decoded = decode(component, linearPool, frames);
+    if (decoded < 0) {
+      state.SkipWithError("Decoding failed");
+      break;
+    }
+    outputFrames += decoded;
+  }
+  state.counters["FrameRate"] = benchmark::Counter(outputFrames, benchmark::Counter::kIsRate);
+
+  component->release();
+  component.reset();
+  DestroyCodec2Factory(factory);
+  property_set("debug.stagefright.c2_sw_pipeline_depth", "");
+}
+
+}  // namespace
+
+#define DECODER_BENCHMARK(fileName)                                  \
+  BENCHMARK_CAPTURE(BM_Decode, fileName, #fileName ".ivf")           \
+      ->Arg(1) /* <-- no pipelining */                               \
+      ->Arg(2)                                                       \
+      ->Arg(3)                                                       \
+      ->UseRealTime()                                                \
+      ->MeasureProcessCPUTime()                                      \
+      ->Unit(benchmark::kMillisecond)
+
+DECODER_BENCHMARK(bbb_1920x1080_vp9);
+DECODER_BENCHMARK(bbb_1280x720_vp9);
+
+BENCHMARK_MAIN();
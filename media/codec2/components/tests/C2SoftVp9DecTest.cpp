@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Decodes a VP9 stream with the software decoder at several pipeline depths,
+ * and checks that every work is returned, in order, with the frame libvpx
+ * decodes.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "C2SoftVp9DecTest"
+#include <log/log.h>
+
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <C2Buffer.h>
+#include <C2Component.h>
+#include <C2ComponentFactory.h>
+#include <C2Config.h>
+#include <C2PlatformSupport.h>
+#include <cutils/properties.h>
+#include <gtest/gtest.h>
+#include <vpx/vp8cx.h>
+#include <vpx/vp8dx.h>
+#include <vpx/vpx_decoder.h>
+#include <vpx/vpx_encoder.h>
+
+using namespace android;
+
+extern "C" ::C2ComponentFactory* CreateCodec2Factory();
+extern "C" void DestroyCodec2Factory(::C2ComponentFactory* factory);
+
+namespace {
+
+constexpr uint32_t kWidth = 176;
+constexpr uint32_t kHeight = 144;
+constexpr size_t kFrames = 30;
+constexpr std::chrono::seconds kTimeout(10);
+
+// Y, U and V planes of a decoded frame, without padding.
+using Frame = std::vector<uint8_t>;
+
+// Encodes moving gradients, one compressed frame per input frame.
+bool encodeStream(std::vector<std::vector<uint8_t>>* stream) {
+  vpx_codec_enc_cfg_t cfg;
+  if (vpx_codec_enc_config_default(vpx_codec_vp9_cx(), &cfg, 0) != VPX_CODEC_OK) {
+    return false;
+  }
+  cfg.g_w = kWidth;
+  cfg.g_h = kHeight;
+  cfg.g_timebase.num = 1;
+  cfg.g_timebase.den = 30;
+  cfg.g_lag_in_frames = 0;  // no hidden alt-ref frames
+  cfg.kf_max_dist = 10;
+  vpx_codec_ctx_t codec;
+  if (vpx_codec_enc_init(&codec, vpx_codec_vp9_cx(), &cfg, 0) != VPX_CODEC_OK) {
+    return false;
+  }
+
+  vpx_image_t image;
+  vpx_img_alloc(&image, VPX_IMG_FMT_I420, kWidth, kHeight, 1);
+  bool ok = true;
+  for (size_t i = 0; ok && i < kFrames; ++i) {
+    for (int plane = 0; plane < 3; ++plane) {
+      const uint32_t width = plane == 0 ? kWidth : (kWidth + 1) / 2;
+      const uint32_t height = plane == 0 ? kHeight : (kHeight + 1) / 2;
+      for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* row = image.planes[plane] + y * image.stride[plane];
+        for (uint32_t x = 0; x < width; ++x) {
+          row[x] = (uint8_t)(x * (plane + 1) + y * 2 + i * 5);
+        }
+      }
+    }
+    ok = vpx_codec_encode(&codec, &image, i, 1, 0, VPX_DL_REALTIME) == VPX_CODEC_OK;
+    vpx_codec_iter_t iter = nullptr;
+    const vpx_codec_cx_pkt_t* packet;
+    while (ok && (packet = vpx_codec_get_cx_data(&codec, &iter)) != nullptr) {
+      if (packet->kind == VPX_CODEC_CX_FRAME_PKT) {
+        const uint8_t* data = (const uint8_t*)packet->data.frame.buf;
+        stream->emplace_back(data, data + packet->data.frame.sz);
+      }
+    }
+  }
+  vpx_img_free(&image);
+  vpx_codec_destroy(&codec);
+  return ok && stream->size() == kFrames;
+}
+
+// Decodes |stream| with libvpx directly.
+bool decodeReference(const std::vector<std::vector<uint8_t>>& stream, std::vector<Frame>* frames) {
+  vpx_codec_ctx_t codec;
+  if (vpx_codec_dec_init(&codec, vpx_codec_vp9_dx(), nullptr, 0) != VPX_CODEC_OK) {
+    return false;
+  }
+  bool ok = true;
+  for (size_t i = 0; ok && i < stream.size(); ++i) {
+    ok = vpx_codec_decode(&codec, stream[i].data(), stream[i].size(), nullptr, 0) ==
+         VPX_CODEC_OK;
+    vpx_codec_iter_t iter = nullptr;
+    vpx_image_t* image;
+    while (ok && (image = vpx_codec_get_frame(&codec, &iter)) != nullptr) {
+      Frame frame;
+      for (int plane = 0; plane < 3; ++plane) {
+        const uint32_t width = plane == 0 ? image->d_w : (image->d_w + 1) / 2;
+        const uint32_t height = plane == 0 ? image->d_h : (image->d_h + 1) / 2;
+        for (uint32_t y = 0; y < height; ++y) {
+          const uint8_t* row = image->planes[plane] + y * image->stride[plane];
+          frame.insert(frame.end(), row, row + width);
+        }
+      }
+      frames->push_back(std::move(frame));
+    }
+  }
+  vpx_codec_destroy(&codec);
+  return ok;
+}
+
+bool readFrame(const std::shared_ptr<C2Buffer>& buffer, Frame* frame) {
+  if (buffer->data().type() != C2BufferData::GRAPHIC ||
+      buffer->data().graphicBlocks().size() != 1) {
+    return false;
+  }
+  const C2ConstGraphicBlock& block = buffer->data().graphicBlocks().front();
+  C2GraphicView view = block.map().get();
+  if (view.error() != C2_OK) {
+    return false;
+  }
+  const C2PlanarLayout& layout = view.layout();
+  const uint32_t width = block.crop().width;
+  const uint32_t height = block.crop().height;
+  for (uint32_t plane : {C2PlanarLayout::PLANE_Y, C2PlanarLayout::PLANE_U,
+                         C2PlanarLayout::PLANE_V}) {
+    const C2PlaneInfo& info = layout.planes[plane];
+    const uint32_t planeWidth = (width + info.colSampling - 1) / info.colSampling;
+    const uint32_t planeHeight = (height + info.rowSampling - 1) / info.rowSampling;
+    for (uint32_t y = 0; y < planeHeight; ++y) {
+      const uint8_t* row = view.data()[plane] + y * info.rowInc;
+      for (uint32_t x = 0; x < planeWidth; ++x) {
+        frame->push_back(row[x * info.colInc]);
+      }
+    }
+  }
+  return true;
+}
+
+struct CodecListener : public C2Component::Listener {
+  void onWorkDone_nb(std::weak_ptr<C2Component> comp,
+                     std::list<std::unique_ptr<C2Work>> workItems) override {
+    (void)comp;
+    std::lock_guard<std::mutex> lock(mLock);
+    for (std::unique_ptr<C2Work>& work : workItems) {
+      mEos |= !work->worklets.empty() &&
+              (work->worklets.front()->output.flags & C2FrameData::FLAG_END_OF_STREAM) != 0;
+      mWorks.push_back(std::move(work));
+    }
+    mCondition.notify_all();
+  }
+
+  void onTripped_nb(std::weak_ptr<C2Component> comp,
+                    std::vector<std::shared_ptr<C2SettingResult>> settingResults) override {
+    (void)comp;
+    (void)settingResults;
+  }
+
+  void onError_nb(std::weak_ptr<C2Component> comp, uint32_t errorCode) override {
+    (void)comp;
+    ALOGE("component error %u", errorCode);
+    std::lock_guard<std::mutex> lock(mLock);
+    mError = true;
+    mCondition.notify_all();
+  }
+
+  std::mutex mLock;
+  std::condition_variable mCondition;
+  std::list<std::unique_ptr<C2Work>> mWorks;
+  bool mEos = false;
+  bool mError = false;
+};
+
+class C2SoftVp9DecTest : public ::testing::TestWithParam<int32_t> {
+ public:
+  void SetUp() override {
+    ASSERT_TRUE(encodeStream(&mStream));
+    ASSERT_TRUE(decodeReference(mStream, &mReference));
+    ASSERT_EQ(mReference.size(), kFrames);
+
+    // Read by the component when it starts.
+    property_set("debug.stagefright.c2_sw_pipeline_depth", std::to_string(GetParam()).c_str());
+    mFactory = CreateCodec2Factory();
+    ASSERT_NE(mFactory, nullptr);
+    ASSERT_EQ(mFactory->createComponent(0 /* id */, &mComponent,
+                                        std::default_delete<C2Component>()),
+              C2_OK);
+    ASSERT_EQ(GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, mComponent, &mLinearPool), C2_OK);
+  }
+
+  void TearDown() override {
+    if (mComponent) {
+      mComponent->release();
+      mComponent.reset();
+    }
+    if (mFactory) {
+      DestroyCodec2Factory(mFactory);
+    }
+    property_set("debug.stagefright.c2_sw_pipeline_depth", "");
+  }
+
+  std::unique_ptr<C2Work> makeWork(size_t index) {
+    std::shared_ptr<C2LinearBlock> block;
+    const std::vector<uint8_t>& frame = mStream[index];
+    if (mLinearPool->fetchLinearBlock(frame.size(),
+                                      {C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE},
+                                      &block) != C2_OK) {
+      return nullptr;
+    }
+    C2WriteView view = block->map().get();
+    if (view.error() != C2_OK) {
+      return nullptr;
+    }
+    memcpy(view.base(), frame.data(), frame.size());
+
+    std::unique_ptr<C2Work> work(new C2Work);
+    work->input.flags = index + 1 == mStream.size() ? C2FrameData::FLAG_END_OF_STREAM
+                                                    : (C2FrameData::flags_t)0;
+    work->input.ordinal.timestamp = index;
+    work->input.ordinal.frameIndex = index;
+    work->input.buffers.emplace_back(
+        C2Buffer::CreateLinearBuffer(block->share(0, frame.size(), C2Fence())));
+    work->worklets.emplace_back(new C2Worklet);
+    return work;
+  }
+
+  std::vector<std::vector<uint8_t>> mStream;
+  std::vector<Frame> mReference;
+  C2ComponentFactory* mFactory = nullptr;
+  std::shared_ptr<C2Component> mComponent;
+  std::shared_ptr<C2BlockPool> mLinearPool;
+};
+
+TEST_P(C2SoftVp9DecTest, ReturnsEveryWorkInOrder) {
+  std::shared_ptr<CodecListener> listener = std::make_shared<CodecListener>();
+  ASSERT_EQ(mComponent->setListener_vb(listener, C2_MAY_BLOCK), C2_OK);
+  ASSERT_EQ(mComponent->start(), C2_OK);
+
+  for (size_t i = 0; i < mStream.size(); ++i) {
+    std::unique_ptr<C2Work> work = makeWork(i);
+    ASSERT_TRUE(work);
+    std::list<std::unique_ptr<C2Work>> items;
+    items.push_back(std::move(work));
+    ASSERT_EQ(mComponent->queue_nb(&items), C2_OK);
+  }
+
+  std::list<std::unique_ptr<C2Work>> works;
+  {
+    std::unique_lock<std::mutex> lock(listener->mLock);
+    EXPECT_TRUE(listener->mCondition.wait_for(lock, kTimeout, [&listener] {
+      return listener->mWorks.size() == kFrames || listener->mError;
+    })) << "received " << listener->mWorks.size() << " works";
+    EXPECT_FALSE(listener->mError);
+    EXPECT_TRUE(listener->mEos);
+    works.swap(listener->mWorks);
+  }
+  mComponent->stop();
+
+  ASSERT_EQ(works.size(), kFrames);
+  uint64_t index = 0;
+  for (const std::unique_ptr<C2Work>& work : works) {
+    SCOPED_TRACE("frame " + std::to_string(index));
+    ASSERT_EQ(work->input.ordinal.frameIndex.peekull(), index);
+    ASSERT_EQ(work->result, C2_OK);
+    ASSERT_EQ(work->workletsProcessed, 1u);
+    const C2FrameData& output = work->worklets.front()->output;
+    ASSERT_EQ(output.ordinal.frameIndex.peekull(), index);
+    ASSERT_EQ(output.buffers.size(), 1u);
+    Frame frame;
+    ASSERT_TRUE(readFrame(output.buffers.front(), &frame));
+    EXPECT_TRUE(frame == mReference[index]);
+    ++index;
+  }
+}
+
+// Depth 1 processes one work at a time.
+INSTANTIATE_TEST_SUITE_P(PipelineDepth, C2SoftVp9DecTest, ::testing::Values(1, 2, 3));
+
+}  // namespace
@@ -19,6 +19,8 @@
 #include <log/log.h>
 
 #include <algorithm>
+#include <list>
+#include <mutex>
 
 #include <media/stagefright/foundation/AUtils.h>
 #include <media/stagefright/foundation/MediaDefs.h>
@@ -334,6 +336,86 @@ bool C2SoftVpxDec::ConverterThread::threadLoop() {
     return true;
 }
 
+class C2SoftVpxDec::FrameBufferPool : public std::enable_shared_from_this<FrameBufferPool> {
+public:
+    // vpx_get_frame_buffer_cb_fn_t and vpx_release_frame_buffer_cb_fn_t
+    static int GetFrameBuffer(void *priv, size_t minSize, vpx_codec_frame_buffer_t *fb);
+    static int ReleaseFrameBuffer(void *priv, vpx_codec_frame_buffer_t *fb);
+
+    // Keeps the frame buffer of a decoded image from being reused until the
+    // returned reference is released.
+    std::shared_ptr<void> hold(void *fbPriv);
+
+private:
+    struct Buffer {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size = 0;
+        int32_t refs = 0;   // the decoder's and the output jobs'
+    };
+
+    std::mutex mLock;
+    std::list<Buffer> mBuffers;  // the decoder refers to them by address
+};
+
+// static
+int C2SoftVpxDec::FrameBufferPool::GetFrameBuffer(
+        void *priv, size_t minSize, vpx_codec_frame_buffer_t *fb) {
+    FrameBufferPool *pool = static_cast<FrameBufferPool *>(priv);
+    std::lock_guard<std::mutex> lock(pool->mLock);
+
+    // Prefer a free buffer that is large enough, else grow a free one.
+    Buffer *buffer = nullptr;
+    for (Buffer &candidate : pool->mBuffers) {
+        if (candidate.refs == 0 && (buffer == nullptr || candidate.size >= minSize)) {
+            buffer = &candidate;
+            if (candidate.size >= minSize) {
+                break;
+            }
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = &pool->mBuffers.emplace_back();
+    }
+    if (buffer->size < minSize) {
+        // libvpx requires new frame buffers to be zeroed.
+        buffer->data.reset(new (std::nothrow) uint8_t[minSize]());
+        buffer->size = buffer->data ? minSize : 0;
+        if (!buffer->data) {
+            ALOGE("failed to allocate a frame buffer of %zu bytes", minSize);
+            return -1;
+        }
+    }
+    buffer->refs = 1;
+    fb->data = buffer->data.get();
+    fb->size = buffer->size;
+    fb->priv = buffer;
+    return 0;
+}
+
+// static
+int C2SoftVpxDec::FrameBufferPool::ReleaseFrameBuffer(
+        void *priv, vpx_codec_frame_buffer_t *fb) {
+    FrameBufferPool *pool = static_cast<FrameBufferPool *>(priv);
+    Buffer *buffer = static_cast<Buffer *>(fb->priv);
+    if (buffer != nullptr) {
+        std::lock_guard<std::mutex> lock(pool->mLock);
+        --buffer->refs;
+    }
+    return 0;
+}
+
+std::shared_ptr<void> C2SoftVpxDec::FrameBufferPool::hold(void *fbPriv) {
+    Buffer *buffer = static_cast<Buffer *>(fbPriv);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        ++buffer->refs;
+    }
+    return std::shared_ptr<void>(buffer, [pool = shared_from_this()](void *fbPriv) {
+        std::lock_guard<std::mutex> lock(pool->mLock);
+        --static_cast<Buffer *>(fbPriv)->refs;
+    });
+}
+
 C2SoftVpxDec::C2SoftVpxDec(
         const char *name,
         c2_node_id_t id,
@@ -342,7 +424,12 @@ C2SoftVpxDec::C2SoftVpxDec(
       mIntf(intfImpl),
       mCodecCtx(nullptr),
       mCoreCount(1),
-      mQueue(new Mutexed<ConversionQueue>) {
+      mQueue(new Mutexed<ConversionQueue>),
+      mCurrentWorkQueued(false) {
+#ifdef VP9
+    // Copy out a frame while decoding the next one.
+    setPipelineDepth(2u);
+#endif
 }
 
 C2SoftVpxDec::~C2SoftVpxDec() {
@@ -447,6 +534,15 @@ status_t C2SoftVpxDec::initDecoder() {
     }
 
     if (mMode == MODE_VP9) {
+        // Output jobs copy decoded frames out of these buffers.
+        mFrameBufferPool = std::make_shared<FrameBufferPool>();
+        if ((vpx_err = vpx_codec_set_frame_buffer_functions(
+                     mCodecCtx, FrameBufferPool::GetFrameBuffer,
+                     FrameBufferPool::ReleaseFrameBuffer, mFrameBufferPool.get()))) {
+            ALOGW("failed to set frame buffer functions (%d), output is not pipelined", vpx_err);
+            mFrameBufferPool.reset();
+        }
+
         using namespace std::string_literals;
         for (int i = 0; i < mCoreCount; ++i) {
             sp<ConverterThread> thread(new ConverterThread(mQueue));
@@ -467,6 +563,7 @@ status_t C2SoftVpxDec::destroyDecoder() {
         delete mCodecCtx;
         mCodecCtx = nullptr;
     }
+    mFrameBufferPool.reset();
     bool running = true;
     for (const sp<ConverterThread> &thread : mConverterThreads) {
         thread->requestExit();
@@ -499,9 +596,8 @@ void fillEmptyWork(const std::unique_ptr<C2Work> &work) {
 }
 
 void C2SoftVpxDec::finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
-                           const std::shared_ptr<C2GraphicBlock> &block) {
-    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block,
-                                                           C2Rect(mWidth, mHeight));
+                           const std::shared_ptr<C2GraphicBlock> &block, const C2Rect &crop) {
+    std::shared_ptr<C2Buffer> buffer = createGraphicBuffer(block, crop);
     auto fillWork = [buffer, index, intf = this->mIntf](
             const std::unique_ptr<C2Work> &work) {
         uint32_t flags = 0;
@@ -551,6 +647,7 @@ void C2SoftVpxDec::process(
     // Initialize output work
     work->result = C2_OK;
     work->workletsProcessed = 0u;
+    mCurrentWorkQueued = false;
     work->worklets.front()->output.configUpdate.clear();
     work->worklets.front()->output.flags = work->input.flags;
 
@@ -807,42 +904,77 @@ status_t C2SoftVpxDec::outputBuffer(
         return UNKNOWN_ERROR;
     }
 
+    ALOGV("provided (%dx%d) required (%dx%d), out frameindex %lld",
+           block->width(), block->height(), mWidth, mHeight,
+           ((c2_cntr64_t *)img->user_priv)->peekll());
+
+    // user_priv points into the work that was decoded, so read it now.
+    uint64_t index = ((c2_cntr64_t *)img->user_priv)->peekull();
+    if (isPipelined() && mFrameBufferPool && img->fb_priv) {
+        // Copy the frame out while the next one is decoded. The frame buffer
+        // must not be reused meanwhile, and the image struct is only valid
+        // until the next decode.
+        std::shared_ptr<void> frameBuffer = mFrameBufferPool->hold(img->fb_priv);
+        if (c2_cntr64_t(index) == work->input.ordinal.frameIndex) {
+            mCurrentWorkQueued = true;
+        }
+        queueOutput([this, image = *img, frameBuffer, width = mWidth, height = mHeight,
+                     format, block, index] {
+            if (copyImage(image, width, height, format, block) != C2_OK) {
+                finish(index, [](const std::unique_ptr<C2Work> &work) {
+                    fillEmptyWork(work);
+                    work->result = C2_CORRUPTED;
+                });
+                return;
+            }
+            finishWork(index, nullptr, block, C2Rect(width, height));
+        });
+        return OK;
+    }
+
+    err = copyImage(*img, mWidth, mHeight, format, block);
+    if (err != C2_OK) {
+        work->result = err;
+        return UNKNOWN_ERROR;
+    }
+    finishWork(index, work, std::move(block), C2Rect(mWidth, mHeight));
+    return OK;
+}
+
+c2_status_t C2SoftVpxDec::copyImage(
+        const vpx_image_t &img, uint32_t width, uint32_t height, uint32_t format,
+        const std::shared_ptr<C2GraphicBlock> &block) {
     C2GraphicView wView = block->map().get();
     if (wView.error()) {
         ALOGE("graphic view map failed %d", wView.error());
-        work->result = C2_CORRUPTED;
-        return UNKNOWN_ERROR;
+        return C2_CORRUPTED;
     }
 
-    ALOGV("provided (%dx%d) required (%dx%d), out frameindex %lld",
-           block->width(), block->height(), mWidth, mHeight,
-           ((c2_cntr64_t *)img->user_priv)->peekll());
-
     uint8_t *dstY = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_Y]);
     uint8_t *dstU = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_U]);
     uint8_t *dstV = const_cast<uint8_t *>(wView.data()[C2PlanarLayout::PLANE_V]);
 
-    size_t srcYStride = img->stride[VPX_PLANE_Y];
-    size_t srcUStride = img->stride[VPX_PLANE_U];
-    size_t srcVStride = img->stride[VPX_PLANE_V];
+    size_t srcYStride = img.stride[VPX_PLANE_Y];
+    size_t srcUStride = img.stride[VPX_PLANE_U];
+    size_t srcVStride = img.stride[VPX_PLANE_V];
     C2PlanarLayout layout = wView.layout();
     size_t dstYStride = layout.planes[C2PlanarLayout::PLANE_Y].rowInc;
     size_t dstUVStride = layout.planes[C2PlanarLayout::PLANE_U].rowInc;
 
-    if (img->fmt == VPX_IMG_FMT_I42016) {
-        const uint16_t *srcY = (const uint16_t *)img->planes[VPX_PLANE_Y];
-        const uint16_t *srcU = (const uint16_t *)img->planes[VPX_PLANE_U];
-        const uint16_t *srcV = (const uint16_t *)img->planes[VPX_PLANE_V];
+    if (img.fmt == VPX_IMG_FMT_I42016) {
+        const uint16_t *srcY = (const uint16_t *)img.planes[VPX_PLANE_Y];
+        const uint16_t *srcU = (const uint16_t *)img.planes[VPX_PLANE_U];
+        const uint16_t *srcV = (const uint16_t *)img.planes[VPX_PLANE_V];
 
         if (format == HAL_PIXEL_FORMAT_RGBA_1010102) {
             Mutexed<ConversionQueue>::Locked queue(*mQueue);
             size_t i = 0;
             constexpr size_t kHeight = 64;
-            for (; i < mHeight; i += kHeight) {
+            for (; i < height; i += kHeight) {
                 queue->entries.push_back(
                         [dstY, srcY, srcU, srcV,
                          srcYStride, srcUStride, srcVStride, dstYStride,
-                         width = mWidth, height = std::min(mHeight - i, kHeight)] {
+                         width, height = std::min(height - i, kHeight)] {
                             convertYUV420Planar16ToY410(
                                     (uint32_t *)dstY, srcY, srcU, srcV, srcYStride / 2,
                                     srcUStride / 2, srcVStride / 2, dstYStride / sizeof(uint32_t),
@@ -864,22 +996,21 @@ status_t C2SoftVpxDec::outputBuffer(
                                                 srcY, srcU, srcV,
                                                 srcYStride / 2, srcUStride / 2, srcVStride / 2,
                                                 dstYStride, dstUVStride,
-                                                mWidth, mHeight);
+                                                width, height);
         }
     } else {
-        const uint8_t *srcY = (const uint8_t *)img->planes[VPX_PLANE_Y];
-        const uint8_t *srcU = (const uint8_t *)img->planes[VPX_PLANE_U];
-        const uint8_t *srcV = (const uint8_t *)img->planes[VPX_PLANE_V];
+        const uint8_t *srcY = (const uint8_t *)img.planes[VPX_PLANE_Y];
+        const uint8_t *srcU = (const uint8_t *)img.planes[VPX_PLANE_U];
+        const uint8_t *srcV = (const uint8_t *)img.planes[VPX_PLANE_V];
 
         copyOutputBufferToYuvPlanarFrame(
                 dstY, dstU, dstV,
                 srcY, srcU, srcV,
                 srcYStride, srcUStride, srcVStride,
                 dstYStride, dstUVStride,
-                mWidth, mHeight);
+                width, height);
     }
-    finishWork(((c2_cntr64_t *)img->user_priv)->peekull(), work, std::move(block));
-    return OK;
+    return C2_OK;
 }
 
 c2_status_t C2SoftVpxDec::drainInternal(
@@ -898,8 +1029,9 @@ c2_status_t C2SoftVpxDec::drainInternal(
     while (outputBuffer(pool, work) == OK) {
     }
 
+    // An output job may still finish the work.
     if (drainMode == DRAIN_COMPONENT_WITH_EOS &&
-            work && work->workletsProcessed == 0u) {
+            work && work->workletsProcessed == 0u && !mCurrentWorkQueued) {
         fillEmptyWork(work);
     }
 
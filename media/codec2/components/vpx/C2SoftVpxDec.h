@@ -51,6 +51,7 @@ struct C2SoftVpxDec : public SimpleC2Component {
     } mMode;
 
     struct ConversionQueue;
+    class FrameBufferPool;
 
     class ConverterThread : public Thread {
     public:
@@ -81,10 +82,19 @@ struct C2SoftVpxDec : public SimpleC2Component {
     std::shared_ptr<Mutexed<ConversionQueue>> mQueue;
     std::vector<sp<ConverterThread>> mConverterThreads;
 
+    // Frame buffers of the VP9 decoder, which output jobs keep from being
+    // reused while they copy the decoded frames.
+    std::shared_ptr<FrameBufferPool> mFrameBufferPool;
+    // Whether an output job finishes the work under processing.
+    bool mCurrentWorkQueued;
+
     status_t initDecoder();
     status_t destroyDecoder();
     void finishWork(uint64_t index, const std::unique_ptr<C2Work> &work,
-                    const std::shared_ptr<C2GraphicBlock> &block);
+                    const std::shared_ptr<C2GraphicBlock> &block, const C2Rect &crop);
+    c2_status_t copyImage(
+            const vpx_image_t &img, uint32_t width, uint32_t height, uint32_t format,
+            const std::shared_ptr<C2GraphicBlock> &block);
     status_t outputBuffer(
             const std::shared_ptr<C2BlockPool> &pool,
             const std::unique_ptr<C2Work> &work);
@@ -157,6 +157,8 @@ CCodecBufferChannel::CCodecBufferChannel(
         input->numSlots = kSmoothnessFactor;
         input->numExtraSlots = 0u;
         input->lastFlushIndex = 0u;
+        input->bytesCopied = 0u;
+        input->bytesPassedThrough = 0u;
     }
     {
         Mutexed<Output>::Locked output(mOutput);
@@ -234,7 +236,7 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     work->input.ordinal.customOrdinal = timeUs;
     work->input.buffers.clear();
 
-    sp<Codec2Buffer> copy;
+    sp<Codec2Buffer> extraBuffer;
     bool usesFrameReassembler = false;
 
     if (buffer->size() > 0u) {
@@ -243,18 +245,25 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         if (!input->buffers->releaseBuffer(buffer, &c2buffer, false)) {
             return -ENOENT;
         }
-        // TODO: we want to delay copying buffers.
+        size_t size = buffer->size();
+        bool copied = false;
         if (input->extraBuffers.numComponentBuffers() < input->numExtraSlots) {
-            copy = input->buffers->cloneAndReleaseBuffer(buffer);
-            if (copy != nullptr) {
-                (void)input->extraBuffers.assignSlot(copy);
-                if (!input->extraBuffers.releaseSlot(copy, &c2buffer, false)) {
+            // Hand the buffer over to the extra slots so that the client gets
+            // a new one; copy it only if the slots are fixed.
+            extraBuffer = input->buffers->moveBuffer(buffer, &input->extraBuffers);
+            if (extraBuffer != nullptr) {
+                ALOGV("[%s] queueInputBuffer: buffer moved to extra slots", mName);
+            } else if ((extraBuffer = input->buffers->cloneAndReleaseBuffer(buffer)) != nullptr) {
+                (void)input->extraBuffers.assignSlot(extraBuffer);
+                if (!input->extraBuffers.releaseSlot(extraBuffer, &c2buffer, false)) {
                     return UNKNOWN_ERROR;
                 }
                 bool released = input->buffers->releaseBuffer(buffer, nullptr, true);
                 ALOGV("[%s] queueInputBuffer: buffer copied; %sreleased",
                       mName, released ? "" : "not ");
-                buffer.clear();
+                extraBuffer->meta()->extend(buffer->meta());
+                buffer = extraBuffer;
+                copied = true;
             } else {
                 ALOGW("[%s] queueInputBuffer: failed to copy a buffer; this may cause input "
                       "buffer starvation on component.", mName);
@@ -262,7 +271,10 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
         }
         if (input->frameReassembler) {
             usesFrameReassembler = true;
-            input->frameReassembler.process(buffer, &items);
+            size_t numItems = items.size();
+            input->frameReassembler.process(buffer, &items, c2buffer);
+            copied = copied || items.size() == numItems
+                    || items.back()->input.buffers.front() != c2buffer;
         } else {
             int32_t cvo = 0;
             if (buffer->meta()->findInt32("cvo", &cvo)) {
@@ -281,6 +293,11 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
                         encryptedBlock->share(0, blockSize, C2Fence())));
             }
         }
+        if (copied) {
+            input->bytesCopied += size;
+        } else {
+            input->bytesPassedThrough += size;
+        }
     } else if (eos) {
         flags |= C2FrameData::FLAG_END_OF_STREAM;
     }
@@ -341,13 +358,13 @@ status_t CCodecBufferChannel::queueInputBufferInternal(
     } else {
         Mutexed<Input>::Locked input(mInput);
         bool released = false;
-        if (buffer) {
+        if (extraBuffer) {
+            released = input->extraBuffers.releaseSlot(extraBuffer, nullptr, true);
+        } else {
             released = input->buffers->releaseBuffer(buffer, nullptr, true);
-        } else if (copy) {
-            released = input->extraBuffers.releaseSlot(copy, nullptr, true);
         }
         ALOGV("[%s] queueInputBuffer: buffer%s %sreleased",
-              mName, (buffer == nullptr) ? "(copy)" : "", released ? "" : "not ");
+              mName, extraBuffer ? "(extra)" : "", released ? "" : "not ");
     }
 
     feedInputBufferIfAvailableInternal();
@@ -969,6 +986,12 @@ void CCodecBufferChannel::getOutputBufferArray(Vector<sp<MediaCodecBuffer>> *arr
     output->buffers->getArray(array);
 }
 
+void CCodecBufferChannel::getMetrics(const sp<AMessage> &metrics) {
+    Mutexed<Input>::Locked input(mInput);
+    metrics->setInt64("input.bytes-passed-through", input->bytesPassedThrough);
+    metrics->setInt64("input.bytes-copied", input->bytesCopied);
+}
+
 status_t CCodecBufferChannel::start(
         const sp<AMessage> &inputFormat,
         const sp<AMessage> &outputFormat,
@@ -91,6 +91,7 @@ public:
     virtual status_t discardBuffer(const sp<MediaCodecBuffer> &buffer) override;
     virtual void getInputBufferArray(Vector<sp<MediaCodecBuffer>> *array) override;
     virtual void getOutputBufferArray(Vector<sp<MediaCodecBuffer>> *array) override;
+    virtual void getMetrics(const sp<AMessage> &metrics) override;
 
     // Methods below are interface for CCodec to use.
 
@@ -276,6 +277,11 @@ private:
         c2_cntr64_t lastFlushIndex;
 
         FrameReassembler frameReassembler;
+
+        // Input bytes copied into another block before being queued, and
+        // bytes queued in the block the client filled. Reported by getMetrics().
+        uint64_t bytesCopied;
+        uint64_t bytesPassedThrough;
     };
     Mutexed<Input> mInput;
     struct Output {
@@ -502,6 +502,29 @@ size_t FlexBuffersImpl::numComponentBuffers() const {
             });
 }
 
+sp<Codec2Buffer> FlexBuffersImpl::moveSlot(
+        const sp<MediaCodecBuffer> &buffer, FlexBuffersImpl *dest) {
+    for (size_t i = 0; i < mBuffers.size(); ++i) {
+        if (mBuffers[i].clientBuffer != buffer) {
+            continue;
+        }
+        Entry entry = mBuffers[i];
+        if (entry.compBuffer.expired()) {
+            entry.compBuffer = entry.clientBuffer->asC2Buffer();
+            entry.clientBuffer->clearC2BufferRefs();
+        }
+        mBuffers[i].clientBuffer.clear();
+        mBuffers[i].compBuffer.reset();
+
+        size_t index = dest->assignSlot(entry.clientBuffer);
+        dest->mBuffers[index].compBuffer = entry.compBuffer;
+        ALOGV("[%s] moved buffer #%zu to [%s] #%zu", mName, i, dest->mName, index);
+        return entry.clientBuffer;
+    }
+    ALOGV("[%s] %s: No matching buffer found", mName, __func__);
+    return nullptr;
+}
+
 // BuffersArrayImpl
 
 void BuffersArrayImpl::initialize(
@@ -784,6 +807,11 @@ size_t LinearInputBuffers::numActiveSlots() const {
     return mImpl.numActiveSlots();
 }
 
+sp<Codec2Buffer> LinearInputBuffers::moveBuffer(
+        const sp<MediaCodecBuffer> &buffer, FlexBuffersImpl *dest) {
+    return mImpl.moveSlot(buffer, dest);
+}
+
 // static
 sp<Codec2Buffer> LinearInputBuffers::Alloc(
         const std::shared_ptr<C2BlockPool> &pool, const sp<AMessage> &format) {
@@ -29,6 +29,7 @@
 namespace android {
 
 struct ICrypto;
+class FlexBuffersImpl;
 class MemoryDealer;
 class SkipCutBuffer;
 
@@ -149,6 +150,23 @@ public:
      */
     sp<Codec2Buffer> cloneAndReleaseBuffer(const sp<MediaCodecBuffer> &buffer);
 
+    /**
+     * Move the slot of the buffer obtained from requestNewBuffer() to
+     * |dest|, along with the C2Buffer object sent to the component. The
+     * buffer stays assigned to the slot in |dest| until released there.
+     * Unlike cloneAndReleaseBuffer(), the data is not copied; the client
+     * gets a freshly allocated buffer the next time around.
+     *
+     * \return  the moved buffer; nullptr if the slots are fixed, e.g. in
+     *          array mode.
+     */
+    virtual sp<Codec2Buffer> moveBuffer(
+            const sp<MediaCodecBuffer> &buffer, FlexBuffersImpl *dest) {
+        (void)buffer;
+        (void)dest;
+        return nullptr;
+    }
+
 protected:
     virtual sp<Codec2Buffer> createNewBuffer() = 0;
 
@@ -590,6 +608,16 @@ public:
      */
     size_t numComponentBuffers() const;
 
+    /**
+     * Move the slot of |buffer| to |dest|, keeping track of the C2Buffer
+     * object sent to the component. The slot here becomes empty.
+     *
+     * \param   buffer[in]  the buffer previously assigned a slot.
+     * \param   dest[in]    the slots to move the buffer to.
+     * \return  the moved buffer; nullptr if no slot matches |buffer|.
+     */
+    sp<Codec2Buffer> moveSlot(const sp<MediaCodecBuffer> &buffer, FlexBuffersImpl *dest);
+
 private:
     friend class BuffersArrayImpl;
 
@@ -826,6 +854,9 @@ public:
 
     size_t numActiveSlots() const final;
 
+    sp<Codec2Buffer> moveBuffer(
+            const sp<MediaCodecBuffer> &buffer, FlexBuffersImpl *dest) override;
+
 protected:
     sp<Codec2Buffer> createNewBuffer() override;
 
@@ -86,7 +86,8 @@ FrameReassembler::operator bool() const {
 
 c2_status_t FrameReassembler::process(
         const sp<MediaCodecBuffer> &buffer,
-        std::list<std::unique_ptr<C2Work>> *items) {
+        std::list<std::unique_ptr<C2Work>> *items,
+        const std::shared_ptr<C2Buffer> &c2buffer) {
     int64_t timeUs;
     if (buffer->size() == 0u
             || !buffer->meta()->findInt64("timeUs", &timeUs)) {
@@ -147,6 +148,15 @@ c2_status_t FrameReassembler::process(
     }
 
     size_t frameSizeBytes = mFrameSize.value() * mChannelCount * bytesPerSample();
+    if (c2buffer && !mCurrentBlock && buffer->size() == frameSizeBytes
+            && c2buffer->data().type() == C2BufferData::LINEAR
+            && c2buffer->data().linearBlocks().size() == 1u
+            && c2buffer->data().linearBlocks().front().size() == frameSizeBytes) {
+        // The client filled exactly one frame; no need to copy it.
+        ALOGV("passing through buffer={offset=%zu size=%zu}", buffer->offset(), buffer->size());
+        queueFrame(c2buffer, items);
+        buffer->setRange(buffer->offset() + buffer->size(), 0);
+    }
     while (buffer->size() > 0) {
         LOG_ALWAYS_FATAL_IF(
                 mCurrentBlock,
@@ -210,10 +220,18 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
                 mWriteView->capacity() - mWriteView->size());
         mWriteView->setSize(mWriteView->capacity());
     }
+    queueFrame(C2Buffer::CreateLinearBuffer(
+            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())), items);
+    mCurrentBlock.reset();
+    mWriteView.reset();
+}
+
+void FrameReassembler::queueFrame(
+        const std::shared_ptr<C2Buffer> &frame,
+        std::list<std::unique_ptr<C2Work>> *items) {
     std::unique_ptr<C2Work> work{std::make_unique<C2Work>()};
     work->input.ordinal = mCurrentOrdinal;
-    work->input.buffers.push_back(C2Buffer::CreateLinearBuffer(
-            mCurrentBlock->share(0, mCurrentBlock->capacity(), C2Fence())));
+    work->input.buffers.push_back(frame);
     work->worklets.clear();
     work->worklets.emplace_back(new C2Worklet);
     items->push_back(std::move(work));
@@ -221,8 +239,6 @@ void FrameReassembler::finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *it
     ++mCurrentOrdinal.frameIndex;
     mCurrentOrdinal.timestamp += mFrameSize.value() * 1000000 / mSampleRate;
     mCurrentOrdinal.customOrdinal = mCurrentOrdinal.timestamp;
-    mCurrentBlock.reset();
-    mWriteView.reset();
 }
 
 }  // namespace android
@@ -47,9 +47,16 @@ public:
 
     explicit operator bool() const;
 
+    /**
+     * Reassemble |buffer| into works of the encoder frame size, appended to
+     * |items|. If |c2buffer| is the C2Buffer backing |buffer|, a whole frame
+     * arriving with no partial frame pending is queued as is instead of
+     * being copied into a new block.
+     */
     c2_status_t process(
             const sp<MediaCodecBuffer> &buffer,
-            std::list<std::unique_ptr<C2Work>> *items);
+            std::list<std::unique_ptr<C2Work>> *items,
+            const std::shared_ptr<C2Buffer> &c2buffer = nullptr);
 
 private:
     std::shared_ptr<C2BlockPool> mBlockPool;
@@ -68,6 +75,9 @@ private:
     uint32_t bytesPerSample() const;
 
     void finishCurrentBlock(std::list<std::unique_ptr<C2Work>> *items);
+    void queueFrame(
+            const std::shared_ptr<C2Buffer> &frame,
+            std::list<std::unique_ptr<C2Work>> *items);
 };
 
 }  // namespace android
@@ -119,6 +119,51 @@ TEST(RawGraphicOutputBuffersTest, WrapNullBuffer) {
     ASSERT_EQ(0, buffer->offset());
 }
 
+TEST(LinearInputBuffersTest, MoveBuffer) {
+    std::shared_ptr<LinearInputBuffers> buffers =
+        std::make_shared<LinearInputBuffers>("test");
+    sp<AMessage> format{new AMessage};
+    format->setInt32(KEY_MAX_INPUT_SIZE, 4096);
+    buffers->setFormat(format);
+    std::shared_ptr<C2BlockPool> pool;
+    ASSERT_EQ(OK, GetCodec2BlockPool(C2BlockPool::BASIC_LINEAR, nullptr, &pool));
+    buffers->setPool(pool);
+
+    size_t index;
+    sp<MediaCodecBuffer> clientBuffer;
+    ASSERT_TRUE(buffers->requestNewBuffer(&index, &clientBuffer));
+    memset(clientBuffer->base(), 0x5a, 1024);
+    clientBuffer->setRange(0, 1024);
+    std::shared_ptr<C2Buffer> c2Buffer;
+    ASSERT_TRUE(buffers->releaseBuffer(clientBuffer, &c2Buffer, false));
+    ASSERT_EQ(1u, buffers->numActiveSlots());
+
+    // The slot moves to the extra slots with the C2Buffer in flight.
+    FlexBuffersImpl extraBuffers("extra");
+    sp<Codec2Buffer> moved = buffers->moveBuffer(clientBuffer, &extraBuffers);
+    ASSERT_EQ(clientBuffer, moved);
+    EXPECT_EQ(0u, buffers->numActiveSlots());
+    EXPECT_EQ(1u, extraBuffers.numActiveSlots());
+    EXPECT_EQ(1u, extraBuffers.numComponentBuffers());
+    EXPECT_EQ(nullptr, buffers->moveBuffer(clientBuffer, &extraBuffers));
+
+    // The component gets the very data the client wrote.
+    ASSERT_EQ(1u, c2Buffer->data().linearBlocks().size());
+    C2ReadView view = c2Buffer->data().linearBlocks().front().map().get();
+    ASSERT_EQ(C2_OK, view.error());
+    ASSERT_EQ(1024u, view.capacity());
+    for (size_t i = 0; i < view.capacity(); ++i) {
+        ASSERT_EQ(0x5a, view.data()[i]) << "i = " << i;
+    }
+
+    std::shared_ptr<C2Buffer> extraC2Buffer;
+    ASSERT_TRUE(extraBuffers.releaseSlot(moved, &extraC2Buffer, true));
+    EXPECT_EQ(c2Buffer, extraC2Buffer);
+    EXPECT_EQ(1u, extraBuffers.numActiveSlots());
+    ASSERT_TRUE(extraBuffers.expireComponentBuffer(c2Buffer));
+    EXPECT_EQ(0u, extraBuffers.numActiveSlots());
+}
+
 TEST(RawGraphicOutputBuffersTest, FlexYuvColorFormat) {
     constexpr int32_t kWidth = 320;
     constexpr int32_t kHeight = 240;
@@ -127,13 +127,67 @@ public:
             << " input size = " << inputIndex << " frame size = " << encoderFrameSizeInBytes;
     }
 
-private:
+protected:
     status_t mInitStatus;
     std::shared_ptr<C2BlockPool> mPool;
 };
 
 const C2MemoryUsage FrameReassemblerTest::kUsage{C2MemoryUsage::CPU_READ, C2MemoryUsage::CPU_WRITE};
 
+// Push frames of exactly the encoder frame size along with their C2Buffers;
+// they are queued without being copied.
+TEST_F(FrameReassemblerTest, PassThroughExactFrameSize) {
+    ASSERT_EQ(OK, initStatus());
+    constexpr size_t kFrameSize = 1024;
+    constexpr size_t kSampleRate = 48000;
+    FrameReassembler frameReassembler;
+    frameReassembler.init(mPool, kUsage, kFrameSize, kSampleRate, 1 /* channel count */, PCM_16);
+    ASSERT_TRUE(frameReassembler) << "FrameReassembler init failed";
+
+    constexpr size_t kFrameSizeInBytes = kFrameSize * 2;
+    for (size_t i = 0; i < 4; ++i) {
+        std::shared_ptr<C2LinearBlock> block;
+        ASSERT_EQ(C2_OK, mPool->fetchLinearBlock(kFrameSizeInBytes, kUsage, &block));
+        std::shared_ptr<C2Buffer> c2buffer =
+            C2Buffer::CreateLinearBuffer(block->share(0, kFrameSizeInBytes, C2Fence()));
+        sp<MediaCodecBuffer> buffer = new MediaCodecBuffer(
+                new AMessage, new ABuffer(kFrameSizeInBytes));
+        buffer->setRange(0, kFrameSizeInBytes);
+        buffer->meta()->setInt64("timeUs", i * kFrameSize * 1000000 / kSampleRate);
+
+        std::list<std::unique_ptr<C2Work>> items;
+        ASSERT_EQ(C2_OK, frameReassembler.process(buffer, &items, c2buffer));
+        ASSERT_EQ(1u, items.size());
+        const std::unique_ptr<C2Work> &work = items.front();
+        ASSERT_EQ(1u, work->input.buffers.size());
+        EXPECT_EQ(c2buffer, work->input.buffers.front());
+        EXPECT_EQ(i, work->input.ordinal.frameIndex.peeku());
+        EXPECT_GE(kTimestampToleranceUs,
+                  Diff(i * kFrameSize * 1000000 / kSampleRate, work->input.ordinal.timestamp));
+        EXPECT_EQ(0u, buffer->size());
+    }
+
+    // A partial frame is copied, and so is the next frame that completes it.
+    std::shared_ptr<C2LinearBlock> block;
+    ASSERT_EQ(C2_OK, mPool->fetchLinearBlock(kFrameSizeInBytes, kUsage, &block));
+    std::shared_ptr<C2Buffer> c2buffer =
+        C2Buffer::CreateLinearBuffer(block->share(0, kFrameSizeInBytes / 2, C2Fence()));
+    sp<MediaCodecBuffer> buffer = new MediaCodecBuffer(
+            new AMessage, new ABuffer(kFrameSizeInBytes));
+    buffer->setRange(0, kFrameSizeInBytes / 2);
+    buffer->meta()->setInt64("timeUs", 4 * kFrameSize * 1000000 / kSampleRate);
+    std::list<std::unique_ptr<C2Work>> items;
+    ASSERT_EQ(C2_OK, frameReassembler.process(buffer, &items, c2buffer));
+    EXPECT_TRUE(items.empty());
+
+    c2buffer = C2Buffer::CreateLinearBuffer(block->share(0, kFrameSizeInBytes, C2Fence()));
+    buffer->setRange(0, kFrameSizeInBytes);
+    buffer->meta()->setInt64("timeUs", (4 * kFrameSize + kFrameSize / 2) * 1000000 / kSampleRate);
+    ASSERT_EQ(C2_OK, frameReassembler.process(buffer, &items, c2buffer));
+    ASSERT_EQ(1u, items.size());
+    EXPECT_NE(c2buffer, items.front()->input.buffers.front());
+}
+
 // Push frames with exactly the same size as the encoder requested.
 TEST_F(FrameReassemblerTest, PushExactFrameSize) {
     ASSERT_EQ(OK, initStatus());
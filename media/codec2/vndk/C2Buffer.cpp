@@ -42,6 +42,7 @@ using android::hardware::media::bufferpool::V2_0::implementation::BufferPoolAllo
 using android::hardware::media::bufferpool::V2_0::implementation::ClientManager;
 using android::hardware::media::bufferpool::V2_0::implementation::ConnectionId;
 using android::hardware::media::bufferpool::V2_0::implementation::INVALID_CONNECTIONID;
+using android::hardware::media::bufferpool::V2_0::implementation::getSizeClass;
 
 // This anonymous namespace contains the helper classes that allow our implementation to create
 // block/buffer objects.
@@ -513,6 +514,7 @@ public:
 
 private:
     static constexpr int kMaxIntParams = 5; // large enough number;
+    static constexpr size_t kMaxSizeClassRatio = 2;
 
     enum AllocType : uint8_t {
         ALLOC_NONE = 0,
@@ -570,16 +572,19 @@ ResultStatus _C2BufferPoolAllocator::allocate(
         case ALLOC_NONE:
             break;
         case ALLOC_LINEAR: {
+            // Round up to the size class so that the allocation can be
+            // recycled for requests of slightly different capacities.
+            const uint32_t capacity = getSizeClass(c2Params.data.params[0]);
             std::shared_ptr<C2LinearAllocation> c2Linear;
             status = mAllocator->newLinearAllocation(
-                    c2Params.data.params[0], c2Params.data.usage, &c2Linear);
+                    capacity, c2Params.data.usage, &c2Linear);
             if (status == C2_OK && c2Linear) {
                 BufferPoolAllocation *ptr = new BufferPoolAllocation(c2Linear->handle());
                 if (ptr) {
                     *alloc = std::shared_ptr<BufferPoolAllocation>(
                             ptr, LinearAllocationDtor(c2Linear));
                     if (*alloc) {
-                        *allocSize = (size_t)c2Params.data.params[0];
+                        *allocSize = (size_t)capacity;
                         return ResultStatus::OK;
                     }
                     delete ptr;
@@ -624,9 +629,15 @@ bool _C2BufferPoolAllocator::compatible(
     memcpy(&newAlloc, newParams.data(), std::min(sizeof(AllocParams), newParams.size()));
     memcpy(&oldAlloc, oldParams.data(), std::min(sizeof(AllocParams), oldParams.size()));
 
-    // TODO: support not exact matching. e.g) newCapacity < oldCapacity
     if (newAlloc.data.allocType == oldAlloc.data.allocType &&
             newAlloc.data.usage.expected == oldAlloc.data.usage.expected) {
+        if (newAlloc.data.allocType == ALLOC_LINEAR) {
+            // Linear allocations are rounded up to their size class; accept
+            // ones up to kMaxSizeClassRatio times the requested class.
+            const size_t newClass = getSizeClass(newAlloc.data.params[0]);
+            const size_t oldClass = getSizeClass(oldAlloc.data.params[0]);
+            return newClass <= oldClass && oldClass <= newClass * kMaxSizeClassRatio;
+        }
         for (int i = 0; i < kMaxIntParams; ++i) {
             if (newAlloc.data.params[i] != oldAlloc.data.params[i]) {
                 return false;
@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <map>
 #include <memory>
+#include <vector>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -126,10 +127,28 @@ private:
     off64_t mCurrentMoofOffset;
     off64_t mCurrentMoofSize;
     off64_t mNextMoofOffset;
-    uint32_t mCurrentTime; // in media timescale ticks
+    uint64_t mCurrentTime; // in media timescale ticks
     int32_t mLastParsedTrackId;
     int32_t mTrackId;
 
+    // Start of a movie fragment, used to seek in fragmented files without sidx.
+    struct FragmentEntry {
+        uint64_t mTime; // in media timescale ticks
+        off64_t mMoofOffset;
+    };
+    // Ordered by time and offset. Taken from the track's tfra box if the file
+    // ends with an mfra box, otherwise extended as fragments are read or
+    // skipped over by seeks.
+    std::vector<FragmentEntry> mFragmentIndex;
+    bool mCheckedFragmentRandomAccess;
+    bool mFragmentIndexFromTfra;
+    bool mFragmentIndexComplete;
+    bool mHasTrackFragmentDecodeTime;
+    uint64_t mTrackFragmentDecodeTime;
+    // Decode time of the first fragment. Playback starts at time 0 from that
+    // fragment, so tfra and tfdt times are made relative to it.
+    uint64_t mFirstFragmentDecodeTime;
+
     int32_t mCryptoMode;    // passed in from extractor
     int32_t mDefaultIVSize; // passed in from extractor
     uint8_t mCryptoKey[16]; // passed in from extractor
@@ -179,6 +198,13 @@ private:
     status_t parseChunk(off64_t *offset);
     status_t parseTrackFragmentHeader(off64_t offset, off64_t size);
     status_t parseTrackFragmentRun(off64_t offset, off64_t size);
+    status_t parseTrackFragmentDecodeTime(off64_t offset, off64_t size);
+    status_t parseFragmentRandomAccess();
+    status_t parseTrackFragmentRandomAccess(off64_t offset, off64_t size);
+    status_t parseFragmentAt(off64_t moofOffset);
+    void addNextFragmentToIndex();
+    status_t seekToFragment(uint64_t seekTicks, ReadOptions::SeekMode mode);
+    uint64_t toPlaybackTicks(uint64_t fragmentTicks) const;
     status_t parseSampleAuxiliaryInformationSizes(off64_t offset, off64_t size);
     status_t parseSampleAuxiliaryInformationOffsets(off64_t offset, off64_t size);
     status_t parseClearEncryptedSizes(off64_t offset, bool isSampleEncryption,
@@ -5070,6 +5096,12 @@ MPEG4Source::MPEG4Source(
       mCurrentMoofSize(0),
       mNextMoofOffset(-1),
       mCurrentTime(0),
+      mCheckedFragmentRandomAccess(false),
+      mFragmentIndexFromTfra(false),
+      mFragmentIndexComplete(false),
+      mHasTrackFragmentDecodeTime(false),
+      mTrackFragmentDecodeTime(0),
+      mFirstFragmentDecodeTime(0),
       mDefaultEncryptedByteBlock(0),
       mDefaultSkipByteBlock(0),
       mCurrentSampleInfoAllocSize(0),
@@ -5222,7 +5254,12 @@ MPEG4Source::MPEG4Source(
 status_t MPEG4Source::init() {
     if (mFirstMoofOffset != 0) {
         off64_t offset = mFirstMoofOffset;
-        return parseChunk(&offset);
+        mFragmentIndex.push_back({0, mFirstMoofOffset});
+        status_t err = parseChunk(&offset);
+        if (err == OK && mHasTrackFragmentDecodeTime) {
+            mFirstFragmentDecodeTime = mTrackFragmentDecodeTime;
+        }
+        return err;
     }
     return OK;
 }
@@ -5404,6 +5441,19 @@ status_t MPEG4Source::parseChunk(off64_t *offset) {
                 break;
         }
 
+        case FOURCC("tfdt"): {
+                status_t err;
+                if (mLastParsedTrackId == mTrackId) {
+                    if ((err = parseTrackFragmentDecodeTime(data_offset, chunk_data_size))
+                            != OK) {
+                        return err;
+                    }
+                }
+
+                *offset += chunk_size;
+                break;
+        }
+
         case FOURCC("saiz"): {
             status_t err;
             if ((err = parseSampleAuxiliaryInformationSizes(data_offset, chunk_data_size)) != OK) {
@@ -6040,6 +6090,245 @@ status_t MPEG4Source::parseTrackFragmentRun(off64_t offset, off64_t size) {
     return OK;
 }
 
+status_t MPEG4Source::parseTrackFragmentDecodeTime(off64_t offset, off64_t size) {
+    if (size < 8) {
+        return -EINVAL;
+    }
+
+    uint32_t flags;
+    if (!mDataSource->getUInt32(offset, &flags)) { // actually version + flags
+        return ERROR_MALFORMED;
+    }
+
+    uint8_t version = flags >> 24;
+    if (version == 1) {
+        if (size < 12) {
+            return -EINVAL;
+        }
+        if (!mDataSource->getUInt64(offset + 4, &mTrackFragmentDecodeTime)) {
+            return ERROR_MALFORMED;
+        }
+    } else {
+        uint32_t decodeTime;
+        if (!mDataSource->getUInt32(offset + 4, &decodeTime)) {
+            return ERROR_MALFORMED;
+        }
+        mTrackFragmentDecodeTime = decodeTime;
+    }
+    mHasTrackFragmentDecodeTime = true;
+
+    return OK;
+}
+
+// Reads the track's tfra box from the mfra box that, if present, ends the
+// file and is located through the trailing mfro box.
+status_t MPEG4Source::parseFragmentRandomAccess() {
+    off64_t fileSize;
+    if (mDataSource->getSize(&fileSize) != OK || fileSize < 16) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    uint8_t mfro[16];
+    if (mDataSource->readAt(fileSize - 16, mfro, sizeof(mfro)) < (ssize_t)sizeof(mfro)) {
+        return ERROR_IO;
+    }
+    if (U32_AT(mfro) != sizeof(mfro) || U32_AT(&mfro[4]) != FOURCC("mfro")) {
+        return ERROR_UNSUPPORTED;
+    }
+
+    uint32_t mfraSize = U32_AT(&mfro[12]);
+    if (mfraSize < 8 + sizeof(mfro) || mfraSize > fileSize - mFirstMoofOffset) {
+        return ERROR_MALFORMED;
+    }
+
+    off64_t offset = fileSize - mfraSize;
+    uint32_t hdr[2];
+    if (mDataSource->readAt(offset, hdr, 8) < 8) {
+        return ERROR_IO;
+    }
+    if (ntohl(hdr[0]) != mfraSize || ntohl(hdr[1]) != FOURCC("mfra")) {
+        return ERROR_MALFORMED;
+    }
+
+    offset += 8;
+    const off64_t stopOffset = fileSize - sizeof(mfro);
+    while (offset < stopOffset) {
+        if (mDataSource->readAt(offset, hdr, 8) < 8) {
+            return ERROR_IO;
+        }
+        uint32_t chunkSize = ntohl(hdr[0]);
+        if (chunkSize < 8 || chunkSize > stopOffset - offset) {
+            return ERROR_MALFORMED;
+        }
+        if (ntohl(hdr[1]) == FOURCC("tfra") && chunkSize >= 16) {
+            uint32_t trackId;
+            if (!mDataSource->getUInt32(offset + 12, &trackId)) {
+                return ERROR_IO;
+            }
+            if ((int32_t)trackId == mTrackId) {
+                return parseTrackFragmentRandomAccess(offset + 8, chunkSize - 8);
+            }
+        }
+        offset += chunkSize;
+    }
+
+    return ERROR_UNSUPPORTED;
+}
+
+// Replaces the fragment index with the entries of this track's tfra box.
+status_t MPEG4Source::parseTrackFragmentRandomAccess(off64_t offset, off64_t size) {
+    uint8_t header[16];
+    if (size < (off64_t)sizeof(header)) {
+        return ERROR_MALFORMED;
+    }
+    if (mDataSource->readAt(offset, header, sizeof(header)) < (ssize_t)sizeof(header)) {
+        return ERROR_IO;
+    }
+
+    uint8_t version = header[0];
+    uint32_t lengthSizes = U32_AT(&header[8]);
+    size_t trafNumberSize = ((lengthSizes >> 4) & 3) + 1;
+    size_t trunNumberSize = ((lengthSizes >> 2) & 3) + 1;
+    size_t sampleNumberSize = (lengthSizes & 3) + 1;
+    size_t entrySize = (version == 1 ? 16 : 8) + trafNumberSize + trunNumberSize
+            + sampleNumberSize;
+
+    uint32_t numEntries = U32_AT(&header[12]);
+    size -= sizeof(header);
+    if (numEntries == 0 || numEntries > size / entrySize
+            || (uint64_t)numEntries * entrySize > kMaxAtomSize) {
+        return ERROR_MALFORMED;
+    }
+
+    size_t dataSize = numEntries * entrySize;
+    auto data = heapbuffer<uint8_t>(dataSize);
+    if (data.get() == NULL) {
+        return NO_MEMORY;
+    }
+    if (mDataSource->readAt(offset + sizeof(header), data.get(), dataSize)
+            < (ssize_t)dataSize) {
+        return ERROR_IO;
+    }
+
+    std::vector<FragmentEntry> index;
+    const uint8_t *ptr = data.get();
+    for (uint32_t i = 0; i < numEntries; ++i, ptr += entrySize) {
+        FragmentEntry entry;
+        if (version == 1) {
+            entry.mTime = toPlaybackTicks(U64_AT(ptr));
+            entry.mMoofOffset = U64_AT(ptr + 8);
+        } else {
+            entry.mTime = toPlaybackTicks(U32_AT(ptr));
+            entry.mMoofOffset = U32_AT(ptr + 4);
+        }
+        // Keep the first random access point of each fragment, and skip
+        // entries that would break the ordering of the index.
+        if (entry.mMoofOffset < mFirstMoofOffset || (!index.empty()
+                && (entry.mMoofOffset <= index.back().mMoofOffset
+                        || entry.mTime < index.back().mTime))) {
+            continue;
+        }
+        index.push_back(entry);
+    }
+
+    if (index.empty()) {
+        return ERROR_MALFORMED;
+    }
+
+    ALOGV("tfra: %zu fragments for track %d", index.size(), mTrackId);
+    mFragmentIndex.swap(index);
+    mFragmentIndexFromTfra = true;
+    mFragmentIndexComplete = true;
+    return OK;
+}
+
+status_t MPEG4Source::parseFragmentAt(off64_t moofOffset) {
+    mCurrentMoofOffset = moofOffset;
+    mNextMoofOffset = -1;
+    mCurrentSamples.clear();
+    mCurrentSampleIndex = 0;
+    mHasTrackFragmentDecodeTime = false;
+    return parseChunk(&moofOffset);
+}
+
+// Appends the fragment following the current one, if the current fragment is
+// the last one indexed so far.
+void MPEG4Source::addNextFragmentToIndex() {
+    if (mFragmentIndexComplete || mFragmentIndex.empty()) {
+        return;
+    }
+    const FragmentEntry &last = mFragmentIndex.back();
+    if (last.mMoofOffset != mCurrentMoofOffset || mNextMoofOffset <= mCurrentMoofOffset) {
+        return;
+    }
+    uint64_t time = last.mTime;
+    for (size_t i = 0; i < mCurrentSamples.size(); ++i) {
+        uint32_t duration = mCurrentSamples[i].duration;
+        time = time > UINT64_MAX - duration ? UINT64_MAX : time + duration;
+    }
+    mFragmentIndex.push_back({time, mNextMoofOffset});
+}
+
+// Moves to the fragment to resume reading from after a seek to |seekTicks|,
+// in O(log(fragments)) once the index covers that time. Without a tfra box,
+// fragments between the end of the index and the seek target are parsed (but
+// their samples not read) once to extend the index.
+status_t MPEG4Source::seekToFragment(uint64_t seekTicks, ReadOptions::SeekMode mode) {
+    if (!mCheckedFragmentRandomAccess) {
+        mCheckedFragmentRandomAccess = true;
+        status_t err = parseFragmentRandomAccess();
+        if (err != OK && err != ERROR_UNSUPPORTED) {
+            ALOGW("ignoring tfra: %d", err);
+        }
+    }
+    if (mFragmentIndex.empty()) {
+        return ERROR_MALFORMED;
+    }
+
+    while (!mFragmentIndexComplete && mFragmentIndex.back().mTime <= seekTicks) {
+        const FragmentEntry last = mFragmentIndex.back();
+        status_t err = parseFragmentAt(last.mMoofOffset);
+        if (err != OK) {
+            return err;
+        }
+        if (mNextMoofOffset <= last.mMoofOffset) {
+            mFragmentIndexComplete = true;
+            break;
+        }
+        addNextFragmentToIndex();
+    }
+
+    auto it = std::upper_bound(mFragmentIndex.begin(), mFragmentIndex.end(), seekTicks,
+            [](uint64_t t, const FragmentEntry &entry) { return t < entry.mTime; });
+    size_t i = it == mFragmentIndex.begin() ? 0 : it - mFragmentIndex.begin() - 1;
+    if (i + 1 < mFragmentIndex.size() && seekTicks > mFragmentIndex[i].mTime) {
+        uint64_t start = mFragmentIndex[i].mTime;
+        uint64_t end = mFragmentIndex[i + 1].mTime;
+        if (mode == ReadOptions::SEEK_NEXT_SYNC ||
+                (mode == ReadOptions::SEEK_CLOSEST_SYNC && seekTicks - start > end - seekTicks)) {
+            // requested next sync, or closest sync and it was closer to the end of
+            // this fragment
+            ++i;
+        }
+    }
+
+    status_t err = parseFragmentAt(mFragmentIndex[i].mMoofOffset);
+    if (err != OK) {
+        return err;
+    }
+    // tfra times are presentation times, so prefer the fragment's decode time.
+    mCurrentTime = mFragmentIndexFromTfra && mHasTrackFragmentDecodeTime
+            ? toPlaybackTicks(mTrackFragmentDecodeTime) : mFragmentIndex[i].mTime;
+    return OK;
+}
+
+// Converts a tfra or tfdt time to the timeline samples are read on, which
+// starts at 0 with the first fragment whatever its decode time.
+uint64_t MPEG4Source::toPlaybackTicks(uint64_t fragmentTicks) const {
+    return fragmentTicks > mFirstFragmentDecodeTime
+            ? fragmentTicks - mFirstFragmentDecodeTime : 0;
+}
+
 media_status_t MPEG4Source::getFormat(AMediaFormat *meta) {
     Mutex::Autolock autoLock(mLock);
     AMediaFormat_copy(meta, mFormat);
@@ -6633,27 +6922,22 @@ media_status_t MPEG4Source::fragmentedRead(
                 totalTime += se->mDurationUs;
                 totalOffset += se->mSize;
             }
-            mCurrentMoofOffset = totalOffset;
-            mNextMoofOffset = -1;
-            mCurrentSamples.clear();
-            mCurrentSampleIndex = 0;
-            status_t err = parseChunk(&totalOffset);
+            status_t err = parseFragmentAt(totalOffset);
             if (err != OK) {
                 return AMEDIA_ERROR_UNKNOWN;
             }
             mCurrentTime = totalTime * mTimescale / 1000000ll;
         } else {
-            // without sidx boxes, we can only seek to 0
-            mCurrentMoofOffset = mFirstMoofOffset;
-            mNextMoofOffset = -1;
-            mCurrentSamples.clear();
-            mCurrentSampleIndex = 0;
-            off64_t tmp = mCurrentMoofOffset;
-            status_t err = parseChunk(&tmp);
+            // without sidx boxes, seek through the fragment index
+            uint64_t seekTicks = 0;
+            if (seekTimeUs > 0) {
+                seekTicks = (uint64_t)seekTimeUs > UINT64_MAX / mTimescale
+                        ? UINT64_MAX : (uint64_t)seekTimeUs * mTimescale / 1000000ll;
+            }
+            status_t err = seekToFragment(seekTicks, mode);
             if (err != OK) {
                 return AMEDIA_ERROR_UNKNOWN;
             }
-            mCurrentTime = 0;
         }
 
         if (mBuffer != NULL) {
@@ -6681,11 +6965,8 @@ media_status_t MPEG4Source::fragmentedRead(
             if (mNextMoofOffset <= mCurrentMoofOffset) {
                 return AMEDIA_ERROR_END_OF_STREAM;
             }
-            off64_t nextMoof = mNextMoofOffset;
-            mCurrentMoofOffset = nextMoof;
-            mCurrentSamples.clear();
-            mCurrentSampleIndex = 0;
-            status_t err = parseChunk(&nextMoof);
+            addNextFragmentToIndex();
+            status_t err = parseFragmentAt(mNextMoofOffset);
             if (err != OK) {
                 return AMEDIA_ERROR_UNKNOWN;
             }
@@ -6697,7 +6978,7 @@ media_status_t MPEG4Source::fragmentedRead(
         const Sample *smpl = &mCurrentSamples[mCurrentSampleIndex];
         offset = smpl->offset;
         size = smpl->size;
-        cts = mCurrentTime + smpl->compositionOffset;
+        cts = (int64_t)mCurrentTime + smpl->compositionOffset;
 
         if (mElstInitialEmptyEditTicks > 0) {
             cts += mElstInitialEmptyEditTicks;
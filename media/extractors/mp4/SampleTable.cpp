@@ -18,7 +18,9 @@
 //#define LOG_NDEBUG 0
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <limits>
+#include <memory>
 
 #include "SampleTable.h"
 #include "SampleIterator.h"
@@ -114,6 +116,499 @@ int32_t SampleTable::CompositionDeltaLookup::getCompositionTimeOffset(
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Maps composition times to sample indices without materializing and sorting
+// an entry for every sample up front. Samples are grouped in decode order into
+// chunks of kSamplesPerChunk. Building the index takes a single pass over the
+// stts and ctts entries and records, for each chunk, where its first sample
+// sits in those tables along with bounds on the chunk's composition times.
+// A chunk's samples are only expanded and sorted once a lookup needs them,
+// and are then stored as 32-bit deltas from the chunk's earliest time
+// whenever the chunk's time span allows it.
+struct SampleTable::SampleTimeIndex {
+    explicit SampleTimeIndex(SampleTable *table);
+    ~SampleTimeIndex();
+
+    status_t build();
+
+    // Number of samples covered by the time-to-sample table.
+    uint32_t countSamples() const { return mNumSamples; }
+
+    // Finds a sample with the largest composition time whose scaled value is
+    // <= req_time, or sets |*found| to false if there is none.
+    status_t findAtOrBefore(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            bool *found, uint64_t *time, uint32_t *sampleIndex);
+
+    // Finds a sample with the smallest composition time whose scaled value is
+    // > req_time, or sets |*found| to false if there is none.
+    status_t findAfter(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            bool *found, uint64_t *time, uint32_t *sampleIndex);
+
+    // Finds the sample at position |rank| in composition order.
+    status_t findAtRank(uint32_t rank, uint32_t *sampleIndex);
+
+    // normally we don't round
+    static uint64_t scaleTime(uint64_t time, uint64_t scale_num, uint64_t scale_den) {
+        return scale_den != 0 ? (time * scale_num) / scale_den : 0;
+    }
+
+private:
+    static constexpr uint32_t kSamplesPerChunk = 4096;
+
+    struct Chunk {
+        uint32_t mFirstSample;
+        uint32_t mNumSamples;
+
+        // Position of mFirstSample within the stts and ctts entries.
+        uint32_t mTimeToSampleEntry;
+        uint32_t mTimeToSampleOffset;
+        uint32_t mCompositionDeltaEntry;
+        uint32_t mCompositionDeltaOffset;
+        uint64_t mDecodeTime;
+
+        // Bounds on the composition times of the chunk's samples. Both are
+        // nondecreasing from one chunk to the next.
+        uint64_t mMinTime;
+        uint64_t mMaxTime;
+
+        // Set once the chunk is expanded: composition times in increasing
+        // order, either as deltas from mBaseTime or, if the chunk spans more
+        // than 32 bits of time, as is, and the matching sample offsets
+        // relative to mFirstSample.
+        uint64_t mBaseTime;
+        uint32_t *mTimeDeltas;
+        uint64_t *mTimes;
+        uint16_t *mSampleOffsets;
+    };
+
+    SampleTable *mTable;
+    Chunk *mChunks;
+    size_t mNumChunks;
+    uint32_t mNumSamples;
+
+    static uint64_t addClamped(uint64_t time, uint64_t delta);
+    static uint64_t addOffsetClamped(uint64_t time, int32_t offset);
+
+    static uint64_t timeAt(const Chunk &chunk, size_t i) {
+        return chunk.mTimes != NULL ? chunk.mTimes[i] : chunk.mBaseTime + chunk.mTimeDeltas[i];
+    }
+
+    status_t expand(Chunk *chunk);
+
+    // Number of samples of an expanded chunk whose scaled time is <= req_time.
+    static size_t countAtOrBefore(
+            const Chunk &chunk, uint64_t req_time, uint64_t scale_num, uint64_t scale_den);
+
+    status_t countAtOrBefore(uint64_t time, uint64_t *count);
+
+    DISALLOW_EVIL_CONSTRUCTORS(SampleTimeIndex);
+};
+
+SampleTable::SampleTimeIndex::SampleTimeIndex(SampleTable *table)
+    : mTable(table),
+      mChunks(NULL),
+      mNumChunks(0),
+      mNumSamples(0) {
+}
+
+SampleTable::SampleTimeIndex::~SampleTimeIndex() {
+    for (size_t i = 0; i < mNumChunks; ++i) {
+        delete[] mChunks[i].mTimeDeltas;
+        delete[] mChunks[i].mTimes;
+        delete[] mChunks[i].mSampleOffsets;
+    }
+    delete[] mChunks;
+    mChunks = NULL;
+}
+
+// static
+uint64_t SampleTable::SampleTimeIndex::addClamped(uint64_t time, uint64_t delta) {
+    return time > UINT64_MAX - delta ? UINT64_MAX : time + delta;
+}
+
+// static
+uint64_t SampleTable::SampleTimeIndex::addOffsetClamped(uint64_t time, int32_t offset) {
+    if (offset < 0) {
+        uint64_t magnitude = -(int64_t)offset;
+        return time < magnitude ? 0 : time - magnitude;
+    }
+    return addClamped(time, offset);
+}
+
+status_t SampleTable::SampleTimeIndex::build() {
+    const uint32_t *timeToSample = mTable->mTimeToSample;
+    const int32_t *deltaEntries = mTable->mCompositionTimeDeltaEntries;
+    const size_t numDeltaEntries =
+            deltaEntries != NULL ? mTable->mNumCompositionTimeDeltaEntries : 0;
+
+    // Samples past the end of stts have no time and are not indexed.
+    uint64_t numTimedSamples = 0;
+    for (uint32_t i = 0; i < mTable->mTimeToSampleCount; ++i) {
+        numTimedSamples += timeToSample[2 * i];
+    }
+    uint32_t numSamples = numTimedSamples < mTable->mNumSampleSizes
+            ? (uint32_t)numTimedSamples : mTable->mNumSampleSizes;
+    if (numSamples == 0) {
+        ALOGE("b/23247055, mNumSampleSizes(%u)", mTable->mNumSampleSizes);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    // Samples not covered by ctts have a zero offset, so zero is always
+    // within the bounds.
+    int32_t minOffset = 0;
+    int32_t maxOffset = 0;
+    for (size_t i = 0; i < numDeltaEntries; ++i) {
+        if (deltaEntries[2 * i] == 0) {
+            continue;
+        }
+        int32_t offset = deltaEntries[2 * i + 1];
+        minOffset = std::min(minOffset, offset);
+        maxOffset = std::max(maxOffset, offset);
+    }
+
+    size_t numChunks = (numSamples + kSamplesPerChunk - 1) / kSamplesPerChunk;
+    uint64_t allocSize = (uint64_t)numChunks * sizeof(Chunk);
+    if (mTable->mTotalSize + allocSize > kMaxTotalSize) {
+        ALOGE("Sample time index would make sample table too large.\n"
+              "    Requested sample time index size = %llu\n"
+              "    Eventual sample table size >= %llu\n"
+              "    Allowed sample table size = %llu\n",
+              (unsigned long long)allocSize,
+              (unsigned long long)(mTable->mTotalSize + allocSize),
+              (unsigned long long)kMaxTotalSize);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    mChunks = new (std::nothrow) Chunk[numChunks]();
+    if (mChunks == NULL) {
+        ALOGE("Cannot allocate sample time index with %zu chunks.", numChunks);
+        return ERROR_OUT_OF_RANGE;
+    }
+    mTable->mTotalSize += allocSize;
+    mNumChunks = numChunks;
+    mNumSamples = numSamples;
+
+    uint32_t timeToSampleEntry = 0;
+    uint32_t timeToSampleOffset = 0;
+    uint32_t deltaEntry = 0;
+    uint32_t deltaOffset = 0;
+    uint64_t decodeTime = 0;
+
+    for (size_t c = 0; c < mNumChunks; ++c) {
+        Chunk *chunk = &mChunks[c];
+        chunk->mFirstSample = c * kSamplesPerChunk;
+        chunk->mNumSamples = mNumSamples - chunk->mFirstSample < kSamplesPerChunk
+                ? mNumSamples - chunk->mFirstSample : kSamplesPerChunk;
+        chunk->mTimeToSampleEntry = timeToSampleEntry;
+        chunk->mTimeToSampleOffset = timeToSampleOffset;
+        chunk->mCompositionDeltaEntry = deltaEntry;
+        chunk->mCompositionDeltaOffset = deltaOffset;
+        chunk->mDecodeTime = decodeTime;
+        chunk->mMinTime = addOffsetClamped(decodeTime, minOffset);
+
+        uint32_t remaining = chunk->mNumSamples;
+        while (remaining > 0) {
+            uint32_t n = std::min(
+                    timeToSample[2 * timeToSampleEntry] - timeToSampleOffset, remaining);
+            decodeTime = addClamped(
+                    decodeTime, (uint64_t)n * timeToSample[2 * timeToSampleEntry + 1]);
+            remaining -= n;
+            timeToSampleOffset += n;
+            if (timeToSampleOffset == timeToSample[2 * timeToSampleEntry]) {
+                ++timeToSampleEntry;
+                timeToSampleOffset = 0;
+            }
+        }
+
+        remaining = chunk->mNumSamples;
+        while (remaining > 0 && deltaEntry < numDeltaEntries) {
+            uint32_t n = std::min(
+                    (uint32_t)deltaEntries[2 * deltaEntry] - deltaOffset, remaining);
+            remaining -= n;
+            deltaOffset += n;
+            if (deltaOffset == (uint32_t)deltaEntries[2 * deltaEntry]) {
+                ++deltaEntry;
+                deltaOffset = 0;
+            }
+        }
+
+        // decodeTime is now past the chunk's last sample.
+        chunk->mMaxTime = addOffsetClamped(decodeTime, maxOffset);
+    }
+
+    return OK;
+}
+
+status_t SampleTable::SampleTimeIndex::expand(Chunk *chunk) {
+    if (chunk->mSampleOffsets != NULL) {
+        return OK;
+    }
+
+    struct Entry {
+        uint64_t mTime;
+        uint16_t mSampleOffset;
+
+        bool operator<(const Entry &other) const {
+            return mTime != other.mTime
+                    ? mTime < other.mTime : mSampleOffset < other.mSampleOffset;
+        }
+    };
+
+    const size_t n = chunk->mNumSamples;
+    std::unique_ptr<Entry[]> entries(new (std::nothrow) Entry[n]);
+    if (!entries) {
+        ALOGE("Cannot expand sample time index chunk with %zu samples.", n);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    const uint32_t *timeToSample = mTable->mTimeToSample;
+    const int32_t *deltaEntries = mTable->mCompositionTimeDeltaEntries;
+    const size_t numDeltaEntries =
+            deltaEntries != NULL ? mTable->mNumCompositionTimeDeltaEntries : 0;
+
+    uint32_t timeToSampleEntry = chunk->mTimeToSampleEntry;
+    uint32_t timeToSampleOffset = chunk->mTimeToSampleOffset;
+    uint32_t deltaEntry = chunk->mCompositionDeltaEntry;
+    uint32_t deltaOffset = chunk->mCompositionDeltaOffset;
+    uint64_t decodeTime = chunk->mDecodeTime;
+
+    for (size_t i = 0; i < n; ++i) {
+        while (timeToSampleOffset == timeToSample[2 * timeToSampleEntry]) {
+            ++timeToSampleEntry;
+            timeToSampleOffset = 0;
+        }
+        while (deltaEntry < numDeltaEntries
+                && deltaOffset == (uint32_t)deltaEntries[2 * deltaEntry]) {
+            ++deltaEntry;
+            deltaOffset = 0;
+        }
+
+        int32_t compTimeDelta = 0;
+        if (deltaEntry < numDeltaEntries) {
+            compTimeDelta = deltaEntries[2 * deltaEntry + 1];
+            ++deltaOffset;
+        }
+
+        entries[i].mTime = addOffsetClamped(decodeTime, compTimeDelta);
+        entries[i].mSampleOffset = i;
+
+        decodeTime = addClamped(decodeTime, timeToSample[2 * timeToSampleEntry + 1]);
+        ++timeToSampleOffset;
+    }
+
+    std::sort(entries.get(), entries.get() + n);
+
+    const uint64_t baseTime = entries[0].mTime;
+    const bool compact = entries[n - 1].mTime - baseTime <= UINT32_MAX;
+    uint64_t allocSize = n * (sizeof(uint16_t) + (compact ? sizeof(uint32_t) : sizeof(uint64_t)));
+    if (mTable->mTotalSize + allocSize > kMaxTotalSize) {
+        ALOGE("Sample time index chunk would make sample table too large.\n"
+              "    Requested chunk size = %llu\n"
+              "    Eventual sample table size >= %llu\n"
+              "    Allowed sample table size = %llu\n",
+              (unsigned long long)allocSize,
+              (unsigned long long)(mTable->mTotalSize + allocSize),
+              (unsigned long long)kMaxTotalSize);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    std::unique_ptr<uint16_t[]> sampleOffsets(new (std::nothrow) uint16_t[n]);
+    std::unique_ptr<uint32_t[]> timeDeltas(compact ? new (std::nothrow) uint32_t[n] : NULL);
+    std::unique_ptr<uint64_t[]> times(compact ? NULL : new (std::nothrow) uint64_t[n]);
+    if (!sampleOffsets || (!timeDeltas && !times)) {
+        ALOGE("Cannot expand sample time index chunk with %zu samples.", n);
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        sampleOffsets[i] = entries[i].mSampleOffset;
+        if (compact) {
+            timeDeltas[i] = entries[i].mTime - baseTime;
+        } else {
+            times[i] = entries[i].mTime;
+        }
+    }
+
+    mTable->mTotalSize += allocSize;
+    chunk->mBaseTime = baseTime;
+    chunk->mTimeDeltas = timeDeltas.release();
+    chunk->mTimes = times.release();
+    chunk->mSampleOffsets = sampleOffsets.release();
+    return OK;
+}
+
+// static
+size_t SampleTable::SampleTimeIndex::countAtOrBefore(
+        const Chunk &chunk, uint64_t req_time, uint64_t scale_num, uint64_t scale_den) {
+    size_t left = 0;
+    size_t right = chunk.mNumSamples;
+    while (left < right) {
+        size_t center = left + (right - left) / 2;
+        if (scaleTime(timeAt(chunk, center), scale_num, scale_den) <= req_time) {
+            left = center + 1;
+        } else {
+            right = center;
+        }
+    }
+    return left;
+}
+
+status_t SampleTable::SampleTimeIndex::findAtOrBefore(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        bool *found, uint64_t *time, uint32_t *sampleIndex) {
+    *found = false;
+
+    // Chunks past the last one whose lower bound is <= req_time cannot hold
+    // a match.
+    Chunk *end = std::upper_bound(
+            mChunks, mChunks + mNumChunks, req_time,
+            [=](uint64_t t, const Chunk &chunk) {
+                return t < scaleTime(chunk.mMinTime, scale_num, scale_den);
+            });
+
+    for (size_t c = end - mChunks; c > 0; --c) {
+        Chunk *chunk = &mChunks[c - 1];
+        if (*found && chunk->mMaxTime <= *time) {
+            // Neither this nor any earlier chunk holds a later sample.
+            break;
+        }
+
+        status_t err = expand(chunk);
+        if (err != OK) {
+            return err;
+        }
+
+        size_t count = countAtOrBefore(*chunk, req_time, scale_num, scale_den);
+        if (count > 0) {
+            uint64_t candidate = timeAt(*chunk, count - 1);
+            if (!*found || candidate > *time) {
+                *found = true;
+                *time = candidate;
+                *sampleIndex = chunk->mFirstSample + chunk->mSampleOffsets[count - 1];
+            }
+        }
+    }
+
+    return OK;
+}
+
+status_t SampleTable::SampleTimeIndex::findAfter(
+        uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+        bool *found, uint64_t *time, uint32_t *sampleIndex) {
+    *found = false;
+
+    // Chunks before the first one whose upper bound is > req_time cannot hold
+    // a match.
+    Chunk *begin = std::upper_bound(
+            mChunks, mChunks + mNumChunks, req_time,
+            [=](uint64_t t, const Chunk &chunk) {
+                return t < scaleTime(chunk.mMaxTime, scale_num, scale_den);
+            });
+
+    for (Chunk *chunk = begin; chunk != mChunks + mNumChunks; ++chunk) {
+        if (*found && chunk->mMinTime >= *time) {
+            // Neither this nor any later chunk holds an earlier sample.
+            break;
+        }
+
+        status_t err = expand(chunk);
+        if (err != OK) {
+            return err;
+        }
+
+        size_t count = countAtOrBefore(*chunk, req_time, scale_num, scale_den);
+        if (count < chunk->mNumSamples) {
+            uint64_t candidate = timeAt(*chunk, count);
+            if (!*found || candidate < *time) {
+                *found = true;
+                *time = candidate;
+                *sampleIndex = chunk->mFirstSample + chunk->mSampleOffsets[count];
+            }
+        }
+    }
+
+    return OK;
+}
+
+status_t SampleTable::SampleTimeIndex::countAtOrBefore(uint64_t time, uint64_t *count) {
+    // Chunks whose upper bound is <= time count in full, chunks whose lower
+    // bound is > time not at all; only the ones in between are expanded.
+    Chunk *begin = std::upper_bound(
+            mChunks, mChunks + mNumChunks, time,
+            [](uint64_t t, const Chunk &chunk) { return t < chunk.mMaxTime; });
+    Chunk *end = std::upper_bound(
+            begin, mChunks + mNumChunks, time,
+            [](uint64_t t, const Chunk &chunk) { return t < chunk.mMinTime; });
+
+    *count = begin != mChunks + mNumChunks ? begin->mFirstSample : mNumSamples;
+    for (Chunk *chunk = begin; chunk != end; ++chunk) {
+        status_t err = expand(chunk);
+        if (err != OK) {
+            return err;
+        }
+        *count += countAtOrBefore(*chunk, time, 1, 1);
+    }
+
+    return OK;
+}
+
+status_t SampleTable::SampleTimeIndex::findAtRank(uint32_t rank, uint32_t *sampleIndex) {
+    if (rank >= mNumSamples) {
+        return ERROR_OUT_OF_RANGE;
+    }
+
+    // Find the earliest time with more than |rank| samples at or before it.
+    uint64_t low = mChunks[0].mMinTime;
+    uint64_t high = mChunks[mNumChunks - 1].mMaxTime;
+    while (low < high) {
+        uint64_t center = low + (high - low) / 2;
+        uint64_t count;
+        status_t err = countAtOrBefore(center, &count);
+        if (err != OK) {
+            return err;
+        }
+        if (count > rank) {
+            high = center;
+        } else {
+            low = center + 1;
+        }
+    }
+
+    uint64_t countBefore = 0;
+    if (low > 0) {
+        status_t err = countAtOrBefore(low - 1, &countBefore);
+        if (err != OK) {
+            return err;
+        }
+    }
+
+    // Pick among the samples sharing that time in chunk order.
+    uint64_t skip = rank - countBefore;
+    Chunk *begin = std::lower_bound(
+            mChunks, mChunks + mNumChunks, low,
+            [](const Chunk &chunk, uint64_t t) { return chunk.mMaxTime < t; });
+    for (Chunk *chunk = begin;
+            chunk != mChunks + mNumChunks && chunk->mMinTime <= low; ++chunk) {
+        status_t err = expand(chunk);
+        if (err != OK) {
+            return err;
+        }
+
+        size_t first = low > 0 ? countAtOrBefore(*chunk, low - 1, 1, 1) : 0;
+        size_t last = countAtOrBefore(*chunk, low, 1, 1);
+        if (skip < last - first) {
+            *sampleIndex = chunk->mFirstSample + chunk->mSampleOffsets[first + skip];
+            return OK;
+        }
+        skip -= last - first;
+    }
+
+    return ERROR_OUT_OF_RANGE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 SampleTable::SampleTable(DataSourceHelper *source)
     : mDataSource(source),
       mChunkOffsetOffset(-1),
@@ -128,7 +623,7 @@ SampleTable::SampleTable(DataSourceHelper *source)
       mHasTimeToSample(false),
       mTimeToSampleCount(0),
       mTimeToSample(NULL),
-      mSampleTimeEntries(NULL),
+      mSampleTimeIndex(NULL),
       mCompositionTimeDeltaEntries(NULL),
       mNumCompositionTimeDeltaEntries(0),
       mCompositionDeltaLookup(new CompositionDeltaLookup),
@@ -157,8 +652,8 @@ SampleTable::~SampleTable() {
     delete[] mCompositionTimeDeltaEntries;
     mCompositionTimeDeltaEntries = NULL;
 
-    delete[] mSampleTimeEntries;
-    mSampleTimeEntries = NULL;
+    delete mSampleTimeIndex;
+    mSampleTimeIndex = NULL;
 
     delete mSampleIterator;
     mSampleIterator = NULL;
@@ -615,147 +1110,58 @@ uint32_t abs_difference(uint64_t time1, uint64_t time2) {
     return time1 > time2 ? time1 - time2 : time2 - time1;
 }
 
-// static
-int SampleTable::CompareIncreasingTime(const void *_a, const void *_b) {
-    const SampleTimeEntry *a = (const SampleTimeEntry *)_a;
-    const SampleTimeEntry *b = (const SampleTimeEntry *)_b;
-
-    if (a->mCompositionTime < b->mCompositionTime) {
-        return -1;
-    } else if (a->mCompositionTime > b->mCompositionTime) {
-        return 1;
-    }
-
-    return 0;
-}
-
-void SampleTable::buildSampleEntriesTable() {
-    Mutex::Autolock autoLock(mLock);
-
-    if (mSampleTimeEntries != NULL || mNumSampleSizes == 0) {
-        if (mNumSampleSizes == 0) {
-            ALOGE("b/23247055, mNumSampleSizes(%u)", mNumSampleSizes);
-        }
-        return;
-    }
-
-    mTotalSize += (uint64_t)mNumSampleSizes * sizeof(SampleTimeEntry);
-    if (mTotalSize > kMaxTotalSize) {
-        ALOGE("Sample entry table size would make sample table too large.\n"
-              "    Requested sample entry table size = %llu\n"
-              "    Eventual sample table size >= %llu\n"
-              "    Allowed sample table size = %llu\n",
-              (unsigned long long)mNumSampleSizes * sizeof(SampleTimeEntry),
-              (unsigned long long)mTotalSize,
-              (unsigned long long)kMaxTotalSize);
-        return;
-    }
-
-    mSampleTimeEntries = new (std::nothrow) SampleTimeEntry[mNumSampleSizes];
-
-    if (!mSampleTimeEntries) {
-        ALOGE("Cannot allocate sample entry table with %llu entries.",
-                (unsigned long long)mNumSampleSizes);
-        return;
-    }
-    memset(mSampleTimeEntries, 0, sizeof(SampleTimeEntry) * mNumSampleSizes);
-
-    uint32_t sampleIndex = 0;
-    uint64_t sampleTime = 0;
-
-    for (uint32_t i = 0; i < mTimeToSampleCount; ++i) {
-        uint32_t n = mTimeToSample[2 * i];
-        uint32_t delta = mTimeToSample[2 * i + 1];
-
-        for (uint32_t j = 0; j < n; ++j) {
-            if (sampleIndex < mNumSampleSizes) {
-                // Technically this should always be the case if the file
-                // is well-formed, but you know... there's (gasp) malformed
-                // content out there.
-
-                mSampleTimeEntries[sampleIndex].mSampleIndex = sampleIndex;
-
-                int32_t compTimeDelta =
-                    mCompositionDeltaLookup->getCompositionTimeOffset(
-                            sampleIndex);
-
-                if ((compTimeDelta < 0 && sampleTime <
-                        (compTimeDelta == INT32_MIN ?
-                                INT32_MAX : uint32_t(-compTimeDelta)))
-                        || (compTimeDelta > 0 &&
-                                sampleTime > UINT64_MAX - compTimeDelta)) {
-                    ALOGE("%llu + %d would overflow, clamping",
-                            (unsigned long long) sampleTime, compTimeDelta);
-                    if (compTimeDelta < 0) {
-                        sampleTime = 0;
-                    } else {
-                        sampleTime = UINT64_MAX;
-                    }
-                    compTimeDelta = 0;
-                }
-
-                mSampleTimeEntries[sampleIndex].mCompositionTime =
-                        compTimeDelta > 0 ? sampleTime + compTimeDelta:
-                                sampleTime - (-compTimeDelta);
-            }
-
-            ++sampleIndex;
-            if (sampleTime > UINT64_MAX - delta) {
-                ALOGE("%llu + %u would overflow, clamping",
-                    (unsigned long long) sampleTime, delta);
-                sampleTime = UINT64_MAX;
-            } else {
-                sampleTime += delta;
-            }
+status_t SampleTable::buildSampleTimeIndex_l() {
+    if (mSampleTimeIndex == NULL) {
+        mSampleTimeIndex = new SampleTimeIndex(this);
+        if (mSampleTimeIndex->build() != OK) {
+            ALOGE("Cannot build sample time index.");
         }
     }
 
-    qsort(mSampleTimeEntries, mNumSampleSizes, sizeof(SampleTimeEntry),
-          CompareIncreasingTime);
+    return mSampleTimeIndex->countSamples() > 0 ? OK : ERROR_OUT_OF_RANGE;
 }
 
 status_t SampleTable::findSampleAtTime(
         uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
         uint32_t *sample_index, uint32_t flags) {
-    buildSampleEntriesTable();
+    Mutex::Autolock autoLock(mLock);
 
-    if (mSampleTimeEntries == NULL) {
+    if (buildSampleTimeIndex_l() != OK) {
         return ERROR_OUT_OF_RANGE;
     }
 
     if (flags == kFlagFrameIndex) {
-        if (req_time >= mNumSampleSizes) {
+        if (req_time >= mSampleTimeIndex->countSamples()) {
             return ERROR_OUT_OF_RANGE;
         }
-        *sample_index = mSampleTimeEntries[req_time].mSampleIndex;
-        return OK;
+        return mSampleTimeIndex->findAtRank(req_time, sample_index) == OK
+                ? OK : ERROR_OUT_OF_RANGE;
     }
 
-    uint32_t left = 0;
-    uint32_t right_plus_one = mNumSampleSizes;
-    while (left < right_plus_one) {
-        uint32_t center = left + (right_plus_one - left) / 2;
-        uint64_t centerTime =
-            getSampleTime(center, scale_num, scale_den);
+    bool hasBefore, hasAfter;
+    uint64_t beforeTime, afterTime;
+    uint32_t beforeIndex, afterIndex;
+    if (mSampleTimeIndex->findAtOrBefore(
+                req_time, scale_num, scale_den, &hasBefore, &beforeTime, &beforeIndex) != OK) {
+        return ERROR_OUT_OF_RANGE;
+    }
 
-        if (req_time < centerTime) {
-            right_plus_one = center;
-        } else if (req_time > centerTime) {
-            left = center + 1;
-        } else {
-            *sample_index = mSampleTimeEntries[center].mSampleIndex;
-            return OK;
-        }
+    if (hasBefore && SampleTimeIndex::scaleTime(beforeTime, scale_num, scale_den) == req_time) {
+        *sample_index = beforeIndex;
+        return OK;
     }
 
-    uint32_t closestIndex = left;
+    if (mSampleTimeIndex->findAfter(
+                req_time, scale_num, scale_den, &hasAfter, &afterTime, &afterIndex) != OK) {
+        return ERROR_OUT_OF_RANGE;
+    }
 
-    if (closestIndex == mNumSampleSizes) {
+    if (!hasAfter) {
         if (flags == kFlagAfter) {
             return ERROR_OUT_OF_RANGE;
         }
         flags = kFlagBefore;
-    } else if (closestIndex == 0) {
+    } else if (!hasBefore) {
         if (flags == kFlagBefore) {
             // normally we should return out of range, but that is
             // treated as end-of-stream.  instead return first sample
@@ -768,13 +1174,13 @@ status_t SampleTable::findSampleAtTime(
     switch (flags) {
         case kFlagBefore:
         {
-            --closestIndex;
+            *sample_index = beforeIndex;
             break;
         }
 
         case kFlagAfter:
         {
-            // nothing to do
+            *sample_index = afterIndex;
             break;
         }
 
@@ -783,16 +1189,17 @@ status_t SampleTable::findSampleAtTime(
             CHECK(flags == kFlagClosest);
             // pick closest based on timestamp. use abs_difference for safety
             if (abs_difference(
-                    getSampleTime(closestIndex, scale_num, scale_den), req_time) >
+                    SampleTimeIndex::scaleTime(afterTime, scale_num, scale_den), req_time) >
                 abs_difference(
-                    req_time, getSampleTime(closestIndex - 1, scale_num, scale_den))) {
-                --closestIndex;
+                    req_time, SampleTimeIndex::scaleTime(beforeTime, scale_num, scale_den))) {
+                *sample_index = beforeIndex;
+            } else {
+                *sample_index = afterIndex;
             }
             break;
         }
     }
 
-    *sample_index = mSampleTimeEntries[closestIndex].mSampleIndex;
     return OK;
 }
 
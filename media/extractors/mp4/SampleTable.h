@@ -98,6 +98,7 @@ protected:
 
 private:
     struct CompositionDeltaLookup;
+    struct SampleTimeIndex;
 
     static const uint32_t kChunkOffsetType32;
     static const uint32_t kChunkOffsetType64;
@@ -126,11 +127,8 @@ private:
     uint32_t mTimeToSampleCount;
     uint32_t* mTimeToSample;
 
-    struct SampleTimeEntry {
-        uint32_t mSampleIndex;
-        uint64_t mCompositionTime;
-    };
-    SampleTimeEntry *mSampleTimeEntries;
+    // Built on the first findSampleAtTime() call.
+    SampleTimeIndex *mSampleTimeIndex;
 
     int32_t *mCompositionTimeDeltaEntries;
     size_t mNumCompositionTimeDeltaEntries;
@@ -155,20 +153,10 @@ private:
 
     friend struct SampleIterator;
 
-    // normally we don't round
-    inline uint64_t getSampleTime(
-            size_t sample_index, uint64_t scale_num, uint64_t scale_den) const {
-        return (sample_index < (size_t)mNumSampleSizes && mSampleTimeEntries != NULL
-                && scale_den != 0)
-                ? (mSampleTimeEntries[sample_index].mCompositionTime * scale_num) / scale_den : 0;
-    }
-
     status_t getSampleSize_l(uint32_t sample_index, size_t *sample_size);
     int32_t getCompositionTimeOffset(uint32_t sampleIndex);
 
-    static int CompareIncreasingTime(const void *, const void *);
-
-    void buildSampleEntriesTable();
+    status_t buildSampleTimeIndex_l();
 
     SampleTable(const SampleTable &);
     SampleTable &operator=(const SampleTable &);
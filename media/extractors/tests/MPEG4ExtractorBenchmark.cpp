@@ -0,0 +1,311 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <datasource/FileSource.h>
+#include <media/stagefright/MediaBufferGroup.h>
+
+#include "mp4/MPEG4Extractor.h"
+#include "SyntheticMp4Writer.h"
+
+using namespace android;
+
+namespace {
+
+const uint32_t kFramesPerHour = 30 * 60 * 60;
+const uint32_t kFragments = 10000;
+const uint32_t kFramesPerFragment = 60;
+
+// Synthetic files are written once per name and removed on exit.
+class SyntheticFiles {
+public:
+    ~SyntheticFiles() {
+        for (const auto &entry : mPaths) {
+            unlink(entry.second.c_str());
+        }
+    }
+
+    const std::string &get(uint32_t hours) {
+        return get(std::to_string(hours) + "h", [hours](const std::string &path) {
+            SyntheticMp4Writer::Params params;
+            params.numSamples = hours * kFramesPerHour;
+            return SyntheticMp4Writer::writeProgressive(path, params);
+        });
+    }
+
+    const std::string &getFragmented(bool withMfra) {
+        return get(withMfra ? "fragmented_mfra" : "fragmented",
+                [withMfra](const std::string &path) {
+            SyntheticMp4Writer::Params params;
+            params.numSamples = kFragments * kFramesPerFragment;
+            params.syncInterval = kFramesPerFragment;
+            return SyntheticMp4Writer::writeFragmented(
+                    path, params, kFramesPerFragment, withMfra);
+        });
+    }
+
+private:
+    const std::string &get(const std::string &name,
+            const std::function<bool(const std::string &)> &write) {
+        auto it = mPaths.find(name);
+        if (it != mPaths.end()) {
+            return it->second;
+        }
+        const char *dir = getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr ? dir : "/data/local/tmp")
+                + "/MPEG4ExtractorBenchmark_" + name + ".mp4";
+        if (!write(path)) {
+            path.clear();
+        }
+        return mPaths[name] = path;
+    }
+
+    std::map<std::string, std::string> mPaths;
+};
+
+SyntheticFiles gFiles;
+
+// Resets the peak resident set size of the process, see proc(5).
+void resetPeakRss() {
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp != nullptr) {
+        fputs("5", fp);
+        fclose(fp);
+    }
+}
+
+double peakRssKb() {
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp == nullptr) {
+        return 0;
+    }
+    char line[128];
+    long kb = 0;
+    while (fgets(line, sizeof(line), fp) != nullptr) {
+        if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(fp);
+    return kb;
+}
+
+// The extractor and started video track of one synthetic file.
+struct OpenFile {
+    explicit OpenFile(const std::string &path) {
+        mSource = new FileSource(path.c_str());
+        if (mSource->initCheck() != OK) {
+            return;
+        }
+        mExtractor = new MPEG4Extractor(new DataSourceHelper(mSource->wrap()));
+        if (mExtractor->countTracks() != 1) {
+            return;
+        }
+        mTrack = mExtractor->getTrack(0);
+        mTrackWrapper = wrap(mTrack);
+        if (mTrackWrapper == nullptr) {
+            return;
+        }
+        mBufferGroup = new MediaBufferGroup();
+        mStarted = mTrackWrapper->start(mTrack, mBufferGroup->wrap()) == AMEDIA_OK;
+    }
+
+    ~OpenFile() {
+        if (mStarted) {
+            mTrackWrapper->stop(mTrack);
+        }
+        delete mTrack;
+        free(mTrackWrapper);
+        delete mBufferGroup;
+        delete mExtractor;
+        mSource.clear();
+    }
+
+    bool seekTo(int64_t seekPos, MediaTrackHelper::ReadOptions::SeekMode mode) {
+        MediaTrackHelper::ReadOptions options(mode | CMediaTrackReadOptions::SEEK, seekPos);
+        MediaBufferHelper *buffer = nullptr;
+        media_status_t status = mTrack->read(&buffer, &options);
+        if (buffer != nullptr) {
+            buffer->release();
+        }
+        return status == AMEDIA_OK;
+    }
+
+    sp<DataSource> mSource;
+    MPEG4Extractor *mExtractor = nullptr;
+    MediaTrackHelper *mTrack = nullptr;
+    CMediaTrack *mTrackWrapper = nullptr;
+    MediaBufferGroup *mBufferGroup = nullptr;
+    bool mStarted = false;
+};
+
+void setCounters(benchmark::State &state, uint32_t hours) {
+    state.counters["samples"] = hours * kFramesPerHour;
+    state.counters["peak_rss_kB"] = peakRssKb();
+}
+
+// Time to parse the moov box and start the track of a state.range(0) hour file.
+void BM_MPEG4Open(benchmark::State &state) {
+    const uint32_t hours = state.range(0);
+    const std::string &path = gFiles.get(hours);
+    if (path.empty()) {
+        state.SkipWithError("Cannot write synthetic file");
+        return;
+    }
+
+    resetPeakRss();
+    for (auto _ : state) {
+        OpenFile *file = new OpenFile(path);
+
+        // Closing is not part of the measurement.
+        state.PauseTiming();
+        bool started = file->mStarted;
+        delete file;
+        state.ResumeTiming();
+
+        if (!started) {
+            state.SkipWithError("Cannot open synthetic file");
+            return;
+        }
+    }
+    setCounters(state, hours);
+}
+
+// Time of the first seek into a freshly opened state.range(0) hour file, which
+// is when the sample time index gets built. Seek targets are spread over the
+// file so that no part of the index is favored.
+template <MediaTrackHelper::ReadOptions::SeekMode MODE>
+void BM_MPEG4FirstSeek(benchmark::State &state) {
+    const uint32_t hours = state.range(0);
+    const std::string &path = gFiles.get(hours);
+    if (path.empty()) {
+        state.SkipWithError("Cannot write synthetic file");
+        return;
+    }
+
+    resetPeakRss();
+    const int64_t durationUs = hours * 3600 * 1000000ll;
+    int64_t seekTimeUs = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        OpenFile *file = new OpenFile(path);
+        if (!file->mStarted) {
+            delete file;
+            state.SkipWithError("Cannot open synthetic file");
+            return;
+        }
+        seekTimeUs = (seekTimeUs + 7919 * 1000000ll) % durationUs;
+        // Frame index seeks take a frame number instead of a time.
+        int64_t seekPos = MODE == MediaTrackHelper::ReadOptions::SEEK_FRAME_INDEX
+                ? seekTimeUs * 30 / 1000000 : seekTimeUs;
+        state.ResumeTiming();
+
+        if (!file->seekTo(seekPos, MODE)) {
+            state.SkipWithError("Seek failed");
+        }
+
+        state.PauseTiming();
+        delete file;
+        state.ResumeTiming();
+    }
+    setCounters(state, hours);
+}
+
+// Time of the first seek into a freshly opened file of 10,000 fragments, with
+// an mfra box if state.range(0) is set. Without one, the fragment index is
+// extended up to the seek target.
+void BM_FragmentedMPEG4FirstSeek(benchmark::State &state) {
+    const std::string &path = gFiles.getFragmented(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("Cannot write synthetic file");
+        return;
+    }
+
+    const int64_t fragmentUs = kFramesPerFragment * 1000000ll / 30;
+    const int64_t durationUs = kFragments * fragmentUs;
+    int64_t seekTimeUs = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        OpenFile *file = new OpenFile(path);
+        if (!file->mStarted) {
+            delete file;
+            state.SkipWithError("Cannot open synthetic file");
+            return;
+        }
+        seekTimeUs = (seekTimeUs + 7919 * fragmentUs + 1000000ll / 3) % durationUs;
+        state.ResumeTiming();
+
+        if (!file->seekTo(seekTimeUs, MediaTrackHelper::ReadOptions::SEEK_PREVIOUS_SYNC)) {
+            state.SkipWithError("Seek failed");
+        }
+
+        state.PauseTiming();
+        delete file;
+        state.ResumeTiming();
+    }
+    state.counters["fragments"] = kFragments;
+}
+
+// Time of a random seek into a file of 10,000 fragments whose index is already
+// complete, with an mfra box if state.range(0) is set.
+void BM_FragmentedMPEG4Seek(benchmark::State &state) {
+    const std::string &path = gFiles.getFragmented(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("Cannot write synthetic file");
+        return;
+    }
+
+    OpenFile file(path);
+    const int64_t fragmentUs = kFramesPerFragment * 1000000ll / 30;
+    const int64_t durationUs = kFragments * fragmentUs;
+    if (!file.mStarted
+            || !file.seekTo(durationUs - 1, MediaTrackHelper::ReadOptions::SEEK_PREVIOUS_SYNC)) {
+        state.SkipWithError("Cannot open synthetic file");
+        return;
+    }
+
+    int64_t seekTimeUs = 0;
+    for (auto _ : state) {
+        seekTimeUs = (seekTimeUs + 7919 * fragmentUs + 1000000ll / 3) % durationUs;
+        if (!file.seekTo(seekTimeUs, MediaTrackHelper::ReadOptions::SEEK_PREVIOUS_SYNC)) {
+            state.SkipWithError("Seek failed");
+            return;
+        }
+    }
+    state.counters["fragments"] = kFragments;
+}
+
+BENCHMARK(BM_MPEG4Open)->Arg(1)->Arg(4)->Arg(12)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MPEG4FirstSeek, MediaTrackHelper::ReadOptions::SEEK_PREVIOUS_SYNC)
+        ->Arg(1)->Arg(4)->Arg(12)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MPEG4FirstSeek, MediaTrackHelper::ReadOptions::SEEK_CLOSEST)
+        ->Arg(1)->Arg(4)->Arg(12)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MPEG4FirstSeek, MediaTrackHelper::ReadOptions::SEEK_FRAME_INDEX)
+        ->Arg(1)->Arg(4)->Arg(12)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FragmentedMPEG4FirstSeek)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FragmentedMPEG4Seek)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "MPEG4ExtractorTest"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <datasource/FileSource.h>
+#include <gtest/gtest.h>
+#include <media/stagefright/MediaBufferGroup.h>
+
+#include "mp4/MPEG4Extractor.h"
+#include "SyntheticMp4Writer.h"
+
+using namespace android;
+
+namespace {
+
+using SeekMode = MediaTrackHelper::ReadOptions::SeekMode;
+
+constexpr uint32_t kFragments = 12;
+constexpr uint32_t kSamplesPerFragment = 3;
+// Three samples of 3000 ticks at 90kHz.
+constexpr int64_t kFragmentUs = 100000;
+// Time of the second sample of a fragment from its start, rounded down.
+constexpr int64_t kSampleUs = 33333;
+
+const SeekMode kModes[] = {
+    MediaTrackHelper::ReadOptions::SEEK_PREVIOUS_SYNC,
+    MediaTrackHelper::ReadOptions::SEEK_NEXT_SYNC,
+    MediaTrackHelper::ReadOptions::SEEK_CLOSEST_SYNC,
+};
+
+// Every fragment starts with a sync sample, and presentation times equal
+// decode times so that tfra times are fragment start times.
+SyntheticMp4Writer::Params fragmentedParams(uint64_t baseDecodeTime) {
+    SyntheticMp4Writer::Params params;
+    params.numSamples = kFragments * kSamplesPerFragment;
+    params.syncInterval = kSamplesPerFragment;
+    params.reordered = false;
+    params.baseDecodeTime = baseDecodeTime;
+    return params;
+}
+
+// The start of, and two points within, the first, two middle and the last
+// fragments, and a time past the end of the file.
+std::vector<int64_t> seekTimesUs() {
+    std::vector<int64_t> times;
+    for (uint32_t fragment : {0u, kFragments / 2, kFragments / 2 + 1, kFragments - 1}) {
+        for (int64_t offsetUs : {0, 30000, 70000}) {
+            times.push_back(fragment * kFragmentUs + offsetUs);
+        }
+    }
+    times.push_back(kFragments * kFragmentUs + 500000);
+    return times;
+}
+
+std::vector<int64_t> fragmentStartsUs(uint32_t stride) {
+    std::vector<int64_t> starts;
+    for (uint32_t fragment = 0; fragment < kFragments; fragment += stride) {
+        starts.push_back(fragment * kFragmentUs);
+    }
+    return starts;
+}
+
+// Time of the sample a seek to |seekTimeUs| resumes from, when the extractor
+// can only seek to the fragments starting at |startsUs|.
+int64_t expectedSeekUs(const std::vector<int64_t> &startsUs, int64_t seekTimeUs,
+        SeekMode mode) {
+    size_t i = std::upper_bound(startsUs.begin(), startsUs.end(), seekTimeUs) - startsUs.begin();
+    i = i == 0 ? 0 : i - 1;
+    if (i + 1 < startsUs.size() && seekTimeUs > startsUs[i]) {
+        if (mode == MediaTrackHelper::ReadOptions::SEEK_NEXT_SYNC
+                || (mode == MediaTrackHelper::ReadOptions::SEEK_CLOSEST_SYNC
+                        && seekTimeUs - startsUs[i] > startsUs[i + 1] - seekTimeUs)) {
+            ++i;
+        }
+    }
+    return startsUs[i];
+}
+
+// The extractor and started video track of one synthetic file.
+struct OpenFile {
+    explicit OpenFile(const std::string &path) {
+        mSource = new FileSource(path.c_str());
+        if (mSource->initCheck() != OK) {
+            return;
+        }
+        mExtractor = new MPEG4Extractor(new DataSourceHelper(mSource->wrap()));
+        if (mExtractor->countTracks() != 1) {
+            return;
+        }
+        mTrack = mExtractor->getTrack(0);
+        mTrackWrapper = wrap(mTrack);
+        if (mTrackWrapper == nullptr) {
+            return;
+        }
+        mBufferGroup = new MediaBufferGroup();
+        mStarted = mTrackWrapper->start(mTrack, mBufferGroup->wrap()) == AMEDIA_OK;
+    }
+
+    ~OpenFile() {
+        if (mStarted) {
+            mTrackWrapper->stop(mTrack);
+        }
+        delete mTrack;
+        free(mTrackWrapper);
+        delete mBufferGroup;
+        delete mExtractor;
+        mSource.clear();
+    }
+
+    // Returns the time of the first sample read after the seek, or -1 if none was.
+    int64_t seekTo(int64_t seekTimeUs, SeekMode mode) {
+        MediaTrackHelper::ReadOptions options(mode | CMediaTrackReadOptions::SEEK, seekTimeUs);
+        return read(&options);
+    }
+
+    // Returns the time of the next sample, or -1 if there is none.
+    int64_t nextTimeUs() { return read(nullptr); }
+
+    int64_t read(const MediaTrackHelper::ReadOptions *options) {
+        MediaBufferHelper *buffer = nullptr;
+        int64_t timeUs = -1;
+        if (mTrack->read(&buffer, options) == AMEDIA_OK && buffer != nullptr
+                && !AMediaFormat_getInt64(buffer->meta_data(), AMEDIAFORMAT_KEY_TIME_US, &timeUs)) {
+            timeUs = -1;
+        }
+        if (buffer != nullptr) {
+            buffer->release();
+        }
+        return timeUs;
+    }
+
+    sp<DataSource> mSource;
+    MPEG4Extractor *mExtractor = nullptr;
+    MediaTrackHelper *mTrack = nullptr;
+    CMediaTrack *mTrackWrapper = nullptr;
+    MediaBufferGroup *mBufferGroup = nullptr;
+    bool mStarted = false;
+};
+
+class FragmentSeekTest : public ::testing::Test {
+protected:
+    void TearDown() override {
+        for (const std::string &path : mPaths) {
+            unlink(path.c_str());
+        }
+    }
+
+    // Writes a fragmented file, with an mfra box laid out as |tfra| describes
+    // unless it is null, whose first fragment starts at |baseDecodeTime|.
+    std::string write(const std::string &name, const SyntheticMp4Writer::TfraParams *tfra,
+            uint64_t baseDecodeTime = 0) {
+        const char *dir = getenv("TMPDIR");
+        std::string path = std::string(dir != nullptr ? dir : "/data/local/tmp")
+                + "/MPEG4ExtractorTest_" + name + ".mp4";
+        mPaths.push_back(path);
+        EXPECT_TRUE(SyntheticMp4Writer::writeFragmented(
+                path, fragmentedParams(baseDecodeTime), kSamplesPerFragment, tfra)) << path;
+        return path;
+    }
+
+    // Checks every seek, each on a freshly opened file so that the fragment
+    // index is built by that seek, against |startsUs|, and that the sample
+    // after the one sought to follows it.
+    void checkSeeks(const std::string &path, const std::vector<int64_t> &startsUs) {
+        for (SeekMode mode : kModes) {
+            for (int64_t seekTimeUs : seekTimesUs()) {
+                OpenFile file(path);
+                ASSERT_TRUE(file.mStarted) << path;
+                const int64_t expectedUs = expectedSeekUs(startsUs, seekTimeUs, mode);
+                EXPECT_EQ(expectedUs, file.seekTo(seekTimeUs, mode))
+                        << "mode " << mode << ", seek to " << seekTimeUs;
+                EXPECT_EQ(expectedUs + kSampleUs, file.nextTimeUs())
+                        << "mode " << mode << ", seek to " << seekTimeUs;
+            }
+        }
+    }
+
+    std::vector<std::string> mPaths;
+};
+
+} // namespace
+
+// Without mfra, the fragment index is extended by scanning moof boxes.
+TEST_F(FragmentSeekTest, SequentialScan) {
+    const std::string path = write("sequential", nullptr);
+    checkSeeks(path, fragmentStartsUs(1));
+
+    // The same seeks on one file, backwards after forwards, reuse the index.
+    OpenFile file(path);
+    ASSERT_TRUE(file.mStarted);
+    std::vector<int64_t> times = seekTimesUs();
+    for (int pass = 0; pass < 2; ++pass) {
+        for (SeekMode mode : kModes) {
+            for (int64_t seekTimeUs : times) {
+                EXPECT_EQ(expectedSeekUs(fragmentStartsUs(1), seekTimeUs, mode),
+                        file.seekTo(seekTimeUs, mode))
+                        << "mode " << mode << ", seek to " << seekTimeUs;
+            }
+        }
+        std::reverse(times.begin(), times.end());
+    }
+}
+
+TEST_F(FragmentSeekTest, TfraMatchesSequentialScan) {
+    const std::string sequential = write("sequential", nullptr);
+    SyntheticMp4Writer::TfraParams tfra;
+    const std::string indexed = write("tfra", &tfra);
+
+    for (SeekMode mode : kModes) {
+        for (int64_t seekTimeUs : seekTimesUs()) {
+            OpenFile sequentialFile(sequential);
+            OpenFile indexedFile(indexed);
+            ASSERT_TRUE(sequentialFile.mStarted);
+            ASSERT_TRUE(indexedFile.mStarted);
+            EXPECT_EQ(sequentialFile.seekTo(seekTimeUs, mode), indexedFile.seekTo(seekTimeUs, mode))
+                    << "mode " << mode << ", seek to " << seekTimeUs;
+        }
+    }
+}
+
+// The tfra box only lists every other fragment, so seeks that land on the
+// listed fragments alone show that it was parsed.
+TEST_F(FragmentSeekTest, TfraLayouts) {
+    SyntheticMp4Writer::TfraParams tfra;
+    tfra.fragmentStride = 2;
+    for (uint8_t version : {0, 1}) {
+        for (uint8_t lengthSizes = 0; lengthSizes < 64; ++lengthSizes) {
+            tfra.version = version;
+            tfra.trafNumberSize = lengthSizes >> 4;
+            tfra.trunNumberSize = (lengthSizes >> 2) & 3;
+            tfra.sampleNumberSize = lengthSizes & 3;
+            SCOPED_TRACE(testing::Message() << "version " << (int)version
+                    << ", length sizes " << (int)lengthSizes);
+            checkSeeks(write("tfra", &tfra), fragmentStartsUs(2));
+        }
+    }
+}
+
+// A tfra box counting more entries than it holds is ignored, and seeks fall
+// back to scanning moof boxes.
+TEST_F(FragmentSeekTest, TruncatedTfra) {
+    SyntheticMp4Writer::TfraParams tfra;
+    tfra.fragmentStride = 2;
+    tfra.missingEntries = 1;
+    for (uint8_t version : {0, 1}) {
+        tfra.version = version;
+        SCOPED_TRACE(testing::Message() << "version " << (int)version);
+        checkSeeks(write("truncated_tfra", &tfra), fragmentStartsUs(1));
+    }
+}
+
+// Files cut from a live stream start with a non-zero decode time. Playback
+// starts at 0 all the same, and seeks count from there.
+TEST_F(FragmentSeekTest, NonZeroBaseDecodeTime) {
+    // The second base does not fit in 32 bits, nor in version 0 tfra boxes.
+    for (uint64_t baseDecodeTime : {900000ull, (1ull << 32) + 900000}) {
+        SCOPED_TRACE(testing::Message() << "base decode time " << baseDecodeTime);
+        const std::string sequential = write("base_sequential", nullptr, baseDecodeTime);
+        {
+            OpenFile file(sequential);
+            ASSERT_TRUE(file.mStarted);
+            EXPECT_EQ(0, file.nextTimeUs());
+            EXPECT_EQ(kSampleUs, file.nextTimeUs());
+        }
+        checkSeeks(sequential, fragmentStartsUs(1));
+
+        SyntheticMp4Writer::TfraParams tfra;
+        tfra.fragmentStride = 2;
+        for (uint8_t version : {0, 1}) {
+            if (version == 0 && baseDecodeTime > UINT32_MAX) {
+                continue;
+            }
+            tfra.version = version;
+            SCOPED_TRACE(testing::Message() << "version " << (int)version);
+            checkSeeks(write("base_tfra", &tfra, baseDecodeTime), fragmentStartsUs(2));
+        }
+    }
+}
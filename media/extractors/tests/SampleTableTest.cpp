@@ -0,0 +1,473 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "SampleTableTest"
+
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/MediaExtractorPluginHelper.h>
+#include <media/stagefright/foundation/ByteUtils.h>
+
+#include "mp4/SampleTable.h"
+
+using namespace android;
+
+namespace {
+
+// Serves the sample table boxes from memory.
+class BufferSource : public DataSourceHelper {
+public:
+    explicit BufferSource(std::vector<uint8_t> data)
+        : DataSourceHelper((CDataSource *)nullptr), mData(std::move(data)) {}
+
+    ssize_t readAt(off64_t offset, void *data, size_t size) override {
+        if (offset < 0 || (size_t)offset >= mData.size()) {
+            return 0;
+        }
+        size = std::min(size, mData.size() - (size_t)offset);
+        memcpy(data, mData.data() + offset, size);
+        return size;
+    }
+
+    status_t getSize(off64_t *size) override {
+        *size = mData.size();
+        return OK;
+    }
+
+    uint32_t flags() override {
+        return 0;
+    }
+
+private:
+    std::vector<uint8_t> mData;
+};
+
+// Contents of the stts, ctts and stss boxes, in file order. The ctts and stss
+// boxes are left out when empty.
+struct Tables {
+    std::vector<std::pair<uint32_t, uint32_t>> mTimeToSample;      // count, delta
+    std::vector<std::pair<uint32_t, int32_t>> mCompositionDeltas;  // count, offset
+    std::vector<uint32_t> mSyncSamples;                           // 1-based
+    bool mHasSyncSamples = false;
+};
+
+void appendU32(std::vector<uint8_t> *data, uint32_t x) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data->push_back(x >> shift);
+    }
+}
+
+// The sample table lookups as they were implemented before the sample time
+// index: composition times of all the samples sorted once, then searched.
+// Composition times are distinct in these tests, so there is one answer.
+class LinearScan {
+public:
+    explicit LinearScan(const Tables &tables) {
+        uint64_t decodeTime = 0;
+        for (const auto &entry : tables.mTimeToSample) {
+            for (uint32_t i = 0; i < entry.first; ++i) {
+                mTimes.push_back(decodeTime);
+                decodeTime += entry.second;
+            }
+        }
+        size_t sample = 0;
+        for (const auto &entry : tables.mCompositionDeltas) {
+            for (uint32_t i = 0; i < entry.first && sample < mTimes.size(); ++i) {
+                mTimes[sample++] += entry.second;
+            }
+        }
+        for (uint32_t i = 0; i < mTimes.size(); ++i) {
+            mSorted.push_back(i);
+        }
+        std::sort(mSorted.begin(), mSorted.end(),
+                [this](uint32_t a, uint32_t b) { return mTimes[a] < mTimes[b]; });
+        for (uint32_t sample : tables.mSyncSamples) {
+            mSyncSamples.push_back(sample - 1);
+        }
+        mHasSyncSamples = tables.mHasSyncSamples;
+    }
+
+    uint64_t lastTime() const {
+        return mTimes.empty() ? 0 : mTimes[mSorted.back()];
+    }
+
+    const std::vector<uint64_t> &times() const {
+        return mTimes;
+    }
+
+    status_t findSampleAtTime(
+            uint64_t req_time, uint64_t scale_num, uint64_t scale_den,
+            uint32_t *sample_index, uint32_t flags) const {
+        const size_t n = mSorted.size();
+        if (n == 0) {
+            return ERROR_OUT_OF_RANGE;
+        }
+        if (flags == SampleTable::kFlagFrameIndex) {
+            if (req_time >= n) {
+                return ERROR_OUT_OF_RANGE;
+            }
+            *sample_index = mSorted[req_time];
+            return OK;
+        }
+
+        // number of samples before req_time, in composition order
+        size_t closest = 0;
+        for (; closest < n; ++closest) {
+            uint64_t time = scaledTime(closest, scale_num, scale_den);
+            if (time == req_time) {
+                *sample_index = mSorted[closest];
+                return OK;
+            }
+            if (time > req_time) {
+                break;
+            }
+        }
+
+        if (closest == n) {
+            if (flags == SampleTable::kFlagAfter) {
+                return ERROR_OUT_OF_RANGE;
+            }
+            flags = SampleTable::kFlagBefore;
+        } else if (closest == 0) {
+            flags = SampleTable::kFlagAfter;
+        }
+
+        if (flags == SampleTable::kFlagBefore) {
+            --closest;
+        } else if (flags == SampleTable::kFlagClosest) {
+            uint64_t after = scaledTime(closest, scale_num, scale_den) - req_time;
+            uint64_t before = req_time - scaledTime(closest - 1, scale_num, scale_den);
+            if (after > before) {
+                --closest;
+            }
+        }
+        *sample_index = mSorted[closest];
+        return OK;
+    }
+
+    status_t findSyncSampleNear(
+            uint32_t start_sample_index, uint32_t *sample_index, uint32_t flags) const {
+        if (!mHasSyncSamples) {
+            *sample_index = start_sample_index;
+            return OK;
+        }
+        if (mSyncSamples.empty()) {
+            *sample_index = 0;
+            return OK;
+        }
+        size_t i = 0;
+        while (i < mSyncSamples.size() && mSyncSamples[i] < start_sample_index) {
+            ++i;
+        }
+        if (i < mSyncSamples.size() && mSyncSamples[i] == start_sample_index) {
+            *sample_index = start_sample_index;
+            return OK;
+        }
+        if (i == mSyncSamples.size()) {
+            if (flags == SampleTable::kFlagAfter) {
+                return ERROR_OUT_OF_RANGE;
+            }
+            flags = SampleTable::kFlagBefore;
+        } else if (i == 0) {
+            flags = SampleTable::kFlagAfter;
+        }
+        *sample_index = mSyncSamples[flags == SampleTable::kFlagBefore ? i - 1 : i];
+        return OK;
+    }
+
+private:
+    uint64_t scaledTime(size_t rank, uint64_t scale_num, uint64_t scale_den) const {
+        return mTimes[mSorted[rank]] * scale_num / scale_den;
+    }
+
+    std::vector<uint64_t> mTimes;       // composition time of each sample
+    std::vector<uint32_t> mSorted;      // sample indices in composition order
+    std::vector<uint32_t> mSyncSamples; // 0-based
+    bool mHasSyncSamples;
+};
+
+// Tables of |numSamples| samples with random durations, reordered in random
+// groups of up to 8 samples like B-frames. Every 30th sample is a sync sample.
+Tables makeReorderedTables(uint32_t numSamples, unsigned seed, bool withCompositionDeltas) {
+    std::mt19937 gen(seed);
+    Tables tables;
+
+    std::vector<uint64_t> decodeTimes;
+    uint64_t decodeTime = 0;
+    while (decodeTimes.size() < numSamples) {
+        uint32_t count = std::min<uint32_t>(
+                std::uniform_int_distribution<uint32_t>(1, 50)(gen),
+                numSamples - decodeTimes.size());
+        uint32_t delta = std::uniform_int_distribution<uint32_t>(1, 3000)(gen);
+        tables.mTimeToSample.emplace_back(count, delta);
+        for (uint32_t i = 0; i < count; ++i) {
+            decodeTimes.push_back(decodeTime);
+            decodeTime += delta;
+        }
+    }
+
+    if (withCompositionDeltas) {
+        // Within a group, sample j is displayed at the decode time of sample
+        // order[j], delayed by more than a group so that offsets stay positive.
+        const int64_t delay = 8 * 3000;
+        for (uint32_t first = 0; first < numSamples; ) {
+            uint32_t size = std::min<uint32_t>(
+                    std::uniform_int_distribution<uint32_t>(1, 8)(gen), numSamples - first);
+            std::vector<uint32_t> order(size);
+            for (uint32_t j = 0; j < size; ++j) {
+                order[j] = first + j;
+            }
+            std::shuffle(order.begin(), order.end(), gen);
+            for (uint32_t j = 0; j < size; ++j) {
+                int32_t offset = (int64_t)decodeTimes[order[j]]
+                        - (int64_t)decodeTimes[first + j] + delay;
+                if (!tables.mCompositionDeltas.empty()
+                        && tables.mCompositionDeltas.back().second == offset) {
+                    ++tables.mCompositionDeltas.back().first;
+                } else {
+                    tables.mCompositionDeltas.emplace_back(1, offset);
+                }
+            }
+            first += size;
+        }
+    }
+
+    tables.mHasSyncSamples = true;
+    for (uint32_t i = 0; i < numSamples; i += 30) {
+        tables.mSyncSamples.push_back(i + 1);
+    }
+    return tables;
+}
+
+class SampleTableTest : public ::testing::Test {
+  protected:
+    // Sets up mSampleTable with the given tables and |numSamples| samples in stsz.
+    void makeSampleTable(const Tables &tables, uint32_t numSamples) {
+        std::vector<uint8_t> data;
+
+        const off64_t sampleSizeOffset = data.size();
+        appendU32(&data, 0);            // version and flags
+        appendU32(&data, 100);          // all samples have the same size
+        appendU32(&data, numSamples);
+        const size_t sampleSizeSize = data.size() - sampleSizeOffset;
+
+        const off64_t timeToSampleOffset = data.size();
+        appendU32(&data, 0);
+        appendU32(&data, tables.mTimeToSample.size());
+        for (const auto &entry : tables.mTimeToSample) {
+            appendU32(&data, entry.first);
+            appendU32(&data, entry.second);
+        }
+        const size_t timeToSampleSize = data.size() - timeToSampleOffset;
+
+        const off64_t compositionOffset = data.size();
+        appendU32(&data, 1 << 24);      // version 1, signed offsets
+        appendU32(&data, tables.mCompositionDeltas.size());
+        for (const auto &entry : tables.mCompositionDeltas) {
+            appendU32(&data, entry.first);
+            appendU32(&data, entry.second);
+        }
+        const size_t compositionSize = data.size() - compositionOffset;
+
+        const off64_t syncSampleOffset = data.size();
+        appendU32(&data, 0);
+        appendU32(&data, tables.mSyncSamples.size());
+        for (uint32_t sample : tables.mSyncSamples) {
+            appendU32(&data, sample);
+        }
+        const size_t syncSampleSize = data.size() - syncSampleOffset;
+
+        mSampleTable.clear();
+        mSource = std::make_unique<BufferSource>(std::move(data));
+        mSampleTable = new SampleTable(mSource.get());
+        ASSERT_EQ(OK, mSampleTable->setSampleSizeParams(
+                FOURCC("stsz"), sampleSizeOffset, sampleSizeSize));
+        ASSERT_EQ(OK, mSampleTable->setTimeToSampleParams(
+                timeToSampleOffset, timeToSampleSize));
+        if (!tables.mCompositionDeltas.empty()) {
+            ASSERT_EQ(OK, mSampleTable->setCompositionTimeToSampleParams(
+                    compositionOffset, compositionSize));
+        }
+        if (tables.mHasSyncSamples) {
+            ASSERT_EQ(OK, mSampleTable->setSyncSampleParams(
+                    syncSampleOffset, syncSampleSize));
+        }
+    }
+
+    // Compares every lookup mode at the given scaled time.
+    void expectSameSampleAtTime(
+            const LinearScan &reference, uint64_t req_time,
+            uint64_t scale_num, uint64_t scale_den) {
+        for (uint32_t flags : {SampleTable::kFlagBefore, SampleTable::kFlagAfter,
+                SampleTable::kFlagClosest, SampleTable::kFlagFrameIndex}) {
+            uint32_t expected = UINT32_MAX, actual = UINT32_MAX;
+            status_t expectedErr = reference.findSampleAtTime(
+                    req_time, scale_num, scale_den, &expected, flags);
+            status_t actualErr = mSampleTable->findSampleAtTime(
+                    req_time, scale_num, scale_den, &actual, flags);
+            ASSERT_EQ(expectedErr, actualErr)
+                    << "time " << req_time << " flags " << flags;
+            if (expectedErr == OK) {
+                ASSERT_EQ(expected, actual) << "time " << req_time << " flags " << flags;
+            }
+        }
+    }
+
+    // Compares lookups at, just before and just after the time of every
+    // sample, at time zero and past the last sample.
+    void expectSameSamplesAtTimes(
+            const LinearScan &reference, uint64_t scale_num, uint64_t scale_den) {
+        std::vector<uint64_t> times = {0, 1};
+        for (uint64_t time : reference.times()) {
+            uint64_t scaled = time * scale_num / scale_den;
+            times.push_back(scaled);
+            times.push_back(scaled + 1);
+            if (scaled > 0) {
+                times.push_back(scaled - 1);
+            }
+        }
+        uint64_t last = reference.lastTime() * scale_num / scale_den;
+        times.push_back(last + 1000);
+        times.push_back(UINT64_MAX);
+        for (uint64_t time : times) {
+            expectSameSampleAtTime(reference, time, scale_num, scale_den);
+        }
+    }
+
+    void expectSameSyncSamples(const LinearScan &reference, uint32_t numSamples) {
+        for (uint32_t sample = 0; sample <= numSamples + 1; ++sample) {
+            for (uint32_t flags : {SampleTable::kFlagBefore, SampleTable::kFlagAfter}) {
+                uint32_t expected = UINT32_MAX, actual = UINT32_MAX;
+                status_t expectedErr = reference.findSyncSampleNear(sample, &expected, flags);
+                status_t actualErr = mSampleTable->findSyncSampleNear(sample, &actual, flags);
+                ASSERT_EQ(expectedErr, actualErr) << "sample " << sample << " flags " << flags;
+                if (expectedErr == OK) {
+                    ASSERT_EQ(expected, actual) << "sample " << sample << " flags " << flags;
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<BufferSource> mSource;
+    sp<SampleTable> mSampleTable;
+};
+
+}  // namespace
+
+TEST_F(SampleTableTest, EmptyTable) {
+    Tables tables;
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 0));
+    LinearScan reference(tables);
+    for (uint64_t time : {0, 1, 1000}) {
+        expectSameSampleAtTime(reference, time, 1, 1);
+    }
+}
+
+TEST_F(SampleTableTest, SamplesWithoutTime) {
+    // stsz lists samples but stts has none
+    Tables tables;
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 10));
+    uint32_t sample;
+    EXPECT_EQ(ERROR_OUT_OF_RANGE,
+            mSampleTable->findSampleAtTime(0, 1, 1, &sample, SampleTable::kFlagClosest));
+}
+
+TEST_F(SampleTableTest, OneSample) {
+    Tables tables;
+    tables.mTimeToSample.emplace_back(1, 1000);
+    tables.mCompositionDeltas.emplace_back(1, 500);
+    tables.mHasSyncSamples = true;
+    tables.mSyncSamples.push_back(1);
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 1));
+    LinearScan reference(tables);
+
+    for (uint64_t time : {0, 499, 500, 501, 1000, 100000}) {
+        expectSameSampleAtTime(reference, time, 1, 1);
+    }
+    expectSameSyncSamples(reference, 1);
+}
+
+TEST_F(SampleTableTest, ConstantFrameRate) {
+    // exact multiples of the frame duration hit a sample
+    Tables tables;
+    tables.mTimeToSample.emplace_back(10000, 3000);
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 10000));
+    LinearScan reference(tables);
+
+    expectSameSamplesAtTimes(reference, 1, 1);
+    expectSameSamplesAtTimes(reference, 1000000, 90000);
+    uint32_t sample;
+    ASSERT_EQ(OK, mSampleTable->findSampleAtTime(
+            4096 * 3000, 1, 1, &sample, SampleTable::kFlagBefore));
+    EXPECT_EQ(4096u, sample);
+    ASSERT_EQ(OK, mSampleTable->findSampleAtTime(
+            4096 * 3000 - 1, 1, 1, &sample, SampleTable::kFlagBefore));
+    EXPECT_EQ(4095u, sample);
+}
+
+TEST_F(SampleTableTest, ReorderedSamplesMatchLinearScan) {
+    // sample counts around the size of an index chunk
+    unsigned seed = 1;
+    for (uint32_t numSamples : {2u, 7u, 100u, 4095u, 4096u, 4097u, 9000u}) {
+        SCOPED_TRACE(numSamples);
+        Tables tables = makeReorderedTables(numSamples, seed++, true /* withCompositionDeltas */);
+        ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, numSamples));
+        LinearScan reference(tables);
+
+        ASSERT_NO_FATAL_FAILURE(expectSameSamplesAtTimes(reference, 1, 1));
+        ASSERT_NO_FATAL_FAILURE(expectSameSamplesAtTimes(reference, 1000000, 90000));
+        for (uint32_t rank = 0; rank <= numSamples; ++rank) {
+            ASSERT_NO_FATAL_FAILURE(expectSameSampleAtTime(reference, rank, 1, 1));
+        }
+        ASSERT_NO_FATAL_FAILURE(expectSameSyncSamples(reference, numSamples));
+    }
+}
+
+TEST_F(SampleTableTest, VariableDurationsMatchLinearScan) {
+    Tables tables = makeReorderedTables(9000, 42, false /* withCompositionDeltas */);
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 9000));
+    LinearScan reference(tables);
+
+    expectSameSamplesAtTimes(reference, 1, 1);
+    expectSameSyncSamples(reference, 9000);
+}
+
+TEST_F(SampleTableTest, AllSyncSamples) {
+    Tables tables = makeReorderedTables(100, 3, true /* withCompositionDeltas */);
+    tables.mHasSyncSamples = false;
+    tables.mSyncSamples.clear();
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 100));
+    LinearScan reference(tables);
+
+    expectSameSyncSamples(reference, 100);
+}
+
+TEST_F(SampleTableTest, EmptySyncSampleTable) {
+    Tables tables = makeReorderedTables(100, 4, true /* withCompositionDeltas */);
+    tables.mSyncSamples.clear();
+    ASSERT_NO_FATAL_FAILURE(makeSampleTable(tables, 100));
+    LinearScan reference(tables);
+
+    expectSameSyncSamples(reference, 100);
+}
@@ -0,0 +1,550 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SYNTHETIC_MP4_WRITER_H__
+#define __SYNTHETIC_MP4_WRITER_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace android {
+
+// Writes minimal but well-formed MP4 files with a single AVC video track, so
+// that extractor benchmarks can run on arbitrarily long content without
+// shipping large test resources. Sample payloads are single dummy NAL units.
+class SyntheticMp4Writer {
+public:
+    struct Params {
+        uint32_t numSamples = 30 * 60 * 60;  // one hour at 30fps
+        uint32_t timescale = 90000;
+        uint32_t sampleDuration = 3000;
+        uint32_t syncInterval = 30;
+        uint32_t samplesPerChunk = 30;
+        uint32_t sampleSize = 16;
+        // Adds a ctts box reordering every three samples as P, B, B.
+        bool reordered = true;
+        // Decode time of the first fragment of a fragmented file, as when cut
+        // from a live stream.
+        uint64_t baseDecodeTime = 0;
+    };
+
+    // Layout of the tfra box of a fragmented file's mfra box.
+    struct TfraParams {
+        // Version 1 stores times and moof offsets on 64 bits, version 0 on 32 bits.
+        uint8_t version = 1;
+        // Sizes in bytes, minus one, of the traf, trun and sample numbers.
+        uint8_t trafNumberSize = 0;
+        uint8_t trunNumberSize = 0;
+        uint8_t sampleNumberSize = 0;
+        // Only lists every |fragmentStride|th fragment, starting with the first.
+        uint32_t fragmentStride = 1;
+        // Leaves out the last entries while still counting them in number_of_entry.
+        uint32_t missingEntries = 0;
+    };
+
+    // Writes a progressive file with moov after mdat, as recorders do.
+    static bool writeProgressive(const std::string &path, const Params &params) {
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (fp == nullptr) {
+            return false;
+        }
+
+        Box file;
+        writeFtyp(&file);
+        const uint64_t mdatPayload = (uint64_t)params.numSamples * params.sampleSize;
+        const bool largeMdat = mdatPayload + 8 > UINT32_MAX;
+        if (largeMdat) {
+            file.u32(1);
+            file.fourcc("mdat");
+            file.u64(mdatPayload + 16);
+        } else {
+            file.u32(mdatPayload + 8);
+            file.fourcc("mdat");
+        }
+        const uint64_t firstSampleOffset = file.size();
+        bool ok = file.flush(fp) && writeSamples(fp, params.numSamples, params.sampleSize);
+
+        Box moov;
+        writeMoov(&moov, params, firstSampleOffset);
+        ok = ok && moov.flush(fp);
+        return fclose(fp) == 0 && ok;
+    }
+
+    // Writes a fragmented file with |samplesPerFragment| samples, starting with
+    // a sync sample, in each moof and mdat pair. If |withMfra| is set, the file
+    // ends with an mfra box indexing every fragment.
+    static bool writeFragmented(const std::string &path, const Params &params,
+            uint32_t samplesPerFragment, bool withMfra) {
+        const TfraParams tfra;
+        return writeFragmented(path, params, samplesPerFragment, withMfra ? &tfra : nullptr);
+    }
+
+    // Same as above, with an mfra box laid out as |tfra| describes, or none if it is null.
+    static bool writeFragmented(const std::string &path, const Params &params,
+            uint32_t samplesPerFragment, const TfraParams *tfra) {
+        FILE *fp = fopen(path.c_str(), "wb");
+        if (fp == nullptr) {
+            return false;
+        }
+
+        Box box;
+        writeFtyp(&box);
+        writeFragmentedMoov(&box, params);
+        uint64_t offset = box.size();
+        bool ok = box.flush(fp);
+
+        // Presentation time and moof offset of each fragment's first sample.
+        std::vector<std::pair<uint64_t, uint64_t>> randomAccess;
+        for (uint32_t first = 0; ok && first < params.numSamples; first += samplesPerFragment) {
+            const uint32_t count = std::min(samplesPerFragment, params.numSamples - first);
+            const uint64_t decodeTime =
+                    params.baseDecodeTime + (uint64_t)first * params.sampleDuration;
+            randomAccess.emplace_back(decodeTime + (params.reordered
+                    ? reorderOffset(first) * params.sampleDuration : 0), offset);
+
+            writeMoof(&box, params, first / samplesPerFragment + 1, decodeTime, first, count);
+            box.u32((uint64_t)count * params.sampleSize + 8);
+            box.fourcc("mdat");
+            offset += box.size() + (uint64_t)count * params.sampleSize;
+            ok = box.flush(fp) && writeSamples(fp, count, params.sampleSize);
+        }
+
+        if (tfra != nullptr) {
+            std::vector<std::pair<uint64_t, uint64_t>> entries;
+            for (size_t i = 0; i < randomAccess.size(); i += tfra->fragmentStride) {
+                entries.push_back(randomAccess[i]);
+            }
+            box.begin("mfra");
+            box.beginFull("tfra", tfra->version, 0);
+            box.u32(1);  // track_ID
+            box.u32((tfra->trafNumberSize & 3) << 4 | (tfra->trunNumberSize & 3) << 2
+                    | (tfra->sampleNumberSize & 3));
+            box.u32(entries.size());
+            entries.resize(entries.size() - std::min<size_t>(tfra->missingEntries,
+                    entries.size()));
+            for (const auto &entry : entries) {
+                if (tfra->version == 1) {
+                    box.u64(entry.first);
+                    box.u64(entry.second);
+                } else {
+                    box.u32(entry.first);
+                    box.u32(entry.second);
+                }
+                box.uN(1, (tfra->trafNumberSize & 3) + 1);
+                box.uN(1, (tfra->trunNumberSize & 3) + 1);
+                box.uN(1, (tfra->sampleNumberSize & 3) + 1);
+            }
+            box.end();
+            const uint32_t mfraSize = box.size() + 16;
+            box.beginFull("mfro", 0, 0);
+            box.u32(mfraSize);
+            box.end();
+            box.end();
+        }
+        ok = ok && box.flush(fp);
+        return fclose(fp) == 0 && ok;
+    }
+
+protected:
+    // Serializes nested boxes into memory; begin() and end() must pair up.
+    class Box {
+    public:
+        void begin(const char *type) {
+            mOpen.push_back(mData.size());
+            u32(0);
+            fourcc(type);
+        }
+        void beginFull(const char *type, uint8_t version, uint32_t flags) {
+            begin(type);
+            u32((uint32_t)version << 24 | (flags & 0xffffff));
+        }
+        void end() {
+            const size_t start = mOpen.back();
+            mOpen.pop_back();
+            patchU32(start, mData.size() - start);
+        }
+
+        void u8(uint8_t x) { mData.push_back(x); }
+        void u16(uint16_t x) { u8(x >> 8); u8(x); }
+        void u32(uint32_t x) { u16(x >> 16); u16(x); }
+        void u64(uint64_t x) { u32(x >> 32); u32(x); }
+        void uN(uint32_t x, size_t n) {
+            for (size_t i = n; i > 0; --i) {
+                u8(x >> (8 * (i - 1)));
+            }
+        }
+        void zeros(size_t n) { mData.insert(mData.end(), n, 0); }
+        void fourcc(const char *s) { bytes(s, 4); }
+        void bytes(const void *data, size_t n) {
+            const uint8_t *p = (const uint8_t *)data;
+            mData.insert(mData.end(), p, p + n);
+        }
+
+        void patchU32(size_t pos, uint32_t x) {
+            mData[pos] = x >> 24;
+            mData[pos + 1] = x >> 16;
+            mData[pos + 2] = x >> 8;
+            mData[pos + 3] = x;
+        }
+
+        size_t size() const { return mData.size(); }
+        bool flush(FILE *fp) {
+            bool ok = fwrite(mData.data(), 1, mData.size(), fp) == mData.size();
+            mData.clear();
+            return ok;
+        }
+
+    private:
+        std::vector<uint8_t> mData;
+        std::vector<size_t> mOpen;
+    };
+
+    static void writeFtyp(Box *box) {
+        box->begin("ftyp");
+        box->fourcc("isom");
+        box->u32(0x200);
+        box->fourcc("isom");
+        box->fourcc("iso2");
+        box->fourcc("avc1");
+        box->fourcc("mp41");
+        box->end();
+    }
+
+    static bool writeSamples(FILE *fp, uint64_t numSamples, uint32_t sampleSize) {
+        // One length-prefixed IDR slice NAL unit filling the whole sample.
+        std::vector<uint8_t> sample(sampleSize, 0xaa);
+        const uint32_t nalSize = sampleSize - 4;
+        sample[0] = nalSize >> 24;
+        sample[1] = nalSize >> 16;
+        sample[2] = nalSize >> 8;
+        sample[3] = nalSize;
+        sample[4] = 0x65;
+
+        const size_t kSamplesPerWrite = 4096;
+        std::vector<uint8_t> block;
+        for (size_t i = 0; i < kSamplesPerWrite; ++i) {
+            block.insert(block.end(), sample.begin(), sample.end());
+        }
+        while (numSamples > 0) {
+            const size_t n = numSamples < kSamplesPerWrite ? numSamples : kSamplesPerWrite;
+            if (fwrite(block.data(), sampleSize, n, fp) != n) {
+                return false;
+            }
+            numSamples -= n;
+        }
+        return true;
+    }
+
+    static uint64_t durationOf(const Params &params) {
+        return (uint64_t)params.numSamples * params.sampleDuration;
+    }
+
+    static void writeMvhd(Box *box, const Params &params) {
+        box->beginFull("mvhd", 1, 0);
+        box->u64(0);  // creation_time
+        box->u64(0);  // modification_time
+        box->u32(params.timescale);
+        box->u64(durationOf(params));
+        box->u32(0x00010000);  // rate
+        box->u16(0x0100);  // volume
+        box->zeros(10);
+        writeMatrix(box);
+        box->zeros(24);
+        box->u32(2);  // next_track_ID
+        box->end();
+    }
+
+    static void writeMatrix(Box *box) {
+        static const uint32_t kUnityMatrix[9] = {
+            0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+        for (uint32_t x : kUnityMatrix) {
+            box->u32(x);
+        }
+    }
+
+    // Writes trak up to and including stsd, leaving stbl open for the caller
+    // to add its sample tables.
+    static void beginVideoTrak(Box *box, const Params &params, uint64_t duration) {
+        const uint16_t kWidth = 1280;
+        const uint16_t kHeight = 720;
+
+        box->begin("trak");
+
+        box->beginFull("tkhd", 1, 7);
+        box->u64(0);  // creation_time
+        box->u64(0);  // modification_time
+        box->u32(1);  // track_ID
+        box->u32(0);
+        box->u64(duration);
+        box->zeros(8);
+        box->u16(0);  // layer
+        box->u16(0);  // alternate_group
+        box->u16(0);  // volume
+        box->u16(0);
+        writeMatrix(box);
+        box->u32((uint32_t)kWidth << 16);
+        box->u32((uint32_t)kHeight << 16);
+        box->end();
+
+        box->begin("mdia");
+
+        box->beginFull("mdhd", 1, 0);
+        box->u64(0);  // creation_time
+        box->u64(0);  // modification_time
+        box->u32(params.timescale);
+        box->u64(duration);
+        box->u16(0x55c4);  // "und"
+        box->u16(0);
+        box->end();
+
+        box->beginFull("hdlr", 0, 0);
+        box->u32(0);
+        box->fourcc("vide");
+        box->zeros(12);
+        box->bytes("VideoHandle", 12);
+        box->end();
+
+        box->begin("minf");
+
+        box->beginFull("vmhd", 0, 1);
+        box->zeros(8);
+        box->end();
+
+        box->begin("dinf");
+        box->beginFull("dref", 0, 0);
+        box->u32(1);
+        box->beginFull("url ", 0, 1);
+        box->end();
+        box->end();
+        box->end();
+
+        box->begin("stbl");
+
+        box->beginFull("stsd", 0, 0);
+        box->u32(1);
+        box->begin("avc1");
+        box->zeros(6);
+        box->u16(1);  // data_reference_index
+        box->zeros(16);
+        box->u16(kWidth);
+        box->u16(kHeight);
+        box->u32(0x00480000);  // horizresolution
+        box->u32(0x00480000);  // vertresolution
+        box->u32(0);
+        box->u16(1);  // frame_count
+        box->zeros(32);  // compressorname
+        box->u16(0x0018);  // depth
+        box->u16(0xffff);
+        writeAvcC(box);
+        box->end();
+        box->end();
+    }
+
+    static void endVideoTrak(Box *box) {
+        box->end();  // stbl
+        box->end();  // minf
+        box->end();  // mdia
+        box->end();  // trak
+    }
+
+    static void writeAvcC(Box *box) {
+        static const uint8_t kSps[] = {
+            0x67, 0x64, 0x00, 0x1f, 0xac, 0xd9, 0x40, 0x50, 0x05, 0xbb, 0x01, 0x10 };
+        static const uint8_t kPps[] = { 0x68, 0xeb, 0xe3, 0xcb, 0x22, 0xc0 };
+
+        box->begin("avcC");
+        box->u8(1);  // configurationVersion
+        box->u8(kSps[1]);
+        box->u8(kSps[2]);
+        box->u8(kSps[3]);
+        box->u8(0xff);  // 4-byte NAL unit lengths
+        box->u8(0xe1);
+        box->u16(sizeof(kSps));
+        box->bytes(kSps, sizeof(kSps));
+        box->u8(1);
+        box->u16(sizeof(kPps));
+        box->bytes(kPps, sizeof(kPps));
+        box->end();
+    }
+
+    // Composition offsets, in samples, of the P, B, B pattern.
+    static uint32_t reorderOffset(uint32_t sampleIndex) {
+        return sampleIndex % 3 == 0 ? 3 : 0;
+    }
+
+    static void writeMoov(Box *box, const Params &params, uint64_t firstSampleOffset) {
+        box->begin("moov");
+        writeMvhd(box, params);
+        beginVideoTrak(box, params, durationOf(params));
+
+        box->beginFull("stts", 0, 0);
+        box->u32(1);
+        box->u32(params.numSamples);
+        box->u32(params.sampleDuration);
+        box->end();
+
+        if (params.reordered) {
+            std::vector<uint32_t> runs;
+            for (uint32_t i = 0; i < params.numSamples; ++i) {
+                const uint32_t offset = reorderOffset(i) * params.sampleDuration;
+                if (runs.empty() || runs.back() != offset) {
+                    runs.push_back(1);
+                    runs.push_back(offset);
+                } else {
+                    ++runs[runs.size() - 2];
+                }
+            }
+            box->beginFull("ctts", 0, 0);
+            box->u32(runs.size() / 2);
+            for (uint32_t x : runs) {
+                box->u32(x);
+            }
+            box->end();
+        }
+
+        box->beginFull("stss", 0, 0);
+        const uint32_t numSync = (params.numSamples + params.syncInterval - 1) / params.syncInterval;
+        box->u32(numSync);
+        for (uint32_t i = 0; i < numSync; ++i) {
+            box->u32(i * params.syncInterval + 1);
+        }
+        box->end();
+
+        const uint32_t numChunks =
+                (params.numSamples + params.samplesPerChunk - 1) / params.samplesPerChunk;
+        const uint32_t lastChunkSamples =
+                params.numSamples - (numChunks - 1) * params.samplesPerChunk;
+        box->beginFull("stsc", 0, 0);
+        box->u32(lastChunkSamples == params.samplesPerChunk ? 1 : 2);
+        box->u32(1);
+        box->u32(params.samplesPerChunk);
+        box->u32(1);
+        if (lastChunkSamples != params.samplesPerChunk) {
+            box->u32(numChunks);
+            box->u32(lastChunkSamples);
+            box->u32(1);
+        }
+        box->end();
+
+        box->beginFull("stsz", 0, 0);
+        box->u32(params.sampleSize);
+        box->u32(params.numSamples);
+        box->end();
+
+        const uint64_t chunkSize = (uint64_t)params.samplesPerChunk * params.sampleSize;
+        const bool co64 = firstSampleOffset + numChunks * chunkSize > UINT32_MAX;
+        box->beginFull(co64 ? "co64" : "stco", 0, 0);
+        box->u32(numChunks);
+        for (uint32_t i = 0; i < numChunks; ++i) {
+            const uint64_t offset = firstSampleOffset + i * chunkSize;
+            if (co64) {
+                box->u64(offset);
+            } else {
+                box->u32(offset);
+            }
+        }
+        box->end();
+
+        endVideoTrak(box);
+        box->end();  // moov
+    }
+
+    // Writes a moov box whose sample tables are empty, as all samples are in
+    // movie fragments.
+    static void writeFragmentedMoov(Box *box, const Params &params) {
+        box->begin("moov");
+        writeMvhd(box, params);
+        beginVideoTrak(box, params, durationOf(params));
+        box->beginFull("stts", 0, 0);
+        box->u32(0);
+        box->end();
+        box->beginFull("stsc", 0, 0);
+        box->u32(0);
+        box->end();
+        box->beginFull("stsz", 0, 0);
+        box->u32(0);
+        box->u32(0);
+        box->end();
+        box->beginFull("stco", 0, 0);
+        box->u32(0);
+        box->end();
+        endVideoTrak(box);
+
+        box->begin("mvex");
+        box->beginFull("trex", 0, 0);
+        box->u32(1);  // track_ID
+        box->u32(1);  // default_sample_description_index
+        box->u32(0);
+        box->u32(0);
+        box->u32(0);
+        box->end();
+        box->end();
+        box->end();  // moov
+    }
+
+    static void writeMoof(Box *box, const Params &params, uint32_t sequenceNumber,
+            uint64_t decodeTime, uint32_t firstSample, uint32_t count) {
+        const uint32_t kNonSyncSampleFlags = 0x01010000;
+        const uint32_t kSyncSampleFlags = 0x02000000;
+
+        const size_t moofStart = box->size();
+        box->begin("moof");
+        box->beginFull("mfhd", 0, 0);
+        box->u32(sequenceNumber);
+        box->end();
+
+        box->begin("traf");
+        // default-base-is-moof, default sample duration, size and flags
+        box->beginFull("tfhd", 0, 0x020000 | 0x08 | 0x10 | 0x20);
+        box->u32(1);  // track_ID
+        box->u32(params.sampleDuration);
+        box->u32(params.sampleSize);
+        box->u32(kNonSyncSampleFlags);
+        box->end();
+
+        box->beginFull("tfdt", 1, 0);
+        box->u64(decodeTime);
+        box->end();
+
+        // data offset and first sample flags, plus composition offsets if reordered
+        box->beginFull("trun", 0, 0x001 | 0x004 | (params.reordered ? 0x800 : 0));
+        box->u32(count);
+        const size_t dataOffsetPos = box->size();
+        box->u32(0);
+        box->u32(kSyncSampleFlags);
+        if (params.reordered) {
+            for (uint32_t i = 0; i < count; ++i) {
+                box->u32(reorderOffset(firstSample + i) * params.sampleDuration);
+            }
+        }
+        box->end();
+        box->end();  // traf
+        box->end();  // moof
+
+        // Samples start right after the header of the mdat following the moof.
+        box->patchU32(dataOffsetPos, box->size() - moofStart + 8);
+    }
+};
+
+}  // namespace android
+
+#endif  // __SYNTHETIC_MP4_WRITER_H__
@@ -34,6 +34,25 @@
 
 using namespace flowgraph;
 
+static bool toFusedFormat(audio_format_t format, FusedConverter::Format *fusedFormat) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_FLOAT:
+            *fusedFormat = FusedConverter::Format::FLOAT;
+            return true;
+        case AUDIO_FORMAT_PCM_16_BIT:
+            *fusedFormat = FusedConverter::Format::I16;
+            return true;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            *fusedFormat = FusedConverter::Format::I24_PACKED;
+            return true;
+        case AUDIO_FORMAT_PCM_32_BIT:
+            *fusedFormat = FusedConverter::Format::I32;
+            return true;
+        default:
+            return false;
+    }
+}
+
 aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
                           int32_t sourceChannelCount,
                           audio_format_t sinkFormat,
@@ -105,10 +124,29 @@ aaudio_result_t AAudioFlowGraph::configure(audio_format_t sourceFormat,
     }
     lastOutput->connect(&mSink->input);
 
+    // The graph is still used while the volume is ramping.
+    FusedConverter::Format fusedSourceFormat;
+    FusedConverter::Format fusedSinkFormat;
+    if (mFusedPassEnabled
+            && mChannelConverter == nullptr
+            && toFusedFormat(sourceFormat, &fusedSourceFormat)
+            && toFusedFormat(sinkFormat, &fusedSinkFormat)) {
+        mFusedConverter = std::make_unique<FusedConverter>(fusedSourceFormat, fusedSinkFormat,
+                                                           mClipper != nullptr);
+        mSamplesPerFrame = sinkChannelCount;
+    }
+
     return AAUDIO_OK;
 }
 
 void AAudioFlowGraph::process(const void *source, void *destination, int32_t numFrames) {
+    if (mFusedConverter != nullptr && !mVolumeRamp->isRamping()) {
+        float minimum = (mClipper != nullptr) ? mClipper->getMinimum() : 0.0f;
+        float maximum = (mClipper != nullptr) ? mClipper->getMaximum() : 0.0f;
+        mFusedConverter->process(source, destination, numFrames * mSamplesPerFrame,
+                                 mVolumeRamp->getLevel(), minimum, maximum);
+        return;
+    }
     mSource->setData(source, numFrames);
     mSink->read(destination, numFrames);
 }
@@ -24,6 +24,7 @@
 
 #include <aaudio/AAudio.h>
 #include <flowgraph/ClipToRange.h>
+#include <flowgraph/FusedConverter.h>
 #include <flowgraph/MonoToMultiConverter.h>
 #include <flowgraph/RampLinear.h>
 
@@ -52,12 +53,24 @@ public:
 
     void setRampLengthInFrames(int32_t numFrames);
 
+    /**
+     * When enabled, process() converts the data in a single pass whenever the volume
+     * is not ramping and the channel count is not changed. The output is the same.
+     * Enabled by default. This should be called before configure().
+     */
+    void setFusedPassEnabled(bool enabled) {
+        mFusedPassEnabled = enabled;
+    }
+
 private:
     std::unique_ptr<flowgraph::AudioSource>          mSource;
     std::unique_ptr<flowgraph::RampLinear>           mVolumeRamp;
     std::unique_ptr<flowgraph::ClipToRange>          mClipper;
     std::unique_ptr<flowgraph::MonoToMultiConverter> mChannelConverter;
     std::unique_ptr<flowgraph::AudioSink>            mSink;
+    std::unique_ptr<flowgraph::FusedConverter>       mFusedConverter;
+    int32_t                                          mSamplesPerFrame = 0;
+    bool                                             mFusedPassEnabled = true;
 };
 
 
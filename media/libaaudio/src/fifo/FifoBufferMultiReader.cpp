@@ -0,0 +1,209 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#define LOG_TAG "FifoBufferMultiReader"
+//#define LOG_NDEBUG 0
+#include <utils/Log.h>
+
+#include <algorithm>
+
+#include "FifoBufferMultiReader.h"
+
+using android::FifoBufferMultiReader;
+using android::WrappingBuffer;
+using android::fifo_counter_t;
+using android::fifo_frames_t;
+
+FifoBufferMultiReader::FifoBufferMultiReader(int32_t bytesPerFrame,
+                                             fifo_frames_t capacityInFrames,
+                                             int32_t maxReaders)
+        : mBytesPerFrame(bytesPerFrame)
+        , mCapacityInFrames(capacityInFrames)
+        , mMaxReaders(maxReaders)
+        , mStorage(std::make_unique<uint8_t[]>(bytesPerFrame * capacityInFrames))
+        , mReaders(std::make_unique<Reader[]>(maxReaders))
+{
+    ALOGV("%s() capacityInFrames = %d, bytesPerFrame = %d, maxReaders = %d",
+          __func__, capacityInFrames, bytesPerFrame, maxReaders);
+}
+
+int32_t FifoBufferMultiReader::addReader() {
+    for (int32_t readerId = 0; readerId < mMaxReaders; readerId++) {
+        Reader &reader = mReaders[readerId];
+        int32_t expected = READER_FREE;
+        if (reader.state.compare_exchange_strong(expected, READER_ADDING)) {
+            reader.readCounter.store(getWriteCounter(), std::memory_order_release);
+            reader.overrunCount.store(0, std::memory_order_relaxed);
+            reader.framesLost.store(0, std::memory_order_relaxed);
+            reader.state.store(READER_ACTIVE, std::memory_order_release);
+            return readerId;
+        }
+    }
+    return -1;
+}
+
+void FifoBufferMultiReader::removeReader(int32_t readerId) {
+    if (isValidReader(readerId)) {
+        mReaders[readerId].state.store(READER_FREE, std::memory_order_release);
+    }
+}
+
+void FifoBufferMultiReader::fillWrappingBuffer(WrappingBuffer *wrappingBuffer,
+                                               fifo_frames_t framesAvailable,
+                                               fifo_counter_t counter) {
+    // % works with non-power of two sizes
+    fifo_frames_t startIndex = (fifo_frames_t) ((uint64_t) counter % mCapacityInFrames);
+    uint8_t *source = &mStorage[startIndex * mBytesPerFrame];
+    wrappingBuffer->data[1] = nullptr;
+    wrappingBuffer->numFrames[1] = 0;
+    // Does the data cross the end of the FIFO?
+    if ((startIndex + framesAvailable) > mCapacityInFrames) {
+        fifo_frames_t firstFrames = mCapacityInFrames - startIndex;
+        wrappingBuffer->data[0] = source;
+        wrappingBuffer->numFrames[0] = firstFrames;
+        wrappingBuffer->data[1] = &mStorage[0];
+        wrappingBuffer->numFrames[1] = framesAvailable - firstFrames;
+    } else {
+        wrappingBuffer->data[0] = source;
+        wrappingBuffer->numFrames[0] = framesAvailable;
+    }
+}
+
+fifo_frames_t FifoBufferMultiReader::write(const void *buffer, fifo_frames_t numFrames) {
+    numFrames = std::min(numFrames, mCapacityInFrames);
+    if (numFrames <= 0) {
+        return 0;
+    }
+    // Only the writer modifies the counters below.
+    fifo_counter_t writeCounter = mWriteCounter.load(std::memory_order_relaxed);
+    fifo_counter_t endCounter = writeCounter + numFrames;
+
+    // Announce the frames about to be overwritten before modifying them.
+    mReserveCounter.store(endCounter, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    WrappingBuffer wrappingBuffer;
+    fillWrappingBuffer(&wrappingBuffer, numFrames, writeCounter);
+    const uint8_t *source = (const uint8_t *) buffer;
+    for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+        int32_t numBytes = wrappingBuffer.numFrames[partIndex] * mBytesPerFrame;
+        if (numBytes > 0) {
+            memcpy(wrappingBuffer.data[partIndex], source, numBytes);
+            source += numBytes;
+        }
+    }
+
+    mWriteCounter.store(endCounter, std::memory_order_release);
+    return numFrames;
+}
+
+fifo_frames_t FifoBufferMultiReader::read(int32_t readerId,
+                                          void *buffer,
+                                          fifo_frames_t numFrames) {
+    if (!isValidReader(readerId) || numFrames <= 0) {
+        return 0;
+    }
+    Reader &reader = mReaders[readerId];
+    fifo_counter_t readCounter = reader.readCounter.load(std::memory_order_relaxed);
+    fifo_counter_t writeCounter = getWriteCounter();
+
+    // Skip the frames that have already been overwritten.
+    fifo_counter_t oldestCounter = writeCounter - mCapacityInFrames;
+    if (readCounter < oldestCounter) {
+        reader.overrunCount.fetch_add(1, std::memory_order_relaxed);
+        reader.framesLost.fetch_add(oldestCounter - readCounter, std::memory_order_relaxed);
+        readCounter = oldestCounter;
+    }
+
+    fifo_frames_t framesToRead = (fifo_frames_t) std::min(
+            (fifo_counter_t) numFrames, writeCounter - readCounter);
+    if (framesToRead <= 0) {
+        reader.readCounter.store(readCounter, std::memory_order_release);
+        return 0;
+    }
+
+    WrappingBuffer wrappingBuffer;
+    fillWrappingBuffer(&wrappingBuffer, framesToRead, readCounter);
+    uint8_t *destination = (uint8_t *) buffer;
+    for (int partIndex = 0; partIndex < WrappingBuffer::SIZE; partIndex++) {
+        int32_t numBytes = wrappingBuffer.numFrames[partIndex] * mBytesPerFrame;
+        if (numBytes > 0) {
+            memcpy(destination, wrappingBuffer.data[partIndex], numBytes);
+            destination += numBytes;
+        }
+    }
+
+    // Were some of the frames overwritten while they were being copied?
+    std::atomic_thread_fence(std::memory_order_acquire);
+    fifo_counter_t reserveCounter = mReserveCounter.load(std::memory_order_relaxed);
+    oldestCounter = reserveCounter - mCapacityInFrames;
+    if (readCounter < oldestCounter) {
+        reader.overrunCount.fetch_add(1, std::memory_order_relaxed);
+        reader.framesLost.fetch_add(oldestCounter - readCounter, std::memory_order_relaxed);
+        reader.readCounter.store(oldestCounter, std::memory_order_release);
+        return 0;
+    }
+
+    reader.readCounter.store(readCounter + framesToRead, std::memory_order_release);
+    return framesToRead;
+}
+
+fifo_frames_t FifoBufferMultiReader::getFullFramesAvailable(int32_t readerId) {
+    if (!isValidReader(readerId)) {
+        return 0;
+    }
+    return (fifo_frames_t) (getWriteCounter() - getReadCounter(readerId));
+}
+
+fifo_frames_t FifoBufferMultiReader::getEmptyFramesAvailable() {
+    return std::max(0, mCapacityInFrames - getSlowestReaderLag());
+}
+
+fifo_frames_t FifoBufferMultiReader::getSlowestReaderLag() {
+    fifo_counter_t writeCounter = getWriteCounter();
+    fifo_counter_t lag = 0;
+    for (int32_t readerId = 0; readerId < mMaxReaders; readerId++) {
+        const Reader &reader = mReaders[readerId];
+        if (reader.state.load(std::memory_order_acquire) == READER_ACTIVE) {
+            lag = std::max(lag,
+                    writeCounter - reader.readCounter.load(std::memory_order_acquire));
+        }
+    }
+    return (fifo_frames_t) std::min(lag, (fifo_counter_t) INT32_MAX);
+}
+
+int32_t FifoBufferMultiReader::getOverrunCount(int32_t readerId) {
+    if (!isValidReader(readerId)) {
+        return 0;
+    }
+    return mReaders[readerId].overrunCount.load(std::memory_order_relaxed);
+}
+
+fifo_counter_t FifoBufferMultiReader::getFramesLost(int32_t readerId) {
+    if (!isValidReader(readerId)) {
+        return 0;
+    }
+    return mReaders[readerId].framesLost.load(std::memory_order_relaxed);
+}
+
+fifo_counter_t FifoBufferMultiReader::getReadCounter(int32_t readerId) {
+    if (!isValidReader(readerId)) {
+        return 0;
+    }
+    return mReaders[readerId].readCounter.load(std::memory_order_acquire);
+}
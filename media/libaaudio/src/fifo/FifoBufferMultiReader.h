@@ -0,0 +1,158 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIFO_FIFO_BUFFER_MULTI_READER_H
+#define FIFO_FIFO_BUFFER_MULTI_READER_H
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+#include "FifoBuffer.h"
+#include "FifoControllerBase.h"
+
+namespace android {
+
+/**
+ * A circular buffer with one writer and several readers, each reading all of the data.
+ *
+ * The writer never waits for the readers. When a reader falls more than the capacity
+ * behind, the writer overwrites frames it has not read yet. The reader detects
+ * this overrun on its next read, skips the lost frames and counts them.
+ *
+ * Reads and writes are wait-free. The writer announces the range it is about to
+ * overwrite before copying the data, so that a reader copying frames concurrently
+ * can tell afterwards whether they were overwritten during the copy. In that case
+ * the read returns no frames and counts an overrun.
+ *
+ * Each reader must be used by a single thread. Readers may be added and removed
+ * while the writer is running.
+ */
+class FifoBufferMultiReader {
+public:
+    /**
+     * @param bytesPerFrame size of a frame in bytes
+     * @param capacityInFrames total size of the circular buffer in frames
+     * @param maxReaders maximum number of readers that can be added at the same time
+     */
+    FifoBufferMultiReader(int32_t bytesPerFrame,
+                          fifo_frames_t capacityInFrames,
+                          int32_t maxReaders);
+
+    ~FifoBufferMultiReader() = default;
+
+    /**
+     * Add a reader. It starts reading at the next frame written.
+     * @return reader id or -1 if maxReaders readers are already added
+     */
+    int32_t addReader();
+
+    /**
+     * Remove a reader so that it is no longer reported by getSlowestReaderLag().
+     * @param readerId id returned by addReader()
+     */
+    void removeReader(int32_t readerId);
+
+    /**
+     * Write frames, overwriting the oldest frames if needed.
+     * At most the capacity is written.
+     * @return number of frames written
+     */
+    fifo_frames_t write(const void *source, fifo_frames_t numFrames);
+
+    /**
+     * Read the next frames of a reader.
+     * @return number of frames read, zero if none are available or the frames
+     *         were overwritten while being read
+     */
+    fifo_frames_t read(int32_t readerId, void *destination, fifo_frames_t numFrames);
+
+    /**
+     * This may exceed the capacity if the reader was overrun.
+     * @return number of frames written but not read yet by the reader
+     */
+    fifo_frames_t getFullFramesAvailable(int32_t readerId);
+
+    /**
+     * @return number of frames the writer may write without overrunning any reader
+     */
+    fifo_frames_t getEmptyFramesAvailable();
+
+    /**
+     * @return largest number of frames written but not read yet by a reader,
+     *         zero if there are no readers
+     */
+    fifo_frames_t getSlowestReaderLag();
+
+    /**
+     * @return number of times the reader was overrun
+     */
+    int32_t getOverrunCount(int32_t readerId);
+
+    /**
+     * @return number of frames the reader lost because of overruns
+     */
+    fifo_counter_t getFramesLost(int32_t readerId);
+
+    fifo_counter_t getReadCounter(int32_t readerId);
+
+    fifo_counter_t getWriteCounter() {
+        return mWriteCounter.load(std::memory_order_acquire);
+    }
+
+    fifo_frames_t getBufferCapacityInFrames() const {
+        return mCapacityInFrames;
+    }
+
+    int32_t getBytesPerFrame() const {
+        return mBytesPerFrame;
+    }
+
+private:
+    enum ReaderState : int32_t {
+        READER_FREE,
+        READER_ADDING,
+        READER_ACTIVE,
+    };
+
+    // Aligned so that readers do not share cache lines.
+    struct alignas(64) Reader {
+        std::atomic<int32_t> state{READER_FREE};
+        std::atomic<fifo_counter_t> readCounter{0};
+        std::atomic<int32_t> overrunCount{0};
+        std::atomic<fifo_counter_t> framesLost{0};
+    };
+
+    bool isValidReader(int32_t readerId) const {
+        return readerId >= 0 && readerId < mMaxReaders;
+    }
+
+    void fillWrappingBuffer(WrappingBuffer *wrappingBuffer,
+                            fifo_frames_t framesAvailable, fifo_counter_t counter);
+
+    const int32_t                  mBytesPerFrame;
+    const fifo_frames_t            mCapacityInFrames;
+    const int32_t                  mMaxReaders;
+    std::unique_ptr<uint8_t[]>     mStorage;
+    std::unique_ptr<Reader[]>      mReaders;
+    // End of the frames being written, ahead of mWriteCounter during a write.
+    std::atomic<fifo_counter_t>    mReserveCounter{0};
+    std::atomic<fifo_counter_t>    mWriteCounter{0};
+};
+
+}  // android
+
+#endif //FIFO_FIFO_BUFFER_MULTI_READER_H
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <stdint.h>
+
+#ifdef __ANDROID__
+#include <audio_utils/primitives.h>
+#endif
+
+#include "AudioProcessorBase.h"
+#include "FlowgraphUtilities.h"
+#include "FusedConverter.h"
+
+using namespace flowgraph;
+
+namespace {
+
+constexpr int kBytesPerI24Packed = 3;
+
+// The per-sample conversions below must match the Source and Sink nodes exactly,
+// so that the fused pass gives the same output as the graph.
+
+struct FloatSample {
+    using type = float;
+
+    static float read(const float *data, int32_t i) {
+        return data[i];
+    }
+
+    static void write(float *data, int32_t i, float sample) {
+        data[i] = sample;
+    }
+};
+
+struct I16Sample {
+    using type = int16_t;
+
+    static float read(const int16_t *data, int32_t i) {
+#ifdef __ANDROID__
+        return float_from_i16(data[i]);
+#else
+        return data[i] * (1.0f / 32768);
+#endif
+    }
+
+    static void write(int16_t *data, int32_t i, float sample) {
+#ifdef __ANDROID__
+        data[i] = clamp16_from_float(sample);
+#else
+        int32_t n = (int32_t) (sample * 32768.0f);
+        data[i] = std::min(INT16_MAX, std::max(INT16_MIN, n)); // clip
+#endif
+    }
+};
+
+struct I24PackedSample {
+    using type = uint8_t;
+
+    static float read(const uint8_t *data, int32_t i) {
+        const uint8_t *byteData = &data[i * kBytesPerI24Packed];
+#ifdef __ANDROID__
+        return float_from_p24(byteData);
+#else
+        static const float scale = 1. / (float)(1UL << 31);
+        // Assemble the data assuming Little Endian format.
+        int32_t pad = byteData[2];
+        pad <<= 8;
+        pad |= byteData[1];
+        pad <<= 8;
+        pad |= byteData[0];
+        pad <<= 8; // Shift to 32 bit data so the sign is correct.
+        return pad * scale; // scale to range -1.0 to 1.0
+#endif
+    }
+
+    static void write(uint8_t *data, int32_t i, float sample) {
+        uint8_t *byteData = &data[i * kBytesPerI24Packed];
+#ifdef __ANDROID__
+        int32_t n = clamp24_from_float(sample);
+#else
+        const int32_t kI24PackedMax = 0x007FFFFF;
+        const int32_t kI24PackedMin = 0xFF800000;
+        int32_t n = (int32_t) (sample * 0x00800000);
+        n = std::min(kI24PackedMax, std::max(kI24PackedMin, n)); // clip
+#endif
+        // Write as a packed 24-bit integer in Little Endian format.
+        byteData[0] = (uint8_t) n;
+        byteData[1] = (uint8_t) (n >> 8);
+        byteData[2] = (uint8_t) (n >> 16);
+    }
+};
+
+struct I32Sample {
+    using type = int32_t;
+
+    static float read(const int32_t *data, int32_t i) {
+#ifdef __ANDROID__
+        return float_from_i32(data[i]);
+#else
+        static constexpr float kScale = 1.0 / (1UL << 31);
+        return data[i] * kScale;
+#endif
+    }
+
+    static void write(int32_t *data, int32_t i, float sample) {
+#ifdef __ANDROID__
+        data[i] = clamp32_from_float(sample);
+#else
+        data[i] = FlowgraphUtilities::clamp32FromFloat(sample);
+#endif
+    }
+};
+
+// One loop per combination of formats, with no branches inside,
+// so that the compiler can vectorize it.
+template <typename Source, typename Sink, bool kClip>
+void convert(const void *source, void *destination, int32_t numSamples,
+             float gain, float minimum, float maximum) {
+    const typename Source::type *input = static_cast<const typename Source::type *>(source);
+    typename Sink::type *output = static_cast<typename Sink::type *>(destination);
+    for (int32_t i = 0; i < numSamples; i++) {
+        float sample = Source::read(input, i) * gain;
+        if (kClip) {
+            sample = std::min(maximum, std::max(minimum, sample));
+        }
+        Sink::write(output, i, sample);
+    }
+}
+
+template <typename Source, typename Sink>
+auto selectClip(bool clip) {
+    return clip ? convert<Source, Sink, true> : convert<Source, Sink, false>;
+}
+
+template <typename Source>
+auto selectSink(FusedConverter::Format sinkFormat, bool clip) {
+    switch (sinkFormat) {
+        case FusedConverter::Format::I16:
+            return selectClip<Source, I16Sample>(clip);
+        case FusedConverter::Format::I24_PACKED:
+            return selectClip<Source, I24PackedSample>(clip);
+        case FusedConverter::Format::I32:
+            return selectClip<Source, I32Sample>(clip);
+        case FusedConverter::Format::FLOAT:
+        default:
+            return selectClip<Source, FloatSample>(clip);
+    }
+}
+
+} // namespace
+
+FusedConverter::FusedConverter(Format sourceFormat, Format sinkFormat, bool clip) {
+    switch (sourceFormat) {
+        case Format::I16:
+            mConvert = selectSink<I16Sample>(sinkFormat, clip);
+            break;
+        case Format::I24_PACKED:
+            mConvert = selectSink<I24PackedSample>(sinkFormat, clip);
+            break;
+        case Format::I32:
+            mConvert = selectSink<I32Sample>(sinkFormat, clip);
+            break;
+        case Format::FLOAT:
+        default:
+            mConvert = selectSink<FloatSample>(sinkFormat, clip);
+            break;
+    }
+}
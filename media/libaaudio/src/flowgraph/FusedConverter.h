@@ -0,0 +1,72 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FLOWGRAPH_FUSED_CONVERTER_H
+#define FLOWGRAPH_FUSED_CONVERTER_H
+
+#include <unistd.h>
+#include <sys/types.h>
+
+namespace flowgraph {
+
+/**
+ * Converts between sample formats, applies a constant gain and optionally clips,
+ * all in a single pass over the data.
+ *
+ * This gives the same result as a Source -> RampLinear -> ClipToRange -> Sink graph
+ * when the ramp is not ramping, without going through the intermediate float blocks.
+ * The channel count is not changed.
+ */
+class FusedConverter {
+public:
+    enum class Format {
+        FLOAT,
+        I16,
+        I24_PACKED,
+        I32,
+    };
+
+    /**
+     * @param sourceFormat
+     * @param sinkFormat
+     * @param clip true to clip the scaled float data, as ClipToRange does
+     */
+    FusedConverter(Format sourceFormat, Format sinkFormat, bool clip);
+
+    /**
+     * @param source
+     * @param destination
+     * @param numSamples frames times channels
+     * @param gain applied to every sample
+     * @param minimum used when clipping
+     * @param maximum used when clipping
+     */
+    void process(const void *source, void *destination, int32_t numSamples,
+                 float gain, float minimum, float maximum) const {
+        mConvert(source, destination, numSamples, gain, minimum, maximum);
+    }
+
+private:
+    using ConvertFunction = void (*)(const void *source, void *destination,
+                                     int32_t numSamples,
+                                     float gain, float minimum, float maximum);
+
+    ConvertFunction mConvert;
+};
+
+} /* namespace flowgraph */
+
+#endif //FLOWGRAPH_FUSED_CONVERTER_H
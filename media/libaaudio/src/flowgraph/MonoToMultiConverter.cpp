@@ -35,6 +35,14 @@ int32_t MonoToMultiConverter::onProcess(int64_t framePosition, int32_t numFrames
     float *outputBuffer = output.getBlock();
     int32_t channelCount = output.getSamplesPerFrame();
     // TODO maybe move to audio_util as audio_mono_to_multi()
+    if (channelCount == 2) {
+        // Most common case, with a constant inner loop count that can be vectorized.
+        for (int i = 0; i < framesToProcess; i++) {
+            outputBuffer[2 * i] = inputBuffer[i];
+            outputBuffer[2 * i + 1] = inputBuffer[i];
+        }
+        return framesToProcess;
+    }
     for (int i = 0; i < framesToProcess; i++) {
         // read one, write many
         float sample = *inputBuffer++;
@@ -65,20 +65,26 @@ int32_t RampLinear::onProcess(int64_t framePosition, int32_t numFrames) {
     if (mRemaining > 0) { // Ramping? This doesn't happen very often.
         int32_t framesToRamp = std::min(framesLeft, mRemaining);
         framesLeft -= framesToRamp;
+        const float levelTo = mLevelTo;
+        const float scaler = mScaler;
+        int32_t remaining = mRemaining;
         while (framesToRamp > 0) {
-            float currentLevel = interpolateCurrent();
+            float currentLevel = levelTo - (remaining * scaler); // same as interpolateCurrent()
             for (int ch = 0; ch < channelCount; ch++) {
                 *outputBuffer++ = *inputBuffer++ * currentLevel;
             }
-            mRemaining--;
+            remaining--;
             framesToRamp--;
         }
+        mRemaining = remaining;
     }
 
     // Process any frames after the ramp.
+    // Use a local so the level is not reloaded after each store, allowing vectorization.
+    const float level = mLevelTo;
     int32_t samplesLeft = framesLeft * channelCount;
     for (int i = 0; i < samplesLeft; i++) {
-        *outputBuffer++ = *inputBuffer++ * mLevelTo;
+        outputBuffer[i] = inputBuffer[i] * level;
     }
 
     return framesToProcess;
@@ -66,6 +66,21 @@ public:
         mLevelTo = level;
     }
 
+    /**
+     * Must be called from the thread that calls onProcess().
+     * @return true if a ramp is in progress or will start on the next onProcess()
+     */
+    bool isRamping() const {
+        return mRemaining > 0 || getTarget() != mLevelTo;
+    }
+
+    /**
+     * @return level applied when not ramping
+     */
+    float getLevel() const {
+        return mLevelTo;
+    }
+
     AudioFloatInputPort input;
     AudioFloatOutputPort output;
 
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of FifoBufferMultiReader compared with one FifoBuffer per reader,
+// which is what a capture stream with several consumers needs otherwise.
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "fifo/FifoBuffer.h"
+#include "fifo/FifoBufferMultiReader.h"
+
+using android::fifo_frames_t;
+using android::FifoBufferAllocated;
+using android::FifoBufferMultiReader;
+
+constexpr int32_t kBytesPerFrame = 2 * sizeof(float); // stereo float
+constexpr fifo_frames_t kCapacity = 4096;
+constexpr fifo_frames_t kBurst = 192; // 4 ms at 48 kHz
+
+// Each iteration writes one burst, readers run on their own threads.
+static void BM_MultiReader(benchmark::State& state) {
+    const int numReaders = state.range(0);
+    FifoBufferMultiReader fifo(kBytesPerFrame, kCapacity, numReaders);
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < numReaders; i++) {
+        int32_t readerId = fifo.addReader();
+        readers.emplace_back([&fifo, &done, readerId]() {
+            std::vector<float> data(kCapacity * 2);
+            while (!done.load(std::memory_order_relaxed)) {
+                if (fifo.read(readerId, data.data(), kCapacity) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<float> data(kBurst * 2);
+    for (auto _ : state) {
+        // Do not outrun the readers, overruns would skip their work.
+        while (fifo.getEmptyFramesAvailable() < kBurst) {
+            std::this_thread::yield();
+        }
+        fifo.write(data.data(), kBurst);
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst * numReaders);
+    state.SetBytesProcessed(state.iterations() * kBurst * kBytesPerFrame * numReaders);
+}
+
+// Same, with the writer copying each burst into one FifoBuffer per reader.
+static void BM_FifoPerReader(benchmark::State& state) {
+    const int numReaders = state.range(0);
+    std::vector<std::unique_ptr<FifoBufferAllocated>> fifos;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < numReaders; i++) {
+        fifos.push_back(std::make_unique<FifoBufferAllocated>(kBytesPerFrame, kCapacity));
+    }
+    for (int i = 0; i < numReaders; i++) {
+        readers.emplace_back([fifo = fifos[i].get(), &done]() {
+            std::vector<float> data(kCapacity * 2);
+            while (!done.load(std::memory_order_relaxed)) {
+                if (fifo->read(data.data(), kCapacity) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    std::vector<float> data(kBurst * 2);
+    for (auto _ : state) {
+        for (auto& fifo : fifos) {
+            while (fifo->getEmptyFramesAvailable() < kBurst) {
+                std::this_thread::yield();
+            }
+            fifo->write(data.data(), kBurst);
+        }
+    }
+    done = true;
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    state.SetItemsProcessed(state.iterations() * kBurst * numReaders);
+    state.SetBytesProcessed(state.iterations() * kBurst * kBytesPerFrame * numReaders);
+}
+
+BENCHMARK(BM_MultiReader)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+BENCHMARK(BM_FifoPerReader)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost per frame of the AAudioFlowGraph configurations used by AAudio streams,
+// with the graph run node by node and as a single fused pass.
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "client/AAudioFlowGraph.h"
+
+constexpr int32_t kFramesPerBurst = 96; // 2 ms at 48 kHz
+
+static size_t bytesPerSample(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return 2;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+static void BM_FlowGraph(benchmark::State& state,
+                         audio_format_t sourceFormat, int32_t sourceChannelCount,
+                         audio_format_t sinkFormat, int32_t sinkChannelCount) {
+    const bool fused = state.range(0) != 0;
+    AAudioFlowGraph flowGraph;
+    flowGraph.setFusedPassEnabled(fused);
+    if (flowGraph.configure(sourceFormat, sourceChannelCount,
+                            sinkFormat, sinkChannelCount) != AAUDIO_OK) {
+        state.SkipWithError("configure() failed");
+        return;
+    }
+    flowGraph.setTargetVolume(0.5f);
+
+    std::vector<uint8_t> source(
+            kFramesPerBurst * sourceChannelCount * bytesPerSample(sourceFormat));
+    std::vector<uint8_t> destination(
+            kFramesPerBurst * sinkChannelCount * bytesPerSample(sinkFormat));
+    // Arbitrary signal, small enough to be valid in every format.
+    for (size_t i = 0; i < source.size(); i++) {
+        source[i] = (i * 7) & 0x3F;
+    }
+    // Let the volume ramp complete.
+    for (int i = 0; i < 100; i++) {
+        flowGraph.process(source.data(), destination.data(), kFramesPerBurst);
+    }
+
+    for (auto _ : state) {
+        flowGraph.process(source.data(), destination.data(), kFramesPerBurst);
+        benchmark::DoNotOptimize(destination.data());
+        benchmark::ClobberMemory();
+    }
+    // Displayed as the time per frame, e.g. 4.2ns.
+    state.counters["time_per_frame"] = benchmark::Counter(
+            state.iterations() * kFramesPerBurst,
+            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+#define FLOWGRAPH_BENCHMARK(name, sourceFormat, sourceChannels, sinkFormat, sinkChannels) \
+    BENCHMARK_CAPTURE(BM_FlowGraph, name, sourceFormat, sourceChannels,                   \
+                      sinkFormat, sinkChannels)                                           \
+            ->Arg(0) /* <-- node by node */                                               \
+            ->Arg(1)
+
+FLOWGRAPH_BENCHMARK(i16_to_float_stereo,
+        AUDIO_FORMAT_PCM_16_BIT, 2, AUDIO_FORMAT_PCM_FLOAT, 2);
+FLOWGRAPH_BENCHMARK(float_to_i16_stereo,
+        AUDIO_FORMAT_PCM_FLOAT, 2, AUDIO_FORMAT_PCM_16_BIT, 2);
+FLOWGRAPH_BENCHMARK(float_to_float_stereo,
+        AUDIO_FORMAT_PCM_FLOAT, 2, AUDIO_FORMAT_PCM_FLOAT, 2);
+FLOWGRAPH_BENCHMARK(i16_to_i16_stereo,
+        AUDIO_FORMAT_PCM_16_BIT, 2, AUDIO_FORMAT_PCM_16_BIT, 2);
+FLOWGRAPH_BENCHMARK(i24_to_i32_stereo,
+        AUDIO_FORMAT_PCM_24_BIT_PACKED, 2, AUDIO_FORMAT_PCM_32_BIT, 2);
+FLOWGRAPH_BENCHMARK(i32_to_float_stereo,
+        AUDIO_FORMAT_PCM_32_BIT, 2, AUDIO_FORMAT_PCM_FLOAT, 2);
+FLOWGRAPH_BENCHMARK(float_to_i24_8ch,
+        AUDIO_FORMAT_PCM_FLOAT, 8, AUDIO_FORMAT_PCM_24_BIT_PACKED, 8);
+FLOWGRAPH_BENCHMARK(i16_mono_to_float_stereo,
+        AUDIO_FORMAT_PCM_16_BIT, 1, AUDIO_FORMAT_PCM_FLOAT, 2);
+
+BENCHMARK_MAIN();
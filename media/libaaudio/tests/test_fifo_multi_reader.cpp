@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fifo/FifoBufferMultiReader.h"
+
+using android::fifo_counter_t;
+using android::fifo_frames_t;
+using android::FifoBufferMultiReader;
+
+// Values are arbitrary primes designed to trigger edge cases.
+constexpr int kCapacity = 83;
+constexpr int kMaxReaders = 3;
+
+static void fillSequence(int16_t *data, int numFrames, int16_t start) {
+    for (int i = 0; i < numFrames; i++) {
+        data[i] = start + i;
+    }
+}
+
+static void checkSequence(const int16_t *data, int numFrames, int16_t start) {
+    for (int i = 0; i < numFrames; i++) {
+        ASSERT_EQ((int16_t)(start + i), data[i]) << "at frame " << i;
+    }
+}
+
+TEST(test_fifo_multi_reader, add_remove_readers) {
+    FifoBufferMultiReader fifo(sizeof(int16_t), kCapacity, kMaxReaders);
+    ASSERT_EQ(kCapacity, fifo.getBufferCapacityInFrames());
+
+    int32_t readers[kMaxReaders];
+    for (int i = 0; i < kMaxReaders; i++) {
+        readers[i] = fifo.addReader();
+        ASSERT_GE(readers[i], 0);
+    }
+    ASSERT_EQ(-1, fifo.addReader());
+
+    fifo.removeReader(readers[1]);
+    ASSERT_EQ(readers[1], fifo.addReader());
+}
+
+TEST(test_fifo_multi_reader, each_reader_reads_all) {
+    FifoBufferMultiReader fifo(sizeof(int16_t), kCapacity, kMaxReaders);
+    int32_t reader1 = fifo.addReader();
+    int32_t reader2 = fifo.addReader();
+
+    int16_t source[kCapacity];
+    int16_t destination[kCapacity];
+    int16_t next1 = 0;
+    int16_t next2 = 0;
+    int16_t written = 0;
+    // Odd sizes make the reads and writes wrap around the end of the buffer.
+    for (int i = 0; i < 20; i++) {
+        constexpr int framesToWrite = 37;
+        fillSequence(source, framesToWrite, written);
+        ASSERT_EQ(framesToWrite, fifo.write(source, framesToWrite));
+        written += framesToWrite;
+
+        // Reader 1 reads everything, reader 2 falls behind by up to 29 frames.
+        fifo_frames_t framesRead = fifo.read(reader1, destination, kCapacity);
+        ASSERT_EQ(framesToWrite, framesRead);
+        checkSequence(destination, framesRead, next1);
+        next1 += framesRead;
+
+        framesRead = fifo.read(reader2, destination, 31);
+        checkSequence(destination, framesRead, next2);
+        next2 += framesRead;
+        framesRead = fifo.read(reader2, destination, fifo.getFullFramesAvailable(reader2) - 29);
+        checkSequence(destination, framesRead, next2);
+        next2 += framesRead;
+        ASSERT_LE(fifo.getFullFramesAvailable(reader2), 29);
+    }
+    EXPECT_EQ(0, fifo.getOverrunCount(reader1));
+    EXPECT_EQ(0, fifo.getOverrunCount(reader2));
+    EXPECT_EQ(fifo.getFullFramesAvailable(reader2), fifo.getSlowestReaderLag());
+}
+
+TEST(test_fifo_multi_reader, slowest_reader_lag) {
+    FifoBufferMultiReader fifo(sizeof(int16_t), kCapacity, kMaxReaders);
+    ASSERT_EQ(0, fifo.getSlowestReaderLag());
+    ASSERT_EQ(kCapacity, fifo.getEmptyFramesAvailable());
+
+    int16_t data[kCapacity] = {};
+    fifo.write(data, 10);
+    // Readers start at the next frame written.
+    int32_t reader1 = fifo.addReader();
+    int32_t reader2 = fifo.addReader();
+    ASSERT_EQ(0, fifo.getSlowestReaderLag());
+
+    fifo.write(data, 50);
+    ASSERT_EQ(50, fifo.getSlowestReaderLag());
+    ASSERT_EQ(kCapacity - 50, fifo.getEmptyFramesAvailable());
+
+    fifo.read(reader1, data, 40);
+    ASSERT_EQ(50, fifo.getSlowestReaderLag());
+    fifo.read(reader2, data, 20);
+    ASSERT_EQ(30, fifo.getSlowestReaderLag());
+
+    // Removed readers are not waited for.
+    fifo.removeReader(reader2);
+    ASSERT_EQ(10, fifo.getSlowestReaderLag());
+}
+
+TEST(test_fifo_multi_reader, overrun) {
+    FifoBufferMultiReader fifo(sizeof(int16_t), kCapacity, kMaxReaders);
+    int32_t reader = fifo.addReader();
+
+    int16_t source[kCapacity];
+    int16_t destination[kCapacity];
+    fillSequence(source, 50, 0);
+    fifo.write(source, 50);
+    fillSequence(source, 50, 50);
+    fifo.write(source, 50);
+    ASSERT_EQ(100, fifo.getFullFramesAvailable(reader));
+
+    // The first 17 frames were overwritten, the oldest remaining ones are read.
+    fifo_frames_t framesRead = fifo.read(reader, destination, kCapacity);
+    ASSERT_EQ(kCapacity, framesRead);
+    checkSequence(destination, framesRead, 100 - kCapacity);
+    EXPECT_EQ(1, fifo.getOverrunCount(reader));
+    EXPECT_EQ(100 - kCapacity, fifo.getFramesLost(reader));
+    EXPECT_EQ(0, fifo.getFullFramesAvailable(reader));
+}
+
+// One writer and several readers running concurrently. The readers check that
+// every frame they read is in sequence, or that an overrun was reported.
+TEST(test_fifo_multi_reader, concurrent_readers) {
+    constexpr int kFramesToWrite = 1 << 20;
+    constexpr int kBurst = 19;
+    FifoBufferMultiReader fifo(sizeof(int32_t), kCapacity, kMaxReaders);
+    std::vector<int32_t> readerIds;
+    for (int i = 0; i < kMaxReaders; i++) {
+        readerIds.push_back(fifo.addReader());
+    }
+
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    std::vector<int> errors(kMaxReaders, 0);
+    for (int i = 0; i < kMaxReaders; i++) {
+        readers.emplace_back([&fifo, &done, &errors, i, readerId = readerIds[i]]() {
+            int32_t data[kCapacity];
+            int32_t expected = 0;
+            int32_t overruns = 0;
+            while (true) {
+                bool finished = done.load();
+                fifo_frames_t framesRead = fifo.read(readerId, data, kCapacity);
+                if (fifo.getOverrunCount(readerId) != overruns) {
+                    overruns = fifo.getOverrunCount(readerId);
+                    // Resume the sequence after the lost frames.
+                    expected = (int32_t) (fifo.getReadCounter(readerId) - framesRead);
+                }
+                for (int j = 0; j < framesRead; j++) {
+                    if (data[j] != expected + j) {
+                        errors[i]++;
+                        break;
+                    }
+                }
+                expected += framesRead;
+                if (finished && framesRead == 0) {
+                    break;
+                }
+            }
+        });
+    }
+
+    int32_t data[kBurst];
+    for (int32_t written = 0; written < kFramesToWrite; written += kBurst) {
+        for (int j = 0; j < kBurst; j++) {
+            data[j] = written + j;
+        }
+        fifo.write(data, kBurst);
+    }
+    done.store(true);
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    for (int i = 0; i < kMaxReaders; i++) {
+        EXPECT_EQ(0, errors[i]) << "reader " << i;
+        EXPECT_EQ(fifo.getWriteCounter(), fifo.getReadCounter(readerIds[i]));
+    }
+}
@@ -19,9 +19,11 @@
  */
 
 #include <iostream>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "client/AAudioFlowGraph.h"
 #include "flowgraph/ClipToRange.h"
 #include "flowgraph/MonoToMultiConverter.h"
 #include "flowgraph/SourceFloat.h"
@@ -155,3 +157,70 @@ TEST(test_flowgraph, module_clip_to_range) {
         EXPECT_NEAR(expected[i], output[i], tolerance);
     }
 }
+
+static size_t bytesPerSample(audio_format_t format) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT:
+            return sizeof(int16_t);
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED:
+            return kBytesPerI24Packed;
+        default:
+            return sizeof(int32_t);
+    }
+}
+
+// The fused pass must give exactly the same output as the graph,
+// including while switching to and from a volume ramp.
+static void checkFusedMatchesGraph(audio_format_t sourceFormat, audio_format_t sinkFormat) {
+    constexpr int32_t kChannelCount = 2;
+    constexpr int32_t kFramesPerBurst = 67; // arbitrary prime, not a multiple of the block size
+    AAudioFlowGraph graph;
+    AAudioFlowGraph fused;
+    graph.setFusedPassEnabled(false);
+    fused.setFusedPassEnabled(true);
+    ASSERT_EQ(AAUDIO_OK, graph.configure(sourceFormat, kChannelCount, sinkFormat, kChannelCount));
+    ASSERT_EQ(AAUDIO_OK, fused.configure(sourceFormat, kChannelCount, sinkFormat, kChannelCount));
+
+    const int32_t numSamples = kFramesPerBurst * kChannelCount;
+    std::vector<uint8_t> source(numSamples * bytesPerSample(sourceFormat));
+    if (sourceFormat == AUDIO_FORMAT_PCM_FLOAT) {
+        // Exceed the clipping range.
+        float *floatData = (float *) source.data();
+        for (int32_t i = 0; i < numSamples; i++) {
+            floatData[i] = ((i * 37) % 101 - 50) * 0.05f;
+        }
+    } else {
+        for (size_t i = 0; i < source.size(); i++) {
+            source[i] = (uint8_t) (i * 73 + 11);
+        }
+    }
+    std::vector<uint8_t> graphOutput(numSamples * bytesPerSample(sinkFormat));
+    std::vector<uint8_t> fusedOutput(graphOutput.size());
+
+    static const float volumes[] = {1.0f, 0.5f, 0.5f, 0.123f, 1.0f};
+    for (float volume : volumes) {
+        graph.setTargetVolume(volume);
+        fused.setTargetVolume(volume);
+        for (int i = 0; i < 20; i++) { // longer than the ramp
+            graph.process(source.data(), graphOutput.data(), kFramesPerBurst);
+            fused.process(source.data(), fusedOutput.data(), kFramesPerBurst);
+            ASSERT_EQ(graphOutput, fusedOutput) << "volume " << volume << ", burst " << i;
+        }
+    }
+}
+
+TEST(test_flowgraph, fused_matches_graph) {
+    static const audio_format_t formats[] = {
+            AUDIO_FORMAT_PCM_FLOAT,
+            AUDIO_FORMAT_PCM_16_BIT,
+            AUDIO_FORMAT_PCM_24_BIT_PACKED,
+            AUDIO_FORMAT_PCM_32_BIT,
+    };
+    for (audio_format_t sourceFormat : formats) {
+        for (audio_format_t sinkFormat : formats) {
+            SCOPED_TRACE(testing::Message() << "source " << sourceFormat
+                                            << ", sink " << sinkFormat);
+            checkFusedMatchesGraph(sourceFormat, sinkFormat);
+        }
+    }
+}
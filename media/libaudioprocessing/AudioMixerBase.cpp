@@ -28,6 +28,7 @@
 #include <utils/Log.h>
 
 #include "AudioMixerOps.h"
+#include "AudioMixerWorkers.h"
 
 // The FCC_2 macro refers to the Fixed Channel Count of 2 for the legacy integer mixer.
 #ifndef FCC_2
@@ -56,6 +57,14 @@ namespace android {
 
 // ----------------------------------------------------------------------------
 
+AudioMixerBase::AudioMixerBase(size_t frameCount, uint32_t sampleRate)
+    : mSampleRate(sampleRate)
+    , mFrameCount(frameCount) {
+}
+
+// Out of line, as AudioMixerWorkers is only declared in the header.
+AudioMixerBase::~AudioMixerBase() {}
+
 bool AudioMixerBase::isValidFormat(audio_format_t format) const
 {
     switch (format) {
@@ -590,6 +599,31 @@ size_t AudioMixerBase::getUnreleasedFrames(int name) const
     return 0;
 }
 
+void AudioMixerBase::setParallelism(size_t workerCount)
+{
+    workerCount = std::min(workerCount, kMaxParallelism);
+    if (workerCount == getParallelism()) {
+        return;
+    }
+    mParallelGroups.clear();
+    mWorkerOutputTemp.clear();
+    mWorkerResampleTemp.clear();
+    mWorkers.reset();
+    if (workerCount > 1) {
+        mWorkers.reset(new AudioMixerWorkers(workerCount));
+        for (size_t i = 0; i < workerCount; ++i) {
+            mWorkerOutputTemp.emplace_back(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+            mWorkerResampleTemp.emplace_back(new int32_t[MAX_NUM_CHANNELS * mFrameCount]);
+        }
+    }
+    invalidate();
+}
+
+size_t AudioMixerBase::getParallelism() const
+{
+    return mWorkers.get() != nullptr ? mWorkers->size() : 1;
+}
+
 std::string AudioMixerBase::trackNames() const
 {
     std::stringstream ss;
@@ -715,6 +749,34 @@ void AudioMixerBase::process__validate()
                 }
             }
         }
+
+        if (mWorkers.get() != nullptr && mEnabled.size() >= kMinParallelTracks) {
+            // Tracks with an aux buffer stay on the calling thread, worker 0, as
+            // several tracks may accumulate into the same aux buffer. The others
+            // go to the worker with the fewest tracks.
+            const size_t workerCount = mWorkers->size();
+            mParallelGroups.clear();
+            for (const auto &pair : mGroups) {
+                ParallelGroup &group = mParallelGroups.emplace_back();
+                group.mainBuffer = pair.first;
+                group.workerTracks.resize(workerCount);
+                for (const int name : pair.second) {
+                    TrackBase * const t = mTracks[name].get();
+                    size_t worker = 0;
+                    if ((t->needs & NEEDS_AUX) == 0) {
+                        for (size_t i = 1; i < workerCount; ++i) {
+                            if (group.workerTracks[i].size()
+                                    < group.workerTracks[worker].size()) {
+                                worker = i;
+                            }
+                        }
+                    }
+                    group.workerTracks[worker].push_back(t);
+                }
+            }
+            mParallelResampling = resampling;
+            mHook = &AudioMixerBase::process__parallel;
+        }
     }
 
     ALOGV("mixer configuration change: %zu "
@@ -791,6 +853,92 @@ void AudioMixerBase::TrackBase::track__nop(int32_t* out __unused,
 {
 }
 
+void AudioMixerBase::TrackBase::mixResampling(
+        int32_t* out, size_t outFrameCount, int32_t* temp)
+{
+    int32_t *aux = NULL;
+    if (CC_UNLIKELY(needs & NEEDS_AUX)) {
+        aux = auxBuffer;
+    }
+
+    // this is a little goofy, on the resampling case we don't
+    // acquire/release the buffers because it's done by
+    // the resampler.
+    if (needs & NEEDS_RESAMPLE) {
+        (this->*hook)(out, outFrameCount, temp, aux);
+    } else {
+
+        size_t outFrames = 0;
+
+        while (outFrames < outFrameCount) {
+            buffer.frameCount = outFrameCount - outFrames;
+            bufferProvider->getNextBuffer(&buffer);
+            mIn = buffer.raw;
+            // mIn == nullptr can happen if the track was flushed just after having
+            // been enabled for mixing.
+            if (mIn == nullptr) break;
+
+            (this->*hook)(
+                    out + outFrames * mMixerChannelCount, buffer.frameCount,
+                    temp, aux != nullptr ? aux + outFrames : nullptr);
+            outFrames += buffer.frameCount;
+
+            bufferProvider->releaseBuffer(&buffer);
+        }
+    }
+}
+
+// Same sequence of hook calls, block by block, as process__genericNoResampling
+// makes for the track, with |out| covering all blocks.
+void AudioMixerBase::TrackBase::mixNoResampling(
+        int32_t* out, size_t outFrameCount, int32_t* temp)
+{
+    // acquire buffer
+    buffer.frameCount = outFrameCount;
+    bufferProvider->getNextBuffer(&buffer);
+    frameCount = buffer.frameCount;
+    mIn = buffer.raw;
+
+    size_t numFrames = 0;
+    do {
+        const size_t blockFrames = std::min((size_t)BLOCKSIZE, outFrameCount - numFrames);
+        int32_t * const blockOut = out + numFrames * mMixerChannelCount;
+        int32_t *aux = NULL;
+        if (CC_UNLIKELY(needs & NEEDS_AUX)) {
+            aux = auxBuffer + numFrames;
+        }
+        for (int outFrames = blockFrames; outFrames > 0; ) {
+            if (mIn == nullptr) {
+                break;
+            }
+            size_t inFrames = (frameCount > outFrames)?outFrames:frameCount;
+            if (inFrames > 0) {
+                (this->*hook)(blockOut + (blockFrames - outFrames) * mMixerChannelCount,
+                        inFrames, temp, aux);
+                frameCount -= inFrames;
+                outFrames -= inFrames;
+                if (CC_UNLIKELY(aux != NULL)) {
+                    aux += inFrames;
+                }
+            }
+            if (frameCount == 0 && outFrames) {
+                bufferProvider->releaseBuffer(&buffer);
+                buffer.frameCount = (outFrameCount - numFrames) - (blockFrames - outFrames);
+                bufferProvider->getNextBuffer(&buffer);
+                mIn = buffer.raw;
+                if (mIn == nullptr) {
+                    break;
+                }
+                frameCount = buffer.frameCount;
+            }
+        }
+        numFrames += blockFrames;
+    } while (numFrames < outFrameCount);
+
+    // release the track's buffer
+    bufferProvider->releaseBuffer(&buffer);
+}
+
 void AudioMixerBase::TrackBase::volumeRampStereo(
         int32_t* out, size_t frameCount, int32_t* temp, int32_t* aux)
 {
@@ -1166,41 +1314,62 @@ void AudioMixerBase::process__genericResampling()
         // clear temp buffer
         memset(outTemp, 0, sizeof(*outTemp) * t1->mMixerChannelCount * mFrameCount);
         for (const int name : group) {
-            const std::shared_ptr<TrackBase> &t = mTracks[name];
-            int32_t *aux = NULL;
-            if (CC_UNLIKELY(t->needs & NEEDS_AUX)) {
-                aux = t->auxBuffer;
-            }
+            mTracks[name]->mixResampling(outTemp, numFrames, mResampleTemp.get() /* naked ptr */);
+        }
+        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+    }
+}
 
-            // this is a little goofy, on the resampling case we don't
-            // acquire/release the buffers because it's done by
-            // the resampler.
-            if (t->needs & NEEDS_RESAMPLE) {
-                (t.get()->*t->hook)(outTemp, numFrames, mResampleTemp.get() /* naked ptr */, aux);
+// generic code, with the tracks of each group mixed on several threads
+void AudioMixerBase::process__parallel()
+{
+    ALOGVV("process__parallel\n");
+    const size_t workerCount = mWorkers->size();
+
+    for (const ParallelGroup &group : mParallelGroups) {
+        TrackBase *t1 = nullptr;
+        for (const auto &tracks : group.workerTracks) {
+            if (!tracks.empty()) {
+                t1 = tracks[0];
+                break;
+            }
+        }
+        const size_t sampleCount = mFrameCount * t1->mMixerChannelCount;
+
+        auto job = [&](size_t worker) {
+            int32_t * const outTemp = mWorkerOutputTemp[worker].get();
+            int32_t * const temp = mWorkerResampleTemp[worker].get();
+            memset(outTemp, 0, sizeof(*outTemp) * sampleCount);
+            for (TrackBase * const t : group.workerTracks[worker]) {
+                if (mParallelResampling) {
+                    t->mixResampling(outTemp, mFrameCount, temp);
+                } else {
+                    t->mixNoResampling(outTemp, mFrameCount, temp);
+                }
+            }
+        };
+        mWorkers->run(job);
+
+        // sum the partial mixes in worker order, so the result is reproducible.
+        int32_t * const outTemp = mWorkerOutputTemp[0].get();
+        for (size_t worker = 1; worker < workerCount; ++worker) {
+            if (group.workerTracks[worker].empty()) continue;
+            const int32_t * const partial = mWorkerOutputTemp[worker].get();
+            if (t1->mMixerInFormat == AUDIO_FORMAT_PCM_FLOAT) {
+                float * const out = reinterpret_cast<float *>(outTemp);
+                const float * const in = reinterpret_cast<const float *>(partial);
+                for (size_t i = 0; i < sampleCount; ++i) {
+                    out[i] += in[i];
+                }
             } else {
-
-                size_t outFrames = 0;
-
-                while (outFrames < numFrames) {
-                    t->buffer.frameCount = numFrames - outFrames;
-                    t->bufferProvider->getNextBuffer(&t->buffer);
-                    t->mIn = t->buffer.raw;
-                    // t->mIn == nullptr can happen if the track was flushed just after having
-                    // been enabled for mixing.
-                    if (t->mIn == nullptr) break;
-
-                    (t.get()->*t->hook)(
-                            outTemp + outFrames * t->mMixerChannelCount, t->buffer.frameCount,
-                            mResampleTemp.get() /* naked ptr */,
-                            aux != nullptr ? aux + outFrames : nullptr);
-                    outFrames += t->buffer.frameCount;
-
-                    t->bufferProvider->releaseBuffer(&t->buffer);
+                for (size_t i = 0; i < sampleCount; ++i) {
+                    outTemp[i] += partial[i];
                 }
             }
         }
-        convertMixerFormat(t1->mainBuffer, t1->mMixerFormat,
-                outTemp, t1->mMixerInFormat, numFrames * t1->mMixerChannelCount);
+        convertMixerFormat(group.mainBuffer, t1->mMixerFormat,
+                outTemp, t1->mMixerInFormat, sampleCount);
     }
 }
 
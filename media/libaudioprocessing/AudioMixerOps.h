@@ -17,10 +17,14 @@
 #ifndef ANDROID_AUDIO_MIXER_OPS_H
 #define ANDROID_AUDIO_MIXER_OPS_H
 
+#include <algorithm>
+
 #include <audio_utils/channels.h>
 #include <audio_utils/primitives.h>
 #include <system/audio.h>
 
+#include "AudioMixerOpsSimd.h"
+
 namespace android {
 
 // Hack to make static_assert work in a constexpr
@@ -372,6 +376,177 @@ void stereoVolumeHelper(TO*& out, const TI*& in, const TV *vol, F f) {
     stereoVolumeHelperWithChannelMask<MIXTYPE, MASK, TO, TI, TV, F>(out, in, vol, f);
 }
 
+/*
+ * MixGain converts a volume of type TV into the per-sample gain used by
+ * mixerops::applyGains, such that out = in * gain rounds exactly as
+ * MixMul<TO, TI, TV>(in, volume). For the float normalizations this holds as
+ * scaling by a power of 2 is exact.
+ * The type is void if there is no vector kernel for <TO, TI, TV>.
+ */
+template <typename TO, typename TI, typename TV>
+struct MixGain {
+    using type = void;
+};
+
+template <>
+struct MixGain<float, float, float> {
+    using type = float;
+    static float from(float volume) { return volume; }
+};
+
+template <>
+struct MixGain<float, int16_t, int16_t> {
+    using type = float;
+    static float from(int16_t volume) {
+        static constexpr float norm = 1. / (1 << (15 + 12));
+        return static_cast<float>(volume) * norm;
+    }
+};
+
+template <>
+struct MixGain<float, int16_t, int32_t> {
+    using type = float;
+    static float from(int32_t volume) {
+        static constexpr float norm = 1. / (1ULL << (15 + 28));
+        return static_cast<float>(volume) * norm;
+    }
+};
+
+template <>
+struct MixGain<int32_t, int16_t, int16_t> {
+    using type = int32_t;
+    static int32_t from(int16_t volume) { return volume; }
+};
+
+template <>
+struct MixGain<int32_t, int16_t, int32_t> {
+    using type = int32_t;
+    static int32_t from(int32_t volume) { return volume >> 16; }
+};
+
+/*
+ * Whether volumeRampMulti and volumeMulti use the vector kernels when there
+ * is no aux buffer. This covers the MIXTYPEs with as many input as output
+ * channels, and the channel counts with a canonical mask.
+ */
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+inline constexpr bool kMixUsesGainKernel =
+        (MIXTYPE == MIXTYPE_MULTI
+                || MIXTYPE == MIXTYPE_MULTI_SAVEONLY
+                || MIXTYPE == MIXTYPE_MULTI_MONOVOL
+                || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL
+                || MIXTYPE == MIXTYPE_MULTI_STEREOVOL
+                || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_STEREOVOL)
+        && canonicalChannelMaskFromCount(NCHAN) != AUDIO_CHANNEL_NONE
+        && mixerops::kHasGainKernel<TO, TI, typename MixGain<TO, TI, TV>::type>;
+
+/*
+ * Writes the NCHAN gains of one frame, in the order the scalar loops of
+ * volumeRampMulti and volumeMulti apply the volumes.
+ */
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+inline void mixGainsForFrame(typename MixGain<TO, TI, TV>::type *gains,
+        const TI *in, const TV *vol) {
+    using Gain = MixGain<TO, TI, TV>;
+    if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+        for (int i = 0; i < NCHAN; ++i) {
+            gains[i] = Gain::from(vol[i]);
+        }
+    } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+        const auto gain = Gain::from(vol[0]);
+        for (int i = 0; i < NCHAN; ++i) {
+            gains[i] = gain;
+        }
+    } else /* constexpr */ {
+        // Shares the channel to volume assignment, but not the input data.
+        const TI *unused = in;
+        stereoVolumeHelper<MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN>(
+                gains, unused, vol, [] (const auto &, const auto &b) {
+            return Gain::from(b);
+        });
+    }
+}
+
+// Frames whose samples fill a whole number of kGainAlign vectors.
+template <int NCHAN>
+constexpr size_t mixGainFrames() {
+    size_t frames = 1;
+    while (frames * NCHAN % mixerops::kGainAlign != 0) {
+        ++frames;
+    }
+    return frames;
+}
+
+/*
+ * Vector part of volumeRampMulti without aux. Processes a multiple of
+ * mixGainFrames<NCHAN>() frames, advancing the volumes as the scalar loop
+ * does, and returns the number of frames processed.
+ */
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+inline size_t volumeRampMultiVector(TO* out, size_t frameCount,
+        const TI* in, TV *vol, const TV *volinc)
+{
+    using G = typename MixGain<TO, TI, TV>::type;
+    constexpr bool ACCUMULATE = MIXTYPE == MIXTYPE_MULTI
+            || MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_STEREOVOL;
+    constexpr size_t FRAMES = mixGainFrames<NCHAN>();
+    // gains of a batch of frames, to amortize the call of the kernel
+    constexpr size_t BATCH_FRAMES = FRAMES * std::max<size_t>(1, 256 / (FRAMES * NCHAN));
+    G gains[BATCH_FRAMES * NCHAN];
+
+    const size_t vectorFrames = frameCount - frameCount % FRAMES;
+    for (size_t done = 0; done < vectorFrames; ) {
+        const size_t frames = std::min(BATCH_FRAMES, vectorFrames - done);
+        for (size_t i = 0; i < frames; ++i) {
+            mixGainsForFrame<MIXTYPE, NCHAN, TO, TI, TV>(gains + i * NCHAN, in, vol);
+            if constexpr (MIXTYPE == MIXTYPE_MULTI || MIXTYPE == MIXTYPE_MULTI_SAVEONLY) {
+                for (int j = 0; j < NCHAN; ++j) {
+                    vol[j] += volinc[j];
+                }
+            } else if constexpr (MIXTYPE == MIXTYPE_MULTI_MONOVOL
+                    || MIXTYPE == MIXTYPE_MULTI_SAVEONLY_MONOVOL) {
+                vol[0] += volinc[0];
+            } else /* constexpr */ {
+                vol[0] += volinc[0];
+                vol[1] += volinc[1];
+            }
+        }
+        mixerops::applyGains<ACCUMULATE>(out, in, frames * NCHAN, gains, frames * NCHAN);
+        out += frames * NCHAN;
+        in += frames * NCHAN;
+        done += frames;
+    }
+    return vectorFrames;
+}
+
+/*
+ * Vector part of volumeMulti without aux, see volumeRampMultiVector.
+ */
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV>
+inline size_t volumeMultiVector(TO* out, size_t frameCount, const TI* in, const TV *vol)
+{
+    using G = typename MixGain<TO, TI, TV>::type;
+    constexpr bool ACCUMULATE = MIXTYPE == MIXTYPE_MULTI
+            || MIXTYPE == MIXTYPE_MULTI_MONOVOL
+            || MIXTYPE == MIXTYPE_MULTI_STEREOVOL;
+    constexpr size_t FRAMES = mixGainFrames<NCHAN>();
+    // a longer period of gains makes for fewer wraparounds in the kernel
+    constexpr size_t PERIOD_FRAMES = FRAMES * std::max<size_t>(1, 64 / (FRAMES * NCHAN));
+    G gains[PERIOD_FRAMES * NCHAN];
+
+    const size_t vectorFrames = frameCount - frameCount % FRAMES;
+    if (vectorFrames != 0) {
+        for (size_t i = 0; i < PERIOD_FRAMES; ++i) {
+            mixGainsForFrame<MIXTYPE, NCHAN, TO, TI, TV>(gains + i * NCHAN, in, vol);
+        }
+        mixerops::applyGains<ACCUMULATE>(
+                out, in, vectorFrames * NCHAN, gains, PERIOD_FRAMES * NCHAN);
+    }
+    return vectorFrames;
+}
+
 /*
  * The volumeRampMulti and volumeRamp functions take a MIXTYPE
  * which indicates the per-frame mixing and accumulation strategy.
@@ -436,6 +611,18 @@ inline void volumeRampMulti(TO* out, size_t frameCount,
 #ifdef ALOGVV
     ALOGVV("volumeRampMulti, MIXTYPE:%d\n", MIXTYPE);
 #endif
+    if constexpr (kMixUsesGainKernel<MIXTYPE, NCHAN, TO, TI, TV>) {
+        if (aux == NULL) {
+            const size_t frames = volumeRampMultiVector<MIXTYPE, NCHAN>(
+                    out, frameCount, in, vol, volinc);
+            if (frames == frameCount) {
+                return;
+            }
+            out += frames * NCHAN;
+            in += frames * NCHAN;
+            frameCount -= frames;
+        }
+    }
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
@@ -530,6 +717,17 @@ inline void volumeMulti(TO* out, size_t frameCount,
 #ifdef ALOGVV
     ALOGVV("volumeMulti MIXTYPE:%d\n", MIXTYPE);
 #endif
+    if constexpr (kMixUsesGainKernel<MIXTYPE, NCHAN, TO, TI, TV>) {
+        if (aux == NULL) {
+            const size_t frames = volumeMultiVector<MIXTYPE, NCHAN>(out, frameCount, in, vol);
+            if (frames == frameCount) {
+                return;
+            }
+            out += frames * NCHAN;
+            in += frames * NCHAN;
+            frameCount -= frames;
+        }
+    }
     if (aux != NULL) {
         do {
             TA auxaccum = 0;
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_OPS_SIMD_H
+#define ANDROID_AUDIO_MIXER_OPS_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#if defined(__aarch64__) || (defined(__arm__) && defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define MIXER_OPS_NEON
+#elif defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#include <immintrin.h>
+#define MIXER_OPS_X86
+#endif
+
+namespace android {
+namespace mixerops {
+
+/* applyGains scales |count| input samples by a matching array of per-sample
+ * gains, with the gains repeating every |period| samples, and either stores
+ * (SAVEONLY) or accumulates (ACCUMULATE) the result into the output:
+ *
+ * out[i] (+)= in[i] * gains[i % period]
+ *
+ * Supported <TO, TI, TG> are:
+ *   <float, float, float>
+ *   <float, int16_t, float>, the gain including the Q0.15 and volume normalization.
+ *   <int32_t, int16_t, int32_t>, the product being Q4.27 as for MixMul.
+ *
+ * |period| and |count| must be multiples of kGainAlign. The kernel is picked at first use from the instruction sets of
+ * the CPU: NEON on ARM, AVX2 (if present) or SSE2 on x86, plain C otherwise.
+ * Every kernel rounds exactly as the scalar MixMul code does, so results do
+ * not depend on the CPU.
+ */
+constexpr size_t kGainAlign = 8;
+
+template <typename TO, typename TI, typename TG>
+inline constexpr bool kHasGainKernel =
+        (std::is_same_v<TO, float> && std::is_same_v<TI, float> && std::is_same_v<TG, float>)
+        || (std::is_same_v<TO, float> && std::is_same_v<TI, int16_t>
+                && std::is_same_v<TG, float>)
+        || (std::is_same_v<TO, int32_t> && std::is_same_v<TI, int16_t>
+                && std::is_same_v<TG, int32_t>);
+
+template <typename TO, typename TI, typename TG>
+using ApplyGainsFn = void (*)(TO *out, const TI *in, size_t count,
+        const TG *gains, size_t period);
+
+// Portable kernels, also used where the vector ones lack an instruction.
+
+template <bool ACCUMULATE, typename TO, typename TI, typename TG>
+void applyGainsC(TO *out, const TI *in, size_t count, const TG *gains, size_t period) {
+    for (size_t i = 0, j = 0; i < count; ++i) {
+        const TO value = static_cast<TG>(in[i]) * gains[j];
+        if constexpr (ACCUMULATE) {
+            out[i] += value;
+        } else {
+            out[i] = value;
+        }
+        if (++j == period) {
+            j = 0;
+        }
+    }
+}
+
+#if defined(MIXER_OPS_NEON)
+
+template <bool ACCUMULATE>
+inline void mul8Neon(float *out, const float *in, const float *g) {
+    float32x4_t lo = vmulq_f32(vld1q_f32(in), vld1q_f32(g));
+    float32x4_t hi = vmulq_f32(vld1q_f32(in + 4), vld1q_f32(g + 4));
+    if constexpr (ACCUMULATE) {
+        lo = vaddq_f32(vld1q_f32(out), lo);
+        hi = vaddq_f32(vld1q_f32(out + 4), hi);
+    }
+    vst1q_f32(out, lo);
+    vst1q_f32(out + 4, hi);
+}
+
+template <bool ACCUMULATE>
+inline void mul8Neon(float *out, const int16_t *in, const float *g) {
+    const int16x8_t x = vld1q_s16(in);
+    float32x4_t lo = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), vld1q_f32(g));
+    float32x4_t hi = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), vld1q_f32(g + 4));
+    if constexpr (ACCUMULATE) {
+        lo = vaddq_f32(vld1q_f32(out), lo);
+        hi = vaddq_f32(vld1q_f32(out + 4), hi);
+    }
+    vst1q_f32(out, lo);
+    vst1q_f32(out + 4, hi);
+}
+
+template <bool ACCUMULATE>
+inline void mul8Neon(int32_t *out, const int16_t *in, const int32_t *g) {
+    const int16x8_t x = vld1q_s16(in);
+    int32x4_t lo = vmulq_s32(vmovl_s16(vget_low_s16(x)), vld1q_s32(g));
+    int32x4_t hi = vmulq_s32(vmovl_s16(vget_high_s16(x)), vld1q_s32(g + 4));
+    if constexpr (ACCUMULATE) {
+        lo = vaddq_s32(vld1q_s32(out), lo);
+        hi = vaddq_s32(vld1q_s32(out + 4), hi);
+    }
+    vst1q_s32(out, lo);
+    vst1q_s32(out + 4, hi);
+}
+
+template <bool ACCUMULATE, typename TO, typename TI, typename TG>
+void applyGainsNeon(TO *out, const TI *in, size_t count, const TG *gains, size_t period) {
+    for (size_t i = 0, j = 0; i < count; i += kGainAlign) {
+        mul8Neon<ACCUMULATE>(out + i, in + i, gains + j);
+        j += kGainAlign;
+        if (j == period) {
+            j = 0;
+        }
+    }
+}
+
+#elif defined(MIXER_OPS_X86)
+
+template <bool ACCUMULATE>
+inline void mul8Sse2(float *out, const float *in, const float *g) {
+    __m128 lo = _mm_mul_ps(_mm_loadu_ps(in), _mm_loadu_ps(g));
+    __m128 hi = _mm_mul_ps(_mm_loadu_ps(in + 4), _mm_loadu_ps(g + 4));
+    if constexpr (ACCUMULATE) {
+        lo = _mm_add_ps(_mm_loadu_ps(out), lo);
+        hi = _mm_add_ps(_mm_loadu_ps(out + 4), hi);
+    }
+    _mm_storeu_ps(out, lo);
+    _mm_storeu_ps(out + 4, hi);
+}
+
+template <bool ACCUMULATE>
+inline void mul8Sse2(float *out, const int16_t *in, const float *g) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+    // sign extend by unpacking into the upper halves and shifting back down
+    const __m128i xlo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    const __m128i xhi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(xlo), _mm_loadu_ps(g));
+    __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(xhi), _mm_loadu_ps(g + 4));
+    if constexpr (ACCUMULATE) {
+        lo = _mm_add_ps(_mm_loadu_ps(out), lo);
+        hi = _mm_add_ps(_mm_loadu_ps(out + 4), hi);
+    }
+    _mm_storeu_ps(out, lo);
+    _mm_storeu_ps(out + 4, hi);
+}
+
+template <bool ACCUMULATE, typename TO, typename TI, typename TG>
+void applyGainsSse2(TO *out, const TI *in, size_t count, const TG *gains, size_t period) {
+    for (size_t i = 0, j = 0; i < count; i += kGainAlign) {
+        mul8Sse2<ACCUMULATE>(out + i, in + i, gains + j);
+        j += kGainAlign;
+        if (j == period) {
+            j = 0;
+        }
+    }
+}
+
+template <bool ACCUMULATE>
+__attribute__((target("avx2")))
+inline void mul8Avx2(float *out, const float *in, const float *g) {
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(in), _mm256_loadu_ps(g));
+    if constexpr (ACCUMULATE) {
+        x = _mm256_add_ps(_mm256_loadu_ps(out), x);
+    }
+    _mm256_storeu_ps(out, x);
+}
+
+template <bool ACCUMULATE>
+__attribute__((target("avx2")))
+inline void mul8Avx2(float *out, const int16_t *in, const float *g) {
+    const __m256i x = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+    __m256 y = _mm256_mul_ps(_mm256_cvtepi32_ps(x), _mm256_loadu_ps(g));
+    if constexpr (ACCUMULATE) {
+        y = _mm256_add_ps(_mm256_loadu_ps(out), y);
+    }
+    _mm256_storeu_ps(out, y);
+}
+
+template <bool ACCUMULATE>
+__attribute__((target("avx2")))
+inline void mul8Avx2(int32_t *out, const int16_t *in, const int32_t *g) {
+    const __m256i x = _mm256_cvtepi16_epi32(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in)));
+    __m256i y = _mm256_mullo_epi32(x, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(g)));
+    if constexpr (ACCUMULATE) {
+        y = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(out)), y);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), y);
+}
+
+template <bool ACCUMULATE, typename TO, typename TI, typename TG>
+__attribute__((target("avx2")))
+void applyGainsAvx2(TO *out, const TI *in, size_t count, const TG *gains, size_t period) {
+    for (size_t i = 0, j = 0; i < count; i += kGainAlign) {
+        mul8Avx2<ACCUMULATE>(out + i, in + i, gains + j);
+        j += kGainAlign;
+        if (j == period) {
+            j = 0;
+        }
+    }
+}
+
+inline bool cpuHasAvx2() {
+    static const bool hasAvx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return hasAvx2;
+}
+
+#endif
+
+template <bool ACCUMULATE, typename TO, typename TI, typename TG>
+ApplyGainsFn<TO, TI, TG> selectApplyGains() {
+    static_assert(kHasGainKernel<TO, TI, TG>);
+#if defined(MIXER_OPS_NEON)
+    return applyGainsNeon<ACCUMULATE, TO, TI, TG>;
+#elif defined(MIXER_OPS_X86)
+    if (cpuHasAvx2()) {
+        return applyGainsAvx2<ACCUMULATE, TO, TI, TG>;
+    }
+    if constexpr (std::is_same_v<TO, float>) {
+        return applyGainsSse2<ACCUMULATE, TO, TI, TG>;
+    } else {
+        return applyGainsC<ACCUMULATE, TO, TI, TG>; // SSE2 has no 32 bit multiply
+    }
+#else
+    return applyGainsC<ACCUMULATE, TO, TI, TG>;
+#endif
+}
+
+template <bool ACCUMULATE, typename TO, typename TI, typename TG>
+inline void applyGains(TO *out, const TI *in, size_t count, const TG *gains, size_t period) {
+    static const ApplyGainsFn<TO, TI, TG> fn = selectApplyGains<ACCUMULATE, TO, TI, TG>();
+    fn(out, in, count, gains, period);
+}
+
+} // namespace mixerops
+} // namespace android
+
+#endif /* ANDROID_AUDIO_MIXER_OPS_SIMD_H */
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioMixerWorkers"
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "AudioMixerWorkers.h"
+
+namespace android {
+
+AudioMixerWorkers::AudioMixerWorkers(size_t count) {
+    for (size_t i = 1; i < count; ++i) {
+        mThreads.emplace_back(&AudioMixerWorkers::threadLoop, this, i);
+    }
+}
+
+AudioMixerWorkers::~AudioMixerWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mStartCondition.notify_all();
+    for (std::thread &thread : mThreads) {
+        thread.join();
+    }
+}
+
+void AudioMixerWorkers::dispatch(Trampoline trampoline, void *context) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mTrampoline = trampoline;
+        mContext = context;
+        mPending = mThreads.size();
+        ++mGeneration;
+    }
+    mStartCondition.notify_all();
+
+    trampoline(context, 0);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    mDoneCondition.wait(lock, [this] { return mPending == 0; });
+}
+
+void AudioMixerWorkers::threadLoop(size_t index) {
+    char name[16];
+    snprintf(name, sizeof(name), "AudioMixer%zu", index);
+    pthread_setname_np(pthread_self(), name);
+
+    uint64_t generation = 0;
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mStartCondition.wait(lock, [&] { return mExit || mGeneration != generation; });
+        if (mExit) {
+            return;
+        }
+        generation = mGeneration;
+        const Trampoline trampoline = mTrampoline;
+        void * const context = mContext;
+
+        lock.unlock();
+        trampoline(context, index);
+        lock.lock();
+
+        if (--mPending == 0) {
+            mDoneCondition.notify_one();
+        }
+    }
+}
+
+} // namespace android
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXER_WORKERS_H
+#define ANDROID_AUDIO_MIXER_WORKERS_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+/* A fixed set of threads on which the mixer runs one job per mix cycle.
+ *
+ * run(job) calls job(0) on the calling thread and job(1) .. job(size() - 1)
+ * on the worker threads, and returns once every call has returned. The job
+ * is passed by reference, so nothing is allocated per cycle.
+ *
+ * The worker threads are created by the constructor and inherit the
+ * scheduling policy and priority of the thread creating them.
+ */
+class AudioMixerWorkers {
+public:
+    // |count| includes the calling thread, so count - 1 threads are created.
+    explicit AudioMixerWorkers(size_t count);
+    ~AudioMixerWorkers();
+
+    AudioMixerWorkers(const AudioMixerWorkers &) = delete;
+    AudioMixerWorkers &operator=(const AudioMixerWorkers &) = delete;
+
+    size_t size() const { return mThreads.size() + 1; }
+
+    template <typename F>
+    void run(F &job) {
+        dispatch([](void *context, size_t index) { (*static_cast<F *>(context))(index); },
+                &job);
+    }
+
+private:
+    using Trampoline = void (*)(void *context, size_t index);
+
+    void dispatch(Trampoline trampoline, void *context);
+    void threadLoop(size_t index);
+
+    std::mutex mLock;
+    std::condition_variable mStartCondition;
+    std::condition_variable mDoneCondition;
+    Trampoline mTrampoline = nullptr;   // guarded by mLock
+    void *mContext = nullptr;           // guarded by mLock
+    uint64_t mGeneration = 0;           // guarded by mLock, bumped for each run()
+    size_t mPending = 0;                // guarded by mLock, worker threads still running
+    bool mExit = false;                 // guarded by mLock
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_MIXER_WORKERS_H
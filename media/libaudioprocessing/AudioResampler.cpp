@@ -30,6 +30,7 @@
 #include "AudioResamplerSinc.h"
 #include "AudioResamplerCubic.h"
 #include "AudioResamplerDyn.h"
+#include "AudioResamplerFilterCache.h"
 
 #ifdef __arm__
     // bug 13102576
@@ -295,6 +296,11 @@ AudioResampler::~AudioResampler() {
     pthread_mutex_unlock(&mutex);
 }
 
+// static
+std::string AudioResampler::dumpFilterCache() {
+    return AudioResamplerFilterCache::getInstance().dump();
+}
+
 void AudioResampler::setSampleRate(int32_t inSampleRate) {
     mInSampleRate = inSampleRate;
     mPhaseIncrement = (uint32_t)((kPhaseMultiplier * inSampleRate) / mSampleRate);
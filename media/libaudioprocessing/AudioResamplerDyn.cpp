@@ -32,8 +32,10 @@
 #include "AudioResamplerFirProcess.h"
 #include "AudioResamplerFirProcessNeon.h"
 #include "AudioResamplerFirProcessSSE.h"
+#include "AudioResamplerFirProcessAVX2.h"
 #include "AudioResamplerFirGen.h" // requires math.h
 #include "AudioResamplerDyn.h"
+#include "AudioResamplerFilterCache.h"
 
 //#define DEBUG_RESAMPLER
 
@@ -181,8 +183,7 @@ template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
         int inChannelCount, int32_t sampleRate, src_quality quality)
     : AudioResampler(inChannelCount, sampleRate, quality),
-      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY),
-    mCoefBuffer(NULL)
+      mResampleFunc(0), mFilterSampleRate(0), mFilterQuality(DEFAULT_QUALITY)
 {
     mVolumeSimd[0] = mVolumeSimd[1] = 0;
     // The AudioResampler base class assumes we are always ready for 1:1 resampling.
@@ -207,7 +208,6 @@ AudioResamplerDyn<TC, TI, TO>::AudioResamplerDyn(
 template<typename TC, typename TI, typename TO>
 AudioResamplerDyn<TC, TI, TO>::~AudioResamplerDyn()
 {
-    free(mCoefBuffer);
 }
 
 template<typename TC, typename TI, typename TO>
@@ -263,24 +263,24 @@ void AudioResamplerDyn<TC, TI, TO>::createKaiserFir(Constants &c,
     const int phases = c.mL;
     const int halfLength = c.mHalfNumCoefs;
 
-    // create buffer
-    TC *coefs = nullptr;
-    int ret = posix_memalign(
-            reinterpret_cast<void **>(&coefs),
-            CACHE_LINE_SIZE /* alignment */,
-            (phases + 1) * halfLength * sizeof(TC));
-    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
-    c.mFirCoefs = coefs;
-    free(mCoefBuffer);
-    mCoefBuffer = coefs;
-
     // square the computed minimum passband value (extra safety).
     double attenuation =
             computeWindowedSincMinimumPassbandValue(stopBandAtten);
     attenuation *= attenuation;
 
-    // design filter
-    firKaiserGen(coefs, phases, halfLength, stopBandAtten, fcr, attenuation);
+    // design filter, or share the one of another resampler doing the same conversion
+    const AudioResamplerFilterCache::Key key = {
+        is_same<TC, float>::value ? AUDIO_FORMAT_PCM_FLOAT
+                : is_same<TC, int32_t>::value ? AUDIO_FORMAT_PCM_32_BIT
+                : AUDIO_FORMAT_PCM_16_BIT,
+        phases, halfLength, stopBandAtten, fcr};
+    mCoefBuffer = AudioResamplerFilterCache::getInstance().acquire(
+            key, (phases + 1) * halfLength * sizeof(TC),
+            [=](void *coefs) {
+                firKaiserGen(static_cast<TC *>(coefs),
+                        phases, halfLength, stopBandAtten, fcr, attenuation);
+            });
+    c.mFirCoefs = static_cast<const TC *>(mCoefBuffer.get());
 
     // update the design criteria
     mNormalizedCutoffFrequency = fcr;
@@ -615,6 +615,25 @@ void AudioResamplerDyn<TC, TI, TO>::setSampleRate(int32_t inSampleRate)
     }
 #pragma pop_macro("AUDIORESAMPLERDYN_CASE")
 
+#if USE_AVX2_DISPATCH
+    // stride 32 selects the AVX2 kernels for mono and stereo on x86,
+    // see AudioResamplerFirProcessAVX2.h. The integer ones are slower than
+    // the scalar code for the shortest (8 tap) filters.
+    if (mChannelCount <= 2 && cpuHasAvx2Fma()
+            && (is_same<TC, float>::value || c.mHalfNumCoefs >= 16)) {
+        stride = 32;
+        if (locked) {
+            mResampleFunc = mChannelCount == 1
+                    ? &AudioResamplerDyn<TC, TI, TO>::resampleAvx2<1, true>
+                    : &AudioResamplerDyn<TC, TI, TO>::resampleAvx2<2, true>;
+        } else {
+            mResampleFunc = mChannelCount == 1
+                    ? &AudioResamplerDyn<TC, TI, TO>::resampleAvx2<1, false>
+                    : &AudioResamplerDyn<TC, TI, TO>::resampleAvx2<2, false>;
+        }
+    }
+#endif
+
 #ifdef DEBUG_RESAMPLER
     printf("channels:%d  %s  stride:%d  %s  coef:%d  shift:%d\n",
             mChannelCount, locked ? "locked" : "interpolated",
@@ -629,6 +648,17 @@ size_t AudioResamplerDyn<TC, TI, TO>::resample(int32_t* out, size_t outFrameCoun
     return (this->*mResampleFunc)(reinterpret_cast<TO*>(out), outFrameCount, provider);
 }
 
+#if USE_AVX2_DISPATCH
+template<typename TC, typename TI, typename TO>
+template<int CHANNELS, bool LOCKED>
+__attribute__((target("avx2,fma"), flatten))
+size_t AudioResamplerDyn<TC, TI, TO>::resampleAvx2(TO* out, size_t outFrameCount,
+        AudioBufferProvider* provider)
+{
+    return resample<CHANNELS, LOCKED, 32>(out, outFrameCount, provider);
+}
+#endif
+
 template<typename TC, typename TI, typename TO>
 template<int CHANNELS, bool LOCKED, int STRIDE>
 size_t AudioResamplerDyn<TC, TI, TO>::resample(TO* out, size_t outFrameCount,
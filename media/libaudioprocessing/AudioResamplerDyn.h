@@ -21,6 +21,8 @@
 #include <sys/types.h>
 #include <android/log.h>
 
+#include <memory>
+
 #include <media/AudioResampler.h>
 
 namespace android {
@@ -155,6 +157,11 @@ private:
     template<int CHANNELS, bool LOCKED, int STRIDE>
     size_t resample(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
 
+    // resample() with STRIDE 32, compiled for AVX2 so that the kernels get inlined.
+    // Only defined for x86.
+    template<int CHANNELS, bool LOCKED>
+    size_t resampleAvx2(TO* out, size_t outFrameCount, AudioBufferProvider* provider);
+
     // define a pointer to member function type for resample
     typedef size_t (AudioResamplerDyn<TC, TI, TO>::*resample_ABP_t)(TO* out,
             size_t outFrameCount, AudioBufferProvider* provider);
@@ -166,7 +173,8 @@ private:
      resample_ABP_t mResampleFunc;     // called function for resampling
             int32_t mFilterSampleRate; // designed filter sample rate.
         src_quality mFilterQuality;    // designed filter quality.
-              void* mCoefBuffer;       // if a filter is created, this is not null
+    std::shared_ptr<const void> mCoefBuffer; // filter coefficients, shared through
+                                             // AudioResamplerFilterCache
 
     // Property selected design parameters.
               // This will enable fixed high quality resampling.
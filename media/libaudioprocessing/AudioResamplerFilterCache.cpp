@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AudioResamplerFilterCache"
+//#define LOG_NDEBUG 0
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <log/log.h>
+
+#include "AudioResamplerFilterCache.h"
+
+namespace android {
+
+namespace {
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+} // namespace
+
+// static
+AudioResamplerFilterCache &AudioResamplerFilterCache::getInstance() {
+    static AudioResamplerFilterCache *cache = new AudioResamplerFilterCache(); // never deleted
+    return *cache;
+}
+
+std::shared_ptr<const void> AudioResamplerFilterCache::acquire(
+        const Key &key, size_t size, const Design &design) {
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        auto it = mFilters.find(key);
+        if (it != mFilters.end()) {
+            std::shared_ptr<const void> coefs = it->second.coefs.lock();
+            if (coefs != nullptr) {
+                ++mHits;
+                return coefs;
+            }
+        }
+        ++mMisses;
+    }
+
+    // Design outside of the lock, it may take milliseconds. Should another
+    // thread design the same filter meanwhile, the first one inserted is kept.
+    void *buffer = nullptr;
+    int ret = posix_memalign(&buffer, CACHE_LINE_SIZE /* alignment */, size);
+    LOG_ALWAYS_FATAL_IF(ret != 0, "Cannot allocate buffer memory, ret %d", ret);
+    design(buffer);
+    std::shared_ptr<const void> coefs(buffer, free);
+    ALOGV("designed filter L:%d hnc:%d stopBandAtten:%lf fcr:%lf (%zu bytes)",
+            key.phases, key.halfNumCoefs, key.stopBandAtten, key.fcr, size);
+
+    std::lock_guard<std::mutex> lock(mLock);
+    removeExpired_l();
+    Entry &entry = mFilters[key];
+    std::shared_ptr<const void> existing = entry.coefs.lock();
+    if (existing != nullptr) {
+        return existing;
+    }
+    entry.coefs = coefs;
+    entry.size = size;
+    return coefs;
+}
+
+AudioResamplerFilterCache::Statistics AudioResamplerFilterCache::getStatistics() {
+    std::lock_guard<std::mutex> lock(mLock);
+    removeExpired_l();
+    Statistics stats;
+    stats.hits = mHits;
+    stats.misses = mMisses;
+    stats.filters = mFilters.size();
+    for (const auto &filter : mFilters) {
+        stats.bytes += filter.second.size;
+    }
+    return stats;
+}
+
+std::string AudioResamplerFilterCache::dump() {
+    const Statistics stats = getStatistics();
+    const uint64_t lookups = stats.hits + stats.misses;
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer),
+            "Resampler filter cache: %zu filters in use, %zu bytes,"
+            " %llu hits, %llu misses (%.1f%% hit rate)\n",
+            stats.filters, stats.bytes,
+            (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+            lookups != 0 ? 100. * stats.hits / lookups : 0.);
+    return buffer;
+}
+
+void AudioResamplerFilterCache::removeExpired_l() {
+    for (auto it = mFilters.begin(); it != mFilters.end(); ) {
+        if (it->second.coefs.expired()) {
+            it = mFilters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace android
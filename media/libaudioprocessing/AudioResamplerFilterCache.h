@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FILTER_CACHE_H
+#define ANDROID_AUDIO_RESAMPLER_FILTER_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include <system/audio.h>
+
+namespace android {
+
+/* Process-wide cache of the polyphase filter coefficients of AudioResamplerDyn.
+ *
+ * A filter is identified by everything its design depends on: the coefficient
+ * format, the number of phases and taps, the stopband attenuation and the
+ * cutoff frequency. These follow from the conversion ratio and quality, so
+ * resamplers doing the same conversion share one copy of the coefficients.
+ *
+ * The cache only holds weak references. A filter is freed when the last
+ * resampler using it is destroyed or switches to another filter, and is
+ * designed again when next needed.
+ */
+class AudioResamplerFilterCache {
+public:
+    struct Key {
+        audio_format_t coefFormat;
+        int phases;
+        int halfNumCoefs;
+        double stopBandAtten;
+        double fcr;
+
+        bool operator<(const Key &other) const {
+            return std::tie(coefFormat, phases, halfNumCoefs, stopBandAtten, fcr)
+                    < std::tie(other.coefFormat, other.phases, other.halfNumCoefs,
+                            other.stopBandAtten, other.fcr);
+        }
+    };
+
+    struct Statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t filters = 0;     // filters in use
+        size_t bytes = 0;       // coefficient memory of the filters in use
+    };
+
+    // Fills in the coefficients of a newly allocated filter.
+    using Design = std::function<void(void *coefs)>;
+
+    static AudioResamplerFilterCache &getInstance();
+
+    // Returns the |size| bytes of coefficients of the filter |key|, calling
+    // |design| to compute them into a new cache line aligned buffer if no
+    // resampler holds them.
+    std::shared_ptr<const void> acquire(const Key &key, size_t size, const Design &design);
+
+    Statistics getStatistics();
+
+    // One line summary for dumpsys.
+    std::string dump();
+
+private:
+    struct Entry {
+        std::weak_ptr<const void> coefs;
+        size_t size;
+    };
+
+    void removeExpired_l();
+
+    std::mutex mLock;
+    std::map<Key, Entry> mFilters;      // guarded by mLock
+    uint64_t mHits = 0;                 // guarded by mLock
+    uint64_t mMisses = 0;               // guarded by mLock
+};
+
+} // namespace android
+
+#endif // ANDROID_AUDIO_RESAMPLER_FILTER_CACHE_H
@@ -17,6 +17,15 @@
 #ifndef ANDROID_AUDIO_RESAMPLER_FIR_OPS_H
 #define ANDROID_AUDIO_RESAMPLER_FIR_OPS_H
 
+// AVX2 kernels are built for all x86 targets and selected at run time,
+// see AudioResamplerFirProcessAVX2.h.
+#if defined(__x86_64__) || defined(__i386__)
+#define USE_AVX2_DISPATCH (true)
+#include <immintrin.h>
+#else
+#define USE_AVX2_DISPATCH (false)
+#endif
+
 namespace android {
 
 #if defined(__arm__) && !defined(__thumb__)
@@ -0,0 +1,532 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H
+#define ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H
+
+namespace android {
+
+// depends on AudioResamplerFirOps.h, AudioResamplerFirProcess.h
+
+#if USE_AVX2_DISPATCH
+
+//
+// AVX2 specializations of Process() and ProcessL() in AudioResamplerFirProcess.h
+// for STRIDE 32, mono and stereo.
+//
+// Unlike the SSE and NEON specializations for STRIDE 16, these are compiled for
+// any x86 target and AudioResamplerDyn selects STRIDE 32 at run time when
+// cpuHasAvx2Fma(). Each loop iteration processes 8 coefficients of each half of
+// the filter, so halfNumCoefs must be a multiple of 8 as for STRIDE 16.
+//
+// The integer kernels accumulate exactly what ProcessBase() does, in a different
+// order, so their output is bit exact. The float kernels differ by rounding.
+//
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+static inline bool cpuHasAvx2Fma()
+{
+    static const bool hasAvx2Fma = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }();
+    return hasAvx2Fma;
+}
+
+AVX2_TARGET
+static inline float hsumAvx2(__m256 v)
+{
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_movehdup_ps(x));
+    return _mm_cvtss_f32(x);
+}
+
+AVX2_TARGET
+static inline int32_t hsumAvx2(__m256i v)
+{
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4E));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xB1));
+    return _mm_cvtsi128_si32(x);
+}
+
+// Returns the low 32 bits of (a * b) >> SHIFT for each signed 32 bit lane,
+// as the scalar int64_t code computes it.
+template <int SHIFT>
+AVX2_TARGET
+static inline __m256i mulShiftAvx2(__m256i a, __m256i b)
+{
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(a, b), SHIFT);
+    const __m256i odd = _mm256_srli_epi64(
+            _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)), SHIFT);
+    return _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+}
+
+// Returns (a * b) >> 15 for each signed 16 bit lane, truncated to 16 bits.
+AVX2_TARGET
+static inline __m256i mulShift15Avx2(__m256i a, __m256i b)
+{
+    return _mm256_or_si256(_mm256_slli_epi16(_mm256_mulhi_epi16(a, b), 1),
+            _mm256_srli_epi16(_mm256_mullo_epi16(a, b), 15));
+}
+
+AVX2_TARGET
+static inline __m256i combineAvx2(__m128i lo, __m128i hi)
+{
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Loads 8 frames of float samples in filter tap order, reversed for the
+// positive half.
+template <int CHANNELS, bool REVERSE>
+AVX2_TARGET
+static inline void loadSamplesAvx2(const float* s, __m256& l, __m256& r)
+{
+    if (CHANNELS == 1) {
+        l = _mm256_loadu_ps(s);
+        if (REVERSE) {
+            l = _mm256_permutevar8x32_ps(l, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+        }
+    } else {
+        // deinterleave into frames 0 1 4 5 2 3 6 7 and put them in order.
+        const __m256 f0123 = _mm256_loadu_ps(s);
+        const __m256 f4567 = _mm256_loadu_ps(s + 8);
+        const __m256i order = REVERSE
+                ? _mm256_setr_epi32(7, 6, 3, 2, 5, 4, 1, 0)
+                : _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+        l = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(f0123, f4567, 0x88), order);
+        r = _mm256_permutevar8x32_ps(_mm256_shuffle_ps(f0123, f4567, 0xDD), order);
+    }
+}
+
+// Loads 8 frames of int16_t samples in filter tap order, reversed for the
+// positive half. Mono samples are returned in the low half, stereo samples
+// as left in the low half and right in the high half.
+template <int CHANNELS, bool REVERSE>
+AVX2_TARGET
+static inline __m256i loadSamplesAvx2(const int16_t* s)
+{
+    if (CHANNELS == 1) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        if (REVERSE) {
+            x = _mm_shuffle_epi8(x, _mm_setr_epi8(
+                    14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+        }
+        return _mm256_castsi128_si256(x);
+    } else {
+        // per 128 bit lane, deinterleave 4 frames into 4 left then 4 right samples,
+        // then gather the left and right quadwords of both lanes.
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+        if (REVERSE) {
+            const __m256i deinterleave = _mm256_setr_epi8(
+                    12, 13, 8, 9, 4, 5, 0, 1, 14, 15, 10, 11, 6, 7, 2, 3,
+                    12, 13, 8, 9, 4, 5, 0, 1, 14, 15, 10, 11, 6, 7, 2, 3);
+            x = _mm256_shuffle_epi8(x, deinterleave);
+            return _mm256_permute4x64_epi64(x, 0x72);
+        } else {
+            const __m256i deinterleave = _mm256_setr_epi8(
+                    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                    0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+            x = _mm256_shuffle_epi8(x, deinterleave);
+            return _mm256_permute4x64_epi64(x, 0xD8);
+        }
+    }
+}
+
+template <int CHANNELS, typename TO>
+static inline void accumulateAvx2(TO* out, TO l, TO r, const TO* volumeLR)
+{
+    out[0] += volumeAdjust(l, volumeLR[0]);
+    out[1] += volumeAdjust(CHANNELS == 1 ? l : r, volumeLR[1]);
+}
+
+template <int CHANNELS, int STRIDE, bool FIXED>
+AVX2_TARGET
+static inline void ProcessAVX2Intrinsic(float* out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* volumeLR,
+        float lerpP,
+        const float* coefsP1,
+        const float* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    __m256 interp;
+    if (!FIXED) {
+        interp = _mm256_set1_ps(lerpP);
+    }
+    __m256 accL = _mm256_setzero_ps();
+    __m256 accR = _mm256_setzero_ps();
+
+    do {
+        __m256 posCoef = _mm256_loadu_ps(coefsP);
+        __m256 negCoef = _mm256_loadu_ps(coefsN);
+        coefsP += 8;
+        coefsN += 8;
+
+        if (!FIXED) { // interpolate
+            const __m256 posCoef1 = _mm256_loadu_ps(coefsP1);
+            const __m256 negCoef1 = _mm256_loadu_ps(coefsN1);
+            coefsP1 += 8;
+            coefsN1 += 8;
+
+            // posCoef = interp * (posCoef1 - posCoef) + posCoef
+            // negCoef = interp * (negCoef - negCoef1) + negCoef1
+            posCoef = _mm256_fmadd_ps(_mm256_sub_ps(posCoef1, posCoef), interp, posCoef);
+            negCoef = _mm256_fmadd_ps(_mm256_sub_ps(negCoef, negCoef1), interp, negCoef1);
+        }
+
+        __m256 posSampL, posSampR, negSampL, negSampR;
+        loadSamplesAvx2<CHANNELS, true>(sP, posSampL, posSampR);
+        loadSamplesAvx2<CHANNELS, false>(sN, negSampL, negSampR);
+        sP -= CHANNELS*8;
+        sN += CHANNELS*8;
+
+        accL = _mm256_fmadd_ps(posSampL, posCoef, accL);
+        accL = _mm256_fmadd_ps(negSampL, negCoef, accL);
+        if (CHANNELS == 2) {
+            accR = _mm256_fmadd_ps(posSampR, posCoef, accR);
+            accR = _mm256_fmadd_ps(negSampR, negCoef, accR);
+        }
+    } while (count -= 8);
+
+    accumulateAvx2<CHANNELS>(out, hsumAvx2(accL), hsumAvx2(accR), volumeLR);
+}
+
+template <int CHANNELS, int STRIDE, bool FIXED>
+AVX2_TARGET
+static inline void ProcessAVX2Intrinsic(int32_t* out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* volumeLR,
+        uint32_t lerpP,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    __m256i interp;
+    if (!FIXED) {
+        interp = _mm256_set1_epi16(static_cast<int16_t>(lerpP));
+    }
+    __m256i accL = _mm256_setzero_si256();
+    __m256i accR = _mm256_setzero_si256();
+
+    do {
+        // positive half coefficients in the low half, negative in the high half,
+        // so that each madd covers both halves of the filter.
+        __m256i coef;
+        if (FIXED) {
+            coef = combineAvx2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsP)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsN)));
+        } else { // interpolate
+            // coef_0 + (lerp * (coef_1 - coef_0) >> 15), see interpolate()
+            const __m256i coef0 = combineAvx2(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsP)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsN1)));
+            const __m256i coef1 = combineAvx2(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsP1)),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(coefsN)));
+            coef = _mm256_add_epi16(coef0,
+                    mulShift15Avx2(interp, _mm256_sub_epi16(coef1, coef0)));
+            coefsP1 += 8;
+            coefsN1 += 8;
+        }
+        coefsP += 8;
+        coefsN += 8;
+
+        const __m256i posSamp = loadSamplesAvx2<CHANNELS, true>(sP);
+        const __m256i negSamp = loadSamplesAvx2<CHANNELS, false>(sN);
+        sP -= CHANNELS*8;
+        sN += CHANNELS*8;
+
+        if (CHANNELS == 1) {
+            accL = _mm256_add_epi32(accL, _mm256_madd_epi16(
+                    _mm256_permute2x128_si256(posSamp, negSamp, 0x20), coef));
+        } else {
+            accL = _mm256_add_epi32(accL, _mm256_madd_epi16(
+                    _mm256_permute2x128_si256(posSamp, negSamp, 0x20), coef));
+            accR = _mm256_add_epi32(accR, _mm256_madd_epi16(
+                    _mm256_permute2x128_si256(posSamp, negSamp, 0x31), coef));
+        }
+    } while (count -= 8);
+
+    accumulateAvx2<CHANNELS>(out, hsumAvx2(accL), hsumAvx2(accR), volumeLR);
+}
+
+template <int CHANNELS, int STRIDE, bool FIXED>
+AVX2_TARGET
+static inline void ProcessAVX2Intrinsic(int32_t* out,
+        int count,
+        const int32_t* coefsP,
+        const int32_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* volumeLR,
+        uint32_t lerpP,
+        const int32_t* coefsP1,
+        const int32_t* coefsN1)
+{
+    ALOG_ASSERT(count > 0 && (count & 7) == 0); // multiple of 8
+    static_assert(CHANNELS == 1 || CHANNELS == 2, "CHANNELS must be 1 or 2");
+
+    sP -= CHANNELS*(8-1);   // adjust sP for a loop iteration of eight
+
+    __m256i interp;
+    if (!FIXED) {
+        interp = _mm256_set1_epi32(lerpP);
+    }
+    __m256i accL = _mm256_setzero_si256();
+    __m256i accR = _mm256_setzero_si256();
+
+    do {
+        __m256i posCoef = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coefsP));
+        __m256i negCoef = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coefsN));
+        coefsP += 8;
+        coefsN += 8;
+
+        if (!FIXED) { // interpolate
+            // coef_0 + (lerp * (coef_1 - coef_0) >> 31), see interpolate()
+            const __m256i posCoef1 =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coefsP1));
+            const __m256i negCoef1 =
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(coefsN1));
+            coefsP1 += 8;
+            coefsN1 += 8;
+
+            posCoef = _mm256_add_epi32(posCoef,
+                    mulShiftAvx2<31>(interp, _mm256_sub_epi32(posCoef1, posCoef)));
+            negCoef = _mm256_add_epi32(negCoef1,
+                    mulShiftAvx2<31>(interp, _mm256_sub_epi32(negCoef, negCoef1)));
+        }
+
+        const __m256i posSamp = loadSamplesAvx2<CHANNELS, true>(sP);
+        const __m256i negSamp = loadSamplesAvx2<CHANNELS, false>(sN);
+        sP -= CHANNELS*8;
+        sN += CHANNELS*8;
+
+        // (coef * sample) >> 16 for each tap, see mulAddRL()
+        accL = _mm256_add_epi32(accL, mulShiftAvx2<16>(posCoef,
+                _mm256_cvtepi16_epi32(_mm256_castsi256_si128(posSamp))));
+        accL = _mm256_add_epi32(accL, mulShiftAvx2<16>(negCoef,
+                _mm256_cvtepi16_epi32(_mm256_castsi256_si128(negSamp))));
+        if (CHANNELS == 2) {
+            accR = _mm256_add_epi32(accR, mulShiftAvx2<16>(posCoef,
+                    _mm256_cvtepi16_epi32(_mm256_extracti128_si256(posSamp, 1))));
+            accR = _mm256_add_epi32(accR, mulShiftAvx2<16>(negCoef,
+                    _mm256_cvtepi16_epi32(_mm256_extracti128_si256(negSamp, 1))));
+        }
+    } while (count -= 8);
+
+    accumulateAvx2<CHANNELS>(out, hsumAvx2(accL), hsumAvx2(accR), volumeLR);
+}
+
+template<>
+inline void ProcessL<1, 32>(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* const volumeLR)
+{
+    ProcessAVX2Intrinsic<1, 32, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+}
+
+template<>
+inline void ProcessL<2, 32>(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* sP,
+        const float* sN,
+        const float* const volumeLR)
+{
+    ProcessAVX2Intrinsic<2, 32, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+}
+
+template<>
+inline void Process<1, 32>(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* coefsP1,
+        const float* coefsN1,
+        const float* sP,
+        const float* sN,
+        float lerpP,
+        const float* const volumeLR)
+{
+    ProcessAVX2Intrinsic<1, 32, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            lerpP, coefsP1, coefsN1);
+}
+
+template<>
+inline void Process<2, 32>(float* const out,
+        int count,
+        const float* coefsP,
+        const float* coefsN,
+        const float* coefsP1,
+        const float* coefsN1,
+        const float* sP,
+        const float* sN,
+        float lerpP,
+        const float* const volumeLR)
+{
+    ProcessAVX2Intrinsic<2, 32, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            lerpP, coefsP1, coefsN1);
+}
+
+template<>
+inline void ProcessL<1, 32>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<1, 32, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+}
+
+template<>
+inline void ProcessL<2, 32>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<2, 32, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+}
+
+template<>
+inline void Process<1, 32>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<1, 32, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            lerpP, coefsP1, coefsN1);
+}
+
+template<>
+inline void Process<2, 32>(int32_t* const out,
+        int count,
+        const int16_t* coefsP,
+        const int16_t* coefsN,
+        const int16_t* coefsP1,
+        const int16_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<2, 32, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            lerpP, coefsP1, coefsN1);
+}
+
+template<>
+inline void ProcessL<1, 32>(int32_t* const out,
+        int count,
+        const int32_t* coefsP,
+        const int32_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<1, 32, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+}
+
+template<>
+inline void ProcessL<2, 32>(int32_t* const out,
+        int count,
+        const int32_t* coefsP,
+        const int32_t* coefsN,
+        const int16_t* sP,
+        const int16_t* sN,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<2, 32, true>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            0 /*lerpP*/, NULL /*coefsP1*/, NULL /*coefsN1*/);
+}
+
+template<>
+inline void Process<1, 32>(int32_t* const out,
+        int count,
+        const int32_t* coefsP,
+        const int32_t* coefsN,
+        const int32_t* coefsP1,
+        const int32_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<1, 32, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            lerpP, coefsP1, coefsN1);
+}
+
+template<>
+inline void Process<2, 32>(int32_t* const out,
+        int count,
+        const int32_t* coefsP,
+        const int32_t* coefsN,
+        const int32_t* coefsP1,
+        const int32_t* coefsN1,
+        const int16_t* sP,
+        const int16_t* sN,
+        uint32_t lerpP,
+        const int32_t* const volumeLR)
+{
+    ProcessAVX2Intrinsic<2, 32, false>(out, count, coefsP, coefsN, sP, sN, volumeLR,
+            lerpP, coefsP1, coefsN1);
+}
+
+#undef AVX2_TARGET
+
+#endif //USE_AVX2_DISPATCH
+
+} // namespace android
+
+#endif /*ANDROID_AUDIO_RESAMPLER_FIR_PROCESS_AVX2_H*/
@@ -36,6 +36,8 @@
 
 namespace android {
 
+class AudioMixerWorkers;
+
 // ----------------------------------------------------------------------------
 
 // AudioMixerBase is functional on its own if only mixing and resampling
@@ -87,12 +89,8 @@ public:
         AUXLEVEL        = 0x4210,
     };
 
-    AudioMixerBase(size_t frameCount, uint32_t sampleRate)
-        : mSampleRate(sampleRate)
-        , mFrameCount(frameCount) {
-    }
-
-    virtual ~AudioMixerBase() {}
+    AudioMixerBase(size_t frameCount, uint32_t sampleRate);
+    virtual ~AudioMixerBase();
 
     virtual bool isValidFormat(audio_format_t format) const;
     virtual bool isValidChannelMask(audio_channel_mask_t channelMask) const;
@@ -133,6 +131,26 @@ public:
 
     size_t      getUnreleasedFrames(int name) const;
 
+    // Mix the tracks of each main buffer on up to |workerCount| threads, the
+    // calling thread included, once at least kMinParallelTracks tracks are
+    // enabled. Each thread mixes its share of the tracks into its own buffer
+    // and the buffers are summed before conversion to the mixer format, so
+    // the integer mix is bit exact and the float mix only differs from the
+    // serial one by the order of the additions.
+    //
+    // The buffer providers of different tracks are then called concurrently.
+    // Tracks with an aux buffer are always mixed on the calling thread, as
+    // their aux buffers may be shared.
+    //
+    // A |workerCount| of 0 or 1 restores serial mixing. The worker threads
+    // inherit the scheduling policy of the caller, so this should be called
+    // from the mixer thread.
+    void        setParallelism(size_t workerCount);
+    size_t      getParallelism() const;
+
+    static constexpr size_t kMaxParallelism = 8;
+    static constexpr size_t kMinParallelTracks = 4;
+
     std::string trackNames() const;
 
   protected:
@@ -234,6 +252,12 @@ public:
 
         void track__nop(int32_t* out, size_t numFrames, int32_t* temp, int32_t* aux);
 
+        // Mix |outFrameCount| frames of the track into |out| the way
+        // process__genericResampling and process__genericNoResampling do,
+        // |out| covering the whole cycle.
+        void mixResampling(int32_t* out, size_t outFrameCount, int32_t* temp);
+        void mixNoResampling(int32_t* out, size_t outFrameCount, int32_t* temp);
+
         template <int MIXTYPE, bool USEFLOATVOL, bool ADJUSTVOL,
             typename TO, typename TI, typename TA>
         void volumeMix(TO *out, size_t outFrames, const TI *in, TA *aux, bool ramp);
@@ -332,6 +356,7 @@ public:
     void process__genericNoResampling();
     void process__genericResampling();
     void process__oneTrack16BitsStereoNoResampling();
+    void process__parallel();
 
     template <int MIXTYPE, typename TO, typename TI, typename TA>
     void process__noResampleOneTrack();
@@ -363,6 +388,19 @@ public:
 
     // track smart pointers, by name, in increasing order of name.
     std::map<int /* name */, std::shared_ptr<TrackBase>> mTracks;
+
+    // the tracks of a main buffer, split between the workers for process__parallel.
+    struct ParallelGroup {
+        void *mainBuffer;
+        std::vector<std::vector<TrackBase *>> workerTracks; // indexed by worker
+    };
+
+    // parallel mixing state, see setParallelism().
+    std::unique_ptr<AudioMixerWorkers> mWorkers;
+    std::vector<std::unique_ptr<int32_t[]>> mWorkerOutputTemp;   // one per worker
+    std::vector<std::unique_ptr<int32_t[]>> mWorkerResampleTemp; // one per worker
+    std::vector<ParallelGroup> mParallelGroups;
+    bool mParallelResampling = false;
 };
 
 }  // namespace android
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <string>
+
 #include <cutils/compiler.h>
 #include <utils/Compat.h>
 
@@ -56,6 +58,10 @@ public:
 
     virtual ~AudioResampler();
 
+    // Returns the use of the filter coefficient cache shared by the dynamic
+    // (DYN_*_QUALITY) resamplers of the process, for dumpsys.
+    static std::string dumpFilterCache();
+
     virtual void init() = 0;
     virtual void setSampleRate(int32_t inSampleRate);
     virtual void setVolume(float left, float right);
@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# This script uses test-mixer to time the AudioMixer as the number
+# of tracks grows, mixing serially and on several threads
+# (see AudioMixer::setParallelism()).
+#
+# Every input is mixed as -n copies, so the track count is
+# 2 x copies. The first input resamples, the second does not.
+
+if [ -z "$ANDROID_BUILD_TOP" ]; then
+    echo "Android build environment not set"
+    exit -1
+fi
+
+# ensure we have mm
+. $ANDROID_BUILD_TOP/build/envsetup.sh
+
+pushd $ANDROID_BUILD_TOP/frameworks/av/media/libaudioprocessing
+
+# build
+pwd
+mm
+
+# send to device
+echo "waiting for device"
+adb root && adb wait-for-device remount
+adb push $OUT/system/lib/libaudioprocessing.so /system/lib
+adb push $OUT/system/lib64/libaudioprocessing.so /system/lib64
+adb push $OUT/system/bin/test-mixer /system/bin
+
+# $1 = flags
+function scaletracks() {
+    for copies in 1 2 4 8 16 32; do
+        for workers in 1 2 4; do
+            adb shell test-mixer $1 -s 48000 -n $copies -p $workers \
+                sine:2,1000,44100 chirp:2,48000 | grep "^mixed"
+        done
+    done
+}
+
+scaletracks ""
+scaletracks "-f -m"
+
+popd
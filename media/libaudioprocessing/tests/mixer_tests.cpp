@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixer_tests"
+#include <log/log.h>
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/AudioMixerBase.h>
+#include "test_utils.h"
+
+using namespace android;
+
+namespace {
+
+// Mixes each track in its own format, so that int16_t tracks take the
+// integer (Q4.27) path of the mixer and float tracks the float one.
+class TestMixer : public AudioMixerBase {
+public:
+    using AudioMixerBase::AudioMixerBase;
+
+    void setBufferProvider(int name, AudioBufferProvider *provider) {
+        mTracks[name]->bufferProvider = provider;
+    }
+
+protected:
+    status_t postCreateTrack(TrackBase *track) override {
+        track->mMixerInFormat = track->mFormat;
+        return OK;
+    }
+};
+
+constexpr size_t kFrameCount = 250;     // not a multiple of the mixer block size
+constexpr uint32_t kSampleRate = 48000;
+constexpr size_t kTracks = 13;
+constexpr size_t kCycles = 20;
+constexpr size_t kChannels = 2;
+
+// One mixer with its tracks, output and aux buffers.
+struct MixerSetup {
+    MixerSetup(audio_format_t format, bool resample, size_t workers)
+        : mixer(kFrameCount, kSampleRate)
+        , providers(kTracks)
+        , output(kFrameCount * kChannels * audio_bytes_per_sample(format))
+        , aux(kFrameCount) {
+        const bool isFloat = format == AUDIO_FORMAT_PCM_FLOAT;
+        const std::vector<int> incr = {97, 33, 250};  // uneven buffers from the providers
+        float volume = 1.f / kTracks;
+        float zero = 0.f;
+
+        mixer.setParallelism(workers);
+        for (size_t i = 0; i < kTracks; ++i) {
+            const int name = i;
+            const size_t channels = i % 2 + 1;
+            const uint32_t sampleRate = resample && i % 2 == 0 ? 44100 : kSampleRate;
+            const double freq = 100. * (i + 1);
+            if (isFloat) {
+                providers[i].setSine<float>(channels, freq, sampleRate, 1 /* seconds */);
+            } else {
+                providers[i].setSine<int16_t>(channels, freq, sampleRate, 1 /* seconds */);
+            }
+            providers[i].setIncr(incr);
+
+            const audio_channel_mask_t channelMask = audio_channel_out_mask_from_count(channels);
+            EXPECT_EQ(OK, mixer.create(name, channelMask, format, AUDIO_SESSION_OUTPUT_MIX));
+            mixer.setBufferProvider(name, &providers[i]);
+            mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::MAIN_BUFFER,
+                    output.data());
+            mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::MIXER_FORMAT,
+                    (void *)(uintptr_t)format);
+            mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::MIXER_CHANNEL_MASK,
+                    (void *)(uintptr_t)AUDIO_CHANNEL_OUT_STEREO);
+            mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::CHANNEL_MASK,
+                    (void *)(uintptr_t)channelMask);
+            mixer.setParameter(name, AudioMixerBase::RESAMPLE, AudioMixerBase::SAMPLE_RATE,
+                    (void *)(uintptr_t)sampleRate);
+            mixer.setParameter(name, AudioMixerBase::VOLUME, AudioMixerBase::VOLUME0, &zero);
+            mixer.setParameter(name, AudioMixerBase::VOLUME, AudioMixerBase::VOLUME1, &zero);
+            mixer.setParameter(name, AudioMixerBase::RAMP_VOLUME, AudioMixerBase::VOLUME0,
+                    &volume);
+            mixer.setParameter(name, AudioMixerBase::RAMP_VOLUME, AudioMixerBase::VOLUME1,
+                    &volume);
+            if (i % 3 == 0) {  // several tracks share the aux buffer
+                mixer.setParameter(name, AudioMixerBase::TRACK, AudioMixerBase::AUX_BUFFER,
+                        aux.data());
+                mixer.setParameter(name, AudioMixerBase::VOLUME, AudioMixerBase::AUXLEVEL,
+                        &zero);
+                mixer.setParameter(name, AudioMixerBase::RAMP_VOLUME, AudioMixerBase::AUXLEVEL,
+                        &volume);
+            }
+            mixer.enable(name);
+        }
+    }
+
+    void process() {
+        memset(aux.data(), 0, aux.size() * sizeof(aux[0]));
+        mixer.process();
+    }
+
+    TestMixer mixer;
+    std::vector<SignalProvider> providers;
+    std::vector<uint8_t> output;
+    std::vector<int32_t> aux;
+};
+
+using ParallelMixerParams = std::tuple<audio_format_t, bool /* resample */, size_t /* workers */>;
+
+class ParallelMixerTest : public ::testing::TestWithParam<ParallelMixerParams> {};
+
+// The parallel mix must match the serial one exactly on the integer path, and
+// up to the rounding of a differently ordered sum of the tracks on the float path.
+TEST_P(ParallelMixerTest, matches_serial) {
+    const auto [format, resample, workers] = GetParam();
+    MixerSetup serial(format, resample, 1);
+    MixerSetup parallel(format, resample, workers);
+    ASSERT_EQ(1u, serial.mixer.getParallelism());
+    ASSERT_EQ(workers, parallel.mixer.getParallelism());
+
+    for (size_t cycle = 0; cycle < kCycles; ++cycle) {
+        serial.process();
+        parallel.process();
+
+        if (format == AUDIO_FORMAT_PCM_FLOAT) {
+            const float *expected = reinterpret_cast<const float *>(serial.output.data());
+            const float *actual = reinterpret_cast<const float *>(parallel.output.data());
+            for (size_t i = 0; i < kFrameCount * kChannels; ++i) {
+                ASSERT_NEAR(expected[i], actual[i], kTracks * FLT_EPSILON)
+                        << "cycle " << cycle << " sample " << i;
+            }
+        } else {
+            ASSERT_EQ(serial.output, parallel.output) << "cycle " << cycle;
+        }
+        // aux tracks are mixed in order on the calling thread.
+        ASSERT_EQ(serial.aux, parallel.aux) << "cycle " << cycle;
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        mixer, ParallelMixerTest,
+        ::testing::Combine(
+                ::testing::Values(AUDIO_FORMAT_PCM_16_BIT, AUDIO_FORMAT_PCM_FLOAT),
+                ::testing::Bool(),
+                ::testing::Values(2, 3, AudioMixerBase::kMaxParallelism)));
+
+TEST(mixer, parallelism_is_bounded) {
+    TestMixer mixer(kFrameCount, kSampleRate);
+    EXPECT_EQ(1u, mixer.getParallelism());
+    mixer.setParallelism(AudioMixerBase::kMaxParallelism + 1);
+    EXPECT_EQ(AudioMixerBase::kMaxParallelism, mixer.getParallelism());
+    mixer.setParallelism(0);
+    EXPECT_EQ(1u, mixer.getParallelism());
+}
+
+} // namespace
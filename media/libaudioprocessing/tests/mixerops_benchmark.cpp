@@ -23,82 +23,110 @@
 
 using namespace android;
 
-template <int MIXTYPE, int NCHAN>
+// Volume types as used by AudioMixer: float for float input, U4.12 (U4.28 when
+// ramping) for int16_t input.
+template <typename TI>
+using VolumeType = std::conditional_t<std::is_same_v<TI, float>, float, int16_t>;
+template <typename TI>
+using RampVolumeType = std::conditional_t<std::is_same_v<TI, float>, float, int32_t>;
+
+template <typename TV>
+static TV volumeIncrement() {
+    if constexpr (std::is_floating_point_v<TV>) {
+        return 0.01f;
+    } else {
+        return 1 << 12;
+    }
+}
+
+template <int MIXTYPE, int NCHAN, typename TI>
 static void BM_VolumeRampMulti(benchmark::State& state) {
+    using TV = RampVolumeType<TI>;
     constexpr size_t FRAME_COUNT = 1000;
     constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
 
     // data inialized to 0.
     float out[SAMPLE_COUNT]{};
-    float in[SAMPLE_COUNT]{};
+    TI in[SAMPLE_COUNT]{};
     float aux[FRAME_COUNT]{};
 
     // volume initialized to 0
     float vola = 0.f;
-    float vol[2] = {0.f, 0.f};
+    TV vol[2] = {0, 0};
 
     // some volume increment
     float volainc = 0.01f;
-    float volinc[2] = {0.01f, 0.01f};
+    TV volinc[2] = {volumeIncrement<TV>(), volumeIncrement<TV>()};
 
+    float *auxp = state.range(0) ? aux : nullptr;
     while (state.KeepRunning()) {
         benchmark::DoNotOptimize(out);
         benchmark::DoNotOptimize(in);
-        volumeRampMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, aux, vol, volinc, &vola, volainc);
+        volumeRampMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, auxp, vol, volinc, &vola, volainc);
         benchmark::ClobberMemory();
     }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
 }
 
-template <int MIXTYPE, int NCHAN>
+template <int MIXTYPE, int NCHAN, typename TI>
 static void BM_VolumeMulti(benchmark::State& state) {
+    using TV = VolumeType<TI>;
     constexpr size_t FRAME_COUNT = 1000;
     constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
 
     // data inialized to 0.
     float out[SAMPLE_COUNT]{};
-    float in[SAMPLE_COUNT]{};
+    TI in[SAMPLE_COUNT]{};
     float aux[FRAME_COUNT]{};
 
     // volume initialized to 0
     float vola = 0.f;
-    float vol[2] = {0.f, 0.f};
-
+    TV vol[2] = {0, 0};
 
+    float *auxp = state.range(0) ? aux : nullptr;
     while (state.KeepRunning()) {
         benchmark::DoNotOptimize(out);
         benchmark::DoNotOptimize(in);
-        volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, aux, vol, vola);
+        volumeMulti<MIXTYPE, NCHAN>(out, FRAME_COUNT, in, auxp, vol, vola);
         benchmark::ClobberMemory();
     }
+    state.SetItemsProcessed(state.iterations() * FRAME_COUNT);
 }
 
 // MULTI mode and MULTI_SAVEONLY mode are not used by AudioMixer for channels > 2,
 // which is ensured by a static_assert (won't compile for those configurations).
-// So we benchmark MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL compared
-// with MIXTYPE_MULTI_STEREOVOL and MIXTYPE_MULTI_SAVEONLY_STEREOVOL.
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_MONOVOL, 2);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 2);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_STEREOVOL, 2);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 2);
-
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_MONOVOL, 4);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 4);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_STEREOVOL, 4);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 4);
-
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_MONOVOL, 5);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 5);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_STEREOVOL, 5);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 5);
-
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_MONOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_STEREOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeRampMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
-
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_MONOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_MONOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_STEREOVOL, 8);
-BENCHMARK_TEMPLATE(BM_VolumeMulti, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, 8);
+// For those, AudioMixer uses MIXTYPE_MULTI_MONOVOL and MIXTYPE_MULTI_SAVEONLY_MONOVOL.
+// Every configuration runs without (Arg 0) and with (Arg 1) an aux buffer.
+#define BENCHMARK_MIXTYPE(BM, MIXTYPE, NCHAN, TI) \
+    BENCHMARK_TEMPLATE(BM, MIXTYPE, NCHAN, TI)->Arg(0)->Arg(1)
+
+#define BENCHMARK_ALL_MIXTYPES(BM, NCHAN, TI) \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MONOEXPAND, NCHAN, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_STEREOEXPAND, NCHAN, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI_MONOVOL, NCHAN, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI_SAVEONLY_MONOVOL, NCHAN, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI_STEREOVOL, NCHAN, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI_SAVEONLY_STEREOVOL, NCHAN, TI)
+
+#define BENCHMARK_ALL_CHANNELS(BM, TI) \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI, 1, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI_SAVEONLY, 1, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI, 2, TI); \
+    BENCHMARK_MIXTYPE(BM, MIXTYPE_MULTI_SAVEONLY, 2, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 1, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 2, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 3, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 4, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 5, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 6, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 7, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 8, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 12, TI); \
+    BENCHMARK_ALL_MIXTYPES(BM, 24, TI)
+
+BENCHMARK_ALL_CHANNELS(BM_VolumeRampMulti, float);
+BENCHMARK_ALL_CHANNELS(BM_VolumeRampMulti, int16_t);
+BENCHMARK_ALL_CHANNELS(BM_VolumeMulti, float);
+BENCHMARK_ALL_CHANNELS(BM_VolumeMulti, int16_t);
 
 BENCHMARK_MAIN();
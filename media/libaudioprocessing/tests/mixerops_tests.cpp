@@ -19,7 +19,9 @@
 #include <log/log.h>
 
 #include <inttypes.h>
+#include <random>
 #include <type_traits>
+#include <vector>
 
 #include <../AudioMixerOps.h>
 #include <gtest/gtest.h>
@@ -164,6 +166,94 @@ TEST(mixerops, stereovolume_24) {
         MixerOpsBasicTest<MIXTYPE_MULTI_STEREOVOL, 24>::testStereoVolume();
     }
 }
+
+// Without aux, the volume functions take the vector path where available. The aux
+// path is scalar, and must give the same output.
+template <int MIXTYPE, int NCHAN, typename TO, typename TI, typename TV, typename TA>
+static void testVectorMatchesScalar() {
+    constexpr size_t FRAME_COUNT = 1001; // not a multiple of the vector length
+    constexpr size_t SAMPLE_COUNT = FRAME_COUNT * NCHAN;
+
+    std::minstd_rand rng(42);
+    std::vector<TI> in(SAMPLE_COUNT);
+    for (auto &x : in) {
+        if constexpr (std::is_floating_point_v<TI>) {
+            x = std::uniform_real_distribution<TI>(-1.f, 1.f)(rng);
+        } else {
+            x = std::uniform_int_distribution<TI>()(rng);
+        }
+    }
+    TV volume[2];
+    TV volumeInc[2];
+    if constexpr (std::is_floating_point_v<TV>) {
+        volume[0] = 0.25f, volume[1] = 0.75f;
+        volumeInc[0] = 1e-4f, volumeInc[1] = -1e-4f;
+    } else {
+        volume[0] = 1 << 10, volume[1] = 3 << 10;
+        volumeInc[0] = 1, volumeInc[1] = -1;
+    }
+
+    std::vector<TO> scalarOut(SAMPLE_COUNT);
+    std::vector<TO> vectorOut(SAMPLE_COUNT);
+    std::vector<TA> aux(FRAME_COUNT);
+    TA auxLevel{};
+    volumeMulti<MIXTYPE, NCHAN>(
+            scalarOut.data(), FRAME_COUNT, in.data(), aux.data(), volume, auxLevel);
+    volumeMulti<MIXTYPE, NCHAN>(
+            vectorOut.data(), FRAME_COUNT, in.data(), (TA *)nullptr, volume, auxLevel);
+    EXPECT_EQ(scalarOut, vectorOut);
+
+    TV scalarVolume[2] = {volume[0], volume[1]};
+    TV vectorVolume[2] = {volume[0], volume[1]};
+    volumeRampMulti<MIXTYPE, NCHAN>(scalarOut.data(), FRAME_COUNT, in.data(), aux.data(),
+            scalarVolume, volumeInc, &auxLevel, auxLevel);
+    volumeRampMulti<MIXTYPE, NCHAN>(vectorOut.data(), FRAME_COUNT, in.data(), (TA *)nullptr,
+            vectorVolume, volumeInc, &auxLevel, auxLevel);
+    EXPECT_EQ(scalarOut, vectorOut);
+    EXPECT_EQ(scalarVolume[0], vectorVolume[0]);
+    EXPECT_EQ(scalarVolume[1], vectorVolume[1]);
+}
+
+template <int MIXTYPE, int NCHAN>
+static void testVectorMatchesScalarAllTypes() {
+    testVectorMatchesScalar<MIXTYPE, NCHAN, float, float, float, float>();
+    testVectorMatchesScalar<MIXTYPE, NCHAN, float, int16_t, int16_t, float>();
+    testVectorMatchesScalar<MIXTYPE, NCHAN, float, int16_t, int32_t, float>();
+    testVectorMatchesScalar<MIXTYPE, NCHAN, int32_t, int16_t, int16_t, int32_t>();
+    testVectorMatchesScalar<MIXTYPE, NCHAN, int32_t, int16_t, int32_t, int32_t>();
+}
+
+template <int MIXTYPE>
+static void testVectorMatchesScalarAllChannels() {
+    testVectorMatchesScalarAllTypes<MIXTYPE, 1>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 2>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 3>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 4>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 5>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 6>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 7>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 8>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 12>();
+    testVectorMatchesScalarAllTypes<MIXTYPE, 24>();
+}
+
+TEST(mixerops, vector_matches_scalar_multi) {
+    testVectorMatchesScalarAllTypes<MIXTYPE_MULTI, 1>();
+    testVectorMatchesScalarAllTypes<MIXTYPE_MULTI, 2>();
+    testVectorMatchesScalarAllTypes<MIXTYPE_MULTI_SAVEONLY, 1>();
+    testVectorMatchesScalarAllTypes<MIXTYPE_MULTI_SAVEONLY, 2>();
+}
+
+TEST(mixerops, vector_matches_scalar_monovol) {
+    testVectorMatchesScalarAllChannels<MIXTYPE_MULTI_MONOVOL>();
+    testVectorMatchesScalarAllChannels<MIXTYPE_MULTI_SAVEONLY_MONOVOL>();
+}
+
+TEST(mixerops, vector_matches_scalar_stereovol) {
+    testVectorMatchesScalarAllChannels<MIXTYPE_MULTI_STEREOVOL>();
+    testVectorMatchesScalarAllChannels<MIXTYPE_MULTI_SAVEONLY_STEREOVOL>();
+}
+
 TEST(mixerops, channel_equivalence) {
     // we must match the constexpr function with the system determined channel mask from count.
     for (size_t i = 0; i < FCC_LIMIT; ++i) {
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+
+#include <benchmark/benchmark.h>
+#include <media/AudioResampler.h>
+
+#include "../AudioResamplerFilterCache.h"
+
+using namespace android;
+
+static std::unique_ptr<AudioResampler> createResampler(
+        audio_format_t format, AudioResampler::src_quality quality) {
+    std::unique_ptr<AudioResampler> resampler(
+            AudioResampler::create(format, 2 /* channels */, 48000, quality));
+    resampler->setSampleRate(44100);
+    return resampler;
+}
+
+// Time to create a 44.1 to 48 kHz resampler of quality state.range(0), with
+// another resampler doing the same conversion if state.range(1) is set.
+// Without one the filter is designed, as it was for every resampler before
+// the filter cache; with one it is shared.
+template <audio_format_t FORMAT>
+static void BM_ResamplerSetup(benchmark::State& state) {
+    const auto quality = static_cast<AudioResampler::src_quality>(state.range(0));
+    std::unique_ptr<AudioResampler> other;
+    if (state.range(1)) {
+        other = createResampler(FORMAT, quality);
+    }
+
+    for (auto _ : state) {
+        std::unique_ptr<AudioResampler> resampler = createResampler(FORMAT, quality);
+        benchmark::DoNotOptimize(resampler.get());
+    }
+
+    const AudioResamplerFilterCache::Statistics stats =
+            AudioResamplerFilterCache::getInstance().getStatistics();
+    state.counters["filter_bytes"] = other != nullptr ? stats.bytes : 0;
+}
+
+static void ResamplerSetupArgs(benchmark::internal::Benchmark* b) {
+    for (int quality : {AudioResampler::DYN_LOW_QUALITY,
+                        AudioResampler::DYN_MED_QUALITY,
+                        AudioResampler::DYN_HIGH_QUALITY}) {
+        for (int shared : {0, 1}) {
+            b->Args({quality, shared});
+        }
+    }
+    b->ArgNames({"quality", "shared"});
+}
+
+BENCHMARK_TEMPLATE(BM_ResamplerSetup, AUDIO_FORMAT_PCM_16_BIT)->Apply(ResamplerSetupArgs)
+        ->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_ResamplerSetup, AUDIO_FORMAT_PCM_FLOAT)->Apply(ResamplerSetupArgs)
+        ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
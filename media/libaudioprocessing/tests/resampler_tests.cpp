@@ -30,6 +30,7 @@
 
 #include <iostream>
 #include <memory>
+#include <random>
 #include <utility>
 #include <vector>
 
@@ -39,7 +40,11 @@
 
 #include <media/AudioResampler.h>
 #include "../AudioResamplerDyn.h"
+#include "../AudioResamplerFilterCache.h"
 #include "../AudioResamplerFirGen.h"
+#include "../AudioResamplerFirOps.h"
+#include "../AudioResamplerFirProcess.h"
+#include "../AudioResamplerFirProcessAVX2.h"
 #include "test_utils.h"
 
 template <typename T>
@@ -601,3 +606,140 @@ TEST(audioflinger_resampler, generalresponse) {
         }
     }
 }
+
+// Resamplers doing the same conversion share one filter, which lives as long
+// as any of them uses it.
+TEST(audioflinger_resampler, filtercache) {
+    using ResamplerType = android::AudioResamplerDyn<float, float, float>;
+    auto create = [](int inSampleRate, int outSampleRate) {
+        std::unique_ptr<ResamplerType> rdyn(
+                static_cast<ResamplerType *>(
+                        android::AudioResampler::create(
+                                AUDIO_FORMAT_PCM_FLOAT,
+                                2 /* channels */,
+                                outSampleRate,
+                                android::AudioResampler::DYN_HIGH_QUALITY)));
+        rdyn->setSampleRate(inSampleRate);
+        return rdyn;
+    };
+    android::AudioResamplerFilterCache &cache = android::AudioResamplerFilterCache::getInstance();
+    const android::AudioResamplerFilterCache::Statistics before = cache.getStatistics();
+
+    auto first = create(44100, 48000);
+    auto second = create(44100, 48000);
+    auto other = create(32000, 48000);
+    const float *coefs = first->getFilterCoefs();
+    EXPECT_EQ(coefs, second->getFilterCoefs());
+    EXPECT_NE(coefs, other->getFilterCoefs());
+
+    android::AudioResamplerFilterCache::Statistics stats = cache.getStatistics();
+    EXPECT_EQ(before.hits + 1, stats.hits);
+    EXPECT_EQ(before.misses + 2, stats.misses);
+    EXPECT_EQ(before.filters + 2, stats.filters);
+
+    // The filter is freed with the last resampler using it.
+    first.reset();
+    EXPECT_EQ(before.filters + 2, cache.getStatistics().filters);
+    second.reset();
+    EXPECT_EQ(before.filters + 1, cache.getStatistics().filters);
+
+    // Filters are designed again once unused.
+    other.reset();
+    EXPECT_EQ(before.filters, cache.getStatistics().filters);
+    EXPECT_EQ(before.bytes, cache.getStatistics().bytes);
+    auto again = create(44100, 48000);
+    stats = cache.getStatistics();
+    EXPECT_EQ(before.misses + 3, stats.misses);
+    EXPECT_EQ(before.filters + 1, stats.filters);
+}
+
+#if USE_AVX2_DISPATCH
+
+template <typename T>
+std::vector<T> randomVector(size_t size, T limit, std::minstd_rand& gen)
+{
+    std::vector<T> v(size);
+    if constexpr (std::is_floating_point_v<T>) {
+        std::uniform_real_distribution<T> dist(-limit, limit);
+        for (T& x : v) x = dist(gen);
+    } else {
+        std::uniform_int_distribution<int64_t> dist(-limit, limit);
+        for (T& x : v) x = dist(gen);
+    }
+    return v;
+}
+
+/* Compares the AVX2 kernels (STRIDE 32) with the portable ProcessBase() for
+ * random coefficients, samples and phases: bit exact for integer types,
+ * within rounding for float.
+ */
+template <int CHANNELS, typename TC, typename TI, typename TO>
+void testAvx2Kernels(TC coefLimit, TI sampleLimit, TO volume)
+{
+    std::minstd_rand gen(42);
+    for (int halfNumCoefs : {8, 24, 32, 64}) {
+        for (int trial = 0; trial < 100; ++trial) {
+            // the next phase of each half directly follows, as in the filter bank.
+            const std::vector<TC> coefsP = randomVector<TC>(2 * halfNumCoefs, coefLimit, gen);
+            const std::vector<TC> coefsN = randomVector<TC>(2 * halfNumCoefs, coefLimit, gen);
+            const std::vector<TI> samples =
+                    randomVector<TI>(2 * halfNumCoefs * CHANNELS, sampleLimit, gen);
+            const TI* sP = samples.data() + (halfNumCoefs - 1) * CHANNELS;
+            const TI* sN = sP + CHANNELS;
+            const TO volumeLR[2] __attribute__((aligned(8))) = {volume, volume / 2};
+
+            TO lerpP;
+            if constexpr (std::is_floating_point_v<TC>) {
+                lerpP = std::uniform_real_distribution<TO>(0., 1.)(gen);
+            } else { // see fir() for the range of the phase fraction
+                lerpP = std::uniform_int_distribution<uint32_t>(
+                        0, (1u << (sizeof(TC) * 8 - 1)) - 1)(gen);
+            }
+
+            TO expected[2] = {1, 2};
+            TO actual[2] = {1, 2};
+            android::ProcessBase<CHANNELS, 16, android::InterpNull>(expected, halfNumCoefs,
+                    coefsP.data(), coefsN.data(), sP, sN, lerpP, volumeLR);
+            android::ProcessL<CHANNELS, 32>(actual, halfNumCoefs,
+                    coefsP.data(), coefsN.data(), sP, sN, volumeLR);
+            if constexpr (std::is_floating_point_v<TO>) {
+                ASSERT_NEAR(expected[0], actual[0], 1e-5);
+                ASSERT_NEAR(expected[1], actual[1], 1e-5);
+            } else {
+                ASSERT_EQ(expected[0], actual[0]);
+                ASSERT_EQ(expected[1], actual[1]);
+            }
+
+            const auto lerpI = static_cast<std::conditional_t<
+                    std::is_floating_point_v<TC>, float, uint32_t>>(lerpP);
+            android::ProcessBase<CHANNELS, 16, android::InterpCompute>(expected, halfNumCoefs,
+                    coefsP.data(), coefsN.data(), sP, sN, lerpI, volumeLR);
+            android::Process<CHANNELS, 32>(actual, halfNumCoefs,
+                    coefsP.data(), coefsN.data(),
+                    coefsP.data() + halfNumCoefs, coefsN.data() + halfNumCoefs,
+                    sP, sN, lerpI, volumeLR);
+            if constexpr (std::is_floating_point_v<TO>) {
+                ASSERT_NEAR(expected[0], actual[0], 1e-5);
+                ASSERT_NEAR(expected[1], actual[1], 1e-5);
+            } else {
+                ASSERT_EQ(expected[0], actual[0]);
+                ASSERT_EQ(expected[1], actual[1]);
+            }
+        }
+    }
+}
+
+TEST(audioflinger_resampler, avx2kernels) {
+    if (!android::cpuHasAvx2Fma()) {
+        GTEST_SKIP() << "CPU without AVX2";
+    }
+    // coefficients limited so that the integer dot products do not overflow.
+    testAvx2Kernels<1, float, float, float>(1.f, 1.f, 0.5f);
+    testAvx2Kernels<2, float, float, float>(1.f, 1.f, 0.5f);
+    testAvx2Kernels<1, int16_t, int16_t, int32_t>(1 << 10, INT16_MAX, 0x7fff0000);
+    testAvx2Kernels<2, int16_t, int16_t, int32_t>(1 << 10, INT16_MAX, 0x7fff0000);
+    testAvx2Kernels<1, int32_t, int16_t, int32_t>(1 << 24, INT16_MAX, 0x7fff0000);
+    testAvx2Kernels<2, int32_t, int16_t, int32_t>(1 << 24, INT16_MAX, 0x7fff0000);
+}
+
+#endif // USE_AVX2_DISPATCH
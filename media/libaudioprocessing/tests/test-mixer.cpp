@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <inttypes.h>
 #include <math.h>
+#include <time.h>
 #include <vector>
 #include <audio_utils/primitives.h>
 #include <audio_utils/sndfile.h>
@@ -38,6 +39,7 @@ using namespace android;
 static void usage(const char* name) {
     fprintf(stderr, "Usage: %s [-f] [-m] [-c channels]"
                     " [-s sample-rate] [-o <output-file>] [-a <aux-buffer-file>] [-P csv]"
+                    " [-n copies] [-p workers]"
                     " (<input-file> | <command>)+\n", name);
     fprintf(stderr, "    -f    enable floating point input track by default\n");
     fprintf(stderr, "    -m    enable floating point mixer output\n");
@@ -46,6 +48,8 @@ static void usage(const char* name) {
     fprintf(stderr, "    -o    <output-file> WAV file, pcm16 (or float if -m specified)\n");
     fprintf(stderr, "    -a    <aux-buffer-file>\n");
     fprintf(stderr, "    -P    # frames provided per call to resample() in CSV format\n");
+    fprintf(stderr, "    -n    mix each input as this many tracks, to time the mixer\n");
+    fprintf(stderr, "    -p    mix on this many threads, see AudioMixer::setParallelism()\n");
     fprintf(stderr, "    <input-file> is a WAV file\n");
     fprintf(stderr, "    <command> can be 'sine:[(i|f),]<channels>,<frequency>,<samplerate>'\n");
     fprintf(stderr, "                     'chirp:[(i|f),]<channels>,<samplerate>'\n");
@@ -98,13 +102,15 @@ int main(int argc, char* argv[]) {
     uint32_t outputSampleRate = 48000;
     uint32_t outputChannels = 2; // stereo for now
     std::vector<int> Pvalues;
+    int copies = 1;
+    int workers = 1;
     const char* outputFilename = NULL;
     const char* auxFilename = NULL;
     std::vector<int32_t> names;
     std::vector<SignalProvider> providers;
     std::vector<audio_format_t> formats;
 
-    for (int ch; (ch = getopt(argc, argv, "fmc:s:o:a:P:")) != -1;) {
+    for (int ch; (ch = getopt(argc, argv, "fmc:s:o:a:P:n:p:")) != -1;) {
         switch (ch) {
         case 'f':
             useInputFloat = true;
@@ -130,6 +136,12 @@ int main(int argc, char* argv[]) {
                 return EXIT_FAILURE;
             }
             break;
+        case 'n':
+            copies = atoi(optarg);
+            break;
+        case 'p':
+            workers = atoi(optarg);
+            break;
         case '?':
         default:
             usage(progname);
@@ -139,10 +151,12 @@ int main(int argc, char* argv[]) {
     argc -= optind;
     argv += optind;
 
-    if (argc == 0) {
+    if (argc == 0 || copies < 1 || workers < 1) {
         usage(progname);
         return EXIT_FAILURE;
     }
+    const int inputs = argc;
+    argc *= copies;
 
     size_t outputFrames = 0;
 
@@ -155,10 +169,11 @@ int main(int argc, char* argv[]) {
         static const char sine[] = "sine:";
         static const double kSeconds = 1;
         bool useFloat = useInputFloat;
+        const char * const arg = argv[i % inputs];
 
-        if (!strncmp(argv[i], chirp, strlen(chirp))) {
+        if (!strncmp(arg, chirp, strlen(chirp))) {
             std::vector<int> v;
-            const char *s = parseFormat(argv[i] + strlen(chirp), &useFloat);
+            const char *s = parseFormat(arg + strlen(chirp), &useFloat);
 
             parseCSV(s, v);
             if (v.size() == 2) {
@@ -172,11 +187,11 @@ int main(int argc, char* argv[]) {
                 }
                 providers[i].setIncr(Pvalues);
             } else {
-                fprintf(stderr, "malformed input '%s'\n", argv[i]);
+                fprintf(stderr, "malformed input '%s'\n", arg);
             }
-        } else if (!strncmp(argv[i], sine, strlen(sine))) {
+        } else if (!strncmp(arg, sine, strlen(sine))) {
             std::vector<int> v;
-            const char *s = parseFormat(argv[i] + strlen(sine), &useFloat);
+            const char *s = parseFormat(arg + strlen(sine), &useFloat);
 
             parseCSV(s, v);
             if (v.size() == 3) {
@@ -190,15 +205,15 @@ int main(int argc, char* argv[]) {
                 }
                 providers[i].setIncr(Pvalues);
             } else {
-                fprintf(stderr, "malformed input '%s'\n", argv[i]);
+                fprintf(stderr, "malformed input '%s'\n", arg);
             }
         } else {
-            printf("creating filename(%s)\n", argv[i]);
+            printf("creating filename(%s)\n", arg);
             if (useInputFloat) {
-                providers[i].setFile<float>(argv[i]);
+                providers[i].setFile<float>(arg);
                 formats[i] = AUDIO_FORMAT_PCM_FLOAT;
             } else {
-                providers[i].setFile<short>(argv[i]);
+                providers[i].setFile<short>(arg);
                 formats[i] = AUDIO_FORMAT_PCM_16_BIT;
             }
             providers[i].setIncr(Pvalues);
@@ -233,6 +248,7 @@ int main(int argc, char* argv[]) {
     // create the mixer.
     const size_t mixerFrameCount = 320; // typical numbers may range from 240 or 960
     AudioMixer *mixer = new AudioMixer(mixerFrameCount, outputSampleRate);
+    mixer->setParallelism(workers);
     audio_format_t mixerFormat = useMixerFloat
             ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
     float f = AudioMixer::UNITY_GAIN_FLOAT / providers.size(); // normalize volume by # tracks
@@ -295,6 +311,8 @@ int main(int argc, char* argv[]) {
     }
 
     // pump the mixer to process data.
+    int64_t mixNs = 0;
+    size_t cycles = 0;
     size_t i;
     for (i = 0; i < outputFrames - mixerFrameCount; i += mixerFrameCount) {
         for (size_t j = 0; j < names.size(); ++j) {
@@ -305,9 +323,19 @@ int main(int argc, char* argv[]) {
                         (char *) auxAddr + i * auxFrameSize);
             }
         }
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
         mixer->process();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        mixNs += (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+        ++cycles;
     }
     outputFrames = i; // reset output frames to the data actually produced.
+    if (cycles > 0) {
+        printf("mixed %zu tracks on %zu threads: %.1f us per %zu frame cycle\n",
+                providers.size(), mixer->getParallelism(),
+                mixNs * 1e-3 / cycles, mixerFrameCount);
+    }
 
     // write to files
     writeFile(outputFilename, outputAddr,
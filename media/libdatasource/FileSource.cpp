@@ -122,13 +122,13 @@ ssize_t FileSource::readAt(off64_t offset, void *data, size_t size) {
 }
 
 ssize_t FileSource::readAt_l(off64_t offset, void *data, size_t size) {
-    off64_t result = lseek64(mFd, offset + mOffset, SEEK_SET);
+    // Read without moving the file offset: the fd may be a dup() sharing its offset
+    // with other sources reading the same file concurrently.
+    ssize_t result = pread64(mFd, data, size, offset + mOffset);
     if (result == -1) {
-        ALOGE("seek to %lld failed", (long long)(offset + mOffset));
-        return UNKNOWN_ERROR;
+        ALOGE("read at %lld failed (%s)", (long long)(offset + mOffset), strerror(errno));
     }
-
-    return ::read(mFd, data, size);
+    return result;
 }
 
 status_t FileSource::getSize(off64_t *size) {
@@ -38,6 +38,9 @@ constexpr effect_uuid_t kEffectUuids[] = {
 
 constexpr size_t kNumEffectUuids = std::size(kEffectUuids);
 
+constexpr const char* kEffectNames[] = {"BassBoost", "Virtualizer", "Equalizer", "Volume"};
+static_assert(std::size(kEffectNames) == kNumEffectUuids);
+
 constexpr size_t kFrameCount = 2048;
 
 constexpr audio_channel_mask_t kChMasks[] = {
@@ -59,6 +62,8 @@ constexpr int kSampleRate = 44100;
  * The first parameter indicates the number of channels.
  * The second parameter indicates the effect.
  * 0: Bass Boost, 1: Virtualizer, 2: Equalizer, 3: Volume
+ * Each run also reports the processing time per frame in the time/frame counter,
+ * e.g. for 2, 6 and 8 channels: --benchmark_filter='BM_LVM/(2|6|8)/'
  * -----------------------------------------------------
  * Benchmark           Time             CPU   Iterations
  * -----------------------------------------------------
@@ -218,6 +223,11 @@ static void BM_LVM(benchmark::State& state) {
     }
 
     state.SetComplexityN(state.range(0));
+    state.SetLabel(kEffectNames[state.range(1)]);
+    // processing time per frame, in seconds
+    state.counters["time/frame"] =
+            benchmark::Counter(kFrameCount, benchmark::Counter::kIsIterationInvariantRate |
+                                                    benchmark::Counter::kInvert);
 
     if (int status = AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(effectHandle); status != 0) {
         ALOGE("release_effect returned an error = %d\n", status);
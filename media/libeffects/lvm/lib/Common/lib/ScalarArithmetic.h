@@ -34,8 +34,11 @@ static inline LVM_FLOAT Abs_Float(LVM_FLOAT input) {
     return fabs(input);
 }
 
+/* Same result as fmin(fmax(val, -1.0f), 1.0f), NaN included, written with comparisons
+ * so that the loops using it can be vectorized */
 static inline LVM_FLOAT LVM_Clamp(LVM_FLOAT val) {
-    return fmin(fmax(val, -1.0f), 1.0f);
+    val = val > -1.0f ? val : -1.0f;
+    return val < 1.0f ? val : 1.0f;
 }
 
 /****************************************************************************************
@@ -33,8 +33,8 @@ void DelayMix_Float(const LVM_FLOAT* src, /* Source 1, to be delayed */
     LVM_INT16 Offset = *pOffset;
     LVM_FLOAT temp;
 
-    for (i = 0; i < n; i++) {
-        if (NrChannels == FCC_1) {
+    if (NrChannels == FCC_1) {
+        for (i = 0; i < n; i++) {
             temp = (LVM_FLOAT)(*dst + (LVM_FLOAT)delay[Offset]) / 2.0f;
             *dst = temp;
             dst++;
@@ -47,7 +47,9 @@ void DelayMix_Float(const LVM_FLOAT* src, /* Source 1, to be delayed */
             if (Offset >= size) {
                 Offset = 0;
             }
-        } else {
+        }
+    } else {
+        for (i = 0; i < n; i++) {
             /* Left channel */
             temp = (LVM_FLOAT)(*dst + (LVM_FLOAT)delay[Offset]) / 2.0f;
             *dst = temp;
@@ -22,15 +22,53 @@
 #include "LVM_Macros.h"
 #include "ScalarArithmetic.h"
 
+/* Number of samples processed per inner loop by LVC_Core_MixGains_MC_float */
+#define LVC_MIX_CHUNK_SAMPLES 32
+
+static inline void MixGains_float(const LVM_FLOAT* gains, const LVM_FLOAT* src, LVM_FLOAT* dst,
+                                  LVM_INT32 n, LVM_INT16 Saturate) {
+    LVM_INT32 ii;
+    if (Saturate) {
+        for (ii = 0; ii < n; ii++) {
+            dst[ii] = LVM_Clamp(src[ii] * gains[ii]);
+        }
+    } else {
+        for (ii = 0; ii < n; ii++) {
+            dst[ii] = src[ii] * gains[ii];
+        }
+    }
+}
+
+void LVC_Core_MixGains_MC_float(const LVM_FLOAT* Gains, const LVM_FLOAT* src, LVM_FLOAT* dst,
+                                LVM_INT16 NrFrames, LVM_INT16 NrChannels, LVM_INT16 Saturate) {
+    /*
+     * The gains are repeated over a few frames, so that the inner loop runs
+     * over contiguous samples with one gain per sample, whatever the channel count.
+     */
+    LVM_FLOAT chunkGains[LVC_MIX_CHUNK_SAMPLES + LVM_MAX_CHANNELS];
+    const LVM_INT32 chunkFrames =
+            NrChannels < LVC_MIX_CHUNK_SAMPLES ? LVC_MIX_CHUNK_SAMPLES / NrChannels : 1;
+    const LVM_INT32 chunkSamples = chunkFrames * NrChannels;
+    LVM_INT32 ii;
+    for (ii = 0; ii < chunkSamples; ii++) {
+        chunkGains[ii] = Gains[ii % NrChannels];
+    }
+
+    LVM_INT32 frames = NrFrames;
+    for (; frames >= chunkFrames; frames -= chunkFrames) {
+        MixGains_float(chunkGains, src, dst, chunkSamples, Saturate);
+        src += chunkSamples;
+        dst += chunkSamples;
+    }
+    MixGains_float(chunkGains, src, dst, frames * NrChannels, Saturate);
+}
+
 void LVC_Core_MixHard_1St_MC_float_SAT(Mix_Private_FLOAT_st** ptrInstance, const LVM_FLOAT* src,
                                        LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
-    LVM_FLOAT Temp;
-    LVM_INT16 ii, jj;
-    for (ii = NrFrames; ii != 0; ii--) {
-        for (jj = 0; jj < NrChannels; jj++) {
-            Mix_Private_FLOAT_st* pInstance1 = (Mix_Private_FLOAT_st*)(ptrInstance[jj]);
-            Temp =  *src++ * pInstance1->Current;
-            *dst++ = LVM_Clamp(Temp);
-        }
+    LVM_FLOAT Gains[LVM_MAX_CHANNELS];
+    LVM_INT16 jj;
+    for (jj = 0; jj < NrChannels; jj++) {
+        Gains[jj] = ptrInstance[jj]->Current;
     }
+    LVC_Core_MixGains_MC_float(Gains, src, dst, NrFrames, NrChannels, LVM_TRUE);
 }
@@ -22,6 +22,15 @@
 #include "LVM_Macros.h"
 #include "ScalarArithmetic.h"
 
+/* Mixes n consecutive samples into the destination with the same gain */
+static inline void MixInSoft_Mc_Gain(const LVM_FLOAT* src, LVM_FLOAT* dst, LVM_INT32 n,
+                                     LVM_FLOAT Current) {
+    for (LVM_INT32 ii = 0; ii < n; ii++) {
+        LVM_FLOAT Temp = dst[ii] + src[ii] * Current;
+        dst[ii] = LVM_Clamp(Temp);
+    }
+}
+
 /**********************************************************************************
    FUNCTION LVCore_MIXSOFT_1ST_D16C31_WRA
 ***********************************************************************************/
@@ -105,12 +114,13 @@ void LVC_Core_MixInSoft_Mc_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_
                                       LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
     LVM_INT16 OutLoop;
     LVM_INT16 InLoop;
-    LVM_INT32 ii, jj;
+    LVM_INT32 ii;
     Mix_Private_FLOAT_st* pInstance = (Mix_Private_FLOAT_st*)(ptrInstance->PrivateParams);
     LVM_FLOAT Delta = pInstance->Delta;
     LVM_FLOAT Current = pInstance->Current;
     LVM_FLOAT Target = pInstance->Target;
     LVM_FLOAT Temp;
+    const LVM_INT32 PairSamples = 2 * NrChannels;
 
     /*
      * Same operation is performed on consecutive frames.
@@ -121,55 +131,54 @@ void LVC_Core_MixInSoft_Mc_D16C31_SAT(LVMixer3_FLOAT_st* ptrInstance, const LVM_
     /* OutLoop is calculated to handle cases where NrFrames value can be odd.*/
     OutLoop = (LVM_INT16)(NrFrames - (InLoop << 1));
 
+    /*
+     * Once a step leaves the gain unchanged, it is constant until the end of the block,
+     * and the remaining frames are processed with a single loop.
+     */
     if (Current < Target) {
         if (OutLoop) {
             Temp = Current + Delta;
             Current = Temp;
             if (Current > Target) Current = Target;
 
-            for (ii = OutLoop * NrChannels; ii != 0; ii--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            MixInSoft_Mc_Gain(src, dst, NrChannels, Current);
+            src += NrChannels;
+            dst += NrChannels;
         }
 
         for (ii = InLoop; ii != 0; ii--) {
+            const LVM_FLOAT Previous = Current;
             Temp = Current + Delta;
             Current = Temp;
             if (Current > Target) Current = Target;
+            if (Current == Previous) break;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            MixInSoft_Mc_Gain(src, dst, PairSamples, Current);
+            src += PairSamples;
+            dst += PairSamples;
         }
     } else {
         if (OutLoop) {
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (ii = OutLoop * NrChannels; ii != 0; ii--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            MixInSoft_Mc_Gain(src, dst, NrChannels, Current);
+            src += NrChannels;
+            dst += NrChannels;
         }
 
         for (ii = InLoop; ii != 0; ii--) {
+            const LVM_FLOAT Previous = Current;
             Current -= Delta;
             if (Current < Target) Current = Target;
+            if (Current == Previous) break;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-
-                Temp = *dst + *src++ * Current;
-                *dst++ = LVM_Clamp(Temp);
-            }
+            MixInSoft_Mc_Gain(src, dst, PairSamples, Current);
+            src += PairSamples;
+            dst += PairSamples;
         }
     }
+    MixInSoft_Mc_Gain(src, dst, ii * PairSamples, Current);
     pInstance->Current = Current;
 }
 
@@ -32,7 +32,8 @@ void LVC_Core_MixSoft_1St_MC_float_WRA(Mix_Private_FLOAT_st** ptrInstance, const
     for (ch = 0; ch < NrChannels; ch++) {
         tempCurrent[ch] = ptrInstance[ch]->Current;
     }
-    for (ii = NrFrames; ii > 0; ii--) {
+    for (ii = NrFrames; ii > 0;) {
+        LVM_INT16 Ramping = LVM_FALSE;
         for (ch = 0; ch < NrChannels; ch++) {
             Mix_Private_FLOAT_st* pInstance = ptrInstance[ch];
             const LVM_FLOAT Delta = pInstance->Delta;
@@ -46,8 +47,16 @@ void LVC_Core_MixSoft_1St_MC_float_WRA(Mix_Private_FLOAT_st** ptrInstance, const
                 if (Current < Target) Current = Target;
             }
             *dst++ = *src++ * Current;
+            Ramping |= Current != tempCurrent[ch];
             tempCurrent[ch] = Current;
         }
+        ii--;
+        if (!Ramping) {
+            /* No gain changed in this frame, so they are constant from now on */
+            LVC_Core_MixGains_MC_float(tempCurrent, src, dst, (LVM_INT16)ii, NrChannels,
+                                       LVM_FALSE);
+            break;
+        }
     }
     for (ch = 0; ch < NrChannels; ch++) {
         ptrInstance[ch]->Current = tempCurrent[ch];
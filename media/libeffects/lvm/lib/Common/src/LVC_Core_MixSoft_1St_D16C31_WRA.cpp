@@ -22,6 +22,14 @@
 #include "LVM_Macros.h"
 #include "ScalarArithmetic.h"
 
+/* Applies the same gain to n consecutive samples */
+static inline void MixSoft_Mc_Gain(const LVM_FLOAT* src, LVM_FLOAT* dst, LVM_INT32 n,
+                                   LVM_FLOAT Current) {
+    for (LVM_INT32 ii = 0; ii < n; ii++) {
+        dst[ii] = src[ii] * Current;
+    }
+}
+
 /**********************************************************************************
    FUNCTION LVCore_MIXSOFT_1ST_D16C31_WRA
 ***********************************************************************************/
@@ -102,11 +110,12 @@ void LVC_Core_MixSoft_Mc_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_FL
                                     LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels) {
     LVM_INT16 OutLoop;
     LVM_INT16 InLoop;
-    LVM_INT32 ii, jj;
+    LVM_INT32 ii;
     Mix_Private_FLOAT_st* pInstance = (Mix_Private_FLOAT_st*)(ptrInstance->PrivateParams);
     LVM_FLOAT Delta = (LVM_FLOAT)pInstance->Delta;
     LVM_FLOAT Current = (LVM_FLOAT)pInstance->Current;
     LVM_FLOAT Target = (LVM_FLOAT)pInstance->Target;
+    const LVM_INT32 PairSamples = 2 * NrChannels;
 
     /*
      * Same operation is performed on consecutive frames.
@@ -117,49 +126,52 @@ void LVC_Core_MixSoft_Mc_D16C31_WRA(LVMixer3_FLOAT_st* ptrInstance, const LVM_FL
     /* OutLoop is calculated to handle cases where NrFrames value can be odd.*/
     OutLoop = (LVM_INT16)(NrFrames - (InLoop << 1));
 
+    /*
+     * Once a step leaves the gain unchanged, it is constant until the end of the block,
+     * and the remaining frames are processed with a single loop.
+     */
     if (Current < Target) {
         if (OutLoop) {
             Current = LVM_Clamp(Current + Delta);
             if (Current > Target) Current = Target;
 
-            for (ii = OutLoop; ii != 0; ii--) {
-                for (jj = NrChannels; jj != 0; jj--) {
-                    *(dst++) = (((LVM_FLOAT) * (src++) * (LVM_FLOAT)Current));
-                }
-            }
+            MixSoft_Mc_Gain(src, dst, NrChannels, Current);
+            src += NrChannels;
+            dst += NrChannels;
         }
 
         for (ii = InLoop; ii != 0; ii--) {
+            const LVM_FLOAT Previous = Current;
             Current = LVM_Clamp(Current + Delta);
             if (Current > Target) Current = Target;
+            if (Current == Previous) break;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            }
+            MixSoft_Mc_Gain(src, dst, PairSamples, Current);
+            src += PairSamples;
+            dst += PairSamples;
         }
     } else {
         if (OutLoop) {
             Current -= Delta;
             if (Current < Target) Current = Target;
 
-            for (ii = OutLoop; ii != 0; ii--) {
-                for (jj = NrChannels; jj != 0; jj--) {
-                    *(dst++) = (((LVM_FLOAT) * (src++) * (LVM_FLOAT)Current));
-                }
-            }
+            MixSoft_Mc_Gain(src, dst, NrChannels, Current);
+            src += NrChannels;
+            dst += NrChannels;
         }
 
         for (ii = InLoop; ii != 0; ii--) {
+            const LVM_FLOAT Previous = Current;
             Current -= Delta;
             if (Current < Target) Current = Target;
+            if (Current == Previous) break;
 
-            for (jj = NrChannels; jj != 0; jj--) {
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-                *(dst++) = (((LVM_FLOAT) * (src++) * Current));
-            }
+            MixSoft_Mc_Gain(src, dst, PairSamples, Current);
+            src += PairSamples;
+            dst += PairSamples;
         }
     }
+    MixSoft_Mc_Gain(src, dst, ii * PairSamples, Current);
     pInstance->Current = Current;
 }
 
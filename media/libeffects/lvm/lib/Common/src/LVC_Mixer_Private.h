@@ -75,4 +75,11 @@ void LVC_Core_MixSoft_1St_MC_float_WRA(Mix_Private_FLOAT_st** ptrInstance, const
 void LVC_Core_MixHard_1St_MC_float_SAT(Mix_Private_FLOAT_st** ptrInstance, const LVM_FLOAT* src,
                                        LVM_FLOAT* dst, LVM_INT16 NrFrames, LVM_INT16 NrChannels);
 
+/**********************************************************************************/
+/* Applies a constant gain per channel, Gains[ch] applies to channel ch.          */
+/* The output is saturated if Saturate is LVM_TRUE.                               */
+/**********************************************************************************/
+void LVC_Core_MixGains_MC_float(const LVM_FLOAT* Gains, const LVM_FLOAT* src, LVM_FLOAT* dst,
+                                LVM_INT16 NrFrames, LVM_INT16 NrChannels, LVM_INT16 Saturate);
+
 #endif  //#ifndef __LVC_MIXER_PRIVATE_H__
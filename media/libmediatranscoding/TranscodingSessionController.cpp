@@ -26,6 +26,7 @@
 #include <utils/AndroidThreads.h>
 #include <utils/Log.h>
 
+#include <algorithm>
 #include <thread>
 #include <utility>
 
@@ -71,27 +72,24 @@ struct TranscodingSessionController::Watchdog {
     // Starts monitoring the session.
     void start(const SessionKeyType& key);
     // Stops monitoring the session.
-    void stop();
+    void stop(const SessionKeyType& key);
     // Signals that the session is still alive. Must be sent at least every mTimeoutUs.
     // (Timeout will happen if no ping in mTimeoutUs since the last ping.)
-    void keepAlive();
+    void keepAlive(const SessionKeyType& key);
 
 private:
     void threadLoop();
-    void updateTimer_l();
+    void updateTimer_l(const SessionKeyType& key);
 
     TranscodingSessionController* mOwner;
     const int64_t mTimeoutUs;
     mutable std::mutex mLock;
     std::condition_variable mCondition GUARDED_BY(mLock);
-    // Whether watchdog is monitoring a session for timeout.
-    bool mActive GUARDED_BY(mLock);
     // Whether watchdog is aborted and the monitoring thread should exit.
     bool mAbort GUARDED_BY(mLock);
-    // When watchdog is active, the next timeout time point.
-    std::chrono::steady_clock::time_point mNextTimeoutTime GUARDED_BY(mLock);
-    // When watchdog is active, the session being watched.
-    SessionKeyType mSessionToWatch GUARDED_BY(mLock);
+    // The sessions being watched, with their next timeout time point.
+    std::map<SessionKeyType, std::chrono::steady_clock::time_point> mNextTimeoutTimes
+            GUARDED_BY(mLock);
     std::thread mThread;
 };
 
@@ -99,7 +97,6 @@ TranscodingSessionController::Watchdog::Watchdog(TranscodingSessionController* o
                                                  int64_t timeoutUs)
       : mOwner(owner),
         mTimeoutUs(timeoutUs),
-        mActive(false),
         mAbort(false),
         mThread(&Watchdog::threadLoop, this) {
     ALOGV("Watchdog CTOR: %p", this);
@@ -123,42 +120,40 @@ TranscodingSessionController::Watchdog::~Watchdog() {
 void TranscodingSessionController::Watchdog::start(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (!mActive) {
+    if (mNextTimeoutTimes.count(key) == 0) {
         ALOGI("Watchdog start: %s", sessionToString(key).c_str());
 
-        mActive = true;
-        mSessionToWatch = key;
-        updateTimer_l();
+        updateTimer_l(key);
         mCondition.notify_one();
     }
 }
 
-void TranscodingSessionController::Watchdog::stop() {
+void TranscodingSessionController::Watchdog::stop(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (mActive) {
-        ALOGI("Watchdog stop: %s", sessionToString(mSessionToWatch).c_str());
+    if (mNextTimeoutTimes.erase(key) > 0) {
+        ALOGI("Watchdog stop: %s", sessionToString(key).c_str());
 
-        mActive = false;
         mCondition.notify_one();
     }
 }
 
-void TranscodingSessionController::Watchdog::keepAlive() {
+void TranscodingSessionController::Watchdog::keepAlive(const SessionKeyType& key) {
     std::scoped_lock lock{mLock};
 
-    if (mActive) {
-        ALOGI("Watchdog keepAlive: %s", sessionToString(mSessionToWatch).c_str());
+    if (mNextTimeoutTimes.count(key) > 0) {
+        ALOGI("Watchdog keepAlive: %s", sessionToString(key).c_str());
 
-        updateTimer_l();
+        updateTimer_l(key);
         mCondition.notify_one();
     }
 }
 
 // updateTimer_l() is only called with lock held.
-void TranscodingSessionController::Watchdog::updateTimer_l() NO_THREAD_SAFETY_ANALYSIS {
+void TranscodingSessionController::Watchdog::updateTimer_l(const SessionKeyType& key)
+        NO_THREAD_SAFETY_ANALYSIS {
     std::chrono::microseconds timeout(mTimeoutUs);
-    mNextTimeoutTime = std::chrono::steady_clock::now() + timeout;
+    mNextTimeoutTimes[key] = std::chrono::steady_clock::now() + timeout;
 }
 
 // Unfortunately std::unique_lock is incompatible with -Wthread-safety.
@@ -167,24 +162,31 @@ void TranscodingSessionController::Watchdog::threadLoop() NO_THREAD_SAFETY_ANALY
     std::unique_lock<std::mutex> lock{mLock};
 
     while (!mAbort) {
-        if (!mActive) {
+        if (mNextTimeoutTimes.empty()) {
             mCondition.wait(lock);
             continue;
         }
-        // Watchdog active, wait till next timeout time.
-        if (mCondition.wait_until(lock, mNextTimeoutTime) == std::cv_status::timeout) {
-            // If timeout happens, report timeout and deactivate watchdog.
-            mActive = false;
-            // Make a copy of session key, as once we unlock, it could be unprotected.
-            SessionKeyType sessionKey = mSessionToWatch;
-
-            ALOGE("Watchdog timeout: %s", sessionToString(sessionKey).c_str());
-
-            lock.unlock();
-            mOwner->onError(sessionKey.first, sessionKey.second,
-                            TranscodingErrorCode::kWatchdogTimeout);
-            lock.lock();
+        // Watchdog active, wait till the earliest timeout time.
+        auto it = std::min_element(
+                mNextTimeoutTimes.begin(), mNextTimeoutTimes.end(),
+                [](const auto& lhs, const auto& rhs) { return lhs.second < rhs.second; });
+        if (it->second > std::chrono::steady_clock::now()) {
+            // Copy the time point, the entry could be erased while we wait.
+            const std::chrono::steady_clock::time_point nextTimeoutTime = it->second;
+            mCondition.wait_until(lock, nextTimeoutTime);
+            continue;
         }
+        // If timeout happens, report timeout and stop watching the session.
+        // Make a copy of session key, as once we unlock, it could be unprotected.
+        SessionKeyType sessionKey = it->first;
+        mNextTimeoutTimes.erase(it);
+
+        ALOGE("Watchdog timeout: %s", sessionToString(sessionKey).c_str());
+
+        lock.unlock();
+        mOwner->onError(sessionKey.first, sessionKey.second,
+                        TranscodingErrorCode::kWatchdogTimeout);
+        lock.lock();
     }
 }
 ///////////////////////////////////////////////////////////////////////////////
@@ -335,7 +337,7 @@ TranscodingSessionController::TranscodingSessionController(
         mUidPolicy(uidPolicy),
         mResourcePolicy(resourcePolicy),
         mThermalPolicy(thermalPolicy),
-        mCurrentSession(nullptr),
+        mCreateTime(std::chrono::steady_clock::now()),
         mResourceLost(false) {
     // Only push empty offline queue initially. Realtime queues are added when requests come in.
     mUidSortedList.push_back(OFFLINE_UID);
@@ -346,10 +348,14 @@ TranscodingSessionController::TranscodingSessionController(
     if (config != nullptr) {
         mConfig = *config;
     }
+    mConfig.maxConcurrentSessions = std::max(mConfig.maxConcurrentSessions, 1);
+    mSlots.resize(mConfig.maxConcurrentSessions);
     mPacer.reset(new Pacer(mConfig));
-    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d",
+    ALOGD("@@@ watchdog %lld, burst count %d, burst time %d, burst threshold %d, "
+          "max concurrent sessions %d",
           (long long)mConfig.watchdogTimeoutUs, mConfig.pacerBurstCountQuota,
-          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs);
+          mConfig.pacerBurstTimeQuotaSeconds, mConfig.pacerBurstThresholdMs,
+          mConfig.maxConcurrentSessions);
 }
 
 TranscodingSessionController::~TranscodingSessionController() {}
@@ -378,6 +384,31 @@ void TranscodingSessionController::dumpSession_l(const Session& session, String8
     }
 }
 
+void TranscodingSessionController::dumpSlots_l(String8& result) {
+    const size_t SIZE = 256;
+    char buffer[SIZE];
+    const auto nowTime = std::chrono::steady_clock::now();
+    const float upTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            nowTime - mCreateTime).count();
+
+    snprintf(buffer, SIZE, "  Session slots: %zu, up: %.1fs\n", mSlots.size(),
+             upTimeUs / 1000000.0f);
+    result.append(buffer);
+    for (size_t i = 0; i < mSlots.size(); i++) {
+        const Slot& slot = mSlots[i];
+        std::chrono::microseconds busyTime = slot.busyTime;
+        if (slot.session != nullptr) {
+            busyTime += std::chrono::duration_cast<std::chrono::microseconds>(nowTime -
+                                                                              slot.busySince);
+        }
+        snprintf(buffer, SIZE, "    slot %zu: %s, sessions: %d, busy: %.1fs (%.1f%%)\n", i,
+                 slot.session != nullptr ? sessionToString(slot.session->key).c_str() : "idle",
+                 slot.sessionCount, busyTime.count() / 1000000.0f,
+                 upTimeUs > 0 ? busyTime.count() * 100.0f / upTimeUs : 0.0f);
+        result.append(buffer);
+    }
+}
+
 void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16>& args __unused) {
     String8 result;
 
@@ -389,6 +420,7 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
     result.append(buffer);
     snprintf(buffer, SIZE, "  Total num of Sessions: %zu\n", mSessionMap.size());
     result.append(buffer);
+    dumpSlots_l(result);
 
     std::vector<int32_t> uids(mUidSortedList.begin(), mUidSortedList.end());
 
@@ -425,31 +457,53 @@ void TranscodingSessionController::dumpAllSessions(int fd, const Vector<String16
 }
 
 /*
- * Returns nullptr if there is no session, or we're paused globally (due to resource lost,
- * thermal throttling, etc.). Otherwise, return the session that should be run next.
+ * Returns an empty list if there is no session, or we're paused globally (due to resource
+ * lost, thermal throttling, etc.). Otherwise, return the sessions that should be running,
+ * up to one per slot, taken from the uid queues in the order of mUidSortedList.
  */
-TranscodingSessionController::Session* TranscodingSessionController::getTopSession_l() {
+std::vector<TranscodingSessionController::Session*>
+TranscodingSessionController::getTopSessions_l() {
+    std::vector<Session*> topSessions;
     if (mSessionMap.empty()) {
-        return nullptr;
+        return topSessions;
     }
 
-    // Return nullptr if we're paused globally due to resource lost or thermal throttling.
+    // Return empty list if we're paused globally due to resource lost or thermal throttling.
     if (((mResourcePolicy != nullptr && mResourceLost) ||
          (mThermalPolicy != nullptr && mThermalThrottling))) {
-        return nullptr;
+        return topSessions;
     }
 
-    uid_t topUid = *mUidSortedList.begin();
-    // If the current session is running, and it's in the topUid's queue, let it continue
-    // to run even if it's not the earliest in that uid's queue.
-    // For example, uid(B) is added to a session while it's pending in uid(A)'s queue, then
-    // B is brought to front which caused the session to run, then user switches back to A.
-    if (mCurrentSession != nullptr && mCurrentSession->getState() == Session::RUNNING &&
-        mCurrentSession->allClientUids.count(topUid) > 0) {
-        return mCurrentSession;
+    // Without a resource policy, only the session that lost the resource is kept paused. It
+    // keeps its slot until the resource is available again, the other slots are still used.
+    if (mResourceLost) {
+        auto it = mSessionMap.find(mResourceLostSession);
+        if (it != mSessionMap.end()) {
+            topSessions.push_back(&it->second);
+        }
     }
-    SessionKeyType topSessionKey = *mSessionQueues[topUid].begin();
-    return &mSessionMap[topSessionKey];
+
+    for (uid_t uid : mUidSortedList) {
+        // If a session is running, and it's in the uid's queue, let it continue to run
+        // even if it's not the earliest in that uid's queue.
+        // For example, uid(B) is added to a session while it's pending in uid(A)'s queue, then
+        // B is brought to front which caused the session to run, then user switches back to A.
+        for (bool running : {true, false}) {
+            for (const SessionKeyType& sessionKey : mSessionQueues[uid]) {
+                if (topSessions.size() == mSlots.size()) {
+                    return topSessions;
+                }
+                Session* session = &mSessionMap[sessionKey];
+                // A session with multiple uids could have been picked from another queue.
+                if (session->isRunning() == running &&
+                    std::find(topSessions.begin(), topSessions.end(), session) ==
+                            topSessions.end()) {
+                    topSessions.push_back(session);
+                }
+            }
+        }
+    }
+    return topSessions;
 }
 
 void TranscodingSessionController::setSessionState_l(Session* session, Session::State state) {
@@ -461,14 +515,10 @@ void TranscodingSessionController::setSessionState_l(Session* session, Session::
         return;
     }
 
-    // Currently we only have 1 running session, and we always put the previous
-    // session in non-running state before we run the new session, so it's okay
-    // to start/stop the watchdog here. If this assumption changes, we need to
-    // track the number of running sessions and start/stop watchdog based on that.
     if (isRunning) {
         mWatchdog->start(session->key);
     } else {
-        mWatchdog->stop();
+        mWatchdog->stop(session->key);
     }
 }
 
@@ -501,72 +551,135 @@ void TranscodingSessionController::Session::setState(Session::State newState) {
     state = newState;
 }
 
-void TranscodingSessionController::updateCurrentSession_l() {
-    Session* curSession = mCurrentSession;
-    Session* topSession = nullptr;
+/*
+ * Returns the slot to run the session in: the slot holding its paused state if that
+ * one is available, otherwise any idle slot.
+ */
+TranscodingSessionController::Slot* TranscodingSessionController::findSlot_l(Session* session) {
+    if (session->slotIndex >= 0) {
+        Slot* slot = &mSlots[session->slotIndex];
+        if (slot->session == nullptr || slot->session == session) {
+            return slot;
+        }
+    }
+    for (Slot& slot : mSlots) {
+        if (slot.session == nullptr) {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
 
-    // Delayed init of transcoder and watchdog.
-    if (mTranscoder == nullptr) {
-        mTranscoder = mTranscoderFactory(shared_from_this());
-        mWatchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
+void TranscodingSessionController::assignSlot_l(Slot* slot, Session* session) {
+    if (slot->session == session) {
+        return;
     }
+    slot->session = session;
+    slot->sessionCount++;
+    slot->busySince = std::chrono::steady_clock::now();
+    session->slotIndex = slot - mSlots.data();
+}
 
-    // If we found a different top session, or the top session's running state is not
-    // correct. Take some actions to ensure it's correct.
-    while ((topSession = getTopSession_l()) != curSession ||
-           (topSession != nullptr && !topSession->isRunning())) {
-        ALOGV("updateCurrentSession_l: topSession is %s, curSession is %s",
-              topSession == nullptr ? "null" : sessionToString(topSession->key).c_str(),
-              curSession == nullptr ? "null" : sessionToString(curSession->key).c_str());
-
-        // If current session is running, pause it first. Note this is needed for either
-        // cases: 1) Top session is changing to another session, or 2) Top session is
-        // changing to null (which means we should be globally paused).
-        if (curSession != nullptr && curSession->getState() == Session::RUNNING) {
-            mTranscoder->pause(curSession->key.first, curSession->key.second);
-            setSessionState_l(curSession, Session::PAUSED);
+void TranscodingSessionController::releaseSlot_l(Slot* slot) {
+    if (slot->session == nullptr) {
+        return;
+    }
+    slot->busyTime += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - slot->busySince);
+    slot->session = nullptr;
+}
+
+void TranscodingSessionController::updateCurrentSessions_l() {
+    // Delayed init of transcoders and watchdog.
+    if (mWatchdog == nullptr) {
+        for (Slot& slot : mSlots) {
+            slot.transcoder = mTranscoderFactory(shared_from_this());
         }
+        mWatchdog = std::make_shared<Watchdog>(this, mConfig.watchdogTimeoutUs);
+    }
 
-        if (topSession == nullptr) {
-            // Nothing more to run (either no session or globally paused).
-            break;
+    bool sessionDropped;
+    do {
+        sessionDropped = false;
+        std::vector<Session*> topSessions = getTopSessions_l();
+
+        // Pause the running sessions that are no longer among the top sessions first, so
+        // that their slots are free for the new top sessions. Note this pauses every
+        // running session if the top sessions are empty (we should be globally paused).
+        for (Slot& slot : mSlots) {
+            Session* session = slot.session;
+            if (session == nullptr ||
+                std::find(topSessions.begin(), topSessions.end(), session) != topSessions.end()) {
+                continue;
+            }
+            ALOGV("updateCurrentSessions_l: pausing %s", sessionToString(session->key).c_str());
+            if (session->getState() == Session::RUNNING) {
+                slot.transcoder->pause(session->key.first, session->key.second);
+                setSessionState_l(session, Session::PAUSED);
+            }
+            releaseSlot_l(&slot);
         }
 
-        // Otherwise, ensure topSession is running.
-        if (topSession->getState() == Session::NOT_STARTED) {
-            // Check if at least one client has quota to start the session.
-            bool keepForClient = false;
-            for (uid_t uid : topSession->allClientUids) {
-                if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
-                    keepForClient = true;
-                    // DO NOT break here, because book-keeping still needs to happen
-                    // for the other uids.
-                }
+        // Then ensure the top sessions are running, in priority order.
+        for (Session* topSession : topSessions) {
+            if (topSession->isRunning() ||
+                (mResourceLost && topSession->key == mResourceLostSession)) {
+                continue;
             }
-            if (!keepForClient) {
-                // Unfortunately all uids requesting this session are out of quota.
-                // Drop this session and try the next one.
-                {
-                    auto clientCallback = mSessionMap[topSession->key].callback.lock();
-                    if (clientCallback != nullptr) {
-                        clientCallback->onTranscodingFailed(
-                                topSession->key.second, TranscodingErrorCode::kDroppedByService);
+            ALOGV("updateCurrentSessions_l: running %s", sessionToString(topSession->key).c_str());
+
+            Slot* slot = findSlot_l(topSession);
+            LOG_ALWAYS_FATAL_IF(slot == nullptr, "no slot for session %s",
+                                sessionToString(topSession->key).c_str());
+
+            if (topSession->getState() == Session::NOT_STARTED) {
+                // Check if at least one client has quota to start the session.
+                bool keepForClient = false;
+                for (uid_t uid : topSession->allClientUids) {
+                    if (mPacer->onSessionStarted(uid, topSession->callingUid)) {
+                        keepForClient = true;
+                        // DO NOT break here, because book-keeping still needs to happen
+                        // for the other uids.
                     }
                 }
-                removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
-                continue;
+                if (!keepForClient) {
+                    // Unfortunately all uids requesting this session are out of quota.
+                    // Drop this session and try the next one.
+                    {
+                        auto clientCallback = topSession->callback.lock();
+                        if (clientCallback != nullptr) {
+                            clientCallback->onTranscodingFailed(
+                                    topSession->key.second,
+                                    TranscodingErrorCode::kDroppedByService);
+                        }
+                    }
+                    removeSession_l(topSession->key, Session::DROPPED_BY_PACER);
+                    sessionDropped = true;
+                    break;
+                }
+                assignSlot_l(slot, topSession);
+                slot->transcoder->start(topSession->key.first, topSession->key.second,
+                                        topSession->request, topSession->callingUid,
+                                        topSession->callback.lock());
+            } else if (topSession->slotIndex != slot - mSlots.data()) {
+                // The paused state is held by the transcoder of another slot, which is busy.
+                // Discard it and start over in this slot (resume() currently restarts the
+                // transcoding from the beginning anyway).
+                mSlots[topSession->slotIndex].transcoder->stop(topSession->key.first,
+                                                               topSession->key.second);
+                assignSlot_l(slot, topSession);
+                slot->transcoder->start(topSession->key.first, topSession->key.second,
+                                        topSession->request, topSession->callingUid,
+                                        topSession->callback.lock());
+            } else {
+                assignSlot_l(slot, topSession);
+                slot->transcoder->resume(topSession->key.first, topSession->key.second,
+                                         topSession->request, topSession->callingUid,
+                                         topSession->callback.lock());
             }
-            mTranscoder->start(topSession->key.first, topSession->key.second, topSession->request,
-                               topSession->callingUid, topSession->callback.lock());
-            setSessionState_l(topSession, Session::RUNNING);
-        } else if (topSession->getState() == Session::PAUSED) {
-            mTranscoder->resume(topSession->key.first, topSession->key.second, topSession->request,
-                                topSession->callingUid, topSession->callback.lock());
             setSessionState_l(topSession, Session::RUNNING);
         }
-        break;
-    }
-    mCurrentSession = topSession;
+    } while (sessionDropped);
 }
 
 void TranscodingSessionController::addUidToSession_l(uid_t clientUid,
@@ -648,9 +761,10 @@ void TranscodingSessionController::removeSession_l(
         return;
     }
 
-    // Clear current session.
-    if (mCurrentSession == &mSessionMap[sessionKey]) {
-        mCurrentSession = nullptr;
+    // Free the session's slot.
+    const int32_t slotIndex = mSessionMap[sessionKey].slotIndex;
+    if (slotIndex >= 0 && mSlots[slotIndex].session == &mSessionMap[sessionKey]) {
+        releaseSlot_l(&mSlots[slotIndex]);
     }
 
     setSessionState_l(&mSessionMap[sessionKey], finalState);
@@ -760,7 +874,7 @@ bool TranscodingSessionController::submit(
 
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
     return true;
@@ -801,7 +915,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            mSlots[mSessionMap[*it].slotIndex].transcoder->stop(it->first, it->second);
         }
 
         // Remove the session.
@@ -815,7 +929,7 @@ bool TranscodingSessionController::cancel(ClientIdType clientId, SessionIdType s
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
     return true;
@@ -840,7 +954,7 @@ bool TranscodingSessionController::addClientUid(ClientIdType clientId, SessionId
     mSessionMap[sessionKey].allClientUids.insert(clientUid);
     addUidToSession_l(clientUid, sessionKey);
 
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
     return true;
@@ -949,7 +1063,7 @@ void TranscodingSessionController::onFinish(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::FINISHED);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateCurrentSessions_l();
 
         validateState_l();
     });
@@ -961,10 +1075,12 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         if (err == TranscodingErrorCode::kWatchdogTimeout) {
             // Abandon the transcoder, as its handler thread might be stuck in some call to
             // MediaTranscoder altogether, and may not be able to handle any new tasks.
-            mTranscoder->stop(clientId, sessionId, true /*abandon*/);
+            // Sessions in the other slots are not affected.
+            Slot& slot = mSlots[mSessionMap[sessionKey].slotIndex];
+            slot.transcoder->stop(clientId, sessionId, true /*abandon*/);
             // Clear the last ref count before we create new transcoder.
-            mTranscoder = nullptr;
-            mTranscoder = mTranscoderFactory(shared_from_this());
+            slot.transcoder = nullptr;
+            slot.transcoder = mTranscoderFactory(shared_from_this());
         }
 
         {
@@ -978,7 +1094,7 @@ void TranscodingSessionController::onError(ClientIdType clientId, SessionIdType
         removeSession_l(sessionKey, Session::ERROR);
 
         // Start next session.
-        updateCurrentSession_l();
+        updateCurrentSessions_l();
 
         validateState_l();
     });
@@ -997,7 +1113,7 @@ void TranscodingSessionController::onProgressUpdate(ClientIdType clientId, Sessi
 
 void TranscodingSessionController::onHeartBeat(ClientIdType clientId, SessionIdType sessionId) {
     notifyClient(clientId, sessionId, "heart-beat",
-                 [=](const SessionKeyType& /*sessionKey*/) { mWatchdog->keepAlive(); });
+                 [=](const SessionKeyType& sessionKey) { mWatchdog->keepAlive(sessionKey); });
 }
 
 void TranscodingSessionController::onResourceLost(ClientIdType clientId, SessionIdType sessionId) {
@@ -1027,6 +1143,11 @@ void TranscodingSessionController::onResourceLost(ClientIdType clientId, Session
             mResourcePolicy->setPidResourceLost(resourceLostSession->request.clientPid);
         }
         mResourceLost = true;
+        mResourceLostSession = sessionKey;
+
+        // Pause the sessions running in the other slots, or with no resource policy, leave
+        // them running and fill the idle ones.
+        updateCurrentSessions_l();
 
         validateState_l();
     });
@@ -1052,7 +1173,7 @@ void TranscodingSessionController::onTopUidsChanged(const std::unordered_set<uid
 
     moveUidsToTop_l(uids, true /*preserveTopUid*/);
 
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1082,7 +1203,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
         // the transcoder to discard any states for the session, otherwise the states may
         // never be discarded.
         if (mSessionMap[*it].getState() != Session::NOT_STARTED) {
-            mTranscoder->stop(it->first, it->second);
+            mSlots[mSessionMap[*it].slotIndex].transcoder->stop(it->first, it->second);
         }
 
         {
@@ -1104,7 +1225,7 @@ void TranscodingSessionController::onUidGone(uid_t goneUid) {
     }
 
     // Start next session.
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1119,7 +1240,7 @@ void TranscodingSessionController::onResourceAvailable() {
     ALOGI("%s", __FUNCTION__);
 
     mResourceLost = false;
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1134,7 +1255,7 @@ void TranscodingSessionController::onThrottlingStarted() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = true;
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1149,7 +1270,7 @@ void TranscodingSessionController::onThrottlingStopped() {
     ALOGI("%s", __FUNCTION__);
 
     mThermalThrottling = false;
-    updateCurrentSession_l();
+    updateCurrentSessions_l();
 
     validateState_l();
 }
@@ -1184,6 +1305,18 @@ void TranscodingSessionController::validateState_l() {
                         "session count (including dup) from mSessionQueues doesn't match that from "
                         "mSessionMap, %d vs %d",
                         totalSessions, totalSessionsAlternative);
+
+    for (auto const& s : mSessionMap) {
+        const Session& session = s.second;
+        LOG_ALWAYS_FATAL_IF(session.getState() != Session::NOT_STARTED &&
+                                    (session.slotIndex < 0 || session.slotIndex >= (int32_t)mSlots.size()),
+                            "session %s has invalid slot %d", sessionToString(s.first).c_str(),
+                            session.slotIndex);
+        LOG_ALWAYS_FATAL_IF(session.getState() == Session::RUNNING &&
+                                    mSlots[session.slotIndex].session != &session,
+                            "running session %s is not in slot %d",
+                            sessionToString(s.first).c_str(), session.slotIndex);
+    }
 #endif  // VALIDATE_STATE
 }
 
@@ -32,6 +32,7 @@
 #include <list>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace android {
 using ::aidl::android::media::TranscodingResultParcel;
@@ -108,6 +109,8 @@ private:
         int32_t pacerBurstCountQuota = 10;
         // Maximum allowed back-to-back running time.
         int32_t pacerBurstTimeQuotaSeconds = 120;  // 2-min
+        // Maximum number of sessions running at the same time.
+        int32_t maxConcurrentSessions = 1;
     };
 
     struct Session {
@@ -133,6 +136,10 @@ private:
         std::chrono::microseconds runningTime{0};
         std::chrono::microseconds pausedTime{0};
 
+        // Index of the slot whose transcoder started the session (and holds its
+        // paused state), -1 if the session was never started.
+        int32_t slotIndex = -1;
+
         TranscodingRequest request;
         std::weak_ptr<ITranscodingClientCallback> callback;
 
@@ -145,6 +152,17 @@ private:
         State state = INVALID;
     };
 
+    // A slot runs one session at a time on its own transcoder.
+    struct Slot {
+        std::shared_ptr<TranscoderInterface> transcoder;
+        // The session assigned to the slot, nullptr if the slot is idle.
+        Session* session = nullptr;
+        // Number of times a session was assigned to the slot.
+        int32_t sessionCount = 0;
+        std::chrono::time_point<std::chrono::steady_clock> busySince;
+        std::chrono::microseconds busyTime{0};
+    };
+
     struct Watchdog;
     struct Pacer;
 
@@ -166,13 +184,15 @@ private:
     std::map<uid_t, std::string> mUidPackageNames;
 
     TranscoderFactoryType mTranscoderFactory;
-    std::shared_ptr<TranscoderInterface> mTranscoder;
     std::shared_ptr<UidPolicyInterface> mUidPolicy;
     std::shared_ptr<ResourcePolicyInterface> mResourcePolicy;
     std::shared_ptr<ThermalPolicyInterface> mThermalPolicy;
 
-    Session* mCurrentSession;
+    std::vector<Slot> mSlots;
+    std::chrono::time_point<std::chrono::steady_clock> mCreateTime;
     bool mResourceLost;
+    // Valid while mResourceLost is set.
+    SessionKeyType mResourceLostSession;
     bool mThermalThrottling;
     std::list<Session> mSessionHistory;
     std::shared_ptr<Watchdog> mWatchdog;
@@ -186,8 +206,12 @@ private:
                                  const ControllerConfig* config = nullptr);
 
     void dumpSession_l(const Session& session, String8& result, bool closedSession = false);
-    Session* getTopSession_l();
-    void updateCurrentSession_l();
+    void dumpSlots_l(String8& result);
+    std::vector<Session*> getTopSessions_l();
+    void updateCurrentSessions_l();
+    Slot* findSlot_l(Session* session);
+    void assignSlot_l(Slot* slot, Session* session);
+    void releaseSlot_l(Slot* slot);
     void addUidToSession_l(uid_t uid, const SessionKeyType& sessionKey);
     void removeSession_l(const SessionKeyType& sessionKey, Session::State finalState,
                          const std::shared_ptr<std::function<bool(uid_t uid)>>& keepUid = nullptr);
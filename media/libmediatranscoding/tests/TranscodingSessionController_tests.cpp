@@ -297,22 +297,7 @@ public:
         mUidPolicy.reset(new TestUidPolicy());
         mResourcePolicy.reset(new TestResourcePolicy());
         mThermalPolicy.reset(new TestThermalPolicy());
-        // Overrid default burst params with shorter values for testing.
-        TranscodingSessionController::ControllerConfig config = {
-                .pacerBurstThresholdMs = 500,
-                .pacerBurstCountQuota = 10,
-                .pacerBurstTimeQuotaSeconds = 3,
-        };
-        mController.reset(new TranscodingSessionController(
-                [this](const std::shared_ptr<TranscoderCallbackInterface>& /*cb*/) {
-                    // Here we require that the SessionController clears out all its refcounts of
-                    // the transcoder object when it calls create.
-                    EXPECT_EQ(mTranscoder.use_count(), 1);
-                    mTranscoder->onCreated();
-                    return mTranscoder;
-                },
-                mUidPolicy, mResourcePolicy, mThermalPolicy, &config));
-        mUidPolicy->setCallback(mController);
+        createController(1 /*maxConcurrentSessions*/);
 
         // Set priority only, ignore other fields for now.
         mOfflineRequest.priority = TranscodingSessionPriority::kUnspecified;
@@ -329,6 +314,43 @@ public:
 
     void TearDown() override { ALOGI("TranscodingSessionControllerTest tear down"); }
 
+    void createController(int32_t maxConcurrentSessions) {
+        // Overrid default burst params with shorter values for testing.
+        TranscodingSessionController::ControllerConfig config = {
+                .pacerBurstThresholdMs = 500,
+                .pacerBurstCountQuota = 10,
+                .pacerBurstTimeQuotaSeconds = 3,
+                .maxConcurrentSessions = maxConcurrentSessions,
+        };
+        mController.reset(new TranscodingSessionController(
+                [this, maxConcurrentSessions](
+                        const std::shared_ptr<TranscoderCallbackInterface>& /*cb*/) {
+                    // Here we require that the SessionController clears out all its refcounts of
+                    // the transcoder object when it calls create. With multiple slots, the
+                    // slots all share mTranscoder, so that all events are in one queue.
+                    if (maxConcurrentSessions == 1) {
+                        EXPECT_EQ(mTranscoder.use_count(), 1);
+                    }
+                    mTranscoder->onCreated();
+                    return mTranscoder;
+                },
+                mUidPolicy, mResourcePolicy, mThermalPolicy, &config));
+        mUidPolicy->setCallback(mController);
+    }
+
+    std::string dumpAllSessions() {
+        std::string result;
+        FILE* file = tmpfile();
+        mController->dumpAllSessions(fileno(file), Vector<String16>());
+        rewind(file);
+        char buffer[256];
+        while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+            result += buffer;
+        }
+        fclose(file);
+        return result;
+    }
+
     void expectTimeout(int64_t clientId, int32_t sessionId, int32_t generation) {
         EXPECT_EQ(mTranscoder->popEvent(2900000), TestTranscoder::NoEvent);
         EXPECT_EQ(mTranscoder->popEvent(200000), TestTranscoder::Abandon(clientId, sessionId));
@@ -1344,4 +1366,197 @@ TEST_F(TranscodingSessionControllerTest, TestTranscoderPacerSelfUid) {
                                12 /*expectedSuccess*/);
 }
 
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessions) {
+    ALOGD("TestConcurrentSessions");
+    createController(2 /*maxConcurrentSessions*/);
+
+    // Start with UID(1) on top.
+    mUidPolicy->setTop(UID(1));
+
+    // Submit offline session to CLIENT(0) in UID(0), should start in slot 0.
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+
+    // Submit real-time session to CLIENT(0), should start in slot 1 without pausing the
+    // offline session.
+    mController->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Submit another real-time session to CLIENT(0), should preempt the offline session.
+    mController->submit(CLIENT(0), SESSION(2), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(2)));
+
+    // Submit a third real-time session to CLIENT(0), should be queued.
+    mController->submit(CLIENT(0), SESSION(3), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    std::string dump = dumpAllSessions();
+    EXPECT_NE(dump.find("Session slots: 2"), std::string::npos) << dump;
+    EXPECT_NE(dump.find("slot 0: {client:1000, session:2}, sessions: 2"), std::string::npos)
+            << dump;
+    EXPECT_NE(dump.find("slot 1: {client:1000, session:1}, sessions: 1"), std::string::npos)
+            << dump;
+
+    // Submit real-time session to CLIENT(2) in UID(1), which is top. Should only preempt
+    // the lower priority of the running sessions of UID(0).
+    mController->submit(CLIENT(2), SESSION(0), UID(2), UID(1), mRealtimeRequest, mClientCallback2);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(2), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Bring UID(0) to top. Its two earliest sessions should run, preempting UID(1)'s session.
+    mUidPolicy->setTop(UID(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(2), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Finish SESSION(1), SESSION(3) should start.
+    mController->onFinish(CLIENT(0), SESSION(1));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(3)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Cancel SESSION(2), CLIENT(2)'s session should resume in the slot holding its paused state.
+    EXPECT_TRUE(mController->cancel(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Stop(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(2), SESSION(0)));
+
+    // Finish SESSION(3), the offline session should run again.
+    mController->onFinish(CLIENT(0), SESSION(3));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(3)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Stop(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+}
+
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessionsMoveSlot) {
+    ALOGD("TestConcurrentSessionsMoveSlot");
+    createController(2 /*maxConcurrentSessions*/);
+
+    // Run SESSION(0) in slot 0 and SESSION(1) in slot 1.
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    mController->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mOfflineRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+
+    // Preempt both with real-time sessions.
+    mController->submit(CLIENT(0), SESSION(2), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(2)));
+    mController->submit(CLIENT(0), SESSION(3), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(3)));
+
+    // Finish SESSION(2) in slot 1. SESSION(0) is next, but its paused state is in the
+    // busy slot 0, so it should be stopped there and started over in slot 1.
+    mController->onFinish(CLIENT(0), SESSION(2));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Stop(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+
+    // Finish SESSION(3) in slot 0, SESSION(1) should be stopped in slot 1 and started
+    // over in slot 0.
+    mController->onFinish(CLIENT(0), SESSION(3));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(3)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Stop(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+}
+
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessionsResourceLostAndThermal) {
+    ALOGD("TestConcurrentSessionsResourceLostAndThermal");
+    createController(2 /*maxConcurrentSessions*/);
+
+    mRealtimeRequest.clientPid = PID(0);
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    mRealtimeRequest.clientPid = PID(1);
+    mController->submit(CLIENT(1), SESSION(0), UID(1), UID(0), mRealtimeRequest, mClientCallback1);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(1), SESSION(0)));
+
+    // Resource lost in one session should pause the other one too.
+    mController->onResourceLost(CLIENT(1), SESSION(0));
+    EXPECT_EQ(mResourcePolicy->getPid(), PID(1));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Both should resume when resource is available.
+    mController->onResourceAvailable();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(1), SESSION(0)));
+
+    // Thermal throttling should pause both, and resume both when stopped.
+    mController->onThrottlingStarted();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Pause(CLIENT(1), SESSION(0)));
+    mController->onThrottlingStopped();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(1), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+}
+
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessionsResourceLostNoPolicy) {
+    ALOGD("TestConcurrentSessionsResourceLostNoPolicy");
+    mResourcePolicy.reset();
+    createController(2 /*maxConcurrentSessions*/);
+
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    mController->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+    mController->submit(CLIENT(0), SESSION(2), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Without a resource policy, only the session that lost the resource is paused.
+    mController->onResourceLost(CLIENT(0), SESSION(0));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // It keeps its slot, the other slot is refilled when its session finishes.
+    mController->onFinish(CLIENT(0), SESSION(1));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Finished(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(2)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // Other events do not resume it.
+    mController->submit(CLIENT(0), SESSION(3), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+
+    // It resumes in its slot when the resource is available.
+    mController->onResourceAvailable();
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Resume(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::NoEvent);
+}
+
+TEST_F(TranscodingSessionControllerTest, TestConcurrentSessionsWatchdog) {
+    ALOGD("TestConcurrentSessionsWatchdog");
+    createController(2 /*maxConcurrentSessions*/);
+
+    mController->submit(CLIENT(0), SESSION(0), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(0)));
+    mController->submit(CLIENT(0), SESSION(1), UID(0), UID(0), mRealtimeRequest, mClientCallback0);
+    EXPECT_EQ(mTranscoder->popEvent(), TestTranscoder::Start(CLIENT(0), SESSION(1)));
+    // Both slots created their transcoder.
+    EXPECT_EQ(mTranscoder->getGeneration(), 2);
+
+    // Only keep SESSION(1) alive, SESSION(0) should time out alone after 3 seconds.
+    for (int i = 0; i < 2; i++) {
+        EXPECT_EQ(mTranscoder->popEvent(1000000), TestTranscoder::NoEvent);
+        mController->onHeartBeat(CLIENT(0), SESSION(1));
+    }
+    EXPECT_EQ(mTranscoder->popEvent(900000), TestTranscoder::NoEvent);
+    EXPECT_EQ(mTranscoder->popEvent(300000), TestTranscoder::Abandon(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->popEvent(100000), TestTranscoder::Failed(CLIENT(0), SESSION(0)));
+    EXPECT_EQ(mTranscoder->getLastError(), TranscodingErrorCode::kWatchdogTimeout);
+    // Should have created a new transcoder for SESSION(0)'s slot only.
+    EXPECT_EQ(mTranscoder->getGeneration(), 3);
+
+    // SESSION(1) should time out 3 seconds after its last keep-alive.
+    EXPECT_EQ(mTranscoder->popEvent(1800000), TestTranscoder::NoEvent);
+    EXPECT_EQ(mTranscoder->popEvent(400000), TestTranscoder::Abandon(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->popEvent(100000), TestTranscoder::Failed(CLIENT(0), SESSION(1)));
+    EXPECT_EQ(mTranscoder->getGeneration(), 4);
+}
+
 }  // namespace android
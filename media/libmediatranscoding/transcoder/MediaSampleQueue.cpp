@@ -22,42 +22,92 @@
 
 namespace android {
 
+static size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+MediaSampleQueue::MediaSampleQueue(size_t capacity)
+      : mSamples(roundUpToPowerOfTwo(capacity)), mIndexMask(mSamples.size() - 1) {}
+
 bool MediaSampleQueue::enqueue(const std::shared_ptr<MediaSample>& sample) {
-    std::scoped_lock<std::mutex> lock(mMutex);
-    if (!mAborted) {
-        mSampleQueue.push(sample);
-        mCondition.notify_one();
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mHead.load(std::memory_order_acquire) == mSamples.size()) {
+        waitUntil([this, tail] { return tail - mHead.load() < mSamples.size(); });
     }
-    return mAborted;
+
+    if (mAborted) {
+        return true;
+    }
+    mSamples[tail & mIndexMask] = sample;
+    mTail.store(tail + 1);
+    notifyWaiters();
+    return false;
 }
 
-// Unfortunately std::unique_lock is incompatible with -Wthread-safety
-bool MediaSampleQueue::dequeue(std::shared_ptr<MediaSample>* sample) NO_THREAD_SAFETY_ANALYSIS {
-    std::unique_lock<std::mutex> lock(mMutex);
-    while (mSampleQueue.empty() && !mAborted) {
-        mCondition.wait(lock);
+bool MediaSampleQueue::dequeue(std::shared_ptr<MediaSample>* sample) {
+    std::unique_lock<std::mutex> lock(mConsumerMutex);
+    size_t head = mHead.load(std::memory_order_relaxed);
+    if (head == mTail.load(std::memory_order_acquire) && !mAborted) {
+        // Don't block abort() while waiting.
+        lock.unlock();
+        waitUntil([this, head] { return mTail.load() != head; });
+        lock.lock();
     }
 
-    if (!mAborted) {
-        if (sample != nullptr) {
-            *sample = mSampleQueue.front();
-        }
-        mSampleQueue.pop();
+    if (mAborted) {
+        return true;
     }
-    return mAborted;
+    if (sample != nullptr) {
+        *sample = std::move(mSamples[head & mIndexMask]);
+    } else {
+        mSamples[head & mIndexMask].reset();
+    }
+    mHead.store(head + 1);
+    notifyWaiters();
+    return false;
 }
 
 bool MediaSampleQueue::isEmpty() {
-    std::scoped_lock<std::mutex> lock(mMutex);
-    return mSampleQueue.empty();
+    return mAborted || mHead.load() == mTail.load();
 }
 
 void MediaSampleQueue::abort() {
-    std::scoped_lock<std::mutex> lock(mMutex);
-    // Clear the queue and notify consumers.
-    std::queue<std::shared_ptr<MediaSample>> empty = {};
-    std::swap(mSampleQueue, empty);
+    std::scoped_lock<std::mutex> lock(mConsumerMutex);
     mAborted = true;
-    mCondition.notify_all();
+
+    // Clear the queue. A sample being enqueued concurrently is released with the queue.
+    const size_t tail = mTail.load(std::memory_order_acquire);
+    for (size_t head = mHead.load(std::memory_order_relaxed); head != tail; ++head) {
+        mSamples[head & mIndexMask].reset();
+    }
+    mHead.store(tail, std::memory_order_release);
+
+    // Notify producers and consumers.
+    { std::scoped_lock<std::mutex> waitLock(mWaitMutex); }
+    mWaitCondition.notify_all();
+}
+
+// Unfortunately std::unique_lock is incompatible with -Wthread-safety
+template <typename Predicate>
+void MediaSampleQueue::waitUntil(Predicate isReady) NO_THREAD_SAFETY_ANALYSIS {
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+    mWaiterCount.fetch_add(1);
+    mWaitCondition.wait(lock, [this, &isReady] { return isReady() || mAborted; });
+    mWaiterCount.fetch_sub(1);
 }
-}  // namespace android
\ No newline at end of file
+
+void MediaSampleQueue::notifyWaiters() {
+    // The index update and this load are sequentially consistent, as are the waiter count
+    // increment and the index load in waitUntil(). Either the waiter sees the new index or we see
+    // the waiter.
+    if (mWaiterCount.load() > 0) {
+        { std::scoped_lock<std::mutex> lock(mWaitMutex); }
+        mWaitCondition.notify_all();
+    }
+}
+
+}  // namespace android
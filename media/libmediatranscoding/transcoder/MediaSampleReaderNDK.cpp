@@ -20,6 +20,9 @@
 #include <android-base/logging.h>
 #include <media/MediaSampleReaderNDK.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <algorithm>
 #include <cmath>
 
@@ -30,8 +33,7 @@ static_assert(SAMPLE_FLAG_SYNC_SAMPLE == AMEDIAEXTRACTOR_SAMPLE_FLAG_SYNC,
               "Sample flag mismatch: SYNC_SAMPLE");
 
 // static
-std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, size_t offset,
-                                                                      size_t size) {
+AMediaExtractor* MediaSampleReaderNDK::createExtractor(int fd, size_t offset, size_t size) {
     AMediaExtractor* extractor = AMediaExtractor_new();
     if (extractor == nullptr) {
         LOG(ERROR) << "Unable to allocate AMediaExtractor";
@@ -45,21 +47,72 @@ std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, si
         return nullptr;
     }
 
-    auto sampleReader = std::shared_ptr<MediaSampleReaderNDK>(new MediaSampleReaderNDK(extractor));
+    return extractor;
+}
+
+// static
+std::shared_ptr<MediaSampleReader> MediaSampleReaderNDK::createFromFd(int fd, size_t offset,
+                                                                      size_t size,
+                                                                      bool extractorPerTrack) {
+    AMediaExtractor* extractor = createExtractor(fd, offset, size);
+    if (extractor == nullptr) {
+        return nullptr;
+    }
+
+    // Keep the source open to create the track extractors as the tracks get selected.
+    // The track extractors share the file offset of this fd, which is safe as long as
+    // FileSource reads with pread().
+    int sourceFd = -1;
+    if (extractorPerTrack) {
+        sourceFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+        if (sourceFd < 0) {
+            PLOG(ERROR) << "Unable to duplicate source fd " << fd;
+            AMediaExtractor_delete(extractor);
+            return nullptr;
+        }
+    }
+
+    auto sampleReader = std::shared_ptr<MediaSampleReaderNDK>(
+            new MediaSampleReaderNDK(extractor, sourceFd, offset, size));
     return sampleReader;
 }
 
-MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor)
-      : mExtractor(extractor), mTrackCount(AMediaExtractor_getTrackCount(mExtractor)) {
+MediaSampleReaderNDK::MediaSampleReaderNDK(AMediaExtractor* extractor, int sourceFd,
+                                           size_t sourceOffset, size_t sourceSize)
+      : mExtractor(extractor),
+        mTrackCount(AMediaExtractor_getTrackCount(mExtractor)),
+        mSourceFd(sourceFd),
+        mSourceOffset(sourceOffset),
+        mSourceSize(sourceSize) {
     if (mTrackCount > 0) {
         mTrackCursors.resize(mTrackCount);
+        if (mSourceFd >= 0) {
+            mTrackExtractors.resize(mTrackCount);
+        }
     }
 }
 
 MediaSampleReaderNDK::~MediaSampleReaderNDK() {
+    mTrackExtractors.clear();
     if (mExtractor != nullptr) {
         AMediaExtractor_delete(mExtractor);
     }
+    if (mSourceFd >= 0) {
+        close(mSourceFd);
+    }
+}
+
+MediaSampleReaderNDK::TrackExtractor::~TrackExtractor() {
+    if (extractor != nullptr) {
+        AMediaExtractor_delete(extractor);
+    }
+}
+
+MediaSampleReaderNDK::TrackExtractor* MediaSampleReaderNDK::getTrackExtractor(int trackIndex) {
+    if (mTrackExtractors.empty() || trackIndex < 0 || trackIndex >= mTrackCount) {
+        return nullptr;
+    }
+    return mTrackExtractors[trackIndex].get();
 }
 
 void MediaSampleReaderNDK::advanceTrack_l(int trackIndex) {
@@ -232,6 +285,23 @@ media_status_t MediaSampleReaderNDK::selectTrack(int trackIndex) {
         return status;
     }
 
+    if (!mTrackExtractors.empty()) {
+        auto trackExtractor = std::make_unique<TrackExtractor>();
+        trackExtractor->extractor = createExtractor(mSourceFd, mSourceOffset, mSourceSize);
+        if (trackExtractor->extractor == nullptr) {
+            AMediaExtractor_unselectTrack(mExtractor, trackIndex);
+            return AMEDIA_ERROR_UNKNOWN;
+        }
+
+        status = AMediaExtractor_selectTrack(trackExtractor->extractor, trackIndex);
+        if (status != AMEDIA_OK) {
+            LOG(ERROR) << "AMediaExtractor_selectTrack returned error: " << status;
+            AMediaExtractor_unselectTrack(mExtractor, trackIndex);
+            return status;
+        }
+        mTrackExtractors[trackIndex] = std::move(trackExtractor);
+    }
+
     mTrackSignals.emplace(std::piecewise_construct, std::forward_as_tuple(trackIndex),
                           std::forward_as_tuple());
     return AMEDIA_OK;
@@ -254,6 +324,9 @@ media_status_t MediaSampleReaderNDK::unselectTrack(int trackIndex) {
         return AMEDIA_ERROR_INVALID_PARAMETER;
     }
     mTrackSignals.erase(it);
+    if (!mTrackExtractors.empty()) {
+        mTrackExtractors[trackIndex].reset();
+    }
 
     media_status_t status = AMediaExtractor_unselectTrack(mExtractor, trackIndex);
     if (status != AMEDIA_OK) {
@@ -269,6 +342,11 @@ media_status_t MediaSampleReaderNDK::setEnforceSequentialAccess(bool enforce) {
 
     std::scoped_lock lock(mExtractorMutex);
 
+    if (!mTrackExtractors.empty()) {
+        // The tracks are read independently of each other.
+        return AMEDIA_OK;
+    }
+
     if (mEnforceSequentialAccess && !enforce) {
         // If switching from enforcing to not enforcing sequential access there may be threads
         // waiting that needs to be woken up.
@@ -388,7 +466,30 @@ media_status_t MediaSampleReaderNDK::getEstimatedBitrateForTrack(int trackIndex,
     return AMEDIA_OK;
 }
 
+media_status_t MediaSampleReaderNDK::getSampleInfoFromTrackExtractor(
+        TrackExtractor* trackExtractor, MediaSampleInfo* info) {
+    std::scoped_lock lock(trackExtractor->mutex);
+    AMediaExtractor* extractor = trackExtractor->extractor;
+
+    if (AMediaExtractor_getSampleTrackIndex(extractor) < 0) {
+        info->presentationTimeUs = 0;
+        info->flags = SAMPLE_FLAG_END_OF_STREAM;
+        info->size = 0;
+        return AMEDIA_ERROR_END_OF_STREAM;
+    }
+
+    info->presentationTimeUs = AMediaExtractor_getSampleTime(extractor);
+    info->flags = AMediaExtractor_getSampleFlags(extractor);
+    info->size = AMediaExtractor_getSampleSize(extractor);
+    return AMEDIA_OK;
+}
+
 media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, MediaSampleInfo* info) {
+    TrackExtractor* trackExtractor = getTrackExtractor(trackIndex);
+    if (trackExtractor != nullptr && info != nullptr) {
+        return getSampleInfoFromTrackExtractor(trackExtractor, info);
+    }
+
     std::unique_lock<std::mutex> lock(mExtractorMutex);
 
     if (mTrackSignals.find(trackIndex) == mTrackSignals.end()) {
@@ -416,8 +517,38 @@ media_status_t MediaSampleReaderNDK::getSampleInfoForTrack(int trackIndex, Media
     return status;
 }
 
+media_status_t MediaSampleReaderNDK::readSampleDataFromTrackExtractor(
+        TrackExtractor* trackExtractor, uint8_t* buffer, size_t bufferSize) {
+    std::scoped_lock lock(trackExtractor->mutex);
+    AMediaExtractor* extractor = trackExtractor->extractor;
+
+    if (AMediaExtractor_getSampleTrackIndex(extractor) < 0) {
+        return AMEDIA_ERROR_END_OF_STREAM;
+    }
+
+    ssize_t sampleSize = AMediaExtractor_getSampleSize(extractor);
+    if (bufferSize < sampleSize) {
+        LOG(ERROR) << "Buffer is too small for sample, " << bufferSize << " vs " << sampleSize;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    ssize_t bytesRead = AMediaExtractor_readSampleData(extractor, buffer, bufferSize);
+    if (bytesRead < sampleSize) {
+        LOG(ERROR) << "Unable to read full sample, " << bytesRead << " vs " << sampleSize;
+        return AMEDIA_ERROR_INVALID_PARAMETER;
+    }
+
+    AMediaExtractor_advance(extractor);
+    return AMEDIA_OK;
+}
+
 media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint8_t* buffer,
                                                             size_t bufferSize) {
+    TrackExtractor* trackExtractor = getTrackExtractor(trackIndex);
+    if (trackExtractor != nullptr && buffer != nullptr) {
+        return readSampleDataFromTrackExtractor(trackExtractor, buffer, bufferSize);
+    }
+
     std::unique_lock<std::mutex> lock(mExtractorMutex);
 
     if (mTrackSignals.find(trackIndex) == mTrackSignals.end()) {
@@ -451,6 +582,13 @@ media_status_t MediaSampleReaderNDK::readSampleDataForTrack(int trackIndex, uint
 }
 
 void MediaSampleReaderNDK::advanceTrack(int trackIndex) {
+    TrackExtractor* trackExtractor = getTrackExtractor(trackIndex);
+    if (trackExtractor != nullptr) {
+        std::scoped_lock lock(trackExtractor->mutex);
+        AMediaExtractor_advance(trackExtractor->extractor);
+        return;
+    }
+
     std::scoped_lock lock(mExtractorMutex);
 
     if (mTrackSignals.find(trackIndex) != mTrackSignals.end()) {
@@ -105,6 +105,10 @@ void MediaTrackTranscoder::stop(bool stopOnSyncSample) {
     if (mState == STARTED || (mStopRequest == STOP_ON_SYNC && !stopOnSyncSample)) {
         mStopRequest = stopOnSyncSample ? STOP_ON_SYNC : STOP_NOW;
         abortTranscodeLoop();
+        if (!stopOnSyncSample) {
+            // Unblock the transcode loop if it waits for room in the sample queue.
+            mSampleQueue.abort();
+        }
         mState = STOPPED;
     } else {
         LOG(WARNING) << "TrackTranscoder must be started before stopped";
@@ -118,11 +122,15 @@ void MediaTrackTranscoder::notifyTrackFormatAvailable() {
 }
 
 void MediaTrackTranscoder::onOutputSampleAvailable(const std::shared_ptr<MediaSample>& sample) {
+    // Samples always go through the queue to keep them in order. Enqueue blocks while the queue
+    // is full, so don't hold the lock, setSampleConsumer() needs it to drain the queue.
+    if (mSampleQueue.enqueue(sample)) {
+        return;
+    }
+
     std::scoped_lock lock{mSampleMutex};
-    if (mSampleConsumer == nullptr) {
-        mSampleQueue.enqueue(sample);
-    } else {
-        mSampleConsumer(sample);
+    if (mSampleConsumer != nullptr) {
+        drainSampleQueue_l();
     }
 }
 
@@ -130,7 +138,10 @@ void MediaTrackTranscoder::setSampleConsumer(
         const MediaSampleWriter::MediaSampleConsumerFunction& sampleConsumer) {
     std::scoped_lock lock{mSampleMutex};
     mSampleConsumer = sampleConsumer;
+    drainSampleQueue_l();
+}
 
+void MediaTrackTranscoder::drainSampleQueue_l() {
     std::shared_ptr<MediaSample> sample;
     while (!mSampleQueue.isEmpty() && !mSampleQueue.dequeue(&sample)) {
         mSampleConsumer(sample);
@@ -42,7 +42,8 @@
 using namespace android;
 
 static void ReadMediaSamples(benchmark::State& state, const std::string& srcFileName,
-                             bool readAudio, bool sequentialAccess = false) {
+                             bool readAudio, bool sequentialAccess = false,
+                             bool extractorPerTrack = false) {
     // Asset directory.
     static const std::string kAssetDirectory = "/data/local/tmp/TranscodingBenchmark/";
 
@@ -58,7 +59,8 @@ static void ReadMediaSamples(benchmark::State& state, const std::string& srcFile
     lseek(srcFd, 0, SEEK_SET);
 
     for (auto _ : state) {
-        auto sampleReader = MediaSampleReaderNDK::createFromFd(srcFd, 0, fileSize);
+        auto sampleReader =
+                MediaSampleReaderNDK::createFromFd(srcFd, 0, fileSize, extractorPerTrack);
         if (sampleReader->setEnforceSequentialAccess(sequentialAccess) != AMEDIA_OK) {
             state.SkipWithError("setEnforceSequentialAccess failed");
             return;
@@ -142,13 +144,30 @@ static void BM_MediaSampleReader_AudioVideo_Sequential(benchmark::State& state)
                      true /* readAudio */, true /* sequentialAccess */);
 }
 
+static void BM_MediaSampleReader_AudioVideo_ExtractorPerTrack(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     true /* readAudio */, false /* sequentialAccess */,
+                     true /* extractorPerTrack */);
+}
+
 static void BM_MediaSampleReader_Video(benchmark::State& state) {
     ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
                      false /* readAudio */);
 }
 
+static void BM_MediaSampleReader_Video_ExtractorPerTrack(benchmark::State& state) {
+    ReadMediaSamples(state, "video_1920x1080_3648frame_h264_22Mbps_30fps_aac.mp4",
+                     false /* readAudio */, false /* sequentialAccess */,
+                     true /* extractorPerTrack */);
+}
+
+// Interleaved audio and video tracks.
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Parallel);
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_Sequential);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_AudioVideo_ExtractorPerTrack);
+
+// Single video track.
 TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video);
+TRANSCODER_BENCHMARK(BM_MediaSampleReader_Video_ExtractorPerTrack);
 
 BENCHMARK_MAIN();
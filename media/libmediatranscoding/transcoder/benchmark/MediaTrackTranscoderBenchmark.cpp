@@ -36,6 +36,7 @@
 #include <android/binder_process.h>
 #include <benchmark/benchmark.h>
 #include <fcntl.h>
+#include <media/MediaSampleQueue.h>
 #include <media/MediaSampleReader.h>
 #include <media/MediaSampleReaderNDK.h>
 #include <media/MediaTrackTranscoder.h>
@@ -44,6 +45,9 @@
 #include <media/PassthroughTrackTranscoder.h>
 #include <media/VideoTrackTranscoder.h>
 
+#include <atomic>
+#include <thread>
+
 using namespace android;
 
 typedef enum {
@@ -432,6 +436,65 @@ static void BM_VideoTranscode_HEVC2AVC_NoExtractor(benchmark::State& state) {
     BenchmarkTranscoderWithOperatingRate(state, srcFile, true /* mockReader */, kVideo);
 }
 
+//-------------------------------- Sample Queue Benchmarks -----------------------------------------
+
+/**
+ * Passes samples from a producer thread to a consumer through a MediaSampleQueue of the given
+ * capacity, with the consumer starting late as when the sample writer is not ready yet. Reports
+ * the sample rate and the peak memory held by samples in flight. The largest capacity holds all
+ * samples, as the queue did before it was bounded.
+ */
+static void BM_SampleQueue(benchmark::State& state) {
+    static constexpr uint32_t kSampleCount = 4096;
+    static constexpr size_t kSampleSize = 64 * 1024;
+    static constexpr auto kConsumerDelay = std::chrono::milliseconds(20);
+
+    const size_t capacity = state.range(0);
+    std::atomic_size_t queuedBytes = 0;
+    size_t peakQueuedBytes = 0;
+
+    for (auto _ : state) {
+        MediaSampleQueue queue(capacity);
+
+        std::thread producer([&queue, &queuedBytes, &peakQueuedBytes] {
+            for (uint32_t id = 0; id < kSampleCount; ++id) {
+                uint8_t* buffer = new uint8_t[kSampleSize];
+                memset(buffer, id, kSampleSize);
+                const size_t bytes = queuedBytes.fetch_add(kSampleSize) + kSampleSize;
+                peakQueuedBytes = std::max(peakQueuedBytes, bytes);
+
+                auto sample = MediaSample::createWithReleaseCallback(
+                        buffer, 0 /* offset */, id, [&queuedBytes](MediaSample* sample) {
+                            delete[] sample->buffer;
+                            queuedBytes.fetch_sub(kSampleSize);
+                        });
+                sample->info.size = kSampleSize;
+                if (queue.enqueue(sample)) {
+                    return;
+                }
+            }
+        });
+
+        std::this_thread::sleep_for(kConsumerDelay);
+        uint64_t checksum = 0;
+        for (uint32_t id = 0; id < kSampleCount; ++id) {
+            std::shared_ptr<MediaSample> sample;
+            if (queue.dequeue(&sample)) {
+                break;
+            }
+            for (size_t i = 0; i < sample->info.size; i += 64) {
+                checksum += sample->buffer[i];
+            }
+        }
+        benchmark::DoNotOptimize(checksum);
+        producer.join();
+    }
+
+    state.counters["SampleRate"] = benchmark::Counter(state.iterations() * kSampleCount,
+                                                      benchmark::Counter::kIsRate);
+    state.counters["PeakQueuedBytes"] = peakQueuedBytes;
+}
+
 //-------------------------------- Benchmark Registration ------------------------------------------
 
 // Benchmark registration wrapper for transcoding.
@@ -453,4 +516,10 @@ TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_AVC2AVC_NoExtractor);
 TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_HEVC2AVC);
 TRANSCODER_OPERATING_RATE_BENCHMARK(BM_VideoTranscode_HEVC2AVC_NoExtractor);
 
+TRANSCODER_BENCHMARK(BM_SampleQueue)
+        ->Arg(4)
+        ->Arg(16)
+        ->Arg(MediaSampleQueue::kDefaultCapacity)
+        ->Arg(4096); /* <-- Holds all samples */
+
 BENCHMARK_MAIN();
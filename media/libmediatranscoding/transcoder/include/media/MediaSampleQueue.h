@@ -20,22 +20,38 @@
 #include <media/MediaSample.h>
 #include <utils/Mutex.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
-#include <queue>
+#include <vector>
 
 namespace android {
 
 /**
  * MediaSampleQueue asynchronously connects a producer and a consumer of media samples.
  * Media samples flows through the queue in FIFO order. If the queue is empty the consumer will be
- * blocked until a new media sample is added or until the producer aborts the queue operation.
+ * blocked until a new media sample is added or until the producer aborts the queue operation. If
+ * the queue is full the producer will be blocked until the consumer removes a media sample or
+ * until the queue operation is aborted.
+ *
+ * The queue is a ring buffer for a single producer thread and a single consumer thread, which
+ * only synchronize with each other when the queue is empty or full.
  */
 class MediaSampleQueue {
 public:
+    /** Default maximum number of media samples in the queue. */
+    static constexpr size_t kDefaultCapacity = 64;
+
+    /**
+     * Creates a queue holding at most capacity media samples (rounded up to a power of two).
+     */
+    explicit MediaSampleQueue(size_t capacity = kDefaultCapacity);
+
     /**
      * Enqueues a media sample at the end of the queue and notifies potentially waiting consumers.
-     * If the queue has previously been aborted this method does nothing.
+     * If the queue has previously been aborted this method does nothing. Note that this method
+     * will block while the queue is full.
      * @param sample The media sample to enqueue.
      * @return True if the queue has been aborted.
      */
@@ -56,16 +72,38 @@ public:
     bool isEmpty();
 
     /**
-     * Aborts the queue operation. This clears the queue and notifies waiting consumers. After the
-     * has been aborted it is not possible to enqueue more samples, and dequeue will return null.
+     * Aborts the queue operation. This clears the queue and notifies waiting producers and
+     * consumers. After the has been aborted it is not possible to enqueue more samples, and dequeue
+     * will return null.
      */
     void abort();
 
+    /** Returns the maximum number of media samples in the queue. */
+    size_t getCapacity() const { return mSamples.size(); }
+
 private:
-    std::queue<std::shared_ptr<MediaSample>> mSampleQueue GUARDED_BY(mMutex);
-    std::mutex mMutex;
-    std::condition_variable mCondition;
-    bool mAborted GUARDED_BY(mMutex) = false;
+    // Blocks until isReady returns true or the queue is aborted.
+    template <typename Predicate>
+    void waitUntil(Predicate isReady);
+    // Wakes up a blocked producer or consumer.
+    void notifyWaiters();
+
+    std::vector<std::shared_ptr<MediaSample>> mSamples;
+    const size_t mIndexMask;
+
+    // Index of the next sample to dequeue, only written by the consumer.
+    alignas(64) std::atomic<size_t> mHead{0};
+    // Index of the next sample to enqueue, only written by the producer.
+    alignas(64) std::atomic<size_t> mTail{0};
+    alignas(64) std::atomic<bool> mAborted{false};
+
+    // Serializes dequeue and abort, which both remove samples from the queue.
+    std::mutex mConsumerMutex;
+
+    // Only used to block when the queue is empty or full.
+    std::mutex mWaitMutex;
+    std::condition_variable mWaitCondition;
+    std::atomic<int32_t> mWaiterCount{0};
 };
 
 }  // namespace android
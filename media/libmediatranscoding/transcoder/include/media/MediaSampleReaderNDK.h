@@ -39,10 +39,13 @@ public:
      *           to do so when this method returns.
      * @param offset Source data offset.
      * @param size Source data size.
+     * @param extractorPerTrack Reads each selected track through its own extractor, so that the
+     *        tracks never wait for each other. Sequential access is not enforced in this mode.
      * @return A shared pointer referencing the new MediaSampleReaderNDK instance on success, or an
      *         empty shared pointer if an error occurred.
      */
-    static std::shared_ptr<MediaSampleReader> createFromFd(int fd, size_t offset, size_t size);
+    static std::shared_ptr<MediaSampleReader> createFromFd(int fd, size_t offset, size_t size,
+                                                           bool extractorPerTrack = false);
 
     AMediaFormat* getFileFormat() override;
     size_t getTrackCount() const override;
@@ -89,12 +92,42 @@ private:
         SamplePosition next;
     };
 
+    /**
+     * TrackExtractor reads the samples of a single selected track when the reader has an extractor
+     * per track. Its mutex only serializes the accesses to that track.
+     */
+    struct TrackExtractor {
+        AMediaExtractor* extractor = nullptr;
+        std::mutex mutex;
+
+        ~TrackExtractor();
+    };
+
     /**
      * Creates a new MediaSampleReaderNDK object from an AMediaExtractor. The extractor needs to be
      * initialized with a valid data source before attempting to create a MediaSampleReaderNDK.
      * @param extractor The initialized media extractor.
+     * @param sourceFd Duplicate of the source fd to open the track extractors from, or -1 to read
+     *        all tracks through the one extractor. The reader takes ownership of the fd.
+     * @param sourceOffset Source data offset.
+     * @param sourceSize Source data size.
      */
-    MediaSampleReaderNDK(AMediaExtractor* extractor);
+    MediaSampleReaderNDK(AMediaExtractor* extractor, int sourceFd = -1, size_t sourceOffset = 0,
+                         size_t sourceSize = 0);
+
+    /** Creates an extractor for the source, or returns null on error. */
+    static AMediaExtractor* createExtractor(int fd, size_t offset, size_t size);
+
+    /** Returns the extractor of a selected track in extractor per track mode, or null. */
+    TrackExtractor* getTrackExtractor(int trackIndex);
+
+    /** Implementation of getSampleInfoForTrack in extractor per track mode. */
+    media_status_t getSampleInfoFromTrackExtractor(TrackExtractor* trackExtractor,
+                                                   MediaSampleInfo* info);
+
+    /** Implementation of readSampleDataForTrack in extractor per track mode. */
+    media_status_t readSampleDataFromTrackExtractor(TrackExtractor* trackExtractor,
+                                                    uint8_t* buffer, size_t bufferSize);
 
     /** Advances the track to next sample. */
     void advanceTrack_l(int trackIndex);
@@ -135,6 +168,15 @@ private:
 
     // Samples cursor for each track in the file.
     std::vector<SampleCursor> mTrackCursors;
+
+    // Source of the track extractors, -1 unless the reader has an extractor per track.
+    const int mSourceFd;
+    const size_t mSourceOffset;
+    const size_t mSourceSize;
+
+    // Extractor of each selected track in extractor per track mode. Only modified while selecting
+    // tracks, so each track can look up its own extractor without holding mExtractorMutex.
+    std::vector<std::unique_ptr<TrackExtractor>> mTrackExtractors;
 };
 
 }  // namespace android
@@ -133,9 +133,13 @@ protected:
     std::atomic<StopRequest> mStopRequest = NONE;
 
 private:
+    // Passes the queued output samples to the sample consumer.
+    void drainSampleQueue_l() REQUIRES(mSampleMutex);
+
     std::mutex mSampleMutex;
-    // SampleQueue for buffering output samples before a sample consumer has been set.
-    MediaSampleQueue mSampleQueue GUARDED_BY(mSampleMutex);
+    // SampleQueue for buffering output samples until the sample consumer takes them. Its bounded
+    // capacity stalls the transcoder while no sample consumer has been set.
+    MediaSampleQueue mSampleQueue;
     MediaSampleWriter::MediaSampleConsumerFunction mSampleConsumer GUARDED_BY(mSampleMutex);
     const std::weak_ptr<MediaTrackTranscoderCallback> mTranscoderCallback;
     std::mutex mStateMutex;
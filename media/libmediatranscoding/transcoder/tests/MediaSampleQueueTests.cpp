@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include <media/MediaSampleQueue.h>
 
+#include <atomic>
 #include <thread>
 
 namespace android {
@@ -229,6 +230,114 @@ TEST_F(MediaSampleQueueTests, TestBlockingAbort) {
     abortingThread.join();
 }
 
+TEST_F(MediaSampleQueueTests, TestCapacity) {
+    LOG(DEBUG) << "TestCapacity Starts";
+
+    EXPECT_EQ(MediaSampleQueue().getCapacity(), MediaSampleQueue::kDefaultCapacity);
+    EXPECT_EQ(MediaSampleQueue(1).getCapacity(), 1u);
+    EXPECT_EQ(MediaSampleQueue(5).getCapacity(), 8u);
+    EXPECT_EQ(MediaSampleQueue(16).getCapacity(), 16u);
+}
+
+TEST_F(MediaSampleQueueTests, TestWrapAroundDequeueOrder) {
+    LOG(DEBUG) << "TestWrapAroundDequeueOrder Starts";
+
+    static constexpr int kCapacity = 4;
+    static constexpr int kNumSamples = 4 * kCapacity + 1;
+    MediaSampleQueue sampleQueue(kCapacity);
+
+    // Keep the queue between one and three samples deep while the indices wrap around.
+    int nextId = 0;
+    for (int i = 0; i < kNumSamples; ++i) {
+        while (nextId < kNumSamples && nextId - i < kCapacity - 1) {
+            EXPECT_FALSE(sampleQueue.enqueue(newSample(nextId++)));
+        }
+
+        std::shared_ptr<MediaSample> sample;
+        bool aborted = sampleQueue.dequeue(&sample);
+        EXPECT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+        EXPECT_FALSE(aborted);
+    }
+    EXPECT_TRUE(sampleQueue.isEmpty());
+}
+
+TEST_F(MediaSampleQueueTests, TestBlockingEnqueue) {
+    LOG(DEBUG) << "TestBlockingEnqueue Starts";
+
+    static constexpr int kCapacity = 2;
+    MediaSampleQueue sampleQueue(kCapacity);
+    for (int i = 0; i < kCapacity; ++i) {
+        EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+    }
+
+    std::atomic_bool enqueued = false;
+    std::thread enqueueThread([&sampleQueue, &enqueued] {
+        bool aborted = sampleQueue.enqueue(newSample(kCapacity));
+        EXPECT_FALSE(aborted);
+        enqueued = true;
+    });
+
+    // Note: This is a bit racy, see TestBlockingDequeue. The test will not fail regardless.
+    std::this_thread::sleep_for(std::chrono::milliseconds(kThreadDelayDurationMs));
+    EXPECT_FALSE(enqueued);
+
+    for (int i = 0; i <= kCapacity; ++i) {
+        std::shared_ptr<MediaSample> sample;
+        bool aborted = sampleQueue.dequeue(&sample);
+        EXPECT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+        EXPECT_FALSE(aborted);
+    }
+    EXPECT_TRUE(sampleQueue.isEmpty());
+
+    enqueueThread.join();
+    EXPECT_TRUE(enqueued);
+}
+
+TEST_F(MediaSampleQueueTests, TestBlockingEnqueueAbort) {
+    LOG(DEBUG) << "TestBlockingEnqueueAbort Starts";
+
+    MediaSampleQueue sampleQueue(1);
+    EXPECT_FALSE(sampleQueue.enqueue(newSample(0)));
+
+    std::thread abortingThread([&sampleQueue] {
+        // Note: This is a bit racy, see TestBlockingAbort. The test will not fail regardless.
+        std::this_thread::sleep_for(std::chrono::milliseconds(kThreadDelayDurationMs));
+        sampleQueue.abort();
+    });
+
+    bool aborted = sampleQueue.enqueue(newSample(1));
+    EXPECT_TRUE(aborted);
+    EXPECT_TRUE(sampleQueue.isEmpty());
+
+    abortingThread.join();
+}
+
+TEST_F(MediaSampleQueueTests, TestConcurrentProducerConsumer) {
+    LOG(DEBUG) << "TestConcurrentProducerConsumer Starts";
+
+    static constexpr int kNumSamples = 10000;
+    MediaSampleQueue sampleQueue(8);
+
+    std::thread enqueueThread([&sampleQueue] {
+        for (int i = 0; i < kNumSamples; ++i) {
+            EXPECT_FALSE(sampleQueue.enqueue(newSample(i)));
+        }
+    });
+
+    for (int i = 0; i < kNumSamples; ++i) {
+        std::shared_ptr<MediaSample> sample;
+        bool aborted = sampleQueue.dequeue(&sample);
+        ASSERT_NE(sample, nullptr);
+        EXPECT_EQ(sample->bufferId, i);
+        EXPECT_FALSE(aborted);
+    }
+    EXPECT_TRUE(sampleQueue.isEmpty());
+
+    enqueueThread.join();
+}
+
 }  // namespace android
 
 int main(int argc, char** argv) {
@@ -84,8 +84,9 @@ static constexpr int SAMPLE_COUNT_ALL = -1;
  */
 class SampleAccessTester {
 public:
-    SampleAccessTester(int sourceFd, size_t fileSize) {
-        mSampleReader = MediaSampleReaderNDK::createFromFd(sourceFd, 0, fileSize);
+    SampleAccessTester(int sourceFd, size_t fileSize, bool extractorPerTrack = false) {
+        mSampleReader =
+                MediaSampleReaderNDK::createFromFd(sourceFd, 0, fileSize, extractorPerTrack);
         EXPECT_TRUE(mSampleReader);
 
         mTrackCount = mSampleReader->getTrackCount();
@@ -315,6 +316,54 @@ TEST_F(MediaSampleReaderNDKTests, TestSequentialSampleAccess) {
     compareSamples(tester.getSamples());
 }
 
+/** Reads all samples from all tracks in parallel, with an extractor per track. */
+TEST_F(MediaSampleReaderNDKTests, TestExtractorPerTrackSampleAccess) {
+    LOG(DEBUG) << "TestExtractorPerTrackSampleAccess Starts";
+
+    SampleAccessTester tester{mSourceFd, mFileSize, true /* extractorPerTrack */};
+    tester.readSamplesAsync(SAMPLE_COUNT_ALL);
+    tester.waitForTracks();
+    compareSamples(tester.getSamples());
+}
+
+/**
+ * Reads all tracks in parallel with an extractor per track, from two readers at once, many times
+ * over. All track extractors read the same file concurrently, so a read of one track landing at
+ * the position of another shows up as sample data differing from the single extractor's.
+ */
+TEST_F(MediaSampleReaderNDKTests, TestExtractorPerTrackConcurrentReads) {
+    LOG(DEBUG) << "TestExtractorPerTrackConcurrentReads Starts";
+    initExtractorSamples();
+
+    static constexpr int kIterations = 50;
+    for (int iteration = 0; iteration < kIterations && !HasFailure(); ++iteration) {
+        SampleAccessTester tester1{mSourceFd, mFileSize, true /* extractorPerTrack */};
+        SampleAccessTester tester2{mSourceFd, mFileSize, true /* extractorPerTrack */};
+        tester1.readSamplesAsync(SAMPLE_COUNT_ALL);
+        tester2.readSamplesAsync(SAMPLE_COUNT_ALL);
+        tester1.waitForTracks();
+        tester2.waitForTracks();
+        compareSamples(tester1.getSamples());
+        compareSamples(tester2.getSamples());
+        if (HasFailure()) {
+            LOG(ERROR) << "Sample mismatch in iteration " << iteration;
+        }
+    }
+}
+
+/** Reads the tracks one after the other with an extractor per track, ignoring sequential mode. */
+TEST_F(MediaSampleReaderNDKTests, TestExtractorPerTrackTrackOrder) {
+    LOG(DEBUG) << "TestExtractorPerTrackTrackOrder Starts";
+
+    SampleAccessTester tester{mSourceFd, mFileSize, true /* extractorPerTrack */};
+    tester.setEnforceSequentialAccess(true);
+    for (int trackIndex = mTrackCount - 1; trackIndex >= 0; --trackIndex) {
+        tester.readSamplesAsync(trackIndex, SAMPLE_COUNT_ALL);
+        tester.waitForTrack(trackIndex);
+    }
+    compareSamples(tester.getSamples());
+}
+
 /** Reads all samples from one track in parallel mode before switching to sequential mode. */
 TEST_F(MediaSampleReaderNDKTests, TestMixedSampleAccessTrackEOS) {
     LOG(DEBUG) << "TestMixedSampleAccessTrackEOS Starts";
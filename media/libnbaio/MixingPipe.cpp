@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MixingPipe"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <sched.h>
+#include <string.h>
+
+#include <audio_utils/primitives.h>
+#include <audio_utils/roundup.h>
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/MixingPipe.h>
+
+namespace android {
+
+MixingPipe::MixingPipe(size_t maxFrames, const NBAIO_Format& format, size_t maxWriters) :
+        mFormat(format),
+        mMaxFrames(roundup(maxFrames)),
+        mChannelCount(Format_channelCount(format)),
+        mMaxWriters(maxWriters),
+        mBuffer(new float[mMaxFrames * mChannelCount]()),
+        mLaneBuffers(new float[mMaxWriters * mMaxFrames * mChannelCount]()),
+        mLanes(new Lane[mMaxWriters])
+{
+    LOG_ALWAYS_FATAL_IF(format.mFormat != AUDIO_FORMAT_PCM_FLOAT,
+            "%s: format %#x is not supported", __func__, format.mFormat);
+    LOG_ALWAYS_FATAL_IF(maxWriters == 0 || maxWriters > kMaxWriters,
+            "%s: invalid maxWriters %zu", __func__, maxWriters);
+    for (size_t i = 0; i < mMaxWriters; i++) {
+        mLanes[i].mBuffer = &mLaneBuffers[i * mMaxFrames * mChannelCount];
+    }
+}
+
+MixingPipe::~MixingPipe()
+{
+    ALOG_ASSERT(mLaneMask.load() == 0);
+    ALOG_ASSERT(mReaders.load() == 0);
+}
+
+int MixingPipe::attach()
+{
+    const uint32_t allLanes = mMaxWriters == 32 ? UINT32_MAX : (1u << mMaxWriters) - 1;
+    uint32_t mask = mLaneMask.load(std::memory_order_relaxed);
+    int lane;
+    do {
+        const uint32_t free = ~mask & allLanes;
+        if (free == 0) {
+            return -1;
+        }
+        lane = __builtin_ctz(free);
+    } while (!mLaneMask.compare_exchange_weak(mask, mask | (1u << lane),
+            std::memory_order_acquire));
+
+    // The writer starts at the current mix position. If the mix moves on before the lane is
+    // active, the writer catches up on its first write.
+    mLanes[lane].mRear.store(mRear.load(std::memory_order_acquire));
+    mLanes[lane].mActive.store(true);
+    return lane;
+}
+
+void MixingPipe::detach(int lane)
+{
+    mLanes[lane].mActive.store(false);
+    // A mix that saw the lane active may still be reading it; wait for that mix to complete
+    // before the lane can be reserved again. Later mixes will not read it.
+    const uint32_t sequence = mMixSequence.load();
+    if (sequence & 1) {
+        while (mMixSequence.load() == sequence) {
+            sched_yield();
+        }
+    }
+    mLaneMask.fetch_and(~(1u << lane), std::memory_order_release);
+    // The frames written to the lane may have been the ones holding back the mix.
+    mix();
+}
+
+uint64_t MixingPipe::minLaneRear() const
+{
+    uint64_t rear = UINT64_MAX;
+    for (size_t i = 0; i < mMaxWriters; i++) {
+        if (mLanes[i].mActive.load()) {
+            rear = std::min(rear, mLanes[i].mRear.load());
+        }
+    }
+    return rear == UINT64_MAX ? 0 : rear;
+}
+
+void MixingPipe::mix()
+{
+    const size_t mask = mMaxFrames - 1;
+    do {
+        if (mMixing.exchange(true)) {
+            return;     // the writer mixing will see our frames when it re-checks below
+        }
+        for (;;) {
+            const uint64_t rear = mRear.load(std::memory_order_relaxed);
+            mMixSequence.fetch_add(1);
+            uint32_t lanes = 0;
+            uint64_t end = UINT64_MAX;
+            for (size_t i = 0; i < mMaxWriters; i++) {
+                if (mLanes[i].mActive.load()) {
+                    lanes |= 1u << i;
+                    end = std::min(end, mLanes[i].mRear.load());
+                }
+            }
+            if (lanes == 0 || end <= rear) {
+                mMixSequence.fetch_add(1);
+                break;
+            }
+
+            // Readers discard the frames they copied if the mix overwrote them meanwhile.
+            mMixLimit.store(end, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            for (uint64_t position = rear; position < end; ) {
+                const size_t offset = position & mask;
+                const size_t frames = std::min<uint64_t>(end - position, mMaxFrames - offset);
+                const size_t samples = frames * mChannelCount;
+                float *dst = &mBuffer[offset * mChannelCount];
+                uint32_t remaining = lanes;
+                const int first = __builtin_ctz(remaining);
+                remaining &= remaining - 1;
+                memcpy(dst, &mLanes[first].mBuffer[offset * mChannelCount],
+                        samples * sizeof(float));
+                while (remaining != 0) {
+                    const int lane = __builtin_ctz(remaining);
+                    remaining &= remaining - 1;
+                    accumulate_float(dst, &mLanes[lane].mBuffer[offset * mChannelCount],
+                            samples);
+                }
+                position += frames;
+            }
+
+            mRear.store(end, std::memory_order_release);
+            mMixSequence.fetch_add(1);
+        }
+        mMixing.store(false);
+        // A writer may have written after our last snapshot, and given up on mixing
+        // because we were still at it.
+    } while (minLaneRear() > mRear.load(std::memory_order_relaxed));
+}
+
+// ----------------------------------------------------------------------------
+
+MixingPipeWriter::MixingPipeWriter(MixingPipe& pipe) :
+        NBAIO_Sink(pipe.mFormat),
+        mPipe(pipe),
+        mLane(pipe.attach()),
+        mRear(mLane >= 0 ? pipe.mLanes[mLane].mRear.load(std::memory_order_relaxed) : 0)
+{
+    ALOGW_IF(mLane < 0, "%s: no lane available among %zu", __func__, pipe.mMaxWriters);
+}
+
+MixingPipeWriter::~MixingPipeWriter()
+{
+    if (mLane >= 0) {
+        mPipe.detach(mLane);
+    }
+}
+
+ssize_t MixingPipeWriter::availableToWrite()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    if (CC_UNLIKELY(mLane < 0)) {
+        return NO_INIT;
+    }
+    const uint64_t rear = mPipe.mRear.load(std::memory_order_acquire);
+    return rear + mPipe.mMaxFrames - std::max(mRear, rear);
+}
+
+ssize_t MixingPipeWriter::write(const void *buffer, size_t count)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    if (CC_UNLIKELY(mLane < 0)) {
+        return NO_INIT;
+    }
+    MixingPipe::Lane& lane = mPipe.mLanes[mLane];
+    const uint64_t rear = mPipe.mRear.load(std::memory_order_acquire);
+    if (CC_UNLIKELY(mRear < rear)) {
+        // The mix moved on between attach() and our first write.
+        mRear = rear;
+    }
+    count = std::min<uint64_t>(count, rear + mPipe.mMaxFrames - mRear);
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t mask = mPipe.mMaxFrames - 1;
+    const size_t channelCount = mPipe.mChannelCount;
+    const float *src = (const float *) buffer;
+    for (size_t written = 0; written < count; ) {
+        const size_t offset = (mRear + written) & mask;
+        const size_t frames = std::min(count - written, mPipe.mMaxFrames - offset);
+        memcpy(&lane.mBuffer[offset * channelCount], &src[written * channelCount],
+                frames * channelCount * sizeof(float));
+        written += frames;
+    }
+    mRear += count;
+    lane.mRear.store(mRear);
+    mFramesWritten += count;
+
+    mPipe.mix();
+    return count;
+}
+
+}   // namespace android
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "MixingPipeReader"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <string.h>
+
+#include <cutils/compiler.h>
+#include <utils/Log.h>
+#include <media/nbaio/MixingPipeReader.h>
+
+namespace android {
+
+MixingPipeReader::MixingPipeReader(MixingPipe& pipe) :
+        NBAIO_Source(pipe.mFormat),
+        mPipe(pipe),
+        mFront(pipe.mRear.load(std::memory_order_acquire)),
+        mFramesOverrun(0),
+        mOverruns(0)
+{
+    mPipe.mReaders++;
+}
+
+MixingPipeReader::~MixingPipeReader()
+{
+#if !LOG_NDEBUG
+    int32_t readers =
+#else
+    (void)
+#endif
+            mPipe.mReaders--;
+    ALOG_ASSERT(readers > 0);
+}
+
+void MixingPipeReader::overrun(uint64_t rear)
+{
+    mFramesOverrun += rear - mFront;
+    ++mOverruns;
+    mFront = rear;
+}
+
+ssize_t MixingPipeReader::availableToRead()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const uint64_t rear = mPipe.mRear.load(std::memory_order_acquire);
+    if (rear - mFront > mPipe.mMaxFrames) {
+        overrun(rear);
+        return OVERRUN;
+    }
+    return rear - mFront;
+}
+
+ssize_t MixingPipeReader::read(void *buffer, size_t count)
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const uint64_t rear = mPipe.mRear.load(std::memory_order_acquire);
+    if (rear - mFront > mPipe.mMaxFrames) {
+        overrun(rear);
+        return OVERRUN;
+    }
+    count = std::min<uint64_t>(count, rear - mFront);
+    if (count == 0) {
+        return 0;
+    }
+
+    const size_t mask = mPipe.mMaxFrames - 1;
+    const size_t channelCount = mPipe.mChannelCount;
+    float *dst = (float *) buffer;
+    for (size_t read = 0; read < count; ) {
+        const size_t offset = (mFront + read) & mask;
+        const size_t frames = std::min(count - read, mPipe.mMaxFrames - offset);
+        memcpy(&dst[read * channelCount], &mPipe.mBuffer[offset * channelCount],
+                frames * channelCount * sizeof(float));
+        read += frames;
+    }
+
+    // The writers do not wait for the readers: check that the mix did not overwrite
+    // the frames while we were copying them.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (mPipe.mMixLimit.load(std::memory_order_relaxed) > mFront + mPipe.mMaxFrames) {
+        overrun(mPipe.mRear.load(std::memory_order_acquire));
+        return OVERRUN;
+    }
+    mFront += count;
+    mFramesRead += count;
+    return count;
+}
+
+ssize_t MixingPipeReader::flush()
+{
+    if (CC_UNLIKELY(!mNegotiated)) {
+        return NEGOTIATE;
+    }
+    const uint64_t rear = mPipe.mRear.load(std::memory_order_acquire);
+    if (rear - mFront > mPipe.mMaxFrames) {
+        overrun(rear);
+        return OVERRUN;
+    }
+    const ssize_t flushed = rear - mFront;
+    mFront = rear;
+    mFramesRead += flushed;     // we consider flushed frames as read, but not lost frames
+    return flushed;
+}
+
+}   // namespace android
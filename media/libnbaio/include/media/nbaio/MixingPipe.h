@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXING_PIPE_H
+#define ANDROID_AUDIO_MIXING_PIPE_H
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+#include <media/nbaio/NBAIO.h>
+
+namespace android {
+
+// MixingPipe is a Pipe that accepts several writers, whose frames are summed together.
+// It is only available for AUDIO_FORMAT_PCM_FLOAT.
+//
+// Each writer (see MixingPipeWriter) reserves one of the lanes of the pipe, and writes into it
+// without any lock. Whichever writer completes the mix first sums the frames written by all
+// the attached writers into the pipe buffer, where the readers (see MixingPipeReader) find them.
+// The mix only advances as fast as the slowest attached writer: a writer that stops writing
+// should be destroyed, or the other writers will stall once their lane is full.
+//
+// As with Pipe, readers can be added and removed dynamically, it's OK to have no readers,
+// and flow control on the read side is the readers' responsibility: each reader has its own
+// read position and overrun accounting.
+// The MixingPipe must outlive its writers and readers.
+class MixingPipe {
+
+    friend class MixingPipeReader;
+    friend class MixingPipeWriter;
+
+public:
+    static constexpr size_t kMaxWriters = 32;
+
+    // maxFrames will be rounded up to a power of 2, and applies to the pipe buffer as well as to
+    // each lane. maxWriters must be in [1, kMaxWriters].
+    MixingPipe(size_t maxFrames, const NBAIO_Format& format, size_t maxWriters);
+    ~MixingPipe();
+
+    NBAIO_Format format() const { return mFormat; }
+    size_t maxFrames() const { return mMaxFrames; }
+    size_t maxWriters() const { return mMaxWriters; }
+
+    // Number of frames mixed so far, may be called from any thread.
+    int64_t framesMixed() const { return mRear.load(std::memory_order_relaxed); }
+
+private:
+    // One lane per writer, on its own cache line so that writers don't contend.
+    struct alignas(64) Lane {
+        std::atomic<bool>       mActive{false};
+        std::atomic<uint64_t>   mRear{0};   // position after the last frame written to the lane
+        float                   *mBuffer = nullptr;
+    };
+
+    // Called by a MixingPipeWriter to reserve a lane, returns -1 if none is free.
+    int attach();
+    // Called by a MixingPipeWriter to give its lane back. The frames not mixed yet are dropped.
+    void detach(int lane);
+
+    // Sums the frames written by all the active lanes into the pipe buffer, up to the
+    // position reached by the slowest writer. Called by writers after each write;
+    // returns immediately if another writer is already mixing, as that writer will mix
+    // the frames written in the meantime before it returns.
+    void mix();
+    // Returns the position reached by the slowest active writer, or 0 if there are none.
+    uint64_t minLaneRear() const;
+
+    const NBAIO_Format  mFormat;
+    const size_t        mMaxFrames;     // always a power of 2
+    const size_t        mChannelCount;
+    const size_t        mMaxWriters;
+    std::unique_ptr<float[]> mBuffer;       // the mixed frames, read by the readers
+    std::unique_ptr<float[]> mLaneBuffers;  // mMaxWriters lanes of mMaxFrames frames
+    std::unique_ptr<Lane[]>  mLanes;
+
+    std::atomic<uint32_t> mLaneMask{0};     // lanes reserved by a writer
+    std::atomic<bool>     mMixing{false};   // a writer is mixing
+    // Incremented before a writer snapshots the active lanes and after it is done mixing them,
+    // so that a detaching writer can wait for any mix that may still read its lane.
+    std::atomic<uint32_t> mMixSequence{0};
+    // Frames below mMixLimit - mMaxFrames may have been overwritten by the mix in progress.
+    // Readers check it after copying frames, as with a sequence lock.
+    std::atomic<uint64_t> mMixLimit{0};
+    std::atomic<uint64_t> mRear{0};         // position after the last mixed frame
+    std::atomic<int32_t>  mReaders{0};      // number of MixingPipeReader attached to this pipe
+};
+
+// MixingPipeWriter is safe for only a single thread, but several MixingPipeWriter of the same
+// MixingPipe can write concurrently.
+class MixingPipeWriter : public NBAIO_Sink {
+
+public:
+    // Construct a MixingPipeWriter and reserve a lane of the MixingPipe.
+    // If all lanes are taken, write() returns NO_INIT; see isAttached().
+    explicit MixingPipeWriter(MixingPipe& pipe);
+    virtual ~MixingPipeWriter();
+
+    bool isAttached() const { return mLane >= 0; }
+
+    // NBAIO_Port interface
+
+    //virtual ssize_t negotiate(const NBAIO_Format offers[], size_t numOffers,
+    //                          NBAIO_Format counterOffers[], size_t& numCounterOffers);
+    //virtual NBAIO_Format format() const;
+
+    // NBAIO_Sink interface
+
+    //virtual int64_t framesWritten() const;
+    //virtual int64_t framesUnderrun() const;
+    //virtual int64_t underruns() const;
+
+    // Space left in the lane of this writer, which depends on the progress of the other writers.
+    virtual ssize_t availableToWrite();
+
+    virtual ssize_t write(const void *buffer, size_t count);
+    //virtual ssize_t writeVia(writeVia_t via, size_t total, void *user, size_t block);
+
+    // NBAIO_Sink end
+
+private:
+    MixingPipe& mPipe;
+    const int   mLane;
+    uint64_t    mRear;      // local copy of the lane position
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_MIXING_PIPE_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_AUDIO_MIXING_PIPE_READER_H
+#define ANDROID_AUDIO_MIXING_PIPE_READER_H
+
+#include "MixingPipe.h"
+
+namespace android {
+
+// MixingPipeReader is safe for only a single thread.
+// It never blocks the writers: if it falls more than a pipe behind, the frames it missed
+// are counted in framesOverrun(), and it resumes from the most recent mixed frame.
+class MixingPipeReader : public NBAIO_Source {
+
+public:
+
+    // Construct a MixingPipeReader and associate it with a MixingPipe.
+    // The reader starts at the most recent mixed frame.
+    explicit MixingPipeReader(MixingPipe& pipe);
+    virtual ~MixingPipeReader();
+
+    // NBAIO_Port interface
+
+    //virtual ssize_t negotiate(const NBAIO_Format offers[], size_t numOffers,
+    //                          NBAIO_Format counterOffers[], size_t& numCounterOffers);
+    //virtual NBAIO_Format format() const;
+
+    // NBAIO_Source interface
+
+    //virtual size_t framesRead() const;
+    virtual int64_t framesOverrun() { return mFramesOverrun; }
+    virtual int64_t overruns()  { return mOverruns; }
+
+    virtual ssize_t availableToRead();
+
+    virtual ssize_t read(void *buffer, size_t count);
+
+    virtual ssize_t flush();
+
+    // NBAIO_Source end
+
+private:
+    // Skips the frames from the read position up to the most recent mixed frame.
+    void overrun(uint64_t rear);
+
+    MixingPipe& mPipe;
+    uint64_t    mFront;     // position of the next frame to read
+    int64_t     mFramesOverrun;
+    int64_t     mOverruns;
+};
+
+}   // namespace android
+
+#endif  // ANDROID_AUDIO_MIXING_PIPE_READER_H
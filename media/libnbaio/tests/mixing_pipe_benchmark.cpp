@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Throughput of a MixingPipe compared to a MonoPipe, writing and reading blocks of
+// frames on the same thread, so that only the cost of the pipes is measured.
+// BM_MixingPipe mixes the given number of writers: a writer that completes the mix
+// sums all the lanes into the pipe buffer.
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <media/nbaio/MixingPipe.h>
+#include <media/nbaio/MixingPipeReader.h>
+#include <media/nbaio/MonoPipe.h>
+#include <media/nbaio/MonoPipeReader.h>
+
+using namespace android;
+
+namespace {
+
+constexpr unsigned kChannelCount = 2;
+constexpr size_t kPipeFrames = 4096;
+constexpr size_t kBlockFrames = 256;
+
+const NBAIO_Format kFormat = Format_from_SR_C(48000, kChannelCount, AUDIO_FORMAT_PCM_FLOAT);
+
+void negotiate(NBAIO_Port *port) {
+    NBAIO_Format offers[1] = {kFormat};
+    size_t numCounterOffers = 0;
+    port->negotiate(offers, 1, nullptr, numCounterOffers);
+}
+
+} // namespace
+
+static void BM_MonoPipe(benchmark::State& state) {
+    sp<MonoPipe> pipe = new MonoPipe(kPipeFrames, kFormat, false /*writeCanBlock*/);
+    sp<MonoPipeReader> reader = new MonoPipeReader(pipe.get());
+    negotiate(pipe.get());
+    negotiate(reader.get());
+    std::vector<float> in(kBlockFrames * kChannelCount, 0.5f);
+    std::vector<float> out(kBlockFrames * kChannelCount);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(pipe->write(in.data(), kBlockFrames));
+        benchmark::DoNotOptimize(reader->read(out.data(), kBlockFrames));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBlockFrames);
+}
+
+BENCHMARK(BM_MonoPipe);
+
+static void BM_MixingPipe(benchmark::State& state) {
+    const size_t numWriters = state.range(0);
+    MixingPipe pipe(kPipeFrames, kFormat, numWriters);
+    std::vector<sp<MixingPipeWriter>> writers;
+    for (size_t i = 0; i < numWriters; i++) {
+        writers.push_back(new MixingPipeWriter(pipe));
+        negotiate(writers.back().get());
+    }
+    sp<MixingPipeReader> reader = new MixingPipeReader(pipe);
+    negotiate(reader.get());
+    std::vector<float> in(kBlockFrames * kChannelCount, 0.5f);
+    std::vector<float> out(kBlockFrames * kChannelCount);
+
+    for (auto _ : state) {
+        for (const auto& writer : writers) {
+            benchmark::DoNotOptimize(writer->write(in.data(), kBlockFrames));
+        }
+        benchmark::DoNotOptimize(reader->read(out.data(), kBlockFrames));
+        benchmark::ClobberMemory();
+    }
+    // frames delivered to the reader, each one the mix of numWriters frames
+    state.SetItemsProcessed(state.iterations() * kBlockFrames);
+    writers.clear();
+}
+
+BENCHMARK(BM_MixingPipe)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+BENCHMARK_MAIN();
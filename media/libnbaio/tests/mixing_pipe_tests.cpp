@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "mixing_pipe_tests"
+
+#include <atomic>
+#include <random>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/nbaio/MixingPipe.h>
+#include <media/nbaio/MixingPipeReader.h>
+
+using namespace android;
+
+namespace {
+
+constexpr unsigned kChannelCount = 2;
+constexpr size_t kPipeFrames = 1024;
+
+const NBAIO_Format kFormat = Format_from_SR_C(48000, kChannelCount, AUDIO_FORMAT_PCM_FLOAT);
+
+// Sample written by a writer at a given position of the pipe. Small integers, so that the
+// mix of all writers is exact.
+float sample(size_t writer, uint64_t position, unsigned channel) {
+    return (float) ((position * 7 + writer * 13 + channel) % 97);
+}
+
+float mixedSample(size_t writers, uint64_t position, unsigned channel) {
+    float sum = 0.f;
+    for (size_t w = 0; w < writers; w++) {
+        sum += sample(w, position, channel);
+    }
+    return sum;
+}
+
+void negotiate(NBAIO_Port *port) {
+    NBAIO_Format offers[1] = {kFormat};
+    size_t numCounterOffers = 0;
+    ASSERT_EQ(0, port->negotiate(offers, 1, nullptr, numCounterOffers));
+}
+
+// Writes frames starting at the given position, returns how many were written.
+ssize_t writeFrames(MixingPipeWriter *writer, size_t index, uint64_t position, size_t count) {
+    std::vector<float> buffer(count * kChannelCount);
+    for (size_t i = 0; i < count; i++) {
+        for (unsigned c = 0; c < kChannelCount; c++) {
+            buffer[i * kChannelCount + c] = sample(index, position + i, c);
+        }
+    }
+    return writer->write(buffer.data(), count);
+}
+
+} // namespace
+
+TEST(MixingPipeTest, SumsWriters) {
+    MixingPipe pipe(kPipeFrames, kFormat, 4 /* maxWriters */);
+    std::vector<sp<MixingPipeWriter>> writers;
+    for (size_t w = 0; w < 3; w++) {
+        writers.push_back(new MixingPipeWriter(pipe));
+        negotiate(writers.back().get());
+    }
+    sp<MixingPipeReader> reader = new MixingPipeReader(pipe);
+    negotiate(reader.get());
+
+    // nothing is mixed until every writer wrote
+    ASSERT_EQ(100, writeFrames(writers[0].get(), 0, 0, 100));
+    ASSERT_EQ(50, writeFrames(writers[1].get(), 1, 0, 50));
+    EXPECT_EQ(0, reader->availableToRead());
+    ASSERT_EQ(80, writeFrames(writers[2].get(), 2, 0, 80));
+    EXPECT_EQ(50, pipe.framesMixed());
+    ASSERT_EQ(50, reader->availableToRead());
+
+    // the fastest writer is held back by the slowest one
+    EXPECT_EQ((ssize_t) (50 + kPipeFrames - 100), writers[0]->availableToWrite());
+
+    std::vector<float> buffer(50 * kChannelCount);
+    ASSERT_EQ(50, reader->read(buffer.data(), 50));
+    for (size_t i = 0; i < 50; i++) {
+        for (unsigned c = 0; c < kChannelCount; c++) {
+            ASSERT_EQ(mixedSample(3, i, c), buffer[i * kChannelCount + c]);
+        }
+    }
+    EXPECT_EQ(0, reader->framesOverrun());
+}
+
+TEST(MixingPipeTest, LaneReservation) {
+    MixingPipe pipe(kPipeFrames, kFormat, 2 /* maxWriters */);
+    sp<MixingPipeWriter> first = new MixingPipeWriter(pipe);
+    sp<MixingPipeWriter> second = new MixingPipeWriter(pipe);
+    sp<MixingPipeWriter> third = new MixingPipeWriter(pipe);
+    EXPECT_TRUE(first->isAttached());
+    EXPECT_TRUE(second->isAttached());
+    EXPECT_FALSE(third->isAttached());
+    negotiate(third.get());
+    float frame[kChannelCount] = {};
+    EXPECT_EQ(NO_INIT, third->write(frame, 1));
+
+    // the lane of a destroyed writer can be reserved again
+    first.clear();
+    sp<MixingPipeWriter> fourth = new MixingPipeWriter(pipe);
+    EXPECT_TRUE(fourth->isAttached());
+}
+
+TEST(MixingPipeTest, DetachReleasesOtherWriters) {
+    MixingPipe pipe(kPipeFrames, kFormat, 2 /* maxWriters */);
+    sp<MixingPipeWriter> writer = new MixingPipeWriter(pipe);
+    negotiate(writer.get());
+    sp<MixingPipeWriter> idle = new MixingPipeWriter(pipe);
+
+    ASSERT_EQ((ssize_t) kPipeFrames, writeFrames(writer.get(), 0, 0, 2 * kPipeFrames));
+    EXPECT_EQ(0, writer->availableToWrite());
+    EXPECT_EQ(0, pipe.framesMixed());
+
+    idle.clear();
+    EXPECT_EQ((int64_t) kPipeFrames, pipe.framesMixed());
+    EXPECT_EQ((ssize_t) kPipeFrames, writer->availableToWrite());
+}
+
+TEST(MixingPipeTest, PerReaderOverrun) {
+    MixingPipe pipe(kPipeFrames, kFormat, 1 /* maxWriters */);
+    sp<MixingPipeWriter> writer = new MixingPipeWriter(pipe);
+    negotiate(writer.get());
+    sp<MixingPipeReader> fast = new MixingPipeReader(pipe);
+    negotiate(fast.get());
+    sp<MixingPipeReader> slow = new MixingPipeReader(pipe);
+    negotiate(slow.get());
+
+    std::vector<float> buffer(kPipeFrames * kChannelCount);
+    uint64_t position = 0;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(512, writeFrames(writer.get(), 0, position, 512));
+        position += 512;
+        ASSERT_EQ(512, fast->read(buffer.data(), kPipeFrames));
+    }
+    EXPECT_EQ(0, fast->framesOverrun());
+    EXPECT_EQ(0, fast->overruns());
+
+    // the slow reader lost everything, and resumes from the most recent frame
+    EXPECT_EQ(OVERRUN, slow->read(buffer.data(), kPipeFrames));
+    EXPECT_EQ((int64_t) position, slow->framesOverrun());
+    EXPECT_EQ(1, slow->overruns());
+    EXPECT_EQ(0, slow->availableToRead());
+    ASSERT_EQ(100, writeFrames(writer.get(), 0, position, 100));
+    ASSERT_EQ(100, slow->read(buffer.data(), kPipeFrames));
+    EXPECT_EQ(sample(0, position, 0), buffer[0]);
+}
+
+// Several writer threads write blocks of random sizes while readers check every frame
+// they read against the expected mix.
+TEST(MixingPipeTest, ConcurrentWriters) {
+    constexpr size_t kWriters = 4;
+    constexpr size_t kReaders = 2;
+    constexpr uint64_t kTotalFrames = 1 << 20;
+
+    MixingPipe pipe(kPipeFrames, kFormat, kWriters);
+    std::vector<sp<MixingPipeWriter>> writers;
+    for (size_t w = 0; w < kWriters; w++) {
+        writers.push_back(new MixingPipeWriter(pipe));
+        negotiate(writers.back().get());
+    }
+    std::vector<sp<MixingPipeReader>> readers;
+    for (size_t r = 0; r < kReaders; r++) {
+        readers.push_back(new MixingPipeReader(pipe));
+        negotiate(readers.back().get());
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < kWriters; w++) {
+        threads.emplace_back([&writers, w]() {
+            std::minstd_rand random(w);
+            uint64_t position = 0;
+            while (position < kTotalFrames) {
+                const size_t count = std::min<uint64_t>(1 + random() % 300,
+                        kTotalFrames - position);
+                const ssize_t written = writeFrames(writers[w].get(), w, position, count);
+                ASSERT_GE(written, 0);
+                if (written == 0) {
+                    sched_yield();  // wait for the other writers
+                }
+                position += written;
+            }
+        });
+    }
+
+    std::atomic<uint64_t> mismatches{0};
+    std::vector<uint64_t> framesChecked(kReaders);
+    for (size_t r = 0; r < kReaders; r++) {
+        threads.emplace_back([&, r]() {
+            MixingPipeReader *reader = readers[r].get();
+            std::vector<float> buffer(256 * kChannelCount);
+            for (;;) {
+                // the frames skipped by an overrun are not read again
+                const uint64_t position = reader->framesRead() + reader->framesOverrun();
+                if (position >= kTotalFrames) {
+                    break;
+                }
+                const ssize_t read = reader->read(buffer.data(), 256);
+                if (read == OVERRUN || read == 0) {
+                    sched_yield();
+                    continue;
+                }
+                ASSERT_GT(read, 0);
+                for (ssize_t i = 0; i < read; i++) {
+                    for (unsigned c = 0; c < kChannelCount; c++) {
+                        if (buffer[i * kChannelCount + c]
+                                != mixedSample(kWriters, position + i, c)) {
+                            mismatches++;
+                        }
+                    }
+                }
+                framesChecked[r] += read;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(0u, mismatches);
+    EXPECT_EQ((int64_t) kTotalFrames, pipe.framesMixed());
+    for (size_t r = 0; r < kReaders; r++) {
+        EXPECT_EQ((int64_t) kTotalFrames,
+                readers[r]->framesRead() + readers[r]->framesOverrun());
+        EXPECT_GT(framesChecked[r], 0u);
+    }
+}
+
+// Writers come and go while others keep writing: the mix must never stall.
+TEST(MixingPipeTest, WritersAttachAndDetach) {
+    constexpr size_t kWriters = 4;
+    MixingPipe pipe(kPipeFrames, kFormat, kWriters);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < kWriters; w++) {
+        threads.emplace_back([&pipe, &done, w]() {
+            std::minstd_rand random(w);
+            std::vector<float> buffer(300 * kChannelCount, 1.f);
+            while (!done) {
+                sp<MixingPipeWriter> writer = new MixingPipeWriter(pipe);
+                ASSERT_TRUE(writer->isAttached());
+                negotiate(writer.get());
+                const int blocks = 1 + random() % 50;
+                for (int i = 0; i < blocks && !done; ) {
+                    const ssize_t written = writer->write(buffer.data(), 1 + random() % 300);
+                    ASSERT_GE(written, 0);
+                    if (written > 0) {
+                        i++;
+                    } else {
+                        sched_yield();
+                    }
+                }
+            }
+        });
+    }
+    while (pipe.framesMixed() < (1 << 20)) {
+        sched_yield();
+    }
+    done = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
@@ -27,6 +27,8 @@
 #include <json/json.h>
 #include <media/nblog/Merger.h>
 #include <media/nblog/PerformanceAnalysis.h>
+#include <media/nblog/PerformanceCollector.h>
+#include <media/nblog/PersistentLog.h>
 #include <media/nblog/ReportPerformance.h>
 #include <media/nblog/Reader.h>
 #include <media/nblog/Timeline.h>
@@ -132,67 +134,12 @@ MergeReader::MergeReader(const void *shared, size_t size, Merger &merger)
 // writes the data to a map of class PerformanceAnalysis, based on their thread ID.
 void MergeReader::processSnapshot(Snapshot &snapshot, int author)
 {
-    ReportPerformance::PerformanceData& data = mThreadPerformanceData[author];
-    // We don't do "auto it" because it reduces readability in this case.
-    for (EntryIterator it = snapshot.begin(); it != snapshot.end(); ++it) {
-        switch (it->type) {
-        case EVENT_HISTOGRAM_ENTRY_TS: {
-            const HistTsEntry payload = it.payload<HistTsEntry>();
-            // TODO: hash for histogram ts and audio state need to match
-            // and correspond to audio production source file location
-            mThreadPerformanceAnalysis[author][0 /*hash*/].logTsEntry(payload.ts);
-        } break;
-        case EVENT_AUDIO_STATE: {
-            mThreadPerformanceAnalysis[author][0 /*hash*/].handleStateChange();
-        } break;
-        case EVENT_THREAD_INFO: {
-            const thread_info_t info = it.payload<thread_info_t>();
-            data.threadInfo = info;
-        } break;
-        case EVENT_THREAD_PARAMS: {
-            const thread_params_t params = it.payload<thread_params_t>();
-            data.threadParams = params;
-        } break;
-        case EVENT_LATENCY: {
-            const double latencyMs = it.payload<double>();
-            data.latencyHist.add(latencyMs);
-        } break;
-        case EVENT_WORK_TIME: {
-            const int64_t monotonicNs = it.payload<int64_t>();
-            const double monotonicMs = monotonicNs * 1e-6;
-            data.workHist.add(monotonicMs);
-            data.active += monotonicNs;
-        } break;
-        case EVENT_WARMUP_TIME: {
-            const double timeMs = it.payload<double>();
-            data.warmupHist.add(timeMs);
-        } break;
-        case EVENT_UNDERRUN: {
-            const int64_t ts = it.payload<int64_t>();
-            data.underruns++;
-            data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
-            // TODO have a data structure to automatically handle resizing
-            if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
-                data.snapshots.pop_back();
-            }
-        } break;
-        case EVENT_OVERRUN: {
-            const int64_t ts = it.payload<int64_t>();
-            data.overruns++;
-            data.snapshots.emplace_front(EVENT_UNDERRUN, ts);
-            // TODO have a data structure to automatically handle resizing
-            if (data.snapshots.size() > ReportPerformance::PerformanceData::kMaxSnapshotsToStore) {
-                data.snapshots.pop_back();
-            }
-        } break;
-        case EVENT_RESERVED:
-        case EVENT_UPPER_BOUND:
-            ALOGW("warning: unexpected event %d", it->type);
-            break;
-        default:
-            break;
-        }
-    }
+    mCollector.processEntries(snapshot.begin(), snapshot.end(), author);
+}
+
+void MergeReader::setPersistentLog(std::unique_ptr<PersistentLogWriter> persistentLog)
+{
+    mPersistentLog = std::move(persistentLog);
 }
 
 void MergeReader::getAndProcessSnapshot()
@@ -208,6 +155,11 @@ void MergeReader::getAndProcessSnapshot()
     for (size_t i = 0; i < nLogs; i++) {
         if (snapshots[i] != nullptr) {
             processSnapshot(*(snapshots[i]), i);
+            if (mPersistentLog != nullptr) {
+                // FIXME Needs a lock, same as mReaders above
+                (void)mPersistentLog->append(i, mReaders[i]->name(), snapshots[i]->lost(),
+                        snapshots[i]->begin(), snapshots[i]->end());
+            }
         }
     }
     checkPushToMediaMetrics();
@@ -215,14 +167,7 @@ void MergeReader::getAndProcessSnapshot()
 
 void MergeReader::checkPushToMediaMetrics()
 {
-    const nsecs_t now = systemTime();
-    for (auto& item : mThreadPerformanceData) {
-        ReportPerformance::PerformanceData& data = item.second;
-        if (now - data.start >= kPeriodicMediaMetricsPush) {
-            (void)ReportPerformance::sendToMediaMetrics(data);
-            data.reset();   // data is persistent per thread
-        }
-    }
+    mCollector.checkPushToMediaMetrics();
 }
 
 void MergeReader::dump(int fd, const Vector<String16>& args)
@@ -241,18 +186,7 @@ void MergeReader::dump(int fd, const Vector<String16>& args)
             retro = true;
         }
     }
-    if (pa) {
-        ReportPerformance::dump(fd, 0 /*indent*/, mThreadPerformanceAnalysis);
-    }
-    if (json) {
-        ReportPerformance::dumpJson(fd, mThreadPerformanceData);
-    }
-    if (plots) {
-        ReportPerformance::dumpPlots(fd, mThreadPerformanceData);
-    }
-    if (retro) {
-        ReportPerformance::dumpRetro(fd, mThreadPerformanceData);
-    }
+    mCollector.dump(fd, pa, json, plots, retro);
 }
 
 void MergeReader::handleAuthor(const AbstractEntry &entry, String8 *body)
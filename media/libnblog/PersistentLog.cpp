@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "NBLog"
+//#define LOG_NDEBUG 0
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <media/nblog/Entry.h>
+#include <media/nblog/PersistentLog.h>
+#include <utils/Log.h>
+
+namespace android {
+namespace NBLog {
+
+// Copies to and from a ring of the given capacity, wrapping around its end.
+static void ringCopyIn(uint8_t *ring, uint64_t capacity, uint64_t position,
+                       const void *data, size_t size)
+{
+    const size_t index = position % capacity;
+    const size_t first = std::min<uint64_t>(size, capacity - index);
+    memcpy(ring + index, data, first);
+    memcpy(ring, (const uint8_t *) data + first, size - first);
+}
+
+static void ringCopyOut(const uint8_t *ring, uint64_t capacity, uint64_t position,
+                        void *data, size_t size)
+{
+    const size_t index = position % capacity;
+    const size_t first = std::min<uint64_t>(size, capacity - index);
+    memcpy(data, ring + index, first);
+    memcpy((uint8_t *) data + first, ring, size - first);
+}
+
+// ---------------------------------------------------------------------------
+
+std::unique_ptr<PersistentLogWriter> PersistentLogWriter::open(const char *path, size_t capacity)
+{
+    if (capacity > kMaxCapacity) {
+        ALOGW("%s: capacity %zu clamped to %zu", __func__, capacity, kMaxCapacity);
+        capacity = kMaxCapacity;
+    }
+    const size_t mapSize = sizeof(PersistentLogHeader) + capacity;
+    const int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        ALOGE("%s: cannot open %s: %s", __func__, path, strerror(errno));
+        return nullptr;
+    }
+    struct stat st;
+    const bool sameSize = fstat(fd, &st) == 0 && (size_t) st.st_size == mapSize;
+    if (!sameSize && ftruncate(fd, mapSize) != 0) {
+        ALOGE("%s: cannot resize %s: %s", __func__, path, strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    void *map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        ALOGE("%s: cannot map %s: %s", __func__, path, strerror(errno));
+        return nullptr;
+    }
+
+    std::unique_ptr<PersistentLogWriter> writer(
+            new PersistentLogWriter((uint8_t *) map, mapSize));
+    PersistentLogHeader *header = writer->mHeader;
+    if (!sameSize || header->magic != PersistentLogHeader::kMagic
+            || header->version != PersistentLogHeader::kVersion
+            || header->capacity != capacity
+            || header->front > header->rear
+            || header->rear - header->front > capacity) {
+        header->magic = PersistentLogHeader::kMagic;
+        header->version = PersistentLogHeader::kVersion;
+        header->capacity = capacity;
+        header->front = 0;
+        header->rear = 0;
+    }
+    ALOGV("%s: %s capacity=%zu front=%llu rear=%llu", __func__, path, capacity,
+          (unsigned long long) header->front, (unsigned long long) header->rear);
+    return writer;
+}
+
+PersistentLogWriter::PersistentLogWriter(uint8_t *map, size_t mapSize)
+    : mMap(map),
+      mMapSize(mapSize),
+      mHeader((PersistentLogHeader *) map),
+      mData(map + sizeof(PersistentLogHeader))
+{
+}
+
+PersistentLogWriter::~PersistentLogWriter()
+{
+    munmap(mMap, mMapSize);
+}
+
+bool PersistentLogWriter::append(int author, const std::string &name, size_t lost,
+                                 EntryIterator begin, EntryIterator end)
+{
+    const size_t entriesSize = end - begin;
+    if (entriesSize == 0) {
+        return true;
+    }
+    const uint64_t capacity = mHeader->capacity;
+    const size_t nameLength = std::min<size_t>(name.size(), UINT16_MAX);
+    const size_t length = sizeof(PersistentLogRecord) + nameLength + entriesSize;
+    if (length > capacity) {
+        return false;
+    }
+
+    // Drop the oldest records to make room. The front is updated before they are
+    // overwritten, so that the file stays consistent if the process dies during the copy.
+    uint64_t front = mHeader->front;
+    const uint64_t rear = mHeader->rear;
+    while (rear + length - front > capacity) {
+        PersistentLogRecord oldest;
+        ringCopyOut(mData, capacity, front, &oldest, sizeof(oldest));
+        if (oldest.length < sizeof(PersistentLogRecord) || oldest.length > rear - front) {
+            ALOGW("%s: corrupt record at %llu, dropping the log",
+                  __func__, (unsigned long long) front);
+            front = rear;
+            break;
+        }
+        front += oldest.length;
+    }
+    mHeader->front = front;
+
+    PersistentLogRecord record{};
+    record.length = length;
+    record.author = author;
+    record.lost = std::min<size_t>(lost, UINT32_MAX);
+    record.nameLength = nameLength;
+    uint64_t position = rear;
+    ringCopyIn(mData, capacity, position, &record, sizeof(record));
+    position += sizeof(record);
+    ringCopyIn(mData, capacity, position, name.data(), nameLength);
+    position += nameLength;
+    ringCopyIn(mData, capacity, position, (const uint8_t *) begin, entriesSize);
+    mHeader->rear = rear + length;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+std::unique_ptr<PersistentLogReader> PersistentLogReader::open(const char *path)
+{
+    const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ALOGE("%s: cannot open %s: %s", __func__, path, strerror(errno));
+        return nullptr;
+    }
+    PersistentLogHeader header;
+    struct stat st;
+    if (read(fd, &header, sizeof(header)) != sizeof(header) || fstat(fd, &st) != 0
+            || header.magic != PersistentLogHeader::kMagic
+            || header.version != PersistentLogHeader::kVersion
+            || header.capacity == 0
+            || (uint64_t) st.st_size != sizeof(header) + header.capacity
+            || header.front > header.rear
+            || header.rear - header.front > header.capacity) {
+        ALOGE("%s: %s is not a valid persistent log", __func__, path);
+        close(fd);
+        return nullptr;
+    }
+    std::unique_ptr<PersistentLogReader> reader(new PersistentLogReader());
+    reader->mData.resize(header.capacity);
+    const ssize_t dataRead = read(fd, reader->mData.data(), header.capacity);
+    close(fd);
+    if (dataRead < 0 || (uint64_t) dataRead != header.capacity) {
+        ALOGE("%s: cannot read %s", __func__, path);
+        return nullptr;
+    }
+    reader->mPosition = header.front;
+    reader->mRear = header.rear;
+    return reader;
+}
+
+bool PersistentLogReader::next(Record *record)
+{
+    const uint64_t capacity = mData.size();
+    PersistentLogRecord header;
+    if (mRear - mPosition < sizeof(header)) {
+        return false;
+    }
+    ringCopyOut(mData.data(), capacity, mPosition, &header, sizeof(header));
+    if (header.length < sizeof(header) + header.nameLength
+            || header.length > mRear - mPosition) {
+        ALOGW("%s: corrupt record at %llu", __func__, (unsigned long long) mPosition);
+        mPosition = mRear;
+        return false;
+    }
+    uint64_t position = mPosition + sizeof(header);
+    record->author = header.author;
+    record->lost = header.lost;
+    record->name.resize(header.nameLength);
+    ringCopyOut(mData.data(), capacity, position, &record->name[0], header.nameLength);
+    position += header.nameLength;
+    record->entries.resize(header.length - sizeof(header) - header.nameLength);
+    ringCopyOut(mData.data(), capacity, position, record->entries.data(), record->entries.size());
+    mPosition += header.length;
+    return true;
+}
+
+}   // namespace NBLog
+}   // namespace android
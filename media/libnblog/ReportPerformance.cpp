@@ -30,7 +30,9 @@
 #include <sys/time.h>
 #include <utility>
 #include <json/json.h>
+#ifdef __ANDROID__
 #include <media/MediaMetricsItem.h>
+#endif
 #include <media/nblog/Events.h>
 #include <media/nblog/PerformanceAnalysis.h>
 #include <media/nblog/ReportPerformance.h>
@@ -150,6 +152,11 @@ void dumpRetro(int fd, const std::map<int, PerformanceData>& threadDataMap)
 
 bool sendToMediaMetrics(const PerformanceData& data)
 {
+#ifndef __ANDROID__
+    // Media metrics are not available in host builds, e.g. nblog_analyzer.
+    (void)data;
+    return false;
+#else
     // See documentation for these metrics here:
     // docs.google.com/document/d/11--6dyOXVOpacYQLZiaOY5QVtQjUyqNx2zT9cCzLKYE/edit?usp=sharing
     static constexpr char kThreadType[] = "android.media.audiothread.type";
@@ -208,6 +215,7 @@ bool sendToMediaMetrics(const PerformanceData& data)
         return item->selfrecord();
     }
     return false;
+#endif
 }
 
 //------------------------------------------------------------------------------
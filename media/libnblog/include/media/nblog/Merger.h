@@ -24,6 +24,8 @@
 
 #include <audio_utils/fifo.h>
 #include <media/nblog/PerformanceAnalysis.h>
+#include <media/nblog/PerformanceCollector.h>
+#include <media/nblog/PersistentLog.h>
 #include <media/nblog/Reader.h>
 #include <utils/Condition.h>
 #include <utils/Mutex.h>
@@ -88,23 +90,21 @@ public:
 
     void dump(int fd, const Vector<String16>& args);
 
+    // Also append every snapshot to this log, which outlives the reader FIFOs and can be
+    // analyzed offline with nblog_analyzer. Must be called before the merge thread runs.
+    void setPersistentLog(std::unique_ptr<PersistentLogWriter> persistentLog);
+
 private:
     // FIXME Needs to be protected by a lock,
     //       because even though our use of it is read-only there may be asynchronous updates
     // The object is owned by the Merger class.
     const std::vector<sp<Reader>>& mReaders;
 
-    // analyzes, compresses and stores the merged data
-    // contains a separate instance for every author (thread), and for every source file
-    // location within each author
-    ReportPerformance::PerformanceAnalysisMap mThreadPerformanceAnalysis;
-
-    // compresses and stores audio performance data from each thread's buffers.
-    // first parameter is author, i.e. thread index.
-    std::map<int, ReportPerformance::PerformanceData> mThreadPerformanceData;
+    // analyzes the snapshots and stores the resulting performance data
+    PerformanceCollector mCollector;
 
-    // how often to push data to Media Metrics
-    static constexpr nsecs_t kPeriodicMediaMetricsPush = s2ns((nsecs_t)2 * 60 * 60); // 2 hours
+    // optional file ring where snapshots are persisted
+    std::unique_ptr<PersistentLogWriter> mPersistentLog;
 
     // handle author entry by looking up the author's name and appending it to the body
     // returns number of bytes read from fmtEntry
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_NBLOG_PERFORMANCE_COLLECTOR_H
+#define ANDROID_MEDIA_NBLOG_PERFORMANCE_COLLECTOR_H
+
+#include <map>
+
+#include <media/nblog/Entry.h>
+#include <media/nblog/PerformanceAnalysis.h>
+#include <utils/Timers.h>
+
+namespace android {
+namespace NBLog {
+
+// Processes log entries into performance analysis and data for each author (thread).
+// Used by MergeReader on the live logs, and by nblog_analyzer on persisted logs.
+class PerformanceCollector {
+public:
+    // process the entries in [begin, end), which were written by author
+    void processEntries(EntryIterator begin, EntryIterator end, int author);
+
+    // check for periodic push of performance data to media metrics, and perform
+    // the send if it is time to do so.
+    void checkPushToMediaMetrics();
+
+    // pa: PerformanceAnalysis report, json: PerformanceData as JSON,
+    // plots: histogram plots, retro: snapshots at underruns and overruns
+    void dump(int fd, bool pa, bool json, bool plots, bool retro);
+
+private:
+    // analyzes, compresses and stores the merged data
+    // contains a separate instance for every author (thread), and for every source file
+    // location within each author
+    ReportPerformance::PerformanceAnalysisMap mThreadPerformanceAnalysis;
+
+    // compresses and stores audio performance data from each thread's buffers.
+    // first parameter is author, i.e. thread index.
+    std::map<int, ReportPerformance::PerformanceData> mThreadPerformanceData;
+
+    // how often to push data to Media Metrics
+    static constexpr nsecs_t kPeriodicMediaMetricsPush = s2ns((nsecs_t)2 * 60 * 60); // 2 hours
+};
+
+}   // namespace NBLog
+}   // namespace android
+
+#endif  // ANDROID_MEDIA_NBLOG_PERFORMANCE_COLLECTOR_H
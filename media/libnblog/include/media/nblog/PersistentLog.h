@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_MEDIA_NBLOG_PERSISTENT_LOG_H
+#define ANDROID_MEDIA_NBLOG_PERSISTENT_LOG_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <media/nblog/Entry.h>
+
+namespace android {
+namespace NBLog {
+
+// Layout of a persistent log file:
+//  PersistentLogHeader
+//  data ring of 'capacity' bytes, containing a sequence of records
+//
+// Each record is a PersistentLogRecord, followed by the author name, followed by
+// the raw log entries of one snapshot of that author, as found in the shared memory FIFO.
+// Records may wrap around the end of the ring. When the ring is full the oldest records
+// are dropped, so that the file always holds the most recent history.
+// Positions are byte counts since the file was created, modulo capacity for the index.
+
+struct PersistentLogHeader {
+    static constexpr uint32_t kMagic = 0x504c424e; // "NBLP"
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;  // size of the data ring in bytes
+    uint64_t front;     // position of the oldest record
+    uint64_t rear;      // position after the newest record, updated last
+};
+
+struct PersistentLogRecord {
+    uint32_t length;        // total length of the record including this header
+    int32_t  author;        // index of the reader the entries came from
+    uint32_t lost;          // bytes lost by the reader before this snapshot
+    uint16_t nameLength;    // length of the author name that follows, no terminator
+    uint16_t reserved;
+};
+
+// Appends snapshots to a memory-mapped file ring. Not thread-safe, intended to be used
+// by the single thread that processes snapshots.
+class PersistentLogWriter {
+public:
+    // Largest ring capacity. Records are no larger than the ring, so their length always
+    // fits PersistentLogRecord::length, and the whole file can be mapped on 32-bit devices.
+    static constexpr size_t kMaxCapacity = 1u << 30;
+
+    // Opens the file, or creates it if it does not exist or has a different layout.
+    // An existing file with the same capacity is appended to. The capacity is clamped to
+    // kMaxCapacity.
+    // Returns nullptr on error.
+    static std::unique_ptr<PersistentLogWriter> open(const char *path, size_t capacity);
+
+    ~PersistentLogWriter();
+
+    // Appends the entries in [begin, end). Returns false if they do not fit in the ring.
+    bool append(int author, const std::string &name, size_t lost,
+                EntryIterator begin, EntryIterator end);
+
+private:
+    PersistentLogWriter(uint8_t *map, size_t mapSize);
+
+    uint8_t * const             mMap;       // whole file
+    const size_t                mMapSize;
+    PersistentLogHeader * const mHeader;    // at start of mMap
+    uint8_t * const             mData;      // data ring, after mHeader
+};
+
+// Reads the records of a persistent log file, oldest first.
+// The file is read in full when opened, so it can be a live file.
+class PersistentLogReader {
+public:
+    struct Record {
+        int                  author;
+        std::string          name;
+        size_t               lost;
+        std::vector<uint8_t> entries;   // complete log entries
+
+        EntryIterator begin() const { return EntryIterator(entries.data()); }
+        EntryIterator end() const { return EntryIterator(entries.data() + entries.size()); }
+    };
+
+    // Returns nullptr if the file cannot be read or is not a persistent log.
+    static std::unique_ptr<PersistentLogReader> open(const char *path);
+
+    // Reads the next record. Returns false at the end of the log, or if the rest
+    // of the log is inconsistent.
+    bool next(Record *record);
+
+private:
+    PersistentLogReader() = default;
+
+    std::vector<uint8_t> mData;     // data ring
+    uint64_t             mPosition = 0;
+    uint64_t             mRear = 0;
+};
+
+}   // namespace NBLog
+}   // namespace android
+
+#endif  // ANDROID_MEDIA_NBLOG_PERSISTENT_LOG_H
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "PersistentLog_tests"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <media/nblog/PersistentLog.h>
+
+using namespace android;
+using namespace android::NBLog;
+
+namespace {
+
+// The raw entries of snapshot |index|: a few entries whose sizes and contents depend
+// on |index|, each laid out as in the shared memory FIFO.
+std::vector<uint8_t> makeEntries(int index) {
+    std::vector<uint8_t> entries;
+    for (int i = 0; i < 1 + index % 3; i++) {
+        const uint8_t length = 4 + (index + i) % 20;
+        entries.push_back(EVENT_HISTOGRAM_ENTRY_TS);
+        entries.push_back(length);
+        for (uint8_t j = 0; j < length; j++) {
+            entries.push_back((uint8_t) (index * 7 + j));
+        }
+        entries.push_back(length);
+    }
+    return entries;
+}
+
+std::string makeName(int index) {
+    return "author" + std::to_string(index % 4);
+}
+
+bool append(PersistentLogWriter *writer, int index) {
+    const std::vector<uint8_t> entries = makeEntries(index);
+    return writer->append(index % 4, makeName(index), index, EntryIterator(entries.data()),
+                          EntryIterator(entries.data() + entries.size()));
+}
+
+// Expects the records in the file to be those of snapshots [first, last).
+void expectRecords(const std::string &path, int first, int last) {
+    std::unique_ptr<PersistentLogReader> reader = PersistentLogReader::open(path.c_str());
+    ASSERT_NE(nullptr, reader);
+    PersistentLogReader::Record record;
+    for (int index = first; index < last; index++) {
+        ASSERT_TRUE(reader->next(&record)) << "record " << index;
+        EXPECT_EQ(index % 4, record.author);
+        EXPECT_EQ(makeName(index), record.name);
+        EXPECT_EQ((size_t) index, record.lost);
+        EXPECT_EQ(makeEntries(index), record.entries);
+    }
+    EXPECT_FALSE(reader->next(&record));
+}
+
+size_t recordSize(int index) {
+    return sizeof(PersistentLogRecord) + makeName(index).size() + makeEntries(index).size();
+}
+
+class PersistentLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        const char *dir = getenv("TMPDIR");
+        mPath = std::string(dir != nullptr ? dir : "/tmp") + "/PersistentLog_tests_"
+                + std::to_string(getpid());
+        unlink(mPath.c_str());
+    }
+
+    void TearDown() override { unlink(mPath.c_str()); }
+
+    // Overwrites the length of the record at |position| in the file.
+    void corruptRecordLength(uint64_t capacity, uint64_t position, uint32_t length) {
+        FILE *file = fopen(mPath.c_str(), "r+b");
+        ASSERT_NE(nullptr, file);
+        // The record header does not wrap in the tests that corrupt it.
+        ASSERT_LE(position % capacity + sizeof(PersistentLogRecord), capacity);
+        ASSERT_EQ(0, fseek(file, sizeof(PersistentLogHeader) + position % capacity
+                + offsetof(PersistentLogRecord, length), SEEK_SET));
+        ASSERT_EQ(1u, fwrite(&length, sizeof(length), 1, file));
+        ASSERT_EQ(0, fclose(file));
+    }
+
+    std::string mPath;
+};
+
+} // namespace
+
+TEST_F(PersistentLogTest, WriteAndRead) {
+    std::unique_ptr<PersistentLogWriter> writer = PersistentLogWriter::open(mPath.c_str(), 4096);
+    ASSERT_NE(nullptr, writer);
+    for (int index = 0; index < 10; index++) {
+        ASSERT_TRUE(append(writer.get(), index));
+    }
+    // The reader can open a live file.
+    expectRecords(mPath, 0, 10);
+    writer.reset();
+    expectRecords(mPath, 0, 10);
+}
+
+TEST_F(PersistentLogTest, WritePastCapacity) {
+    constexpr size_t kCapacity = 1000;
+    std::unique_ptr<PersistentLogWriter> writer =
+            PersistentLogWriter::open(mPath.c_str(), kCapacity);
+    ASSERT_NE(nullptr, writer);
+
+    // Many times the capacity, so that records wrap around the end of the ring at
+    // different offsets.
+    constexpr int kRecords = 200;
+    for (int index = 0; index < kRecords; index++) {
+        ASSERT_TRUE(append(writer.get(), index));
+    }
+    writer.reset();
+
+    // Only the most recent records that fit are kept.
+    int first = kRecords;
+    size_t size = 0;
+    while (first > 0 && size + recordSize(first - 1) <= kCapacity) {
+        size += recordSize(--first);
+    }
+    expectRecords(mPath, first, kRecords);
+
+    // A record larger than the ring is rejected, and the log is left as is.
+    writer = PersistentLogWriter::open(mPath.c_str(), kCapacity);
+    ASSERT_NE(nullptr, writer);
+    const std::vector<uint8_t> entries(kCapacity, 0);
+    EXPECT_FALSE(writer->append(0, "large", 0, EntryIterator(entries.data()),
+                                EntryIterator(entries.data() + entries.size())));
+    writer.reset();
+    expectRecords(mPath, first, kRecords);
+}
+
+TEST_F(PersistentLogTest, Reopen) {
+    std::unique_ptr<PersistentLogWriter> writer = PersistentLogWriter::open(mPath.c_str(), 4096);
+    ASSERT_NE(nullptr, writer);
+    for (int index = 0; index < 5; index++) {
+        ASSERT_TRUE(append(writer.get(), index));
+    }
+    writer.reset();
+
+    // Reopening with the same capacity appends to the log.
+    writer = PersistentLogWriter::open(mPath.c_str(), 4096);
+    ASSERT_NE(nullptr, writer);
+    for (int index = 5; index < 10; index++) {
+        ASSERT_TRUE(append(writer.get(), index));
+    }
+    writer.reset();
+    expectRecords(mPath, 0, 10);
+
+    // Reopening with another capacity starts over.
+    writer = PersistentLogWriter::open(mPath.c_str(), 2048);
+    ASSERT_NE(nullptr, writer);
+    for (int index = 10; index < 12; index++) {
+        ASSERT_TRUE(append(writer.get(), index));
+    }
+    writer.reset();
+    expectRecords(mPath, 10, 12);
+}
+
+TEST_F(PersistentLogTest, CorruptRecordHeader) {
+    constexpr size_t kCapacity = 4096;
+    std::unique_ptr<PersistentLogWriter> writer =
+            PersistentLogWriter::open(mPath.c_str(), kCapacity);
+    ASSERT_NE(nullptr, writer);
+    for (int index = 0; index < 5; index++) {
+        ASSERT_TRUE(append(writer.get(), index));
+    }
+    writer.reset();
+
+    // A record running past the end of the log ends reading before it.
+    const uint64_t third = recordSize(0) + recordSize(1);
+    corruptRecordLength(kCapacity, third, kCapacity);
+    expectRecords(mPath, 0, 2);
+
+    // So does a record too short for its own header.
+    corruptRecordLength(kCapacity, third, sizeof(PersistentLogRecord) - 1);
+    expectRecords(mPath, 0, 2);
+
+    // A writer that has to drop the corrupt record drops the whole log, and carries on.
+    corruptRecordLength(kCapacity, 0, 0);
+    writer = PersistentLogWriter::open(mPath.c_str(), kCapacity);
+    ASSERT_NE(nullptr, writer);
+    int index = 5;
+    size_t size = 0;
+    for (int i = 0; i < 5; i++) {
+        size += recordSize(i);
+    }
+    while (size + recordSize(index) <= kCapacity) {
+        size += recordSize(index);
+        ASSERT_TRUE(append(writer.get(), index++));
+    }
+    const int first = index;
+    ASSERT_TRUE(append(writer.get(), index++));
+    writer.reset();
+    expectRecords(mPath, first, index);
+}
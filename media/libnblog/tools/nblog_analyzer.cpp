@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reads a persistent log written by media.log and prints the same reports as
+// "dumpsys media.log --pa --json --plots --retro", for the whole history in the file.
+//
+// Usage: nblog_analyzer [--pa] [--json] [--plots] [--retro] <file>
+// With no option, all reports are printed.
+// Pull the file from the device first, e.g. adb pull /data/misc/audioserver/nblog.bin
+
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+
+#include <media/nblog/PerformanceCollector.h>
+#include <media/nblog/PersistentLog.h>
+
+using namespace android;
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [--pa] [--json] [--plots] [--retro] <file>\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    bool pa = false, json = false, plots = false, retro = false;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--pa")) {
+            pa = true;
+        } else if (!strcmp(argv[i], "--json")) {
+            json = true;
+        } else if (!strcmp(argv[i], "--plots")) {
+            plots = true;
+        } else if (!strcmp(argv[i], "--retro")) {
+            retro = true;
+        } else if (argv[i][0] != '-' && path == nullptr) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path == nullptr) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!pa && !json && !plots && !retro) {
+        pa = json = plots = retro = true;
+    }
+
+    std::unique_ptr<NBLog::PersistentLogReader> reader = NBLog::PersistentLogReader::open(path);
+    if (reader == nullptr) {
+        fprintf(stderr, "%s: cannot read persistent log %s\n", argv[0], path);
+        return 1;
+    }
+
+    NBLog::PerformanceCollector collector;
+    std::map<int, std::string> names;
+    std::map<int, size_t> lost;
+    size_t records = 0;
+    NBLog::PersistentLogReader::Record record;
+    while (reader->next(&record)) {
+        collector.processEntries(record.begin(), record.end(), record.author);
+        names[record.author] = record.name;
+        lost[record.author] += record.lost;
+        records++;
+    }
+
+    printf("%zu records\n", records);
+    for (const auto &item : names) {
+        printf("author %d: %s, %zu bytes lost\n", item.first, item.second.c_str(),
+               lost[item.first]);
+    }
+    fflush(stdout);
+    collector.dump(STDOUT_FILENO, pa, json, plots, retro);
+    return 0;
+}
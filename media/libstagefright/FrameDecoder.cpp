@@ -24,6 +24,8 @@
 #include <binder/MemoryHeapBase.h>
 #include <gui/Surface.h>
 #include <inttypes.h>
+#include <algorithm>
+#include <thread>
 #include <mediadrm/ICrypto.h>
 #include <media/IMediaSource.h>
 #include <media/MediaCodecBuffer.h>
@@ -46,6 +48,8 @@ namespace android {
 static const int64_t kBufferTimeOutUs = 10000LL; // 10 msec
 static const size_t kRetryCount = 100; // must be >0
 static const int64_t kDefaultSampleDurationUs = 33333LL; // 33ms
+// max threads used to convert a full video frame; only large frames are split
+static const size_t kMaxColorConverterThreads = 4;
 
 sp<IMemory> allocVideoFrame(const sp<MetaData>& trackMeta,
         int32_t width, int32_t height, int32_t tileWidth, int32_t tileHeight,
@@ -660,6 +664,8 @@ status_t VideoFrameDecoder::onOutputReceived(
     }
 
     ColorConverter converter((OMX_COLOR_FORMATTYPE)srcFormat, dstFormat());
+    converter.setNumThreads(std::min(
+            (size_t)std::thread::hardware_concurrency(), kMaxColorConverterThreads));
 
     uint32_t standard, range, transfer;
     if (!outputFormat->findInt32("color-standard", (int32_t*)&standard)) {
@@ -174,6 +174,10 @@ static const char *kCodecPlaybackDurationSec =
    >=0: number of fields changed */
 static const char *kCodecShapingEnhanced = "android.media.mediacodec.shaped";
 
+// prefix of the statistics reported by the buffer channel, see
+// BufferChannelBase::getMetrics()
+static const char *kCodecMetricsPrefix = "android.media.mediacodec.";
+
 // XXX suppress until we get our representation right
 static bool kEmitHistogram = false;
 
@@ -891,6 +895,20 @@ void MediaCodec::updateMediametrics() {
         mediametrics_setInt64(mMetricsHandle, kCodecVideoInputBytes, mBytesInput);
     }
 
+    if (mBufferChannel != nullptr) {
+        sp<AMessage> channelMetrics = new AMessage;
+        mBufferChannel->getMetrics(channelMetrics);
+        for (size_t i = 0; i < channelMetrics->countEntries(); ++i) {
+            AMessage::Type type;
+            const char *name = channelMetrics->getEntryNameAt(i, &type);
+            int64_t value;
+            if (type == AMessage::kTypeInt64 && channelMetrics->findInt64(name, &value)) {
+                std::string key = std::string(kCodecMetricsPrefix) + name;
+                mediametrics_setInt64(mMetricsHandle, key.c_str(), value);
+            }
+        }
+    }
+
     {
         Mutex::Autolock al(mLatencyLock);
         mediametrics_setInt64(mMetricsHandle, kCodecNumLowLatencyModeOn, mNumLowLatencyEnables);
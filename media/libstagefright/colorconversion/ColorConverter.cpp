@@ -29,8 +29,15 @@
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/video_common.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <mutex>
+#include <pthread.h>
 #include <sys/time.h>
+#include <thread>
+#include <vector>
 
 #define USE_LIBYUV
 #define PERF_PROFILING 0
@@ -42,12 +49,91 @@
 #define USE_NEON_Y410 0
 #endif
 
-#if USE_NEON_Y410
+#if defined(__aarch64__) || defined(__ARM_NEON__)
+#define USE_NEON_YUV2RGB 1
+#define USE_SSE_YUV2RGB 0
+#elif defined(__SSE4_1__)
+#define USE_NEON_YUV2RGB 0
+#define USE_SSE_YUV2RGB 1
+#else
+#define USE_NEON_YUV2RGB 0
+#define USE_SSE_YUV2RGB 0
+#endif
+
+#if USE_NEON_Y410 || USE_NEON_YUV2RGB
 #include <arm_neon.h>
 #endif
 
+#if USE_SSE_YUV2RGB
+#include <smmintrin.h>
+#endif
+
 namespace android {
 
+// Frames are only split when every band gets at least this many rows, so that
+// the cost of handing a band to a worker thread stays small compared to the work.
+static const size_t kMinRowsPerBand = 128;
+
+// Worker threads shared by all the converters of the process, so that converting
+// a frame in bands does not start and join threads every time. The pool is
+// created on first use, grows to the largest number of bands converted at once,
+// and is never destroyed.
+class BandWorkers {
+public:
+    static BandWorkers &get() {
+        static BandWorkers *workers = new BandWorkers;
+        return *workers;
+    }
+
+    // Runs job(i) for i in [1, count) on the workers and job(0) on the calling
+    // thread, and returns when all of them are done.
+    void run(size_t count, const std::function<void(size_t)> &job) {
+        std::condition_variable doneCond;
+        size_t remaining = count - 1;
+        {
+            std::lock_guard<std::mutex> lock(mLock);
+            for (; mNumThreads < count - 1; ++mNumThreads) {
+                std::thread(&BandWorkers::threadLoop, this).detach();
+            }
+            for (size_t i = 1; i < count; ++i) {
+                mQueue.push_back([this, &job, &doneCond, &remaining, i] {
+                    job(i);
+                    // notify with the lock held, so that doneCond outlives the call
+                    std::lock_guard<std::mutex> lock(mLock);
+                    if (--remaining == 0) {
+                        doneCond.notify_one();
+                    }
+                });
+            }
+        }
+        mWorkCond.notify_all();
+
+        job(0);
+
+        std::unique_lock<std::mutex> lock(mLock);
+        doneCond.wait(lock, [&remaining] { return remaining == 0; });
+    }
+
+private:
+    void threadLoop() {
+        pthread_setname_np(pthread_self(), "ColorConverter");
+        std::unique_lock<std::mutex> lock(mLock);
+        for (;;) {
+            mWorkCond.wait(lock, [this] { return !mQueue.empty(); });
+            std::function<void()> work = std::move(mQueue.front());
+            mQueue.pop_front();
+            lock.unlock();
+            work();
+            lock.lock();
+        }
+    }
+
+    std::mutex mLock;
+    std::condition_variable mWorkCond;
+    std::deque<std::function<void()>> mQueue;   // guarded by mLock
+    size_t mNumThreads = 0;                     // guarded by mLock
+};
+
 static bool isRGB(OMX_COLOR_FORMATTYPE colorFormat) {
     return colorFormat == OMX_COLOR_Format16bitRGB565
             || colorFormat == OMX_COLOR_Format32BitRGBA8888
@@ -70,7 +156,9 @@ ColorConverter::ColorConverter(
     : mSrcFormat(from),
       mDstFormat(to),
       mSrcColorSpace({0, 0, 0}),
-      mClip(NULL) {
+      mClip(NULL),
+      mNumThreads(1),
+      mUseSimd(true) {
 }
 
 ColorConverter::~ColorConverter() {
@@ -123,6 +211,14 @@ void ColorConverter::setSrcColorSpace(
     mSrcColorSpace.mTransfer = transfer;
 }
 
+void ColorConverter::setNumThreads(size_t numThreads) {
+    mNumThreads = std::max(numThreads, (size_t)1);
+}
+
+void ColorConverter::setUseSimd(bool useSimd) {
+    mUseSimd = useSimd;
+}
+
 /*
  * If stride is non-zero, client's stride will be used. For planar
  * or semi-planar YUV formats, stride must be even numbers.
@@ -211,6 +307,70 @@ status_t ColorConverter::convert(
         return ERROR_UNSUPPORTED;
     }
 
+    size_t numBands = std::min(mNumThreads, src.cropHeight() / kMinRowsPerBand);
+    if (numBands > 1 && canConvertInBands()) {
+        return convertInBands(src, dst, numBands);
+    }
+
+    return convertInternal(src, dst);
+}
+
+bool ColorConverter::canConvertInBands() const {
+    // The QCOM and CbYCrY converters derive their source row addresses from
+    // the crop rectangle in ways that do not match advancing row by row, so
+    // they are always converted in one piece.
+    switch (mSrcFormat) {
+        case OMX_COLOR_FormatYUV420Planar:
+        case OMX_COLOR_FormatYUV420Planar16:
+        case OMX_COLOR_FormatYUV420SemiPlanar:
+        case OMX_TI_COLOR_FormatYUV420PackedSemiPlanar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+status_t ColorConverter::convertInBands(
+        const BitmapParams &src, const BitmapParams &dst, size_t numBands) {
+    // Bands start on even rows so that chroma rows are never shared between
+    // two bands, which keeps the output identical to a single pass.
+    size_t bandHeight = (src.cropHeight() + numBands - 1) / numBands;
+    bandHeight = (bandHeight + 1) & ~1;
+
+    // the clip table is lazily initialized, so do it before going concurrent
+    initClip();
+
+    std::vector<BitmapParams> srcBands;
+    std::vector<BitmapParams> dstBands;
+    for (size_t top = 0; top < src.cropHeight(); top += bandHeight) {
+        size_t bottom = std::min(top + bandHeight, src.cropHeight()) - 1;
+
+        BitmapParams srcBand = src;
+        srcBand.mCropTop = src.mCropTop + top;
+        srcBand.mCropBottom = src.mCropTop + bottom;
+        srcBands.push_back(srcBand);
+
+        BitmapParams dstBand = dst;
+        dstBand.mCropTop = dst.mCropTop + top;
+        dstBand.mCropBottom = dst.mCropTop + bottom;
+        dstBands.push_back(dstBand);
+    }
+
+    std::vector<status_t> results(srcBands.size(), OK);
+    BandWorkers::get().run(srcBands.size(), [this, &srcBands, &dstBands, &results](size_t i) {
+        results[i] = convertInternal(srcBands[i], dstBands[i]);
+    });
+
+    for (status_t result : results) {
+        if (result != OK) {
+            return result;
+        }
+    }
+    return OK;
+}
+
+status_t ColorConverter::convertInternal(
+        const BitmapParams &src, const BitmapParams &dst) {
     status_t err;
 
     switch (mSrcFormat) {
@@ -265,6 +425,316 @@ status_t ColorConverter::convert(
     return err;
 }
 
+/*
+ * Vectorized row kernels for the YUV -> RGB conversions that are not handled
+ * by libyuv. They implement exactly the same integer math as the scalar loops
+ * below (BT.601 limited range, 8-bit coefficients, division truncating toward
+ * zero, clipped to 0..255), 8 pixels at a time, so output is bit-identical.
+ * Each kernel converts the largest multiple of 8 pixels of a row and returns
+ * that count; the scalar loops finish the remainder.
+ */
+
+enum YuvRowLayout {
+    kYuvRowPlanar16,        // separate 16-bit Y, U and V planes holding 10-bit samples
+    kYuvRowSemiPlanarUV,    // 8-bit Y plane and interleaved U/V plane
+    kYuvRowCbYCrY,          // packed U Y0 V Y1
+};
+
+enum RgbRowLayout {
+    kRgbRow565,             // R in the most significant bits
+    kRgbRowBgr565,          // B in the most significant bits
+    kRgbRowRGBA8888,
+    kRgbRowBGRA8888,
+};
+
+typedef size_t (*ConvertRowFunc)(
+        const void *srcY, const void *srcU, const void *srcV, uint8_t *dst, size_t width);
+
+#if USE_SSE_YUV2RGB
+
+// Loads 8 pixels at |x| as Y - 16, U - 128 and V - 128 in 16-bit lanes, with
+// each chroma sample duplicated for the two pixels it covers.
+template<YuvRowLayout SRC>
+static inline void loadYuvSse(
+        const void *srcY, const void *srcU, const void *srcV, size_t x,
+        __m128i *y, __m128i *u, __m128i *v) {
+    switch (SRC) {
+        case kYuvRowPlanar16:
+        {
+            *y = _mm_srli_epi16(
+                    _mm_loadu_si128((const __m128i *)((const uint16_t *)srcY + x)), 2);
+            *u = _mm_srli_epi16(
+                    _mm_loadl_epi64((const __m128i *)((const uint16_t *)srcU + x / 2)), 2);
+            *v = _mm_srli_epi16(
+                    _mm_loadl_epi64((const __m128i *)((const uint16_t *)srcV + x / 2)), 2);
+            *u = _mm_unpacklo_epi16(*u, *u);
+            *v = _mm_unpacklo_epi16(*v, *v);
+            break;
+        }
+        case kYuvRowSemiPlanarUV:
+        case kYuvRowCbYCrY:
+        {
+            // chroma pairs end up as U V in the low and high half of each 32-bit lane
+            __m128i chroma;
+            if (SRC == kYuvRowCbYCrY) {
+                __m128i packed = _mm_loadu_si128((const __m128i *)((const uint8_t *)srcY + x * 2));
+                *y = _mm_srli_epi16(packed, 8);
+                chroma = _mm_and_si128(packed, _mm_set1_epi16(0xFF));
+            } else {
+                *y = _mm_cvtepu8_epi16(
+                        _mm_loadl_epi64((const __m128i *)((const uint8_t *)srcY + x)));
+                chroma = _mm_cvtepu8_epi16(
+                        _mm_loadl_epi64((const __m128i *)((const uint8_t *)srcU + x)));
+            }
+            *u = _mm_and_si128(chroma, _mm_set1_epi32(0xFFFF));
+            *v = _mm_srli_epi32(chroma, 16);
+            *u = _mm_or_si128(*u, _mm_slli_epi32(*u, 16));
+            *v = _mm_or_si128(*v, _mm_slli_epi32(*v, 16));
+            break;
+        }
+    }
+    *y = _mm_sub_epi16(*y, _mm_set1_epi16(16));
+    *u = _mm_sub_epi16(*u, _mm_set1_epi16(128));
+    *v = _mm_sub_epi16(*v, _mm_set1_epi16(128));
+}
+
+// (x / 256) rounding toward zero, as the scalar code does
+static inline __m128i div256Sse(__m128i x) {
+    return _mm_srai_epi32(
+            _mm_add_epi32(x, _mm_and_si128(_mm_srai_epi32(x, 31), _mm_set1_epi32(255))), 8);
+}
+
+// Converts 4 pixels held in 32-bit lanes.
+static inline void yuvToRgb4Sse(
+        __m128i y, __m128i u, __m128i v, __m128i *r, __m128i *g, __m128i *b) {
+    __m128i tmp = _mm_mullo_epi32(y, _mm_set1_epi32(298));
+    *b = div256Sse(_mm_add_epi32(tmp, _mm_mullo_epi32(u, _mm_set1_epi32(517))));
+    *g = div256Sse(_mm_sub_epi32(tmp, _mm_add_epi32(
+            _mm_mullo_epi32(v, _mm_set1_epi32(208)), _mm_mullo_epi32(u, _mm_set1_epi32(100)))));
+    *r = div256Sse(_mm_add_epi32(tmp, _mm_mullo_epi32(v, _mm_set1_epi32(409))));
+}
+
+// Converts 8 pixels, returning the clipped components as 16-bit lanes.
+static inline void yuvToRgb8Sse(
+        __m128i y, __m128i u, __m128i v, __m128i *r, __m128i *g, __m128i *b) {
+    __m128i rlo, glo, blo, rhi, ghi, bhi;
+    yuvToRgb4Sse(_mm_cvtepi16_epi32(y), _mm_cvtepi16_epi32(u), _mm_cvtepi16_epi32(v),
+            &rlo, &glo, &blo);
+    yuvToRgb4Sse(_mm_cvtepi16_epi32(_mm_srli_si128(y, 8)),
+            _mm_cvtepi16_epi32(_mm_srli_si128(u, 8)),
+            _mm_cvtepi16_epi32(_mm_srli_si128(v, 8)),
+            &rhi, &ghi, &bhi);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    *r = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(rlo, rhi), zero), max);
+    *g = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(glo, ghi), zero), max);
+    *b = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(blo, bhi), zero), max);
+}
+
+template<RgbRowLayout DST>
+static inline void storeRgbSse(uint8_t *dst, __m128i r, __m128i g, __m128i b) {
+    switch (DST) {
+        case kRgbRow565:
+        case kRgbRowBgr565:
+        {
+            __m128i hi = (DST == kRgbRow565) ? r : b;
+            __m128i lo = (DST == kRgbRow565) ? b : r;
+            __m128i rgb = _mm_or_si128(
+                    _mm_or_si128(
+                            _mm_and_si128(_mm_slli_epi16(hi, 8), _mm_set1_epi16(0xF800)),
+                            _mm_and_si128(_mm_slli_epi16(g, 3), _mm_set1_epi16(0x07E0))),
+                    _mm_srli_epi16(lo, 3));
+            _mm_storeu_si128((__m128i *)dst, rgb);
+            break;
+        }
+        case kRgbRowRGBA8888:
+        case kRgbRowBGRA8888:
+        {
+            __m128i first = (DST == kRgbRowRGBA8888) ? r : b;
+            __m128i third = (DST == kRgbRowRGBA8888) ? b : r;
+            // 16-bit lanes of (c0 | c1 << 8)
+            __m128i c01 = _mm_or_si128(first, _mm_slli_epi16(g, 8));
+            __m128i c23 = _mm_or_si128(third, _mm_set1_epi16((int16_t)0xFF00));
+            _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(c01, c23));
+            _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(c01, c23));
+            break;
+        }
+    }
+}
+
+template<YuvRowLayout SRC, RgbRowLayout DST>
+static size_t convertRowSimd(
+        const void *srcY, const void *srcU, const void *srcV, uint8_t *dst, size_t width) {
+    const size_t bpp = (DST == kRgbRow565 || DST == kRgbRowBgr565) ? 2 : 4;
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i y, u, v, r, g, b;
+        loadYuvSse<SRC>(srcY, srcU, srcV, x, &y, &u, &v);
+        yuvToRgb8Sse(y, u, v, &r, &g, &b);
+        storeRgbSse<DST>(dst + x * bpp, r, g, b);
+    }
+    return x;
+}
+
+#elif USE_NEON_YUV2RGB
+
+// Loads 8 pixels at |x| as Y - 16, U - 128 and V - 128 in 16-bit lanes, with
+// each chroma sample duplicated for the two pixels it covers.
+template<YuvRowLayout SRC>
+static inline void loadYuvNeon(
+        const void *srcY, const void *srcU, const void *srcV, size_t x,
+        int16x8_t *y, int16x8_t *u, int16x8_t *v) {
+    uint16x8_t y16, u16, v16;
+    switch (SRC) {
+        case kYuvRowPlanar16:
+        {
+            y16 = vshrq_n_u16(vld1q_u16((const uint16_t *)srcY + x), 2);
+            uint16x4_t u4 = vshr_n_u16(vld1_u16((const uint16_t *)srcU + x / 2), 2);
+            uint16x4_t v4 = vshr_n_u16(vld1_u16((const uint16_t *)srcV + x / 2), 2);
+            uint16x4x2_t uu = vzip_u16(u4, u4);
+            uint16x4x2_t vv = vzip_u16(v4, v4);
+            u16 = vcombine_u16(uu.val[0], uu.val[1]);
+            v16 = vcombine_u16(vv.val[0], vv.val[1]);
+            break;
+        }
+        case kYuvRowSemiPlanarUV:
+        case kYuvRowCbYCrY:
+        {
+            // chroma pairs end up as U V in the low and high half of each 32-bit lane
+            uint32x4_t chroma;
+            if (SRC == kYuvRowCbYCrY) {
+                uint16x8_t packed = vreinterpretq_u16_u8(
+                        vld1q_u8((const uint8_t *)srcY + x * 2));
+                y16 = vshrq_n_u16(packed, 8);
+                chroma = vreinterpretq_u32_u16(vandq_u16(packed, vdupq_n_u16(0xFF)));
+            } else {
+                y16 = vmovl_u8(vld1_u8((const uint8_t *)srcY + x));
+                chroma = vreinterpretq_u32_u16(vmovl_u8(vld1_u8((const uint8_t *)srcU + x)));
+            }
+            uint32x4_t u32 = vandq_u32(chroma, vdupq_n_u32(0xFFFF));
+            uint32x4_t v32 = vshrq_n_u32(chroma, 16);
+            u16 = vreinterpretq_u16_u32(vorrq_u32(u32, vshlq_n_u32(u32, 16)));
+            v16 = vreinterpretq_u16_u32(vorrq_u32(v32, vshlq_n_u32(v32, 16)));
+            break;
+        }
+    }
+    *y = vsubq_s16(vreinterpretq_s16_u16(y16), vdupq_n_s16(16));
+    *u = vsubq_s16(vreinterpretq_s16_u16(u16), vdupq_n_s16(128));
+    *v = vsubq_s16(vreinterpretq_s16_u16(v16), vdupq_n_s16(128));
+}
+
+// (x / 256) rounding toward zero, as the scalar code does
+static inline int32x4_t div256Neon(int32x4_t x) {
+    return vshrq_n_s32(
+            vaddq_s32(x, vandq_s32(vshrq_n_s32(x, 31), vdupq_n_s32(255))), 8);
+}
+
+// Converts 4 pixels, returning the unclipped components.
+static inline void yuvToRgb4Neon(
+        int16x4_t y, int16x4_t u, int16x4_t v,
+        int32x4_t *r, int32x4_t *g, int32x4_t *b) {
+    int32x4_t tmp = vmull_n_s16(y, 298);
+    *b = div256Neon(vmlal_n_s16(tmp, u, 517));
+    *g = div256Neon(vmlsl_n_s16(vmlsl_n_s16(tmp, v, 208), u, 100));
+    *r = div256Neon(vmlal_n_s16(tmp, v, 409));
+}
+
+// Converts 8 pixels, returning the clipped components.
+static inline void yuvToRgb8Neon(
+        int16x8_t y, int16x8_t u, int16x8_t v, uint8x8_t *r, uint8x8_t *g, uint8x8_t *b) {
+    int32x4_t rlo, glo, blo, rhi, ghi, bhi;
+    yuvToRgb4Neon(vget_low_s16(y), vget_low_s16(u), vget_low_s16(v), &rlo, &glo, &blo);
+    yuvToRgb4Neon(vget_high_s16(y), vget_high_s16(u), vget_high_s16(v), &rhi, &ghi, &bhi);
+    *r = vqmovun_s16(vcombine_s16(vmovn_s32(rlo), vmovn_s32(rhi)));
+    *g = vqmovun_s16(vcombine_s16(vmovn_s32(glo), vmovn_s32(ghi)));
+    *b = vqmovun_s16(vcombine_s16(vmovn_s32(blo), vmovn_s32(bhi)));
+}
+
+template<RgbRowLayout DST>
+static inline void storeRgbNeon(uint8_t *dst, uint8x8_t r, uint8x8_t g, uint8x8_t b) {
+    switch (DST) {
+        case kRgbRow565:
+        case kRgbRowBgr565:
+        {
+            uint8x8_t hi = (DST == kRgbRow565) ? r : b;
+            uint8x8_t lo = (DST == kRgbRow565) ? b : r;
+            uint16x8_t rgb = vorrq_u16(
+                    vorrq_u16(
+                            vandq_u16(vshll_n_u8(hi, 8), vdupq_n_u16(0xF800)),
+                            vandq_u16(vshll_n_u8(g, 3), vdupq_n_u16(0x07E0))),
+                    vmovl_u8(vshr_n_u8(lo, 3)));
+            vst1q_u16((uint16_t *)dst, rgb);
+            break;
+        }
+        case kRgbRowRGBA8888:
+        case kRgbRowBGRA8888:
+        {
+            uint8x8x4_t rgba;
+            rgba.val[0] = (DST == kRgbRowRGBA8888) ? r : b;
+            rgba.val[1] = g;
+            rgba.val[2] = (DST == kRgbRowRGBA8888) ? b : r;
+            rgba.val[3] = vdup_n_u8(0xFF);
+            vst4_u8(dst, rgba);
+            break;
+        }
+    }
+}
+
+template<YuvRowLayout SRC, RgbRowLayout DST>
+static size_t convertRowSimd(
+        const void *srcY, const void *srcU, const void *srcV, uint8_t *dst, size_t width) {
+    const size_t bpp = (DST == kRgbRow565 || DST == kRgbRowBgr565) ? 2 : 4;
+    size_t x = 0;
+    for (; x + 8 <= width; x += 8) {
+        int16x8_t y, u, v;
+        uint8x8_t r, g, b;
+        loadYuvNeon<SRC>(srcY, srcU, srcV, x, &y, &u, &v);
+        yuvToRgb8Neon(y, u, v, &r, &g, &b);
+        storeRgbNeon<DST>(dst + x * bpp, r, g, b);
+    }
+    return x;
+}
+
+#else
+
+template<YuvRowLayout SRC, RgbRowLayout DST>
+static size_t convertRowSimd(
+        const void * /* srcY */, const void * /* srcU */, const void * /* srcV */,
+        uint8_t * /* dst */, size_t /* width */) {
+    return 0;
+}
+
+#endif // USE_SSE_YUV2RGB
+
+// leaves the whole row to the scalar loop
+static size_t convertRowNone(
+        const void * /* srcY */, const void * /* srcU */, const void * /* srcV */,
+        uint8_t * /* dst */, size_t /* width */) {
+    return 0;
+}
+
+template<YuvRowLayout SRC>
+static ConvertRowFunc getConvertRowSimd(RgbRowLayout dstLayout, bool useSimd) {
+    if (!useSimd) {
+        return convertRowNone;
+    }
+    switch (dstLayout) {
+        case kRgbRow565:        return convertRowSimd<SRC, kRgbRow565>;
+        case kRgbRowBgr565:     return convertRowSimd<SRC, kRgbRowBgr565>;
+        case kRgbRowRGBA8888:   return convertRowSimd<SRC, kRgbRowRGBA8888>;
+        case kRgbRowBGRA8888:   return convertRowSimd<SRC, kRgbRowBGRA8888>;
+    }
+    return nullptr;
+}
+
+static RgbRowLayout getRgbRowLayout(OMX_COLOR_FORMATTYPE dstFormat) {
+    switch (dstFormat) {
+        case OMX_COLOR_Format32BitRGBA8888: return kRgbRowRGBA8888;
+        case OMX_COLOR_Format32bitBGRA8888: return kRgbRowBGRA8888;
+        default:                            return kRgbRow565;
+    }
+}
+
 status_t ColorConverter::convertCbYCrY(
         const BitmapParams &src, const BitmapParams &dst) {
     // XXX Untested
@@ -277,8 +747,11 @@ status_t ColorConverter::convertCbYCrY(
     const uint8_t *src_ptr = (const uint8_t *)src.mBits
         + (src.mCropTop * dst.mWidth + src.mCropLeft) * 2;
 
+    ConvertRowFunc convertRow = getConvertRowSimd<kYuvRowCbYCrY>(kRgbRow565, mUseSimd);
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = convertRow(src_ptr, nullptr, nullptr, (uint8_t *)dst_ptr, src.cropWidth());
+        for (; x < src.cropWidth(); x += 2) {
             signed y1 = (signed)src_ptr[2 * x + 1] - 16;
             signed y2 = (signed)src_ptr[2 * x + 3] - 16;
             signed u = (signed)src_ptr[2 * x] - 128;
@@ -527,8 +1000,14 @@ status_t ColorConverter::convertYUV420Planar(
 
     uint8_t *src_v = src_u + (src.mStride / 2) * (src.mHeight / 2);
 
+    // 8-bit sources only get here without USE_LIBYUV.
+    ConvertRowFunc convertRow = mSrcFormat == OMX_COLOR_FormatYUV420Planar16
+            ? getConvertRowSimd<kYuvRowPlanar16>(getRgbRowLayout(mDstFormat), mUseSimd)
+            : convertRowNone;
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = convertRow(src_y, src_u, src_v, dst_ptr, src.cropWidth());
+        for (; x < src.cropWidth(); x += 2) {
             // B = 1.164 * (Y - 16) + 2.018 * (U - 128)
             // G = 1.164 * (Y - 16) - 0.813 * (V - 128) - 0.391 * (U - 128)
             // R = 1.164 * (Y - 16) + 1.596 * (V - 128)
@@ -648,6 +1127,37 @@ status_t ColorConverter::convertYUV420Planar16ToY410(
 
         uint32_t u01, v01, y01, y23, y45, y67, uv0, uv1;
         size_t x = 0;
+#if USE_SSE_YUV2RGB
+        // 8 pixels of both lines at a time
+        const __m128i mask10 = _mm_set1_epi16(0x3FF);
+        for (; mUseSimd && x + 8 <= src.cropWidth(); x += 8) {
+            __m128i u = _mm_cvtepu16_epi32(_mm_and_si128(
+                    _mm_loadl_epi64((const __m128i *)ptr_u), mask10));
+            __m128i v = _mm_cvtepu16_epi32(_mm_and_si128(
+                    _mm_loadl_epi64((const __m128i *)ptr_v), mask10));
+            __m128i uv = _mm_or_si128(u, _mm_slli_epi32(v, 20));
+            __m128i uv01 = _mm_unpacklo_epi32(uv, uv);
+            __m128i uv23 = _mm_unpackhi_epi32(uv, uv);
+            ptr_u += 4;
+            ptr_v += 4;
+
+            __m128i ytop = _mm_and_si128(_mm_loadu_si128((const __m128i *)ptr_ytop), mask10);
+            __m128i ybot = _mm_and_si128(_mm_loadu_si128((const __m128i *)ptr_ybot), mask10);
+            ptr_ytop += 8;
+            ptr_ybot += 8;
+
+            _mm_storeu_si128((__m128i *)dst_top, _mm_or_si128(uv01,
+                    _mm_slli_epi32(_mm_cvtepu16_epi32(ytop), 10)));
+            _mm_storeu_si128((__m128i *)(dst_top + 4), _mm_or_si128(uv23,
+                    _mm_slli_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(ytop, 8)), 10)));
+            _mm_storeu_si128((__m128i *)dst_bot, _mm_or_si128(uv01,
+                    _mm_slli_epi32(_mm_cvtepu16_epi32(ybot), 10)));
+            _mm_storeu_si128((__m128i *)(dst_bot + 4), _mm_or_si128(uv23,
+                    _mm_slli_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(ybot, 8)), 10)));
+            dst_top += 8;
+            dst_bot += 8;
+        }
+#endif
         for (; x < src.cropWidth() - 3; x += 4) {
             u01 = *((uint32_t*)ptr_u); ptr_u += 2;
             v01 = *((uint32_t*)ptr_v); ptr_v += 2;
@@ -833,8 +1343,11 @@ status_t ColorConverter::convertQCOMYUV420SemiPlanar(
         (const uint8_t *)src_y + src.mWidth * src.mHeight
         + src.mCropTop * src.mWidth + src.mCropLeft;
 
+    ConvertRowFunc convertRow = getConvertRowSimd<kYuvRowSemiPlanarUV>(kRgbRowBgr565, mUseSimd);
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = convertRow(src_y, src_u, nullptr, (uint8_t *)dst_ptr, src.cropWidth());
+        for (; x < src.cropWidth(); x += 2) {
             signed y1 = (signed)src_y[x] - 16;
             signed y2 = (signed)src_y[x + 1] - 16;
 
@@ -966,8 +1479,11 @@ status_t ColorConverter::convertTIYUV420PackedSemiPlanar(
     const uint8_t *src_u =
         (const uint8_t *)src_y + src.mWidth * (src.mHeight - src.mCropTop / 2);
 
+    ConvertRowFunc convertRow = getConvertRowSimd<kYuvRowSemiPlanarUV>(kRgbRow565, mUseSimd);
+
     for (size_t y = 0; y < src.cropHeight(); ++y) {
-        for (size_t x = 0; x < src.cropWidth(); x += 2) {
+        size_t x = convertRow(src_y, src_u, nullptr, (uint8_t *)dst_ptr, src.cropWidth());
+        for (; x < src.cropWidth(); x += 2) {
             signed y1 = (signed)src_y[x] - 16;
             signed y2 = (signed)src_y[x + 1] - 16;
 
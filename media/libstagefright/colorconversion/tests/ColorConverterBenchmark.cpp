@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/ColorConverter.h>
+#include <media/stagefright/foundation/ColorUtils.h>
+
+using namespace android;
+
+/*
+ * Measures ColorConverter::convert() throughput in MPix/s for every source and
+ * destination format pair ColorConverter converts with its own row kernels.
+ * I420 and NV12 sources go through libyuv and are left out. The first argument
+ * indexes kFormatPairs, the others are the frame width and height.
+ */
+
+struct FormatPair {
+    const char *mName;
+    OMX_COLOR_FORMATTYPE mSrc;
+    OMX_COLOR_FORMATTYPE mDst;
+    // bytes per sample of the source planes
+    size_t mSrcBpp;
+};
+
+static const FormatPair kFormatPairs[] = {
+    {"I420P16->RGB565", OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format16bitRGB565, 2},
+    {"I420P16->RGBA8888", OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32BitRGBA8888, 2},
+    {"I420P16->BGRA8888", OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_Format32bitBGRA8888, 2},
+    {"I420P16->Y410", OMX_COLOR_FormatYUV420Planar16, OMX_COLOR_FormatYUV444Y410, 2},
+    {"QCOM_NV12->RGB565",
+            OMX_QCOM_COLOR_FormatYVU420SemiPlanar, OMX_COLOR_Format16bitRGB565, 1},
+    {"TI_NV12->RGB565",
+            OMX_TI_COLOR_FormatYUV420PackedSemiPlanar, OMX_COLOR_Format16bitRGB565, 1},
+    {"CbYCrY->RGB565", OMX_COLOR_FormatCbYCrY, OMX_COLOR_Format16bitRGB565, 1},
+};
+
+static size_t dstBytesPerPixel(OMX_COLOR_FORMATTYPE format) {
+    return format == OMX_COLOR_Format16bitRGB565 ? 2 : 4;
+}
+
+static void BM_ColorConverter(benchmark::State &state) {
+    const FormatPair &pair = kFormatPairs[state.range(0)];
+    const size_t width = state.range(1);
+    const size_t height = state.range(2);
+
+    ColorConverter converter(pair.mSrc, pair.mDst);
+    if (!converter.isValid()) {
+        state.SkipWithError("unsupported format pair");
+        return;
+    }
+    converter.setSrcColorSpace(
+            ColorUtils::kColorStandardBT601_625, ColorUtils::kColorRangeLimited,
+            ColorUtils::kColorTransferSMPTE_170M);
+
+    // CbYCrY is a packed 2 bytes per pixel, everything else is 4:2:0
+    const size_t srcSize = pair.mSrc == OMX_COLOR_FormatCbYCrY
+            ? width * height * 2 : width * height * 3 / 2 * pair.mSrcBpp;
+    std::vector<uint8_t> src(srcSize);
+    std::vector<uint8_t> dst(width * height * dstBytesPerPixel(pair.mDst));
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> dis(0, 255);
+    for (uint8_t &byte : src) {
+        byte = dis(gen);
+    }
+    if (pair.mSrcBpp == 2) {
+        // keep 16-bit samples within 10 bits
+        uint16_t *samples = (uint16_t *)src.data();
+        for (size_t i = 0; i < src.size() / 2; ++i) {
+            samples[i] &= 0x3FF;
+        }
+    }
+
+    for (auto _ : state) {
+        status_t err = converter.convert(
+                src.data(), width, height, 0 /* srcStride */,
+                0, 0, width - 1, height - 1,
+                dst.data(), width, height, 0 /* dstStride */,
+                0, 0, width - 1, height - 1);
+        if (err != OK) {
+            state.SkipWithError("conversion failed");
+            return;
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetLabel(pair.mName);
+    state.counters["MPix/s"] = benchmark::Counter(
+            width * height / 1e6, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void FormatPairsAndResolutions(benchmark::internal::Benchmark *b) {
+    static const int kResolutions[][2] = {
+        {640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160},
+    };
+    for (size_t i = 0; i < sizeof(kFormatPairs) / sizeof(kFormatPairs[0]); ++i) {
+        for (const auto &resolution : kResolutions) {
+            b->Args({(int)i, resolution[0], resolution[1]});
+        }
+    }
+}
+
+BENCHMARK(BM_ColorConverter)->Apply(FormatPairsAndResolutions);
+
+BENCHMARK_MAIN();
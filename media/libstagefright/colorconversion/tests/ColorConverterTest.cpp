@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "ColorConverterTest"
+
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <media/stagefright/ColorConverter.h>
+#include <utils/Log.h>
+
+using namespace android;
+
+// source format, destination format, bytes per source sample
+using ColorConverterParams = std::tuple<OMX_COLOR_FORMATTYPE, OMX_COLOR_FORMATTYPE, size_t>;
+
+class ColorConverterTest : public ::testing::TestWithParam<ColorConverterParams> {
+  protected:
+    void SetUp() override {
+        std::tie(mSrcFormat, mDstFormat, mSrcBpp) = GetParam();
+    }
+
+    // Converts a frame with the given crop and number of threads and returns the destination.
+    std::vector<uint8_t> convert(
+            const std::vector<uint8_t> &src, size_t width, size_t height,
+            size_t cropLeft, size_t cropTop, size_t cropRight, size_t cropBottom,
+            size_t numThreads) {
+        ColorConverter converter(mSrcFormat, mDstFormat);
+        EXPECT_TRUE(converter.isValid());
+        converter.setNumThreads(numThreads);
+
+        size_t dstBpp = mDstFormat == OMX_COLOR_Format16bitRGB565 ? 2 : 4;
+        std::vector<uint8_t> dst(width * height * dstBpp, 0);
+        EXPECT_EQ(OK, converter.convert(
+                src.data(), width, height, 0 /* srcStride */,
+                cropLeft, cropTop, cropRight, cropBottom,
+                dst.data(), width, height, 0 /* dstStride */,
+                cropLeft, cropTop, cropRight, cropBottom));
+        return dst;
+    }
+
+    std::vector<uint8_t> makeSource(size_t width, size_t height, unsigned seed = 7) {
+        size_t size = mSrcFormat == OMX_COLOR_FormatCbYCrY
+                ? width * height * 2 : width * height * 3 / 2 * mSrcBpp;
+        std::vector<uint8_t> src(size);
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<int> dis(0, 255);
+        for (uint8_t &byte : src) {
+            byte = dis(gen);
+        }
+        if (mSrcBpp == 2) {
+            uint16_t *samples = (uint16_t *)src.data();
+            for (size_t i = 0; i < src.size() / 2; ++i) {
+                samples[i] &= 0x3FF;
+            }
+        }
+        return src;
+    }
+
+    OMX_COLOR_FORMATTYPE mSrcFormat;
+    OMX_COLOR_FORMATTYPE mDstFormat;
+    size_t mSrcBpp;
+};
+
+TEST_P(ColorConverterTest, SimdMatchesScalar) {
+    if (mSrcFormat == OMX_COLOR_FormatYUV420Planar
+            || mSrcFormat == OMX_COLOR_FormatYUV420SemiPlanar) {
+        GTEST_SKIP() << "converted by libyuv, which setUseSimd() does not affect";
+    }
+    std::mt19937 gen(11);
+    auto random = [&gen](size_t min, size_t max) {
+        return std::uniform_int_distribution<size_t>(min, max)(gen);
+    };
+    const size_t srcPixelBytes = mSrcFormat == OMX_COLOR_FormatCbYCrY ? 2 : mSrcBpp;
+    const size_t dstBpp = mDstFormat == OMX_COLOR_Format16bitRGB565 ? 2 : 4;
+
+    for (int i = 0; i < 100; ++i) {
+        // odd widths, crops that start on any even column and end on any column, and
+        // strides padded past the width
+        const size_t width = random(8, 400) | 1;
+        const size_t height = random(2, 64) & ~1;
+        const size_t cropLeft = random(0, (width - 4) / 2) * 2;
+        const size_t cropRight = random(cropLeft + 3, width - 1);
+        const size_t cropTop = random(0, height / 2);
+        const size_t cropBottom = random(cropTop, height - 1);
+        const size_t srcStride = ((width + random(0, 32)) * srcPixelBytes + 3) & ~3;
+        const size_t dstStride = (width + random(0, 32)) * dstBpp;
+
+        // both sides get some slack, the scalar loops convert pixels in pairs and the
+        // QCOM converter skips a full chroma row per cropped row
+        std::vector<uint8_t> src = makeSource(srcStride * 2, height + 2, i);
+        std::vector<uint8_t> expected(dstStride * (height + 2), 0);
+        std::vector<uint8_t> actual(dstStride * (height + 2), 0);
+
+        for (bool useSimd : {false, true}) {
+            ColorConverter converter(mSrcFormat, mDstFormat);
+            ASSERT_TRUE(converter.isValid());
+            converter.setUseSimd(useSimd);
+            ASSERT_EQ(OK, converter.convert(
+                    src.data(), width, height, srcStride,
+                    cropLeft, cropTop, cropRight, cropBottom,
+                    (useSimd ? actual : expected).data(), width, height, dstStride,
+                    cropLeft, cropTop, cropRight, cropBottom));
+        }
+        ASSERT_EQ(expected, actual) << "differs for a " << width << "x" << height
+                << " frame, crop " << cropLeft << "," << cropTop << " - "
+                << cropRight << "," << cropBottom << ", strides "
+                << srcStride << " and " << dstStride;
+    }
+}
+
+TEST_P(ColorConverterTest, MultiThreadedMatchesSingleThreaded) {
+    const size_t width = 1920;
+    const size_t height = 1088;
+    std::vector<uint8_t> src = makeSource(width, height);
+
+    std::vector<uint8_t> expected =
+            convert(src, width, height, 0, 0, width - 1, height - 1, 1 /* numThreads */);
+    for (size_t numThreads : {2, 3, 4, 8}) {
+        std::vector<uint8_t> actual =
+                convert(src, width, height, 0, 0, width - 1, height - 1, numThreads);
+        EXPECT_EQ(expected, actual) << "differs with " << numThreads << " threads";
+    }
+}
+
+TEST_P(ColorConverterTest, MultiThreadedMatchesSingleThreadedWithCrop) {
+    const size_t width = 1280;
+    const size_t height = 720;
+    std::vector<uint8_t> src = makeSource(width, height);
+
+    // odd top and height, so bands do not line up with the crop
+    const size_t cropLeft = 16, cropTop = 3, cropRight = 1263, cropBottom = 709;
+    std::vector<uint8_t> expected = convert(
+            src, width, height, cropLeft, cropTop, cropRight, cropBottom, 1 /* numThreads */);
+    std::vector<uint8_t> actual = convert(
+            src, width, height, cropLeft, cropTop, cropRight, cropBottom, 4 /* numThreads */);
+    EXPECT_EQ(expected, actual);
+}
+
+// Converters on different threads share the band workers.
+TEST_P(ColorConverterTest, ConcurrentConvertersMatchSingleThreaded) {
+    const size_t width = 1280;
+    const size_t height = 720;
+    std::vector<uint8_t> src = makeSource(width, height);
+    std::vector<uint8_t> expected =
+            convert(src, width, height, 0, 0, width - 1, height - 1, 1 /* numThreads */);
+
+    std::vector<std::vector<uint8_t>> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < 5; ++j) {
+                results[i] = convert(
+                        src, width, height, 0, 0, width - 1, height - 1, 1 + i % 4);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (const std::vector<uint8_t> &result : results) {
+        EXPECT_EQ(expected, result);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+        ColorConverterTestAll, ColorConverterTest,
+        ::testing::Values(
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar,
+                        OMX_COLOR_Format16bitRGB565, 1),
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar,
+                        OMX_COLOR_Format32BitRGBA8888, 1),
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar,
+                        OMX_COLOR_Format32bitBGRA8888, 1),
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar16,
+                        OMX_COLOR_Format16bitRGB565, 2),
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar16,
+                        OMX_COLOR_Format32BitRGBA8888, 2),
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar16,
+                        OMX_COLOR_Format32bitBGRA8888, 2),
+                std::make_tuple(OMX_COLOR_FormatYUV420Planar16,
+                        OMX_COLOR_FormatYUV444Y410, 2),
+                std::make_tuple(OMX_COLOR_FormatYUV420SemiPlanar,
+                        OMX_COLOR_Format16bitRGB565, 1),
+                std::make_tuple(OMX_COLOR_FormatYUV420SemiPlanar,
+                        OMX_COLOR_Format32BitRGBA8888, 1),
+                std::make_tuple(OMX_TI_COLOR_FormatYUV420PackedSemiPlanar,
+                        OMX_COLOR_Format16bitRGB565, 1),
+                std::make_tuple(OMX_QCOM_COLOR_FormatYVU420SemiPlanar,
+                        OMX_COLOR_Format16bitRGB565, 1),
+                std::make_tuple(OMX_COLOR_FormatCbYCrY,
+                        OMX_COLOR_Format16bitRGB565, 1)));
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    int status = RUN_ALL_TESTS();
+    ALOGV("Test result = %d\n", status);
+    return status;
+}
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include <sys/types.h>
 
 #include "AAtomizer.h"
@@ -25,7 +26,25 @@ AAtomizer AAtomizer::gAtomizer;
 
 // static
 const char *AAtomizer::Atomize(const char *name) {
-    return gAtomizer.atomize(name);
+    // Names are mostly string literals, so remember which atom was last returned
+    // for a given pointer on this thread and skip the global lock if its contents
+    // still match. Atoms are never freed, so cached atoms stay valid.
+    struct CacheEntry {
+        const char *mName;
+        const char *mAtom;
+    };
+    static thread_local CacheEntry sCache[kNumCacheEntries];
+
+    CacheEntry &entry =
+        sCache[(reinterpret_cast<uintptr_t>(name) >> 3) % kNumCacheEntries];
+    if (entry.mName == name && !strcmp(entry.mAtom, name)) {
+        return entry.mAtom;
+    }
+
+    const char *atom = gAtomizer.atomize(name);
+    entry.mName = name;
+    entry.mAtom = atom;
+    return atom;
 }
 
 AAtomizer::AAtomizer() {
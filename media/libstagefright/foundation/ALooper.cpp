@@ -23,6 +23,8 @@
 
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "ALooper.h"
 
 #include "AHandler.h"
@@ -70,7 +72,9 @@ int64_t ALooper::GetNowUs() {
 }
 
 ALooper::ALooper()
-    : mRunningLocally(false) {
+    : mNextEventSeq(0),
+      mRunningLocally(false),
+      mRunning(false) {
     // clean up stale AHandlers. Doing it here instead of in the destructor avoids
     // the side effect of objects being deleted from the unregister function recursively.
     gLooperRoster.unregisterStaleHandlers();
@@ -104,6 +108,7 @@ status_t ALooper::start(
             }
 
             mRunningLocally = true;
+            mRunning.store(true, std::memory_order_release);
         }
 
         do {
@@ -119,11 +124,13 @@ status_t ALooper::start(
     }
 
     mThread = new LooperThread(this, canCallJava);
+    mRunning.store(true, std::memory_order_release);
 
     status_t err = mThread->run(
             mName.empty() ? "ALooper" : mName.c_str(), priority);
     if (err != OK) {
         mThread.clear();
+        mRunning.store(false, std::memory_order_release);
     }
 
     return err;
@@ -140,6 +147,7 @@ status_t ALooper::stop() {
         runningLocally = mRunningLocally;
         mThread.clear();
         mRunningLocally = false;
+        mRunning.store(false, std::memory_order_release);
     }
 
     if (thread == NULL && !runningLocally) {
@@ -177,26 +185,24 @@ void ALooper::post(const sp<AMessage> &msg, int64_t delayUs) {
         whenUs = GetNowUs();
     }
 
-    List<Event>::iterator it = mEventQueue.begin();
-    while (it != mEventQueue.end() && (*it).mWhenUs <= whenUs) {
-        ++it;
-    }
-
     Event event;
     event.mWhenUs = whenUs;
+    event.mSeq = mNextEventSeq++;
     event.mMessage = msg;
 
-    if (it == mEventQueue.begin()) {
+    // only wake up the looper if the new event is now the earliest one
+    if (mEventQueue.empty() || whenUs < mEventQueue.front().mWhenUs) {
         mQueueChangedCondition.signal();
     }
 
-    mEventQueue.insert(it, event);
+    mEventQueue.push_back(event);
+    std::push_heap(mEventQueue.begin(), mEventQueue.end(), EventLater());
 }
 
 bool ALooper::loop() {
     Event event;
 
-    {
+    if (mDueEvents.empty()) {
         Mutex::Autolock autoLock(mLock);
         if (mThread == NULL && !mRunningLocally) {
             return false;
@@ -205,7 +211,7 @@ bool ALooper::loop() {
             mQueueChangedCondition.wait(mLock);
             return true;
         }
-        int64_t whenUs = (*mEventQueue.begin()).mWhenUs;
+        int64_t whenUs = mEventQueue.front().mWhenUs;
         int64_t nowUs = GetNowUs();
 
         if (whenUs > nowUs) {
@@ -218,10 +224,24 @@ bool ALooper::loop() {
             return true;
         }
 
-        event = *mEventQueue.begin();
-        mEventQueue.erase(mEventQueue.begin());
+        // Drain every event that is already due in one go, so that a burst of
+        // messages costs a single lock acquisition instead of one per message.
+        // Anything posted while these are delivered is due no earlier than
+        // nowUs, so time ordering is preserved.
+        do {
+            std::pop_heap(mEventQueue.begin(), mEventQueue.end(), EventLater());
+            mDueEvents.push_back(std::move(mEventQueue.back()));
+            mEventQueue.pop_back();
+        } while (!mEventQueue.empty() && mEventQueue.front().mWhenUs <= nowUs);
+    } else if (!mRunning.load(std::memory_order_acquire)) {
+        // a previous delivery stopped the looper; the remaining due events
+        // stay queued for a subsequent start(), as they would in mEventQueue.
+        return false;
     }
 
+    event = std::move(mDueEvents.front());
+    mDueEvents.pop_front();
+
     event.mMessage->deliver();
 
     // NOTE: It's important to note that at this point our "ALooper" object
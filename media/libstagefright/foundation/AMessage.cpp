@@ -54,11 +54,13 @@ status_t AReplyToken::setReply(const sp<AMessage> &reply) {
 
 AMessage::AMessage(void)
     : mWhat(0),
-      mTarget(0) {
+      mTarget(0),
+      mInternKeys(false) {
 }
 
 AMessage::AMessage(uint32_t what, const sp<const AHandler> &handler)
-    : mWhat(what) {
+    : mWhat(what),
+      mInternKeys(false) {
     setTarget(handler);
 }
 
@@ -89,13 +91,19 @@ void AMessage::setTarget(const sp<const AHandler> &handler) {
 void AMessage::clear() {
     // Item needs to be handled delicately
     for (Item &item : mItems) {
-        delete[] item.mName;
-        item.mName = NULL;
+        item.freeName();
         freeItemValue(&item);
     }
     mItems.clear();
 }
 
+void AMessage::setInternKeys(bool intern) {
+    mInternKeys = intern;
+    if (intern) {
+        mItems.reserve(kNumInternedItemsReserved);
+    }
+}
+
 void AMessage::freeItemValue(Item *item) {
     switch (item->mType) {
         case kTypeString:
@@ -150,19 +158,30 @@ static void reportStats() {
 }
 #endif
 
-inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
+// static
+inline uint32_t AMessage::HashName(const char *name, size_t *len) {
+    uint32_t hash = 0;
+    const char *s = name;
+    for (; *s != '\0'; ++s) {
+        hash = (hash * 31) + (uint8_t)*s;
+    }
+    *len = s - name;
+    return hash;
+}
+
+inline size_t AMessage::findItemIndex(const char *name, size_t len, uint32_t hash) const {
 #ifdef DUMP_STATS
     size_t memchecks = 0;
 #endif
     size_t i = 0;
     for (; i < mItems.size(); i++) {
-        if (len != mItems[i].mNameLength) {
+        if (hash != mItems[i].mNameHash || len != mItems[i].mNameLength) {
             continue;
         }
 #ifdef DUMP_STATS
         ++memchecks;
 #endif
-        if (!memcmp(mItems[i].mName, name, len)) {
+        if (mItems[i].mName == name || !memcmp(mItems[i].mName, name, len)) {
             break;
         }
     }
@@ -179,22 +198,62 @@ inline size_t AMessage::findItemIndex(const char *name, size_t len) const {
     return i;
 }
 
+inline size_t AMessage::findItemIndex(const char *name) const {
+    if (mInternKeys) {
+        // interned keys can be matched by pointer without looking at the name
+        for (size_t i = 0; i < mItems.size(); i++) {
+            if (mItems[i].mName == name) {
+                return i;
+            }
+        }
+    }
+    size_t len;
+    uint32_t hash = HashName(name, &len);
+    return findItemIndex(name, len, hash);
+}
+
 // assumes item's name was uninitialized or NULL
-void AMessage::Item::setName(const char *name, size_t len) {
+void AMessage::Item::setName(const char *name, size_t len, uint32_t hash) {
     mNameLength = len;
+    mNameHash = hash;
+    mNameInterned = false;
     mName = new char[len + 1];
     memcpy((void*)mName, name, len + 1);
 }
 
-AMessage::Item::Item(const char *name, size_t len)
+// assumes item's name was uninitialized or NULL
+void AMessage::Item::setInternedName(const char *atom, size_t len, uint32_t hash) {
+    mNameLength = len;
+    mNameHash = hash;
+    mNameInterned = true;
+    mName = atom;
+}
+
+void AMessage::Item::freeName() {
+    if (!mNameInterned) {
+        delete[] mName;
+    }
+    mName = nullptr;
+    mNameInterned = false;
+}
+
+AMessage::Item::Item(const char *name, size_t len, uint32_t hash, bool interned)
     : mType(kTypeInt32) {
-    // mName and mNameLength are initialized by setName
-    setName(name, len);
+    // mName, mNameLength, mNameHash and mNameInterned are initialized by the setters
+    if (interned) {
+        setInternedName(name, len, hash);
+    } else {
+        setName(name, len, hash);
+    }
 }
 
 AMessage::Item *AMessage::allocateItem(const char *name) {
-    size_t len = strlen(name);
-    size_t i = findItemIndex(name, len);
+    if (mInternKeys) {
+        name = AAtomizer::Atomize(name);
+    }
+    size_t len;
+    uint32_t hash = HashName(name, &len);
+    size_t i = findItemIndex(name, len, hash);
     Item *item;
 
     if (i < mItems.size()) {
@@ -204,7 +263,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
         CHECK(mItems.size() < kMaxNumItems);
         i = mItems.size();
         // place a 'blank' item at the end - this is of type kTypeInt32
-        mItems.emplace_back(name, len);
+        mItems.emplace_back(name, len, hash, mInternKeys);
         item = &mItems[i];
     }
 
@@ -213,7 +272,7 @@ AMessage::Item *AMessage::allocateItem(const char *name) {
 
 const AMessage::Item *AMessage::findItem(
         const char *name, Type type) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         return item->mType == type ? item : NULL;
@@ -223,7 +282,7 @@ const AMessage::Item *AMessage::findItem(
 }
 
 bool AMessage::findAsFloat(const char *name, float *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -250,7 +309,7 @@ bool AMessage::findAsFloat(const char *name, float *value) const {
 }
 
 bool AMessage::findAsInt64(const char *name, int64_t *value) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     if (i < mItems.size()) {
         const Item *item = &mItems[i];
         switch (item->mType) {
@@ -268,7 +327,7 @@ bool AMessage::findAsInt64(const char *name, int64_t *value) const {
 }
 
 bool AMessage::contains(const char *name) const {
-    size_t i = findItemIndex(name, strlen(name));
+    size_t i = findItemIndex(name);
     return i < mItems.size();
 }
 
@@ -480,6 +539,7 @@ bool AMessage::senderAwaitsResponse(sp<AReplyToken> *replyToken) {
 sp<AMessage> AMessage::dup() const {
     sp<AMessage> msg = new AMessage(mWhat, mHandler.promote());
     msg->mItems = mItems;
+    msg->mInternKeys = mInternKeys;
 
 #ifdef DUMP_STATS
     {
@@ -494,7 +554,9 @@ sp<AMessage> AMessage::dup() const {
         const Item *from = &mItems[i];
         Item *to = &msg->mItems[i];
 
-        to->setName(from->mName, from->mNameLength);
+        if (!from->mNameInterned) {
+            to->setName(from->mName, from->mNameLength, from->mNameHash);
+        }
         to->mType = from->mType;
 
         switch (from->mType) {
@@ -760,7 +822,9 @@ sp<AMessage> AMessage::FromParcel(const Parcel &parcel, size_t maxNestingLevel)
             }
         }
 
-        item->setName(name, strlen(name));
+        size_t len;
+        uint32_t hash = HashName(name, &len);
+        item->setName(name, len, hash);
     }
 
     return msg;
@@ -1006,13 +1070,13 @@ status_t AMessage::setEntryNameAt(size_t index, const char *name) {
     if (!strcmp(name, mItems[index].mName)) {
         return OK; // name has not changed
     }
-    size_t len = strlen(name);
-    if (findItemIndex(name, len) < mItems.size()) {
+    size_t len;
+    uint32_t hash = HashName(name, &len);
+    if (findItemIndex(name, len, hash) < mItems.size()) {
         return ALREADY_EXISTS;
     }
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
-    mItems[index].setName(name, len);
+    mItems[index].freeName();
+    mItems[index].setName(name, len, hash);
     return OK;
 }
 
@@ -1075,8 +1139,7 @@ status_t AMessage::removeEntryAt(size_t index) {
         return BAD_INDEX;
     }
     // delete entry data and objects
-    delete[] mItems[index].mName;
-    mItems[index].mName = nullptr;
+    mItems[index].freeName();
     freeItemValue(&mItems[index]);
 
     // swap entry with last entry and clear last entry's data
@@ -1084,6 +1147,7 @@ status_t AMessage::removeEntryAt(size_t index) {
     if (index < lastIndex) {
         mItems[index] = mItems[lastIndex];
         mItems[lastIndex].mName = nullptr;
+        mItems[lastIndex].mNameInterned = false;
         mItems[lastIndex].mType = kTypeInt32;
     }
     mItems.pop_back();
@@ -1130,7 +1194,7 @@ void AMessage::extend(const sp<AMessage> &other) {
 }
 
 size_t AMessage::findEntryByName(const char *name) const {
-    return name == nullptr ? countEntries() : findItemIndex(name, strlen(name));
+    return name == nullptr ? countEntries() : findItemIndex(name);
 }
 
 }  // namespace android
@@ -32,6 +32,10 @@ struct AAtomizer {
     static const char *Atomize(const char *name);
 
 private:
+    enum {
+        kNumCacheEntries = 64,  // per-thread Atomize() cache
+    };
+
     static AAtomizer gAtomizer;
 
     Mutex mLock;
@@ -26,6 +26,10 @@
 #include <utils/RefBase.h>
 #include <utils/threads.h>
 
+#include <atomic>
+#include <deque>
+#include <vector>
+
 namespace android {
 
 struct AHandler;
@@ -66,19 +70,36 @@ private:
 
     struct Event {
         int64_t mWhenUs;
+        uint64_t mSeq;  // breaks ties so that equal-time events stay in post order
         sp<AMessage> mMessage;
     };
 
+    // orders the event heap so that the earliest (then oldest) event is at the front
+    struct EventLater {
+        bool operator()(const Event &a, const Event &b) const {
+            return a.mWhenUs != b.mWhenUs ? a.mWhenUs > b.mWhenUs : a.mSeq > b.mSeq;
+        }
+    };
+
     Mutex mLock;
     Condition mQueueChangedCondition;
 
     AString mName;
 
-    List<Event> mEventQueue;
+    // binary min-heap of pending events, guarded by mLock
+    std::vector<Event> mEventQueue;
+    uint64_t mNextEventSeq;
+
+    // events that were already due when last drained from mEventQueue. Only
+    // accessed from loop(), i.e. from the looper thread, so it needs no lock.
+    std::deque<Event> mDueEvents;
 
     struct LooperThread;
     sp<LooperThread> mThread;
     bool mRunningLocally;
+    // mirrors (mThread != NULL || mRunningLocally) so that loop() can check it
+    // without taking mLock while it works through mDueEvents
+    std::atomic<bool> mRunning;
 
     // use a separate lock for reply handling, as it is always on another thread
     // use a central lock, however, to avoid creating a mutex for each reply
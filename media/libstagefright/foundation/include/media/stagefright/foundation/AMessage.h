@@ -100,6 +100,15 @@ struct AMessage : public RefBase {
     // removes all items
     void clear();
 
+    // When enabled, item names set from now on are stored as AAtomizer atoms
+    // instead of per-item heap copies, so setting and dup()-ing items does not
+    // allocate for their names. Lookups with a name obtained from
+    // AAtomizer::Atomize() then match by pointer before falling back to a
+    // hashed string compare. Atoms are never freed, so only use this for
+    // messages whose keys come from a fixed set (e.g. per-frame codec
+    // messages). The setting is inherited by dup().
+    void setInternKeys(bool intern);
+
     void setInt32(const char *name, int32_t value);
     void setInt64(const char *name, int64_t value);
     void setSize(const char *name, size_t value);
@@ -303,16 +312,26 @@ private:
         } u;
         const char *mName;
         size_t      mNameLength;
+        uint32_t    mNameHash;
+        bool        mNameInterned; // mName is an AAtomizer atom and is not owned
         Type mType;
-        void setName(const char *name, size_t len);
-        Item() : mName(nullptr), mNameLength(0), mType(kTypeInt32) { }
-        Item(const char *name, size_t length);
+        void setName(const char *name, size_t len, uint32_t hash);
+        void setInternedName(const char *atom, size_t len, uint32_t hash);
+        void freeName();
+        Item()
+            : mName(nullptr), mNameLength(0), mNameHash(0), mNameInterned(false),
+              mType(kTypeInt32) { }
+        Item(const char *name, size_t length, uint32_t hash, bool interned);
     };
 
     enum {
-        kMaxNumItems = 256
+        kMaxNumItems = 256,
+        // number of items reserved up front for messages with interned keys,
+        // enough for typical per-frame codec messages to never regrow
+        kNumInternedItemsReserved = 32,
     };
     std::vector<Item> mItems;
+    bool mInternKeys;
 
     /**
      * Allocates an item with the given key |name|. If the key already exists, the corresponding
@@ -343,7 +362,15 @@ private:
     void setObjectInternal(
             const char *name, const sp<RefBase> &obj, Type type);
 
-    size_t findItemIndex(const char *name, size_t len) const;
+    /** Computes the length and lookup hash of |name|. */
+    static uint32_t HashName(const char *name, size_t *len);
+
+    /**
+     * Returns the index of the item with key |name|, or mItems.size() if there is none.
+     * |len| and |hash| must be as computed by HashName().
+     */
+    size_t findItemIndex(const char *name, size_t len, uint32_t hash) const;
+    size_t findItemIndex(const char *name) const;
 
     void deliver();
 
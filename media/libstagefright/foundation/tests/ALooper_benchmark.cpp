@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AHandler.h>
+#include <media/stagefright/foundation/ALooper.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <utils/List.h>
+
+using namespace android;
+
+namespace {
+
+// Delays for the posted messages, in microseconds. A fixed seed keeps the
+// legacy and heap queues working on exactly the same sequence.
+std::vector<int64_t> makeDelays(size_t count) {
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int64_t> dis(0, 1000000);
+    std::vector<int64_t> delays(count);
+    for (int64_t &delay : delays) {
+        delay = dis(gen);
+    }
+    return delays;
+}
+
+struct Event {
+    int64_t mWhenUs;
+    uint64_t mSeq;
+    int32_t mPayload;
+};
+
+// Mirrors the previous ALooper queue: a time-ordered List<Event> with a
+// linear insert, and one lock acquisition per dispatched event.
+struct LegacyListQueue {
+    void post(int64_t whenUs, int32_t payload) {
+        std::lock_guard<std::mutex> guard(mLock);
+        List<Event>::iterator it = mQueue.begin();
+        while (it != mQueue.end() && (*it).mWhenUs <= whenUs) {
+            ++it;
+        }
+        mQueue.insert(it, Event{whenUs, 0, payload});
+    }
+
+    size_t dispatchDue(int64_t nowUs) {
+        size_t dispatched = 0;
+        for (;;) {
+            Event event;
+            {
+                std::lock_guard<std::mutex> guard(mLock);
+                if (mQueue.empty() || (*mQueue.begin()).mWhenUs > nowUs) {
+                    break;
+                }
+                event = *mQueue.begin();
+                mQueue.erase(mQueue.begin());
+            }
+            benchmark::DoNotOptimize(event.mPayload);
+            ++dispatched;
+        }
+        return dispatched;
+    }
+
+    std::mutex mLock;
+    List<Event> mQueue;
+};
+
+// Mirrors the current ALooper queue: a binary heap ordered by (time, sequence)
+// and a single lock acquisition to drain every due event.
+struct HeapQueue {
+    struct Later {
+        bool operator()(const Event &a, const Event &b) const {
+            return a.mWhenUs != b.mWhenUs ? a.mWhenUs > b.mWhenUs : a.mSeq > b.mSeq;
+        }
+    };
+
+    void post(int64_t whenUs, int32_t payload) {
+        std::lock_guard<std::mutex> guard(mLock);
+        mQueue.push_back(Event{whenUs, mNextSeq++, payload});
+        std::push_heap(mQueue.begin(), mQueue.end(), Later());
+    }
+
+    size_t dispatchDue(int64_t nowUs) {
+        {
+            std::lock_guard<std::mutex> guard(mLock);
+            while (!mQueue.empty() && mQueue.front().mWhenUs <= nowUs) {
+                std::pop_heap(mQueue.begin(), mQueue.end(), Later());
+                mDue.push_back(mQueue.back());
+                mQueue.pop_back();
+            }
+        }
+        size_t dispatched = mDue.size();
+        for (const Event &event : mDue) {
+            benchmark::DoNotOptimize(event.mPayload);
+        }
+        mDue.clear();
+        return dispatched;
+    }
+
+    std::mutex mLock;
+    std::vector<Event> mQueue;
+    std::vector<Event> mDue;
+    uint64_t mNextSeq = 0;
+};
+
+// Posts state.range(0) events with random delays, then dispatches them in
+// 1ms steps of simulated time.
+template <typename Queue>
+void BM_QueuePostDispatch(benchmark::State &state) {
+    const std::vector<int64_t> delays = makeDelays(state.range(0));
+
+    for (auto _ : state) {
+        Queue queue;
+        for (size_t i = 0; i < delays.size(); ++i) {
+            queue.post(delays[i], i);
+        }
+        size_t dispatched = 0;
+        for (int64_t nowUs = 0; dispatched < delays.size(); nowUs += 1000) {
+            dispatched += queue.dispatchDue(nowUs);
+        }
+        benchmark::DoNotOptimize(dispatched);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_QueuePostDispatch, LegacyListQueue)->RangeMultiplier(4)->Range(16, 4096);
+BENCHMARK_TEMPLATE(BM_QueuePostDispatch, HeapQueue)->RangeMultiplier(4)->Range(16, 4096);
+
+struct CountingHandler : public AHandler {
+    explicit CountingHandler(size_t expected) : mExpected(expected), mReceived(0) {}
+
+    void waitForAll() {
+        std::unique_lock<std::mutex> lock(mLock);
+        mCondition.wait(lock, [this] { return mReceived == mExpected; });
+    }
+
+protected:
+    void onMessageReceived(const sp<AMessage> & /* msg */) override {
+        std::lock_guard<std::mutex> guard(mLock);
+        if (++mReceived == mExpected) {
+            mCondition.notify_all();
+        }
+    }
+
+private:
+    const size_t mExpected;
+    size_t mReceived;
+    std::mutex mLock;
+    std::condition_variable mCondition;
+};
+
+// End-to-end throughput of the real ALooper: posts state.range(0) messages
+// spread over a 2ms window while the looper thread is dispatching them.
+void BM_ALooperPostDispatch(benchmark::State &state) {
+    const size_t count = state.range(0);
+    std::vector<int64_t> delays = makeDelays(count);
+    for (int64_t &delay : delays) {
+        delay %= 2000;
+    }
+
+    sp<ALooper> looper = new ALooper;
+    looper->setName("ALooper_benchmark");
+    looper->start();
+
+    for (auto _ : state) {
+        sp<CountingHandler> handler = new CountingHandler(count);
+        looper->registerHandler(handler);
+        for (int64_t delay : delays) {
+            sp<AMessage> msg = new AMessage(0, handler);
+            msg->post(delay);
+        }
+        handler->waitForAll();
+        looper->unregisterHandler(handler->id());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+
+    looper->stop();
+}
+
+BENCHMARK(BM_ALooperPostDispatch)->RangeMultiplier(4)->Range(16, 4096)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
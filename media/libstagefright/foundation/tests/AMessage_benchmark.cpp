@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <media/stagefright/foundation/AAtomizer.h>
+#include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
+
+using namespace android;
+
+namespace {
+
+// Keys shaped like the ones MediaCodec and ACodec put in their per-frame messages.
+std::vector<AString> makeKeys(size_t count) {
+    std::vector<AString> keys;
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back(AStringPrintf("frame-key-%zu", i));
+    }
+    return keys;
+}
+
+std::vector<const char *> keyNames(const std::vector<AString> &keys, bool interned) {
+    std::vector<const char *> names;
+    for (const AString &key : keys) {
+        names.push_back(interned ? AAtomizer::Atomize(key.c_str()) : key.c_str());
+    }
+    return names;
+}
+
+sp<AMessage> makeMessage(const std::vector<const char *> &names, bool interned) {
+    sp<AMessage> msg = new AMessage;
+    msg->setInternKeys(interned);
+    for (size_t i = 0; i < names.size(); ++i) {
+        msg->setInt32(names[i], i);
+    }
+    return msg;
+}
+
+// Builds a message of state.range(0) items from scratch.
+template <bool INTERNED>
+void BM_AMessageSet(benchmark::State &state) {
+    const std::vector<AString> keys = makeKeys(state.range(0));
+    const std::vector<const char *> names = keyNames(keys, INTERNED);
+
+    for (auto _ : state) {
+        sp<AMessage> msg = makeMessage(names, INTERNED);
+        benchmark::DoNotOptimize(msg.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Looks up every item of a message of state.range(0) items.
+template <bool INTERNED>
+void BM_AMessageFind(benchmark::State &state) {
+    const std::vector<AString> keys = makeKeys(state.range(0));
+    const std::vector<const char *> names = keyNames(keys, INTERNED);
+    sp<AMessage> msg = makeMessage(names, INTERNED);
+
+    for (auto _ : state) {
+        for (const char *name : names) {
+            int32_t value;
+            benchmark::DoNotOptimize(msg->findInt32(name, &value));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Duplicates a message of state.range(0) items.
+template <bool INTERNED>
+void BM_AMessageDup(benchmark::State &state) {
+    const std::vector<AString> keys = makeKeys(state.range(0));
+    const std::vector<const char *> names = keyNames(keys, INTERNED);
+    sp<AMessage> msg = makeMessage(names, INTERNED);
+
+    for (auto _ : state) {
+        sp<AMessage> copy = msg->dup();
+        benchmark::DoNotOptimize(copy.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_AMessageSet, false)->Arg(10)->Arg(30)->Arg(60);
+BENCHMARK_TEMPLATE(BM_AMessageSet, true)->Arg(10)->Arg(30)->Arg(60);
+BENCHMARK_TEMPLATE(BM_AMessageFind, false)->Arg(10)->Arg(30)->Arg(60);
+BENCHMARK_TEMPLATE(BM_AMessageFind, true)->Arg(10)->Arg(30)->Arg(60);
+BENCHMARK_TEMPLATE(BM_AMessageDup, false)->Arg(10)->Arg(30)->Arg(60);
+BENCHMARK_TEMPLATE(BM_AMessageDup, true)->Arg(10)->Arg(30)->Arg(60);
+
+}  // namespace
+
+BENCHMARK_MAIN();
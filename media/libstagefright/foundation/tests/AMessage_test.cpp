@@ -20,7 +20,9 @@
 #include <gtest/gtest.h>
 #include <utils/RefBase.h>
 
+#include <media/stagefright/foundation/AAtomizer.h>
 #include <media/stagefright/foundation/AMessage.h>
+#include <media/stagefright/foundation/AString.h>
 
 using namespace android;
 
@@ -123,3 +125,45 @@ TEST(AMessage_tests, item_manipulation) {
 
 }
 
+
+TEST(AMessage_tests, interned_keys) {
+  sp<AMessage> m1 = new AMessage();
+  m1->setInt32("copied", 1);
+  m1->setInternKeys(true);
+
+  m1->setInt32("value", 2);
+  m1->setString("name", "interned");
+
+  // keys are found both by atom and by an equal, non-interned string
+  int32_t i32;
+  char key[] = "value";
+  EXPECT_TRUE(m1->findInt32(AAtomizer::Atomize("value"), &i32));
+  EXPECT_EQ(2, i32);
+  EXPECT_TRUE(m1->findInt32(key, &i32));
+  EXPECT_EQ(2, i32);
+  EXPECT_TRUE(m1->findInt32("copied", &i32));
+  EXPECT_EQ(1, i32);
+
+  AMessage::Type type;
+  EXPECT_EQ(AAtomizer::Atomize("value"), m1->getEntryNameAt(1, &type));
+
+  // overwriting an interned key does not add an entry
+  m1->setInt32(key, 3);
+  EXPECT_EQ(3u, m1->countEntries());
+
+  sp<AMessage> m2 = m1->dup();
+  EXPECT_TRUE(m2->findInt32("value", &i32));
+  EXPECT_EQ(3, i32);
+  AString s;
+  EXPECT_TRUE(m2->findString("name", &s));
+  EXPECT_EQ(AString("interned"), s);
+
+  // renaming and removing interned entries leaves the others intact
+  EXPECT_EQ(OK, m2->setEntryNameAt(m2->findEntryByName("value"), "renamed"));
+  EXPECT_TRUE(m2->findInt32("renamed", &i32));
+  EXPECT_FALSE(m2->findInt32("value", &i32));
+  EXPECT_EQ(OK, m2->removeEntryByName("copied"));
+  EXPECT_TRUE(m2->findString("name", &s));
+  EXPECT_TRUE(m1->findInt32("value", &i32));
+  EXPECT_TRUE(m1->findInt32("copied", &i32));
+}
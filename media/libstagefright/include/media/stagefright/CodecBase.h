@@ -425,6 +425,12 @@ public:
      * Clear and fill array with output buffers.
      */
     virtual void getOutputBufferArray(Vector<sp<MediaCodecBuffer>> *array) = 0;
+    /**
+     * Add statistics kept by the channel to |metrics| as int64 entries.
+     * MediaCodec reports them in its media metrics, under the same names
+     * prefixed with "android.media.mediacodec.".
+     */
+    virtual void getMetrics(const sp<AMessage> & /* metrics */) {}
 
     /**
      * Convert binder IMemory to drm SharedBuffer
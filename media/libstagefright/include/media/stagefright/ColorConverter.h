@@ -37,6 +37,16 @@ struct ColorConverter {
 
     void setSrcColorSpace(uint32_t standard, uint32_t range, uint32_t transfer);
 
+    // Lets convert() split large frames into bands of rows that are converted
+    // concurrently on up to |numThreads| threads, including the calling thread.
+    // The output is identical to the single-threaded conversion. Defaults to 1.
+    void setNumThreads(size_t numThreads);
+
+    // Selects whether the vectorized row kernels are used where available.
+    // The output is identical either way, this only lets tests compare them
+    // against the scalar loops. Defaults to true.
+    void setUseSimd(bool useSimd);
+
     status_t convert(
             const void *srcBits,
             size_t srcWidth, size_t srcHeight, size_t srcStride,
@@ -78,9 +88,20 @@ private:
     OMX_COLOR_FORMATTYPE mSrcFormat, mDstFormat;
     ColorSpace mSrcColorSpace;
     uint8_t *mClip;
+    size_t mNumThreads;
+    bool mUseSimd;
 
     uint8_t *initClip();
 
+    // whether a crop rectangle can be converted as independent bands of rows
+    bool canConvertInBands() const;
+
+    status_t convertInBands(
+            const BitmapParams &src, const BitmapParams &dst, size_t numBands);
+
+    status_t convertInternal(
+            const BitmapParams &src, const BitmapParams &dst);
+
     status_t convertCbYCrY(
             const BitmapParams &src, const BitmapParams &dst);
 
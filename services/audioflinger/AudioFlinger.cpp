@@ -58,6 +58,7 @@
 #include "AudioFlinger.h"
 #include "NBAIO_Tee.h"
 
+#include <media/AudioResampler.h>
 #include <media/AudioResamplerPublic.h>
 
 #include <system/audio_effects/effect_visualizer.h>
@@ -607,6 +608,7 @@ void AudioFlinger::dumpInternals(int fd, const Vector<String16>& args __unused)
                             hardwareStatus,
                             (uint32_t)(mStandbyTimeInNsecs / 1000000));
     result.append(buffer);
+    result.append(AudioResampler::dumpFilterCache().c_str());
     write(fd, result.string(), result.size());
 }
 
@@ -35,6 +35,12 @@
 // uncomment for debugging timing problems related to StateQueue::push()
 //#define STATE_QUEUE_DUMP
 
+// Build time limit on the number of fast tracks of a FastMixer, including the track
+// reserved for the normal mixer. The run time limit is set by ro.audio.max_fast_tracks.
+#ifndef FAST_MIXER_MAX_FAST_TRACKS
+#define FAST_MIXER_MAX_FAST_TRACKS 64
+#endif
+
 // uncomment to allow tee sink debugging to be enabled by property
 //#define TEE_SINK
 
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "EffectChainWorkerPool"
+//#define LOG_NDEBUG 0
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include <utils/AndroidThreads.h>
+#include <utils/Log.h>
+#include <utils/Timers.h>
+
+#include "EffectChainWorkerPool.h"
+
+namespace android {
+
+EffectChainWorkerPool::EffectChainWorkerPool(size_t numWorkers)
+{
+    for (size_t i = 0; i < numWorkers; i++) {
+        mWorkers.emplace_back([this, i]() {
+            char name[16];
+            snprintf(name, sizeof(name), "AudioEffect%zu", i);
+            pthread_setname_np(pthread_self(), name);
+            // Same priority as the mixer threads.
+            androidSetThreadPriority(0 /*tid*/, ANDROID_PRIORITY_URGENT_AUDIO);
+            threadLoop();
+        });
+    }
+    ALOGV("%s: %zu workers", __func__, numWorkers);
+}
+
+EffectChainWorkerPool::~EffectChainWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> _l(mLock);
+        mExit = true;
+    }
+    mWakeCond.notify_all();
+    for (std::thread& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+bool EffectChainWorkerPool::claim(uint32_t generation, size_t count, size_t *index)
+{
+    uint64_t claim = mClaim.load(std::memory_order_acquire);
+    do {
+        if ((uint32_t) (claim >> 32) != generation || (claim & UINT32_MAX) >= count) {
+            return false;
+        }
+    } while (!mClaim.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel));
+    *index = claim & UINT32_MAX;
+    return true;
+}
+
+size_t EffectChainWorkerPool::runJobs(uint32_t generation, size_t count, const Job& job)
+{
+    size_t jobs = 0;
+    size_t index;
+    while (claim(generation, count, &index)) {
+        job(index);
+        jobs++;
+        if (mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Lock so that the notification cannot be missed by run().
+            std::lock_guard<std::mutex> _l(mLock);
+            mDoneCond.notify_one();
+        }
+    }
+    return jobs;
+}
+
+void EffectChainWorkerPool::threadLoop()
+{
+    std::unique_lock<std::mutex> l(mLock);
+    uint32_t generation = mGeneration;
+    for (;;) {
+        mWakeCond.wait(l, [&]() { return mExit || mGeneration != generation; });
+        if (mExit) {
+            return;
+        }
+        generation = mGeneration;
+        // The job outlives the generation: run() does not return before every job
+        // claimed for this generation is done, and no job can be claimed afterwards.
+        const Job *job = mJob;
+        const size_t count = mCount;
+        if (job == nullptr) {
+            continue;   // run() already completed every job of this generation
+        }
+        l.unlock();
+        const size_t jobs = runJobs(generation, count, *job);
+        mJobsOnWorkers.fetch_add(jobs, std::memory_order_relaxed);
+        l.lock();
+    }
+}
+
+void EffectChainWorkerPool::run(size_t count, const Job& job, int64_t deadlineNs)
+{
+    if (count == 0) {
+        return;
+    }
+    if (mWorkers.empty() || count == 1 || mSerialRunsLeft > 0) {
+        if (mSerialRunsLeft > 0) {
+            mSerialRunsLeft--;
+        }
+        for (size_t i = 0; i < count; i++) {
+            job(i);
+        }
+        mSerialRuns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const nsecs_t startNs = systemTime();
+    uint32_t generation;
+    {
+        std::lock_guard<std::mutex> _l(mLock);
+        generation = ++mGeneration;
+        mJob = &job;
+        mCount = count;
+        mRemaining.store(count, std::memory_order_relaxed);
+        mClaim.store((uint64_t) generation << 32, std::memory_order_release);
+    }
+    mWakeCond.notify_all();
+
+    runJobs(generation, count, job);
+    {
+        std::unique_lock<std::mutex> l(mLock);
+        mDoneCond.wait(l, [this]() {
+            return mRemaining.load(std::memory_order_acquire) == 0;
+        });
+        mJob = nullptr;
+    }
+
+    mParallelRuns.fetch_add(1, std::memory_order_relaxed);
+    const nsecs_t elapsedNs = systemTime() - startNs;
+    if (elapsedNs > deadlineNs) {
+        mDeadlineMisses.fetch_add(1, std::memory_order_relaxed);
+        mSerialRunsLeft = kSerialRunsAfterMiss;
+        ALOGV("%s: %zu jobs took %lld ns, deadline %lld ns, running serially",
+                __func__, count, (long long) elapsedNs, (long long) deadlineNs);
+    }
+}
+
+void EffectChainWorkerPool::dump(int fd, int spaces) const
+{
+    dprintf(fd, "%*sEffect chain workers: %zu, parallel runs: %llu, serial runs: %llu,"
+            " deadline misses: %llu, jobs on workers: %llu\n",
+            spaces, "", mWorkers.size(),
+            (unsigned long long) parallelRuns(), (unsigned long long) serialRuns(),
+            (unsigned long long) deadlineMisses(), (unsigned long long) jobsOnWorkers());
+}
+
+}   // namespace android
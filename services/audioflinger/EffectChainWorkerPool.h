@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_EFFECT_CHAIN_WORKER_POOL_H
+#define ANDROID_EFFECT_CHAIN_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace android {
+
+// A small pool of audio priority threads used by a PlaybackThread to process independent
+// effect chains concurrently.
+//
+// The thread calling run() takes part in the processing, and jobs are claimed one at
+// a time, so a run never takes much longer than processing all the jobs on the calling
+// thread, even if the workers are late to wake up.
+// If a parallel run still misses its deadline, the following runs are serial for a
+// while, on the calling thread only.
+class EffectChainWorkerPool {
+public:
+    using Job = std::function<void(size_t index)>;
+
+    explicit EffectChainWorkerPool(size_t numWorkers);
+    ~EffectChainWorkerPool();
+
+    // Runs job(i) for i in [0, count), and returns when all of them are done.
+    // The jobs must be independent. Must always be called from the same thread.
+    void run(size_t count, const Job& job, int64_t deadlineNs);
+
+    size_t numWorkers() const { return mWorkers.size(); }
+
+    void dump(int fd, int spaces) const;
+
+    // Statistics, may be read from any thread.
+    uint64_t parallelRuns() const { return mParallelRuns.load(std::memory_order_relaxed); }
+    uint64_t serialRuns() const { return mSerialRuns.load(std::memory_order_relaxed); }
+    uint64_t deadlineMisses() const { return mDeadlineMisses.load(std::memory_order_relaxed); }
+    uint64_t jobsOnWorkers() const { return mJobsOnWorkers.load(std::memory_order_relaxed); }
+
+    // number of serial runs after a parallel run misses its deadline
+    static constexpr uint32_t kSerialRunsAfterMiss = 100;
+
+private:
+    void threadLoop();
+
+    // Claims the next job of this generation, returns false if there is none left.
+    bool claim(uint32_t generation, size_t count, size_t *index);
+    // Runs the jobs claimed by the calling thread, returns how many.
+    size_t runJobs(uint32_t generation, size_t count, const Job& job);
+
+    std::mutex              mLock;
+    std::condition_variable mWakeCond;      // workers wait for a new generation
+    std::condition_variable mDoneCond;      // run() waits for the last job
+    uint32_t                mGeneration = 0;    // guarded by mLock
+    const Job*              mJob = nullptr;     // guarded by mLock
+    size_t                  mCount = 0;         // guarded by mLock
+    bool                    mExit = false;      // guarded by mLock
+
+    // generation in the high 32 bits, index of the next job to claim in the low 32 bits
+    std::atomic<uint64_t>   mClaim{0};
+    std::atomic<size_t>     mRemaining{0};      // jobs not finished yet
+
+    std::vector<std::thread> mWorkers;
+
+    uint32_t                mSerialRunsLeft = 0;    // only used by the thread calling run()
+    std::atomic<uint64_t>   mParallelRuns{0};
+    std::atomic<uint64_t>   mSerialRuns{0};
+    std::atomic<uint64_t>   mDeadlineMisses{0};
+    std::atomic<uint64_t>   mJobsOnWorkers{0};
+};
+
+}   // namespace android
+
+#endif  // ANDROID_EFFECT_CHAIN_WORKER_POOL_H
@@ -2181,6 +2181,7 @@ void AudioFlinger::EffectChain::process_l()
 
     size_t size = mEffects.size();
     if (doProcess) {
+        const nsecs_t startCpuNs = mProcessCpuMeasured ? systemTime(SYSTEM_TIME_THREAD) : 0;
         // Only the input and output buffers of the chain can be external,
         // and 'update' / 'commit' do nothing for allocated buffers, thus
         // it's not needed to consider any other buffers here.
@@ -2195,6 +2196,14 @@ void AudioFlinger::EffectChain::process_l()
         if (mInBuffer->audioBuffer()->raw != mOutBuffer->audioBuffer()->raw) {
             mOutBuffer->commit();
         }
+        if (mProcessCpuMeasured) {
+            const nsecs_t cpuNs = systemTime(SYSTEM_TIME_THREAD) - startCpuNs;
+            mProcessCount.fetch_add(1, std::memory_order_relaxed);
+            mProcessCpuNs.fetch_add(cpuNs, std::memory_order_relaxed);
+            if (cpuNs > mProcessMaxCpuNs.load(std::memory_order_relaxed)) {
+                mProcessMaxCpuNs.store(cpuNs, std::memory_order_relaxed);
+            }
+        }
     }
     bool doResetVolume = false;
     for (size_t i = 0; i < size; i++) {
@@ -2606,6 +2615,15 @@ void AudioFlinger::EffectChain::dump(int fd, const Vector<String16>& args)
                 (int)outBufferStr.size(), "Out buffer      ");
         result.appendFormat("\t%s   %s   %d\n",
                 inBufferStr.c_str(), outBufferStr.c_str(), mActiveTrackCnt);
+        if (mProcessCpuMeasured) {
+            const int64_t processCount = mProcessCount.load(std::memory_order_relaxed);
+            result.appendFormat("\tProcess CPU time: %lld cycles, mean %.1f us, max %.1f us\n",
+                    (long long) processCount,
+                    processCount > 0 ?
+                            mProcessCpuNs.load(std::memory_order_relaxed) * 1e-3 / processCount
+                            : 0.,
+                    mProcessMaxCpuNs.load(std::memory_order_relaxed) * 1e-3);
+        }
         write(fd, result.string(), result.size());
 
         for (size_t i = 0; i < numEffects; ++i) {
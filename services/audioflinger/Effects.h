@@ -491,6 +491,8 @@ public:
     effect_buffer_t *outBuffer() const {
         return mOutBuffer != 0 ? reinterpret_cast<effect_buffer_t*>(mOutBuffer->ptr()) : NULL;
     }
+    // Only chains processed by the effect chain workers measure their CPU time.
+    void setProcessCpuMeasured(bool measured) { mProcessCpuMeasured = measured; }
 
     void incTrackCnt() { android_atomic_inc(&mTrackCnt); }
     void decTrackCnt() { android_atomic_dec(&mTrackCnt); }
@@ -689,6 +691,14 @@ private:
              KeyedVector< int, sp<SuspendedEffectDesc> > mSuspendedEffects;
 
              const sp<EffectCallback> mEffectCallback;
+
+    // CPU time used by process_l(), which may run on an effect chain worker thread.
+    // Updated by the thread processing the chain when mProcessCpuMeasured is set,
+    // read by dump().
+    bool mProcessCpuMeasured = false;
+    std::atomic<int64_t> mProcessCount{0};
+    std::atomic<int64_t> mProcessCpuNs{0};
+    std::atomic<int64_t> mProcessMaxCpuNs{0};
 };
 
 class DeviceEffectProxy : public EffectBase {
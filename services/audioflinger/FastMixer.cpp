@@ -39,7 +39,6 @@
 #include <audio_utils/channels.h>
 #include <audio_utils/format.h>
 #include <audio_utils/mono_blend.h>
-#include <cutils/bitops.h>
 #include <media/AudioMixer.h>
 #include "FastMixer.h"
 #include "TypedLogger.h"
@@ -228,7 +227,7 @@ void FastMixer::onStateChange()
 
     // handle state change here, but since we want to diff the state,
     // we're prepared for previous == &sInitial the first time through
-    unsigned previousTrackMask;
+    FastTrackMask previousTrackMask;
 
     // check for change in output HAL configuration
     NBAIO_Format previousFormat = mFormat;
@@ -302,7 +301,7 @@ void FastMixer::onStateChange()
         }
         mMixerBufferState = UNDEFINED;
         // we need to reconfigure all active tracks
-        previousTrackMask = 0;
+        previousTrackMask = FastTrackMask();
         mFastTracksGen = current->mFastTracksGen - 1;
         dumpState->mFrameCount = frameCount;
 #ifdef TEE_SINK
@@ -314,34 +313,31 @@ void FastMixer::onStateChange()
     }
 
     // check for change in active track set
-    const unsigned currentTrackMask = current->mTrackMask;
+    const FastTrackMask currentTrackMask = current->mTrackMask;
     dumpState->mTrackMask = currentTrackMask;
-    dumpState->mNumTracks = popcount(currentTrackMask);
+    dumpState->mNumTracks = currentTrackMask.count();
     if (current->mFastTracksGen != mFastTracksGen) {
 
         // process removed tracks first to avoid running out of track names
-        unsigned removedTracks = previousTrackMask & ~currentTrackMask;
-        while (removedTracks != 0) {
-            int i = __builtin_ctz(removedTracks);
-            removedTracks &= ~(1 << i);
+        FastTrackMask removedTracks = previousTrackMask & ~currentTrackMask;
+        while (removedTracks.any()) {
+            int i = removedTracks.popFirst();
             updateMixerTrack(i, REASON_REMOVE);
             // don't reset track dump state, since other side is ignoring it
         }
 
         // now process added tracks
-        unsigned addedTracks = currentTrackMask & ~previousTrackMask;
-        while (addedTracks != 0) {
-            int i = __builtin_ctz(addedTracks);
-            addedTracks &= ~(1 << i);
+        FastTrackMask addedTracks = currentTrackMask & ~previousTrackMask;
+        while (addedTracks.any()) {
+            int i = addedTracks.popFirst();
             updateMixerTrack(i, REASON_ADD);
         }
 
         // finally process (potentially) modified tracks; these use the same slot
         // but may have a different buffer provider or volume provider
-        unsigned modifiedTracks = currentTrackMask & previousTrackMask;
-        while (modifiedTracks != 0) {
-            int i = __builtin_ctz(modifiedTracks);
-            modifiedTracks &= ~(1 << i);
+        FastTrackMask modifiedTracks = currentTrackMask & previousTrackMask;
+        while (modifiedTracks.any()) {
+            int i = modifiedTracks.popFirst();
             updateMixerTrack(i, REASON_MODIFY);
         }
 
@@ -383,10 +379,9 @@ void FastMixer::onWork()
         bool anyEnabledTracks = false;
 
         // for each track, update volume and check for underrun
-        unsigned currentTrackMask = current->mTrackMask;
-        while (currentTrackMask != 0) {
-            int i = __builtin_ctz(currentTrackMask);
-            currentTrackMask &= ~(1 << i);
+        FastTrackMask currentTrackMask = current->mTrackMask;
+        while (currentTrackMask.any()) {
+            int i = currentTrackMask.popFirst();
             const FastTrack* fastTrack = &current->mFastTracks[i];
 
             const int64_t trackFramesWrittenButNotPresented =
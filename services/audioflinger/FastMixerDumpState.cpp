@@ -32,8 +32,7 @@ namespace android {
 FastMixerDumpState::FastMixerDumpState() : FastThreadDumpState(),
     mWriteSequence(0), mFramesWritten(0),
     mNumTracks(0), mWriteErrors(0),
-    mSampleRate(0), mFrameCount(0),
-    mTrackMask(0)
+    mSampleRate(0), mFrameCount(0)
 {
 }
 
@@ -170,12 +169,12 @@ void FastMixerDumpState::dump(int fd) const
     // then we might display an obsolete track or omit an active track.
     // Instead we always display all tracks, with an indication
     // of whether we think the track is active.
-    uint32_t trackMask = mTrackMask;
-    dprintf(fd, "  Fast tracks: sMaxFastTracks=%u activeMask=%#x\n",
-            FastMixerState::sMaxFastTracks, trackMask);
+    const FastTrackMask trackMask = mTrackMask;
+    dprintf(fd, "  Fast tracks: sMaxFastTracks=%u activeMask=%s\n",
+            FastMixerState::sMaxFastTracks, trackMask.toString().c_str());
     dprintf(fd, "  Index Active Full Partial Empty  Recent Ready    Written\n");
-    for (uint32_t i = 0; i < FastMixerState::sMaxFastTracks; ++i, trackMask >>= 1) {
-        bool isActive = trackMask & 1;
+    for (uint32_t i = 0; i < FastMixerState::sMaxFastTracks; ++i) {
+        bool isActive = trackMask.test(i);
         const FastTrackDump *ftDump = &mTracks[i];
         const FastTrackUnderruns& underruns = ftDump->mUnderruns;
         const char *mostRecent;
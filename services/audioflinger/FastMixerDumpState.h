@@ -74,7 +74,7 @@ struct FastMixerDumpState : FastThreadDumpState {
     uint32_t mWriteErrors;      // total number of write() errors
     uint32_t mSampleRate;
     size_t   mFrameCount;
-    uint32_t mTrackMask;        // mask of active tracks
+    FastTrackMask mTrackMask;   // mask of active tracks
     FastTrackDump   mTracks[FastMixerState::kMaxFastTracks];
 
     // For timestamp statistics.
@@ -17,11 +17,31 @@
 #define LOG_TAG "FastMixerState"
 //#define LOG_NDEBUG 0
 
+#include <stdio.h>
+
 #include <cutils/properties.h>
 #include "FastMixerState.h"
 
 namespace android {
 
+std::string FastTrackMask::toString() const
+{
+    std::string str("0x");
+    bool leading = true;
+    for (unsigned w = kWords; w-- > 0; ) {
+        char word[17];
+        if (leading) {
+            if (mWords[w] == 0 && w > 0) continue;
+            snprintf(word, sizeof(word), "%llx", (unsigned long long) mWords[w]);
+            leading = false;
+        } else {
+            snprintf(word, sizeof(word), "%016llx", (unsigned long long) mWords[w]);
+        }
+        str += word;
+    }
+    return str;
+}
+
 FastTrack::FastTrack() :
     mBufferProvider(NULL), mVolumeProvider(NULL),
     mChannelMask(AUDIO_CHANNEL_OUT_STEREO), mFormat(AUDIO_FORMAT_INVALID), mGeneration(0)
@@ -34,7 +54,10 @@ FastTrack::~FastTrack()
 
 FastMixerState::FastMixerState() : FastThreadState(),
     // mFastTracks
-    mFastTracksGen(0), mTrackMask(0), mOutputSink(NULL), mOutputSinkGen(0),
+    mFastTracksGen(0),
+    // the states are default constructed, copy all the tracks until each state was mutated
+    mModifiedTracks(FastTrackMask::firstN(kMaxFastTracks)),
+    mOutputSink(NULL), mOutputSinkGen(0),
     mFrameCount(0)
 {
     int ok = pthread_once(&sMaxFastTracksOnce, sMaxFastTracksInit);
@@ -82,4 +105,28 @@ void FastMixerState::sMaxFastTracksInit()
     ALOGI("sMaxFastTracks = %u", sMaxFastTracks);
 }
 
+void copyState(FastMixerState *next, const FastMixerState& pushed,
+        const FastMixerState states[], size_t numStates)
+{
+    FastTrackMask modifiedTracks;
+    for (size_t i = 0; i < numStates; ++i) {
+        if (&states[i] != next) {
+            modifiedTracks |= states[i].mModifiedTracks;
+        }
+    }
+    // Everything but the tracks, keep in sync with FastThreadState and FastMixerState.
+    static_cast<FastThreadState&>(*next) = pushed;
+    next->mFastTracksGen = pushed.mFastTracksGen;
+    next->mTrackMask = pushed.mTrackMask;
+    next->mOutputSink = pushed.mOutputSink;
+    next->mOutputSinkGen = pushed.mOutputSinkGen;
+    next->mFrameCount = pushed.mFrameCount;
+    next->mSinkChannelMask = pushed.mSinkChannelMask;
+    while (modifiedTracks.any()) {
+        const unsigned i = modifiedTracks.popFirst();
+        next->mFastTracks[i] = pushed.mFastTracks[i];
+    }
+    next->mModifiedTracks = FastTrackMask();
+}
+
 }   // namespace android
@@ -18,6 +18,8 @@
 #define ANDROID_AUDIO_FAST_MIXER_STATE_H
 
 #include <math.h>
+#include <stdint.h>
+#include <string>
 
 #include <audio_utils/minifloat.h>
 #include <system/audio.h>
@@ -26,6 +28,7 @@
 #include <media/nbaio/NBAIO.h>
 #include <media/nblog/NBLog.h>
 #include <vibrator/ExternalVibrationUtils.h>
+#include "Configuration.h"
 #include "FastThreadState.h"
 
 namespace android {
@@ -41,6 +44,99 @@ protected:
     virtual ~VolumeProvider() { }
 };
 
+// A set of fast track indices, bit i is set if and only if index i is in the set.
+// Not limited to the size of a machine word, so that the number of fast tracks can be
+// raised at build time with FAST_MIXER_MAX_FAST_TRACKS.
+class FastTrackMask {
+public:
+    static constexpr unsigned kMaxTracks = FAST_MIXER_MAX_FAST_TRACKS;
+
+    constexpr FastTrackMask() : mWords{} { }
+
+    // Returns the set of indices [0, count).
+    static FastTrackMask firstN(unsigned count) {
+        FastTrackMask mask;
+        for (unsigned w = 0; w < kWords && count > 0; ++w) {
+            const unsigned bits = count < kBitsPerWord ? count : kBitsPerWord;
+            mask.mWords[w] = bits == kBitsPerWord ? ~Word(0) : (Word(1) << bits) - 1;
+            count -= bits;
+        }
+        return mask;
+    }
+
+    bool test(unsigned i) const { return (mWords[i / kBitsPerWord] & bit(i)) != 0; }
+    void set(unsigned i) { mWords[i / kBitsPerWord] |= bit(i); }
+    void reset(unsigned i) { mWords[i / kBitsPerWord] &= ~bit(i); }
+
+    bool any() const {
+        for (Word word : mWords) {
+            if (word != 0) return true;
+        }
+        return false;
+    }
+    bool none() const { return !any(); }
+
+    unsigned count() const {
+        unsigned count = 0;
+        for (Word word : mWords) {
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+
+    // Removes the lowest index from the set and returns it. The set must not be empty.
+    unsigned popFirst() {
+        for (unsigned w = 0; ; ++w) {
+            if (mWords[w] != 0) {
+                const unsigned i = __builtin_ctzll(mWords[w]);
+                mWords[w] &= mWords[w] - 1;
+                return w * kBitsPerWord + i;
+            }
+        }
+    }
+
+    // Returns the lowest index of the set. The set must not be empty.
+    unsigned first() const { return FastTrackMask(*this).popFirst(); }
+
+    FastTrackMask& operator&=(const FastTrackMask& other) {
+        for (unsigned w = 0; w < kWords; ++w) mWords[w] &= other.mWords[w];
+        return *this;
+    }
+    FastTrackMask& operator|=(const FastTrackMask& other) {
+        for (unsigned w = 0; w < kWords; ++w) mWords[w] |= other.mWords[w];
+        return *this;
+    }
+    FastTrackMask operator&(const FastTrackMask& other) const {
+        return FastTrackMask(*this) &= other;
+    }
+    FastTrackMask operator|(const FastTrackMask& other) const {
+        return FastTrackMask(*this) |= other;
+    }
+    FastTrackMask operator~() const {
+        FastTrackMask mask;
+        for (unsigned w = 0; w < kWords; ++w) mask.mWords[w] = ~mWords[w];
+        return mask &= firstN(kMaxTracks);
+    }
+    bool operator==(const FastTrackMask& other) const {
+        for (unsigned w = 0; w < kWords; ++w) {
+            if (mWords[w] != other.mWords[w]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const FastTrackMask& other) const { return !(*this == other); }
+
+    // Hexadecimal representation, for dumpsys.
+    std::string toString() const;
+
+private:
+    using Word = uint64_t;
+    static constexpr unsigned kBitsPerWord = 64;
+    static constexpr unsigned kWords = (kMaxTracks + kBitsPerWord - 1) / kBitsPerWord;
+    static Word bit(unsigned i) { return Word(1) << (i % kBitsPerWord); }
+
+    Word mWords[kWords];
+};
+
 // Represents the state of a fast track
 struct FastTrack {
     FastTrack();
@@ -63,7 +159,7 @@ struct FastMixerState : FastThreadState {
 
     // These are the minimum, maximum, and default values for maximum number of fast tracks
     static const unsigned kMinFastTracks = 2;
-    static const unsigned kMaxFastTracks = 32;
+    static const unsigned kMaxFastTracks = FastTrackMask::kMaxTracks;
     static const unsigned kDefaultFastTracks = 8;
 
     static unsigned sMaxFastTracks;             // Configured maximum number of fast tracks
@@ -72,7 +168,10 @@ struct FastMixerState : FastThreadState {
     // all pointer fields use raw pointers; objects are owned and ref-counted by the normal mixer
     FastTrack   mFastTracks[kMaxFastTracks];
     int         mFastTracksGen; // increment when any mFastTracks[i].mGeneration is incremented
-    unsigned    mTrackMask;     // bit i is set if and only if mFastTracks[i] is active
+    FastTrackMask mTrackMask;   // bit i is set if and only if mFastTracks[i] is active
+    // Bit i must be set by the mutator whenever it assigns a field of mFastTracks[i].
+    // Only these tracks are copied when the state is pushed, see copyState() below.
+    FastTrackMask mModifiedTracks;
     NBAIO_Sink* mOutputSink;    // HAL output device, must already be negotiated
     int         mOutputSinkGen; // increment when mOutputSink is assigned
     size_t      mFrameCount;    // number of frames per fast mix buffer
@@ -95,6 +194,13 @@ struct FastMixerState : FastThreadState {
 
 };  // struct FastMixerState
 
+// Called by StateQueue<FastMixerState>::push() to bring the next state to mutate up to date
+// with the state just pushed. The next state is the oldest one in the queue, so it only
+// differs from the pushed state by the tracks modified in the other states of the queue.
+// The cost is proportional to the number of modified tracks rather than kMaxFastTracks.
+void copyState(FastMixerState *next, const FastMixerState& pushed,
+        const FastMixerState states[], size_t numStates);
+
 }   // namespace android
 
 #endif  // ANDROID_AUDIO_FAST_MIXER_STATE_H
@@ -149,7 +149,7 @@ template<typename T> bool StateQueue<T>::push(StateQueue<T>::block_t block)
         if (++mMutating >= &mStates[kN]) {
             mMutating = &mStates[0];
         }
-        *mMutating = *mExpecting;
+        copyState(mMutating, *mExpecting, mStates, kN);
         mIsDirty = false;
 
     }
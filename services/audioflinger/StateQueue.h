@@ -124,6 +124,15 @@ struct StateQueueMutatorDump {
 #endif
 
 // manages a FIFO queue of states
+// Called by StateQueue<T>::push() to initialize the next state to mutate from the state just
+// pushed. states[] are all the states of the queue, including both of them.
+// A state type can overload this to copy less than the whole state.
+template<typename T> void copyState(T *next, const T& pushed,
+        const T /*states*/[], size_t /*numStates*/)
+{
+    *next = pushed;
+}
+
 template<typename T> class StateQueue {
 
 public:
@@ -21,6 +21,7 @@
 #define ATRACE_TAG ATRACE_TAG_AUDIO
 
 #include "Configuration.h"
+#include <algorithm>
 #include <math.h>
 #include <fcntl.h>
 #include <memory>
@@ -1999,7 +2000,8 @@ AudioFlinger::PlaybackThread::PlaybackThread(const sp<AudioFlinger>& audioFlinge
         mDrainSequence(0),
         mScreenState(AudioFlinger::mScreenState),
         // index 0 is reserved for normal mixer's submix
-        mFastTrackAvailMask(((1 << FastMixerState::sMaxFastTracks) - 1) & ~1),
+        mFastTrackAvailMask(FastTrackMask::firstN(FastMixerState::sMaxFastTracks)
+                & ~FastTrackMask::firstN(1)),
         mHwSupportsPause(false), mHwPaused(false), mFlushPending(false),
         mLeftVolFloat(-1.0), mRightVolFloat(-1.0),
         mDownStreamPatch{}
@@ -2050,6 +2052,19 @@ AudioFlinger::PlaybackThread::PlaybackThread(const sp<AudioFlinger>& audioFlinge
                                        : AUDIO_DEVICE_NONE));
     }
 
+    // Session effect chains only depend on each other through mEffectBuffer, which they
+    // accumulate into. Parallel processing requires the effect buffer to give each of them
+    // a private output buffer.
+    if (type == MIXER && mEffectBufferEnabled) {
+        static constexpr int64_t kMaxEffectChainWorkers = 4;
+        mEffectChainWorkers = (size_t)std::clamp(property_get_int64(
+                "af.effect.parallel_workers", 0 /* default_value */),
+                (int64_t)0, kMaxEffectChainWorkers);
+        if (mEffectChainWorkers > 0) {
+            mEffectChainWorkerPool = std::make_unique<EffectChainWorkerPool>(mEffectChainWorkers);
+        }
+    }
+
     for (int i = AUDIO_STREAM_MIN; i < AUDIO_STREAM_FOR_POLICY_CNT; ++i) {
         const audio_stream_type_t stream{static_cast<audio_stream_type_t>(i)};
         mStreamTypes[stream].volume = 0.0f;
@@ -2181,7 +2196,7 @@ void AudioFlinger::PlaybackThread::dumpInternals_l(int fd, const Vector<String16
     dprintf(fd, "  Sink buffer : %p\n", mSinkBuffer);
     dprintf(fd, "  Mixer buffer: %p\n", mMixerBuffer);
     dprintf(fd, "  Effect buffer: %p\n", mEffectBuffer);
-    dprintf(fd, "  Fast track availMask=%#x\n", mFastTrackAvailMask);
+    dprintf(fd, "  Fast track availMask=%s\n", mFastTrackAvailMask.toString().c_str());
     dprintf(fd, "  Standby delay ns=%lld\n", (long long)mStandbyDelayNs);
     AudioStreamOut *output = mOutput;
     audio_output_flags_t flags = output != NULL ? output->flags : AUDIO_OUTPUT_FLAG_NONE;
@@ -2189,6 +2204,13 @@ void AudioFlinger::PlaybackThread::dumpInternals_l(int fd, const Vector<String16
             output, flags, toString(flags).c_str());
     dprintf(fd, "  Frames written: %lld\n", (long long)mFramesWritten);
     dprintf(fd, "  Suspended frames: %lld\n", (long long)mSuspendedFrames);
+    dprintf(fd, "  Bytes copied: %lld, per second: %lld, mixing to sink buffer: %s\n",
+            (long long)mBytesCopied.load(std::memory_order_relaxed),
+            (long long)mBytesCopiedPerSecond.load(std::memory_order_relaxed),
+            mMixToSinkBufferSupported ? "supported" : "no");
+    if (mEffectChainWorkerPool != nullptr) {
+        mEffectChainWorkerPool->dump(fd, 2 /* spaces */);
+    }
     if (mPipeSink.get() != nullptr) {
         dprintf(fd, "  PipeSink frames written: %lld\n", (long long)mPipeSink->framesWritten());
     }
@@ -2266,7 +2288,7 @@ sp<AudioFlinger::PlaybackThread::Track> AudioFlinger::PlaybackThread::createTrac
             // normal mixer has an associated fast mixer
             hasFastMixer() &&
             // there are sufficient fast track slots available
-            (mFastTrackAvailMask != 0)
+            mFastTrackAvailMask.any()
             // FIXME test that MixerThread for this fast track has a capable output HAL
             // FIXME add a permission test also?
         ) {
@@ -2307,10 +2329,10 @@ sp<AudioFlinger::PlaybackThread::Track> AudioFlinger::PlaybackThread::createTrac
         ALOGV("AUDIO_OUTPUT_FLAG_FAST denied: sharedBuffer=%p frameCount=%zu "
                 "mFrameCount=%zu format=%#x mFormat=%#x isLinear=%d channelMask=%#x "
                 "sampleRate=%u mSampleRate=%u "
-                "hasFastMixer=%d tid=%d fastTrackAvailMask=%#x",
+                "hasFastMixer=%d tid=%d fastTrackAvailMask=%s",
                 sharedBuffer.get(), frameCount, mFrameCount, format, mFormat,
                 audio_is_linear_pcm(format), channelMask, sampleRate,
-                mSampleRate, hasFastMixer(), tid, mFastTrackAvailMask);
+                mSampleRate, hasFastMixer(), tid, mFastTrackAvailMask.toString().c_str());
         *flags = (audio_output_flags_t)(*flags & ~AUDIO_OUTPUT_FLAG_FAST);
       }
     }
@@ -2811,8 +2833,8 @@ void AudioFlinger::PlaybackThread::removeTrack_l(const sp<Track>& track)
     if (track->isFastTrack()) {
         int index = track->mFastIndex;
         ALOG_ASSERT(0 < index && index < (int)FastMixerState::sMaxFastTracks);
-        ALOG_ASSERT(!(mFastTrackAvailMask & (1 << index)));
-        mFastTrackAvailMask |= 1 << index;
+        ALOG_ASSERT(!mFastTrackAvailMask.test(index));
+        mFastTrackAvailMask.set(index);
         // redundant as track is about to be destroyed, for dumpsys only
         track->mFastIndex = -1;
     }
@@ -3107,6 +3129,12 @@ void AudioFlinger::PlaybackThread::readOutputParameters_l()
     mChannelCount -= mHapticChannelCount;
     mMixerChannelMask = static_cast<audio_channel_mask_t>(mMixerChannelMask & ~mHapticChannelMask);
 
+    // The mixer can write directly to the sink buffer if they have the same layout.
+    mMixToSinkBufferSupported = mType == MIXER && mMixerBufferEnabled
+            && mFormat == mMixerBufferFormat && mMixerChannelMask == mChannelMask
+            && mHapticChannelCount == 0
+            && property_get_bool("af.thread.mix_to_sink", true /* default_value */);
+
     // force reconfiguration of effect chains and engines to take new buffer size and audio
     // parameters into account
     // Note that mLock is not held when readOutputParameters_l() is called from the constructor
@@ -3310,6 +3338,67 @@ void AudioFlinger::PlaybackThread::checkSilentMode_l()
     }
 }
 
+bool AudioFlinger::PlaybackThread::hasPrivateEffectOutput_l(const sp<EffectChain>& chain) const
+{
+    return mEffectChainWorkers > 0 && !audio_is_global_session(chain->sessionId())
+            && chain->outBuffer() != mEffectBuffer;
+}
+
+void AudioFlinger::PlaybackThread::processParallelEffectChains_l(
+        const Vector<sp<EffectChain>>& effectChains)
+{
+    if (mEffectChainWorkers == 0) {
+        return;
+    }
+    mParallelEffectChains.clear();
+    for (const sp<EffectChain>& chain : effectChains) {
+        if (hasPrivateEffectOutput_l(chain)) {
+            mParallelEffectChains.push_back(chain);
+        }
+    }
+    if (mParallelEffectChains.empty()) {
+        return;
+    }
+
+    // Haptic channels are not processed by the effects, they are copied by threadLoop().
+    const size_t numSamples = mNormalFrameCount
+            * audio_channel_count_from_out_mask(mMixerChannelMask);
+    // Leave at least half of the period for the global chains and the write.
+    const int64_t deadlineNs = (int64_t)mNormalFrameCount * NANOS_PER_SECOND / mSampleRate / 2;
+    mEffectChainWorkerPool->run(mParallelEffectChains.size(), [this, numSamples](size_t i) {
+        const sp<EffectChain>& chain = mParallelEffectChains[i];
+        // the last effect of the chain accumulates into its output buffer
+        memset(chain->outBuffer(), 0, numSamples * sizeof(effect_buffer_t));
+        chain->process_l();
+    }, deadlineNs);
+
+    // Accumulate in chain order, so that the mix does not depend on the scheduling.
+    for (const sp<EffectChain>& chain : mParallelEffectChains) {
+#ifdef FLOAT_EFFECT_CHAIN
+        accumulate_float((float *)mEffectBuffer, chain->outBuffer(), numSamples);
+#else
+        accumulate_i16((int16_t *)mEffectBuffer, chain->outBuffer(), numSamples);
+#endif
+    }
+    mParallelEffectChains.clear();
+}
+
+void AudioFlinger::PlaybackThread::updateBytesCopiedPerSecond()
+{
+    const nsecs_t now = systemTime();
+    const nsecs_t elapsedNs = now - mBytesCopiedWindowStartNs;
+    if (elapsedNs < NANOS_PER_SECOND) {
+        return;
+    }
+    const int64_t bytesCopied = mBytesCopied.load(std::memory_order_relaxed);
+    if (mBytesCopiedWindowStartNs != 0) {
+        mBytesCopiedPerSecond.store((bytesCopied - mBytesCopiedWindowStart)
+                * NANOS_PER_SECOND / elapsedNs, std::memory_order_relaxed);
+    }
+    mBytesCopiedWindowStart = bytesCopied;
+    mBytesCopiedWindowStartNs = now;
+}
+
 // shared by MIXER and DIRECT, overridden by DUPLICATING
 ssize_t AudioFlinger::PlaybackThread::threadLoop_write()
 {
@@ -3369,6 +3458,11 @@ ssize_t AudioFlinger::PlaybackThread::threadLoop_write()
             mCallbackThread->setWriteBlocked(mWriteAckSequence);
         }
     }
+    if (bytesWritten > 0) {
+        // the sink copies the data into the pipe or the HAL buffer
+        addBytesCopied(bytesWritten);
+    }
+    updateBytesCopiedPerSecond();
 
     mNumWrites++;
     mInWrite = false;
@@ -3555,6 +3649,14 @@ status_t AudioFlinger::PlaybackThread::addEffectChain_l(const sp<EffectChain>& c
                         numSamples * sizeof(effect_buffer_t),
                         &halInBuffer);
                 if (result != OK) return result;
+                if (mEffectChainWorkers > 0) {
+                    // The chain accumulates into a private buffer, so that it can be
+                    // processed concurrently with the other session chains.
+                    result = mAudioFlinger->mEffectsFactoryHal->allocateBuffer(
+                            numSamples * sizeof(effect_buffer_t),
+                            &halOutBuffer);
+                    if (result != OK) return result;
+                }
 #ifdef FLOAT_EFFECT_CHAIN
                 buffer = halInBuffer->audioBuffer()->f32;
 #else
@@ -3591,6 +3693,7 @@ status_t AudioFlinger::PlaybackThread::addEffectChain_l(const sp<EffectChain>& c
     chain->setThread(this);
     chain->setInBuffer(halInBuffer);
     chain->setOutBuffer(halOutBuffer);
+    chain->setProcessCpuMeasured(mEffectChainWorkers > 0);
     // Effect chain for session AUDIO_SESSION_DEVICE is inserted at end of effect
     // chains list in order to be processed last as it contains output device effects.
     // Effect chain for session AUDIO_SESSION_OUTPUT_STAGE is inserted just before to apply post
@@ -3978,14 +4081,16 @@ bool AudioFlinger::PlaybackThread::threadLoop()
             // TODO use mSleepTimeUs == 0 as an additional condition.
             uint32_t mixerChannelCount = mEffectBufferValid ?
                         audio_channel_count_from_out_mask(mMixerChannelMask) : mChannelCount;
-            if (mMixerBufferValid) {
+            if (mMixerBufferValid || mSinkBufferMixed) {
                 void *buffer = mEffectBufferValid ? mEffectBuffer : mSinkBuffer;
                 audio_format_t format = mEffectBufferValid ? mEffectBufferFormat : mFormat;
+                // mSinkBufferMixed implies mMixerBufferFormat == mFormat and no effect buffer
+                void *mixBuffer = mSinkBufferMixed ? mSinkBuffer : mMixerBuffer;
 
                 // mono blend occurs for mixer threads only (not direct or offloaded)
                 // and is handled here if we're going directly to the sink.
                 if (requireMonoBlend() && !mEffectBufferValid) {
-                    mono_blend(mMixerBuffer, mMixerBufferFormat, mChannelCount, mNormalFrameCount,
+                    mono_blend(mixBuffer, mMixerBufferFormat, mChannelCount, mNormalFrameCount,
                                true /*limit*/);
                 }
 
@@ -3994,11 +4099,16 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                     // We do it here if there is no FastMixer.
                     // mBalance detects zero balance within the class for speed (not needed here).
                     mBalance.setBalance(mMasterBalance.load());
-                    mBalance.process((float *)mMixerBuffer, mNormalFrameCount);
+                    mBalance.process((float *)mixBuffer, mNormalFrameCount);
                 }
 
-                memcpy_by_audio_format(buffer, format, mMixerBuffer, mMixerBufferFormat,
-                        mNormalFrameCount * (mixerChannelCount + mHapticChannelCount));
+                if (!mSinkBufferMixed) {
+                    const size_t sampleCount =
+                            mNormalFrameCount * (mixerChannelCount + mHapticChannelCount);
+                    memcpy_by_audio_format(buffer, format, mMixerBuffer, mMixerBufferFormat,
+                            sampleCount);
+                    addBytesCopied(sampleCount * audio_bytes_per_sample(format));
+                }
 
                 // If we're going directly to the sink and there are haptic channels,
                 // we should adjust channels as the sample data is partially interleaved
@@ -4024,8 +4134,14 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
             // only process effects if we're going to write
             if (mSleepTimeUs == 0 && mType != OFFLOAD) {
+                processParallelEffectChains_l(effectChains);
                 for (size_t i = 0; i < effectChains.size(); i ++) {
-                    effectChains[i]->process_l();
+                    // Chains with a private output buffer were processed above and their
+                    // output accumulated into mEffectBuffer.
+                    const bool hasPrivateOutput = hasPrivateEffectOutput_l(effectChains[i]);
+                    if (!hasPrivateOutput) {
+                        effectChains[i]->process_l();
+                    }
                     // TODO: Write haptic data directly to sink buffer when mixing.
                     if (activeHapticSessionId != AUDIO_SESSION_NONE
                             && activeHapticSessionId == effectChains[i]->sessionId()) {
@@ -4041,8 +4157,10 @@ bool AudioFlinger::PlaybackThread::threadLoop()
                         const size_t audioBufferSize = mNormalFrameCount
                             * audio_bytes_per_frame(hapticSessionChannelCount,
                                                     EFFECT_BUFFER_FORMAT);
+                        uint8_t *outBuffer = hasPrivateOutput ? (uint8_t*)mEffectBuffer
+                                : (uint8_t*)effectChains[i]->outBuffer();
                         memcpy_by_audio_format(
-                                (uint8_t*)effectChains[i]->outBuffer() + audioBufferSize,
+                                outBuffer + audioBufferSize,
                                 EFFECT_BUFFER_FORMAT,
                                 (const uint8_t*)effectChains[i]->inBuffer() + audioBufferSize,
                                 EFFECT_BUFFER_FORMAT, mNormalFrameCount * mHapticChannelCount);
@@ -4100,6 +4218,7 @@ bool AudioFlinger::PlaybackThread::threadLoop()
 
             memcpy_by_audio_format(mSinkBuffer, mFormat, effectBuffer, mEffectBufferFormat,
                     mNormalFrameCount * (mChannelCount + mHapticChannelCount));
+            addBytesCopied(mNormalFrameCount * mFrameSize);
 
             // The sample data is partially interleaved when haptic channels exist,
             // we need to adjust channels here.
@@ -4823,8 +4942,9 @@ AudioFlinger::MixerThread::MixerThread(const sp<AudioFlinger>& audioFlinger, Aud
         fastTrack->mHapticIntensity = os::HapticScale::NONE;
         fastTrack->mHapticMaxAmplitude = NAN;
         fastTrack->mGeneration++;
+        state->mModifiedTracks.set(0);
         state->mFastTracksGen++;
-        state->mTrackMask = 1;
+        state->mTrackMask = FastTrackMask::firstN(1);
         // fast mixer will use the HAL output sink
         state->mOutputSink = mOutputSink.get();
         state->mOutputSinkGen++;
@@ -4905,7 +5025,7 @@ AudioFlinger::MixerThread::~MixerThread()
         // We'll use that extract the final state which contains one remaining fast track
         // corresponding to our sub-mix.
         state = sq->begin();
-        ALOG_ASSERT(state->mTrackMask == 1);
+        ALOG_ASSERT(state->mTrackMask == FastTrackMask::firstN(1));
         FastTrack *fastTrack = &state->mFastTracks[0];
         ALOG_ASSERT(fastTrack->mBufferProvider != NULL);
         delete fastTrack->mBufferProvider;
@@ -4941,7 +5061,8 @@ ssize_t AudioFlinger::MixerThread::threadLoop_write()
         FastMixerStateQueue *sq = mFastMixer->sq();
         FastMixerState *state = sq->begin();
         if (state->mCommand != FastMixerState::MIX_WRITE &&
-                (kUseFastMixer != FastMixer_Dynamic || state->mTrackMask > 1)) {
+                (kUseFastMixer != FastMixer_Dynamic
+                        || (state->mTrackMask & ~FastTrackMask::firstN(1)).any())) {
             if (state->mCommand == FastMixerState::COLD_IDLE) {
 
                 // FIXME workaround for first HAL write being CPU bound on some devices
@@ -5150,7 +5271,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
     size_t tracksWithEffect = 0;
     // counts only _active_ fast tracks
     size_t fastTracks = 0;
-    uint32_t resetMask = 0; // bit mask of fast tracks that need to be reset
+    FastTrackMask resetMask; // fast indices of the tracks that need to be reset
 
     float masterVolume = mMasterVolume;
     bool masterMute = mMasterMute;
@@ -5181,6 +5302,10 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
 
     mMixerBufferValid = false;  // mMixerBuffer has no valid data until appropriate tracks found.
     mEffectBufferValid = false; // mEffectBuffer has no valid data until tracks found.
+    mSinkBufferMixed = false;   // mSinkBuffer has no mixer data until appropriate tracks found.
+    // With effect chains, the tracks without effects must be mixed in mMixerBuffer, as
+    // the chains may accumulate into mEffectBuffer which is then converted to mSinkBuffer.
+    const bool mixToSinkBuffer = mMixToSinkBufferSupported && mEffectChains.isEmpty();
 
     // DeferredOperations handles statistics after setting mixerStatus.
     class DeferredOperations {
@@ -5244,7 +5369,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             // is impossible because the slot isn't marked available until the end of each cycle.
             int j = track->mFastIndex;
             ALOG_ASSERT(0 < j && j < (int)FastMixerState::sMaxFastTracks);
-            ALOG_ASSERT(!(mFastTrackAvailMask & (1 << j)));
+            ALOG_ASSERT(!mFastTrackAvailMask.test(j));
             FastTrack *fastTrack = &state->mFastTracks[j];
 
             // Determine whether the track is currently in underrun condition,
@@ -5342,7 +5467,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                     // Can't reset directly, as fast mixer is still polling this track
                     //   track->reset();
                     // So instead mark this track as needing to be reset after push with ack
-                    resetMask |= 1 << i;
+                    resetMask.set(j);
                 }
                 isActive = false;
                 break;
@@ -5353,7 +5478,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
 
             if (isActive) {
                 // was it previously inactive?
-                if (!(state->mTrackMask & (1 << j))) {
+                if (!state->mTrackMask.test(j)) {
                     ExtendedAudioBufferProvider *eabp = track;
                     VolumeProvider *vp = track;
                     fastTrack->mBufferProvider = eabp;
@@ -5364,7 +5489,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                     fastTrack->mHapticIntensity = track->getHapticIntensity();
                     fastTrack->mHapticMaxAmplitude = track->getHapticMaxAmplitude();
                     fastTrack->mGeneration++;
-                    state->mTrackMask |= 1 << j;
+                    state->mModifiedTracks.set(j);
+                    state->mTrackMask.set(j);
                     didModify = true;
                     // no acknowledgement required for newly active tracks
                 }
@@ -5394,10 +5520,11 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                 ++fastTracks;
             } else {
                 // was it previously active?
-                if (state->mTrackMask & (1 << j)) {
+                if (state->mTrackMask.test(j)) {
                     fastTrack->mBufferProvider = NULL;
                     fastTrack->mGeneration++;
-                    state->mTrackMask &= ~(1 << j);
+                    state->mModifiedTracks.set(j);
+                    state->mTrackMask.reset(j);
                     didModify = true;
                     // If any fast tracks were removed, we must wait for acknowledgement
                     // because we're about to decrement the last sp<> on those tracks.
@@ -5409,8 +5536,9 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                     // FastTrack state hasn't had time to update.
                     // TODO Remove the ALOGW when this theory is confirmed.
                     ALOGW("fast track %d should have been active; "
-                            "mState=%d, mTrackMask=%#x, recentUnderruns=%u, isShared=%d",
-                            j, (int)track->mState, state->mTrackMask, recentUnderruns,
+                            "mState=%d, mTrackMask=%s, recentUnderruns=%u, isShared=%d",
+                            j, (int)track->mState, state->mTrackMask.toString().c_str(),
+                            recentUnderruns,
                             track->sharedBuffer() != 0);
                     // Since the FastMixer state already has the track inactive, do nothing here.
                 }
@@ -5420,6 +5548,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
             }
             if (fastTrack->mHapticPlaybackEnabled != track->getHapticPlaybackEnabled()) {
                 fastTrack->mHapticPlaybackEnabled = track->getHapticPlaybackEnabled();
+                state->mModifiedTracks.set(j);
                 didModify = true;
             }
             continue;
@@ -5676,6 +5805,18 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
                             trackId,
                             AudioMixer::TRACK,
                             AudioMixer::MAIN_BUFFER, (void *)mPostSpatializerBuffer);
+                } else if (mixToSinkBuffer) {
+                    // Same format and channel mask as mMixerBuffer, saves the copy
+                    // from mMixerBuffer to mSinkBuffer.
+                    mAudioMixer->setParameter(
+                            trackId,
+                            AudioMixer::TRACK,
+                            AudioMixer::MIXER_FORMAT, (void *)mMixerBufferFormat);
+                    mAudioMixer->setParameter(
+                            trackId,
+                            AudioMixer::TRACK,
+                            AudioMixer::MAIN_BUFFER, (void *)mSinkBuffer);
+                    mSinkBufferMixed = true;
                 } else {
                     mAudioMixer->setParameter(
                             trackId,
@@ -5797,6 +5938,7 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
         FastTrack *fastTrack = &state->mFastTracks[0];
         if (fastTrack->mHapticPlaybackEnabled != noFastHapticTrack) {
             fastTrack->mHapticPlaybackEnabled = noFastHapticTrack;
+            state->mModifiedTracks.set(0);
             didModify = true;
         }
     }
@@ -5807,7 +5949,8 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
         state->mFastTracksGen++;
         // if the fast mixer was active, but now there are no fast tracks, then put it in cold idle
         if (kUseFastMixer == FastMixer_Dynamic &&
-                state->mCommand == FastMixerState::MIX_WRITE && state->mTrackMask <= 1) {
+                state->mCommand == FastMixerState::MIX_WRITE
+                && (state->mTrackMask & ~FastTrackMask::firstN(1)).none()) {
             state->mCommand = FastMixerState::COLD_IDLE;
             state->mColdFutexAddr = &mFastMixerFutex;
             state->mColdGen++;
@@ -5840,13 +5983,13 @@ AudioFlinger::PlaybackThread::mixer_state AudioFlinger::MixerThread::prepareTrac
 #endif
 
     // Now perform the deferred reset on fast tracks that have stopped
-    while (resetMask != 0) {
-        size_t i = __builtin_ctz(resetMask);
-        ALOG_ASSERT(i < count);
-        resetMask &= ~(1 << i);
+    for (size_t i = 0; resetMask.any() && i < count; i++) {
         sp<Track> track = mActiveTracks[i];
-        ALOG_ASSERT(track->isFastTrack() && track->isStopped());
-        track->reset();
+        if (track->isFastTrack() && resetMask.test(track->mFastIndex)) {
+            resetMask.reset(track->mFastIndex);
+            ALOG_ASSERT(track->isStopped());
+            track->reset();
+        }
     }
 
     // Track destruction may occur outside of threadLoop once it is removed from active tracks.
@@ -7090,6 +7233,9 @@ ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 {
     for (size_t i = 0; i < outputTracks.size(); i++) {
         const ssize_t actualWritten = outputTracks[i]->write(mSinkBuffer, writeFrames);
+        if (actualWritten > 0) {
+            addBytesCopied(actualWritten * mFrameSize);
+        }
 
         // Consider the first OutputTrack for timestamp and frame counting.
 
@@ -7106,6 +7252,7 @@ ssize_t AudioFlinger::DuplicatingThread::threadLoop_write()
 
         // TODO: Report correction for the other output tracks and show in the dump.
     }
+    updateBytesCopiedPerSecond();
     if (mStandby) {
         mThreadMetrics.logBeginInterval();
         mStandby = false;
@@ -1106,6 +1106,30 @@ protected:
     // when mMixerBuffer contains valid data after mixing.
     bool                            mMixerBufferValid;
 
+    // Set by readOutputParameters_l() when mMixerBuffer and mSinkBuffer have the same format
+    // and channel mask, unless property af.thread.mix_to_sink is false.
+    // Then when there are no effect chains, MixerThread::prepareTracks_l() has the mixer
+    // write directly into mSinkBuffer, saving the copy from mMixerBuffer.
+    bool                            mMixToSinkBufferSupported = false;
+
+    // An internal flag set to true by MixerThread::prepareTracks_l()
+    // when the mixer writes directly into mSinkBuffer, in which case mMixerBufferValid is false.
+    bool                            mSinkBufferMixed = false;
+
+    // Number of bytes copied or converted by threadLoop() from the mixer output to the sink,
+    // including the copy done by the sink write(). Written by threadLoop(), read by dump.
+    std::atomic<int64_t>            mBytesCopied{0};
+    // Bytes copied per second, over the last second or more.
+    std::atomic<int64_t>            mBytesCopiedPerSecond{0};
+    int64_t                         mBytesCopiedWindowStart = 0;    // threadLoop() only
+    nsecs_t                         mBytesCopiedWindowStartNs = 0;  // threadLoop() only
+                void        addBytesCopied(size_t bytes) {
+                                // single writer
+                                mBytesCopied.store(mBytesCopied.load(std::memory_order_relaxed)
+                                        + bytes, std::memory_order_relaxed);
+                            }
+                void        updateBytesCopiedPerSecond();
+
     // Effects Buffer (mEffectsBuffer*)
     //
     // In the case of effects data, which is not in the sink format,
@@ -1140,6 +1164,15 @@ protected:
     // Size of mPostSpatializerBuffer in bytes
     size_t                          mPostSpatializerBufferSize;
 
+    // Number of worker threads processing the session effect chains of a MIXER thread
+    // in parallel, from property af.effect.parallel_workers. 0 if disabled.
+    // When enabled, each session chain outputs to a private buffer instead of mEffectBuffer,
+    // see processParallelEffectChains_l().
+    size_t                          mEffectChainWorkers = 0;
+    // Created by the constructor if mEffectChainWorkers > 0.
+    std::unique_ptr<EffectChainWorkerPool> mEffectChainWorkerPool;
+    // The chains with a private output buffer in the current cycle.
+    std::vector<sp<EffectChain>>    mParallelEffectChains;
 
     // suspend count, > 0 means suspended.  While suspended, the thread continues to pull from
     // tracks and mix, but doesn't write to HAL.  A2DP and SCO HAL implementations can't handle
@@ -1188,6 +1221,13 @@ protected:
     // Code snippets that are temporarily lifted up out of threadLoop() until the merge
                 void        checkSilentMode_l();
 
+    // Returns true if the chain is a session chain writing to a private output buffer.
+                bool        hasPrivateEffectOutput_l(const sp<EffectChain>& chain) const;
+    // Processes the chains with a private output buffer, on the effect chain workers,
+    // and accumulates their output into mEffectBuffer.
+                void        processParallelEffectChains_l(
+                                    const Vector<sp<EffectChain>>& effectChains);
+
     // Non-trivial for DUPLICATING only
     virtual     void        saveOutputTracks() { }
     virtual     void        clearOutputTracks() { }
@@ -1366,7 +1406,7 @@ public:
 
 protected:
                 // accessed by both binder threads and within threadLoop(), lock on mutex needed
-                unsigned    mFastTrackAvailMask;    // bit i set if fast track [i] is available
+                FastTrackMask mFastTrackAvailMask;  // bit i set if fast track [i] is available
                 bool        mHwSupportsPause;
                 bool        mHwPaused;
                 bool        mFlushPending;
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "effect_chain_worker_pool_tests"
+
+#include <atomic>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../EffectChainWorkerPool.h"
+
+using namespace android;
+
+namespace {
+
+constexpr size_t kFrameCount = 256;
+constexpr size_t kChannelCount = 2;
+constexpr size_t kNumSamples = kFrameCount * kChannelCount;
+constexpr int64_t kNoDeadlineNs = INT64_MAX;
+
+// Stands for a session effect chain of a mixer thread: a private input buffer holding the
+// session mix, and a private output buffer the last effect accumulates into.
+struct TestChain {
+    explicit TestChain(size_t index)
+        : gain(0.25f * (index + 1)), in(kNumSamples), out(kNumSamples) {
+        for (size_t i = 0; i < kNumSamples; i++) {
+            in[i] = (float) ((i * 7 + index * 13) % 101) / 101.f - 0.5f;
+        }
+    }
+
+    void process() {
+        std::fill(out.begin(), out.end(), 0.f);
+        for (size_t i = 0; i < kNumSamples; i++) {
+            // a few passes so that the jobs overlap
+            float sample = in[i];
+            for (int pass = 0; pass < 16; pass++) {
+                sample = sample * gain + 0.001f * pass;
+            }
+            out[i] += sample;
+        }
+        processCount++;
+    }
+
+    const float gain;
+    std::vector<float> in;
+    std::vector<float> out;
+    std::atomic<int> processCount{0};
+};
+
+// Processes the chains with the pool and accumulates their output in chain order,
+// like PlaybackThread::processParallelEffectChains_l().
+std::vector<float> mix(EffectChainWorkerPool *pool, std::vector<std::unique_ptr<TestChain>>& chains,
+        int64_t deadlineNs) {
+    pool->run(chains.size(), [&chains](size_t i) { chains[i]->process(); }, deadlineNs);
+    std::vector<float> mixBuffer(kNumSamples);
+    for (const auto& chain : chains) {
+        for (size_t i = 0; i < kNumSamples; i++) {
+            mixBuffer[i] += chain->out[i];
+        }
+    }
+    return mixBuffer;
+}
+
+std::vector<std::unique_ptr<TestChain>> makeChains(size_t count) {
+    std::vector<std::unique_ptr<TestChain>> chains;
+    for (size_t i = 0; i < count; i++) {
+        chains.push_back(std::make_unique<TestChain>(i));
+    }
+    return chains;
+}
+
+} // namespace
+
+TEST(EffectChainWorkerPoolTest, ParallelMatchesSerial) {
+    EffectChainWorkerPool serial(0 /* numWorkers */);
+    EffectChainWorkerPool parallel(3 /* numWorkers */);
+    auto serialChains = makeChains(6);
+    auto parallelChains = makeChains(6);
+
+    for (int cycle = 0; cycle < 200; cycle++) {
+        const std::vector<float> expected = mix(&serial, serialChains, kNoDeadlineNs);
+        const std::vector<float> actual = mix(&parallel, parallelChains, kNoDeadlineNs);
+        // bit exact: each chain is processed by one thread, and accumulated in order
+        ASSERT_EQ(expected, actual) << "cycle " << cycle;
+    }
+    for (const auto& chain : parallelChains) {
+        EXPECT_EQ(200, chain->processCount);
+    }
+    EXPECT_EQ(200u, parallel.parallelRuns());
+    EXPECT_EQ(0u, parallel.serialRuns());
+    EXPECT_EQ(0u, parallel.deadlineMisses());
+    EXPECT_EQ(200u, serial.serialRuns());
+}
+
+TEST(EffectChainWorkerPoolTest, EachJobRunsOnce) {
+    EffectChainWorkerPool pool(4 /* numWorkers */);
+    for (size_t count = 0; count < 40; count++) {
+        std::vector<std::atomic<int>> runs(count);
+        pool.run(count, [&runs](size_t i) { runs[i]++; }, kNoDeadlineNs);
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(1, runs[i]) << "count " << count << " job " << i;
+        }
+    }
+}
+
+TEST(EffectChainWorkerPoolTest, SerialAfterDeadlineMiss) {
+    EffectChainWorkerPool pool(2 /* numWorkers */);
+    auto chains = makeChains(4);
+
+    mix(&pool, chains, 0 /* deadlineNs */);
+    EXPECT_EQ(1u, pool.parallelRuns());
+    EXPECT_EQ(1u, pool.deadlineMisses());
+
+    // the following runs are serial, and produce the same mix
+    EffectChainWorkerPool serial(0 /* numWorkers */);
+    auto serialChains = makeChains(4);
+    for (uint32_t i = 0; i < EffectChainWorkerPool::kSerialRunsAfterMiss; i++) {
+        ASSERT_EQ(mix(&serial, serialChains, kNoDeadlineNs), mix(&pool, chains, 0));
+    }
+    EXPECT_EQ(1u, pool.parallelRuns());
+    EXPECT_EQ(EffectChainWorkerPool::kSerialRunsAfterMiss, pool.serialRuns());
+
+    // then parallel again
+    mix(&pool, chains, kNoDeadlineNs);
+    EXPECT_EQ(2u, pool.parallelRuns());
+    EXPECT_EQ(1u, pool.deadlineMisses());
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Cost of a FastMixerState handoff through the StateQueue, for the fast track capacity
+// set at build time by FAST_MIXER_MAX_FAST_TRACKS.
+// BM_StateQueuePush only copies the modified tracks, and should not depend on the capacity.
+// BM_FullStateCopy is the cost of copying the whole state, as push() used to do.
+
+#include <benchmark/benchmark.h>
+
+#include "FastMixerState.h"
+#include "StateQueue.h"
+
+using namespace android;
+
+// Pushes a state with the given number of modified tracks, and polls it as FastMixer does.
+static void BM_StateQueuePush(benchmark::State& state) {
+    const unsigned modifiedTracks = state.range(0);
+    StateQueue<FastMixerState> sq;
+    sq.begin();
+    sq.end();
+    sq.push();
+    sq.poll();
+
+    unsigned index = 0;
+    for (auto _ : state) {
+        FastMixerState *mutating = sq.begin();
+        for (unsigned i = 0; i < modifiedTracks; ++i) {
+            index = (index + 1) % FastMixerState::kMaxFastTracks;
+            mutating->mFastTracks[index].mGeneration++;
+            mutating->mModifiedTracks.set(index);
+        }
+        mutating->mFastTracksGen++;
+        sq.end();
+        sq.push();
+        benchmark::DoNotOptimize(sq.poll());
+    }
+    state.SetLabel(std::to_string(FastMixerState::kMaxFastTracks) + " tracks");
+}
+
+BENCHMARK(BM_StateQueuePush)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_FullStateCopy(benchmark::State& state) {
+    FastMixerState states[2];
+    unsigned i = 0;
+    for (auto _ : state) {
+        states[i ^ 1] = states[i];
+        benchmark::ClobberMemory();
+        i ^= 1;
+    }
+    state.SetLabel(std::to_string(FastMixerState::kMaxFastTracks) + " tracks");
+}
+
+BENCHMARK(BM_FullStateCopy);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//#define LOG_NDEBUG 0
+#define LOG_TAG "fast_mixer_state_tests"
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "FastMixerState.h"
+#include "StateQueue.h"
+
+using namespace android;
+
+namespace {
+
+constexpr unsigned kMaxTracks = FastMixerState::kMaxFastTracks;
+
+bool tracksEqual(const FastTrack& a, const FastTrack& b) {
+    return a.mBufferProvider == b.mBufferProvider && a.mVolumeProvider == b.mVolumeProvider
+            && a.mChannelMask == b.mChannelMask && a.mFormat == b.mFormat
+            && a.mGeneration == b.mGeneration
+            && a.mHapticPlaybackEnabled == b.mHapticPlaybackEnabled;
+}
+
+void expectStatesEqual(const FastMixerState& expected, const FastMixerState& actual) {
+    EXPECT_EQ(expected.mCommand, actual.mCommand);
+    EXPECT_EQ(expected.mFastTracksGen, actual.mFastTracksGen);
+    EXPECT_EQ(expected.mTrackMask, actual.mTrackMask);
+    EXPECT_EQ(expected.mFrameCount, actual.mFrameCount);
+    for (unsigned i = 0; i < kMaxTracks; ++i) {
+        EXPECT_TRUE(tracksEqual(expected.mFastTracks[i], actual.mFastTracks[i]))
+                << "track " << i;
+    }
+}
+
+} // namespace
+
+TEST(FastTrackMaskTest, Basics) {
+    FastTrackMask mask;
+    EXPECT_TRUE(mask.none());
+    EXPECT_EQ(0u, mask.count());
+
+    mask.set(0);
+    mask.set(kMaxTracks - 1);
+    EXPECT_TRUE(mask.test(0));
+    EXPECT_TRUE(mask.test(kMaxTracks - 1));
+    EXPECT_FALSE(mask.test(1));
+    EXPECT_EQ(2u, mask.count());
+
+    EXPECT_EQ(0u, mask.first());
+    EXPECT_EQ(0u, mask.popFirst());
+    EXPECT_EQ(kMaxTracks - 1, mask.popFirst());
+    EXPECT_TRUE(mask.none());
+
+    EXPECT_EQ(kMaxTracks, FastTrackMask::firstN(kMaxTracks).count());
+    EXPECT_EQ(kMaxTracks - 1, (~FastTrackMask::firstN(1)).count());
+    EXPECT_TRUE((FastTrackMask::firstN(3) & ~FastTrackMask::firstN(3)).none());
+    EXPECT_EQ(FastTrackMask::firstN(5), FastTrackMask::firstN(2) | FastTrackMask::firstN(5));
+
+    EXPECT_EQ("0x0", FastTrackMask().toString());
+    EXPECT_EQ("0x6", (FastTrackMask::firstN(3) & ~FastTrackMask::firstN(1)).toString());
+}
+
+// The state queue only copies the modified tracks on push; check that the observer sees
+// the same states as with full copies.
+TEST(FastMixerStateQueueTest, PushCopiesModifiedTracks) {
+    StateQueue<FastMixerState> sq;
+    FastMixerState expected;
+    std::minstd_rand random(42);
+
+    FastMixerState *state = sq.begin();
+    state->mCommand = FastMixerState::MIX_WRITE;
+    state->mFrameCount = 192;
+    sq.end();
+    expected.mCommand = FastMixerState::MIX_WRITE;
+    expected.mFrameCount = 192;
+
+    for (int push = 0; push < 1000; ++push) {
+        // a few mutations may be squashed into one push
+        const int mutations = 1 + random() % 3;
+        for (int m = 0; m < mutations; ++m) {
+            state = sq.begin();
+            const unsigned i = random() % kMaxTracks;
+            for (FastMixerState *s : {state, &expected}) {
+                FastTrack *fastTrack = &s->mFastTracks[i];
+                if (s->mTrackMask.test(i)) {
+                    fastTrack->mBufferProvider = nullptr;
+                    s->mTrackMask.reset(i);
+                } else {
+                    fastTrack->mBufferProvider =
+                            reinterpret_cast<ExtendedAudioBufferProvider *>(uintptr_t(push + 1));
+                    fastTrack->mFormat = (push & 1) ? AUDIO_FORMAT_PCM_FLOAT
+                                                    : AUDIO_FORMAT_PCM_16_BIT;
+                    s->mTrackMask.set(i);
+                }
+                fastTrack->mGeneration++;
+                s->mFastTracksGen++;
+            }
+            state->mModifiedTracks.set(i);
+            sq.end();
+        }
+        ASSERT_TRUE(sq.push(StateQueue<FastMixerState>::BLOCK_NEVER));
+
+        const FastMixerState *current = sq.poll();
+        ASSERT_NE(nullptr, current);
+        expectStatesEqual(expected, *current);
+        // the next state to mutate starts from the pushed state
+        state = sq.begin();
+        expectStatesEqual(expected, *state);
+        sq.end(false /*didModify*/);
+        if (HasFailure()) {
+            FAIL() << "push " << push;
+        }
+    }
+}
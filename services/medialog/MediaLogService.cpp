@@ -17,9 +17,11 @@
 #define LOG_TAG "MediaLog"
 //#define LOG_NDEBUG 0
 
+#include <algorithm>
 #include <sys/mman.h>
 #include <utils/Log.h>
 #include <binder/PermissionCache.h>
+#include <cutils/properties.h>
 #include <media/nblog/Merger.h>
 #include <media/nblog/NBLog.h>
 #include <mediautils/ServiceUtilities.h>
@@ -41,6 +43,17 @@ MediaLogService::MediaLogService() :
     mMergeReader(mMergerShared, kMergeBufferSize, mMerger),
     mMergeThread(new NBLog::MergeThread(mMerger, mMergeReader))
 {
+    // Optionally keep the history in a file, for offline analysis with nblog_analyzer.
+    char path[PROPERTY_VALUE_MAX];
+    if (property_get("media.log.persist.path", path, "") > 0) {
+        const int32_t sizeKb = property_get_int32("media.log.persist.size_kb",
+                                                  kPersistentLogSizeKb);
+        if (sizeKb > 0) {
+            const size_t size = std::min<size_t>(sizeKb,
+                    NBLog::PersistentLogWriter::kMaxCapacity / 1024) * 1024;
+            mMergeReader.setPersistentLog(NBLog::PersistentLogWriter::open(path, size));
+        }
+    }
     mMergeThread->run("MergeThread");
 }
 
@@ -52,6 +52,8 @@ private:
     static const int kDumpLockSleepUs = 20000;
     // Size of merge buffer, in bytes
     static const size_t kMergeBufferSize = 64 * 1024; // TODO determine good value for this
+    // Default size of the persistent log, when enabled by property media.log.persist.path
+    static const int32_t kPersistentLogSizeKb = 16 * 1024;
     static bool dumpTryLock(Mutex& mutex);
 
     Mutex               mLock;
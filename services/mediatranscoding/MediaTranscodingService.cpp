@@ -70,6 +70,8 @@ MediaTranscodingService::MediaTranscodingService()
                 property_get_int32("persist.transcoding.burst_count_quota", -1);
         int32_t pacerBurstTimeQuotaSeconds =
                 property_get_int32("persist.transcoding.burst_time_quota_seconds", -1);
+        int32_t maxConcurrentSessions =
+                property_get_int32("persist.transcoding.max_concurrent_sessions", -1);
         // Override default config params with properties if present.
         TranscodingSessionController::ControllerConfig config;
         if (overrideBurstCountQuota > 0) {
@@ -78,6 +80,9 @@ MediaTranscodingService::MediaTranscodingService()
         if (pacerBurstTimeQuotaSeconds > 0) {
             config.pacerBurstTimeQuotaSeconds = pacerBurstTimeQuotaSeconds;
         }
+        if (maxConcurrentSessions > 0) {
+            config.maxConcurrentSessions = maxConcurrentSessions;
+        }
         mSessionController.reset(new TranscodingSessionController(
                 [logger = mLogger](const std::shared_ptr<TranscoderCallbackInterface>& cb)
                         -> std::shared_ptr<TranscoderInterface> {